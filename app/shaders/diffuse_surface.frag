@@ -1,10 +1,15 @@
 #pragma include <surface.frag>
 
-uniform vec3 u_color;
-uniform bool u_useDiffuseTex;
+// packed into a single uniform buffer by CustomMaterial
+layout(std140) uniform MaterialData
+{
+	vec3 u_color;
+	float u_fresnelPow;
+	vec3 u_edgeColor;
+	bool u_useDiffuseTex;
+};
+
 uniform sampler2D u_diffuseTex;
-uniform float u_fresnelPow;
-uniform vec3 u_edgeColor;
 
 void surface(inout Material material)
 {
@@ -0,0 +1,21 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#version 150 core
+
+// index of the node in the picking pass, 0 is nothing
+uniform uint u_id;
+out uint fragId;
+
+void main()
+{
+    fragId = u_id;
+}
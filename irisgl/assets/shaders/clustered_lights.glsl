@@ -0,0 +1,70 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+// Point and spot lights binned into clusters by LightClusters in irisgl/src/graphics/lightclusters.cpp
+// Only for fragment shaders, scene_uniforms.glsl must be included first
+
+// 4 texels per light:
+// position and distance, color * intensity and type, direction and cutoff angle, cutoff softness
+uniform samplerBuffer u_clusterLights;
+// offset into u_clusterIndices and light count of each cluster
+uniform usamplerBuffer u_clusterCells;
+uniform usamplerBuffer u_clusterIndices;
+
+// adds the diffuse and specular light of the lights in the fragment's cluster
+void addClusterLights(vec3 worldPos, vec3 n, vec3 v, float shininess,
+                      inout vec3 diffuse, inout vec3 specular)
+{
+    if (u_clusterGrid.w == 0)
+        return;
+
+    float depth = -(u_viewMatrix * vec4(worldPos, 1.0)).z;
+    vec2 tile = (gl_FragCoord.xy - u_clusterViewport.xy) / u_clusterViewport.zw * vec2(u_clusterGrid.xy);
+    float slice = log(max(depth, u_clusterDepth.x) / u_clusterDepth.x) * u_clusterDepth.y;
+
+    ivec3 cell = clamp(ivec3(int(tile.x), int(tile.y), int(slice)), ivec3(0), u_clusterGrid.xyz - 1);
+    int cluster = (cell.z * u_clusterGrid.y + cell.y) * u_clusterGrid.x + cell.x;
+    uvec2 range = texelFetch(u_clusterCells, cluster).xy;
+
+    for (uint i = 0u; i < range.y; i++) {
+        int index = int(texelFetch(u_clusterIndices, int(range.x + i)).r) * 4;
+        vec4 posDist = texelFetch(u_clusterLights, index);
+        vec4 colorType = texelFetch(u_clusterLights, index + 1);
+
+        vec3 lightDir = posDist.xyz - worldPos;
+        vec3 l = normalize(lightDir);
+        float ndl = max(dot(n, l), 0.0);
+        if (ndl <= 0.0)
+            continue;
+
+        float atten = clamp((length(lightDir) - posDist.w) / (-posDist.w), 0.0, 1.0);
+        atten = atten * atten;
+
+        float spotCutoff = 1.0;
+        if (int(colorType.w) == TYPE_SPOT) {
+            vec4 dirAngle = texelFetch(u_clusterLights, index + 2);
+            float softness = texelFetch(u_clusterLights, index + 3).x;
+            float angle = degrees(acos(dot(-l, dirAngle.xyz)));
+            spotCutoff = clamp((angle - dirAngle.w) / (-softness), 0.0, 1.0);
+            ndl = ndl * spotCutoff;
+        }
+
+        float spec = 0.0;
+        if (ndl > 0.0 && shininess > 0.0) {
+            float normFactor = (shininess + 2.0) / 2.0;
+            vec3 r = reflect(-l, n);
+            spec = normFactor * pow(max(dot(r, v), 0.0), shininess) * spotCutoff;
+        }
+
+        diffuse += atten * ndl * colorType.rgb;
+        specular += atten * spec * colorType.rgb;
+    }
+}
@@ -42,51 +42,28 @@ in vec3 v_normal;
 in vec3 v_worldPos;
 in mat3 v_tanToWorld;
 
-const int MAX_LIGHTS = 8;
-const int TYPE_POINT = 0;
-const int TYPE_DIRECTIONAL = 1;
-const int TYPE_SPOT = 2;
-
-//const int SHADOW_NONE = 0;
-//const int SHADOW_HARD = 1;
-//const int SHADOW_SOFT = 2;
-//const int SHADOW_SOFTER = 3;
-
-//in vec4 FragPosLightSpace;
-//uniform sampler2D u_shadowMap;
-//uniform bool u_shadowEnabled;
-struct Light {
-    int type;
-    vec3 position;
-    vec3 ambient;
-    vec4 color;
-    float distance;
-    float intensity;
-    vec3 direction;
-    float cutOffAngle;
-    float cutOffSoftness;
-
-    sampler2D shadowMap;
-    bool shadowEnabled;
-    int shadowType;
-    mat4 shadowMatrix;
-};
+#pragma include <scene_uniforms.glsl>
+#pragma include <clustered_lights.glsl>
 
-float SampleShadowMap(in sampler2D shadowMap, vec2 coords, float compare) {
-    if (coords.x < 0.0 || coords.x > 1.0 || coords.y < 0.0 || coords.y > 1.0)
-        return 1.0;
+// shadow maps cant be a part of the scene block
+uniform sampler2D u_shadowMaps[MAX_LIGHTS];
+
+// tile is the uv rect of the cascade being sampled as min.xy, max.xy
+// taps are clamped inside it so filtering doesnt read the neighbouring cascades
+float SampleShadowMap(in sampler2D shadowMap, vec2 coords, float compare, vec4 tile, vec2 texelSize) {
+    coords = clamp(coords, tile.xy + texelSize * 0.5, tile.zw - texelSize * 0.5);
     return step(compare, texture(shadowMap, coords.xy).r);
 }
 
-float SampleShadowMapLinear(sampler2D shadowMap, vec2 coords, float compare, vec2 texelSize) {
+float SampleShadowMapLinear(sampler2D shadowMap, vec2 coords, float compare, vec4 tile, vec2 texelSize) {
     vec2 pixelPos = coords / texelSize + vec2(0.5);
     vec2 fracPart = fract(pixelPos);
     vec2 startTexel = (pixelPos - fracPart) * texelSize;
 
-    float blTexel = SampleShadowMap(shadowMap, startTexel, compare);
-    float brTexel = SampleShadowMap(shadowMap, startTexel + vec2(texelSize.x, 0.0), compare);
-    float tlTexel = SampleShadowMap(shadowMap, startTexel + vec2(0.0, texelSize.y), compare);
-    float trTexel = SampleShadowMap(shadowMap, startTexel + texelSize, compare);
+    float blTexel = SampleShadowMap(shadowMap, startTexel, compare, tile, texelSize);
+    float brTexel = SampleShadowMap(shadowMap, startTexel + vec2(texelSize.x, 0.0), compare, tile, texelSize);
+    float tlTexel = SampleShadowMap(shadowMap, startTexel + vec2(0.0, texelSize.y), compare, tile, texelSize);
+    float trTexel = SampleShadowMap(shadowMap, startTexel + texelSize, compare, tile, texelSize);
 
     float mixA = mix(blTexel, tlTexel, fracPart.y);
     float mixB = mix(brTexel, trTexel, fracPart.y);
@@ -94,7 +71,7 @@ float SampleShadowMapLinear(sampler2D shadowMap, vec2 coords, float compare, vec
     return mix(mixA, mixB, fracPart.x);
 }
 
-float SampleShadowMapPCF(in sampler2D shadowMap, vec2 coords, float compare, vec2 texelSize) {
+float SampleShadowMapPCF(in sampler2D shadowMap, vec2 coords, float compare, vec4 tile, vec2 texelSize) {
     float result = 0;
 
     const float NUM_SAMPLES = 7.0;
@@ -103,58 +80,88 @@ float SampleShadowMapPCF(in sampler2D shadowMap, vec2 coords, float compare, vec
     for(float y = -SAMPLES_START; y <= SAMPLES_START; y++) {
         for(float x = -SAMPLES_START; x <= SAMPLES_START; x++) {
             vec2 offset = vec2(x, y) * texelSize;
-            result += SampleShadowMapLinear(shadowMap, coords + offset, compare, texelSize);
+            result += SampleShadowMapLinear(shadowMap, coords + offset, compare, tile, texelSize);
         }
     }
 
     return result / (NUM_SAMPLES * NUM_SAMPLES);
 }
 
-float CalcShadowMap(in sampler2D shadowMap, vec4 fragPosLightSpace) {
+bool outsideTile(vec2 coords, vec4 tile) {
+    return coords.x < tile.x || coords.x > tile.z || coords.y < tile.y || coords.y > tile.w;
+}
+
+float CalcShadowMap(in sampler2D shadowMap, vec4 fragPosLightSpace, vec4 tile) {
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     projCoords = projCoords * 0.5 + 0.5;
+    if (outsideTile(projCoords.xy, tile))
+        return 1.0;
     vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
-    return SampleShadowMapPCF(shadowMap, projCoords.xy, projCoords.z, texelSize);
+    return SampleShadowMapPCF(shadowMap, projCoords.xy, projCoords.z, tile, texelSize);
 }
 
-float calcSoftShadowMap(in Light light, in vec4 lightSpacePos)
+float calcSoftShadowMap(in sampler2D shadowMap, in vec4 lightSpacePos, vec4 tile)
 {
-    return CalcShadowMap(light.shadowMap, lightSpacePos);
+    return CalcShadowMap(shadowMap, lightSpacePos, tile);
 }
 
-float calcHardShadowMap(in Light light, in vec4 lightSpacePos)
+float calcHardShadowMap(in sampler2D shadowMap, in vec4 lightSpacePos, vec4 tile)
 {
     vec3 projCoords = lightSpacePos.xyz / lightSpacePos.w;
     projCoords = projCoords * 0.5 + 0.5;
-    //return SampleShadowMap(light.shadowMap,projCoords.xy,projCoords.z);
-    if (projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0)
+    //return SampleShadowMap(shadowMap,projCoords.xy,projCoords.z);
+    if (outsideTile(projCoords.xy, tile))
         return 1.0;
-    if (projCoords.z > texture(light.shadowMap, projCoords.xy).r)
+    if (projCoords.z > texture(shadowMap, projCoords.xy).r)
         return 0.0;
     return 1.0;
 }
 
-
-//  Handles shadowing for lights with different shadowing types
-float calculateShadowFactor(in Light light, in vec3 worldPos)
+// Picks the cascade covering the fragment's view depth
+// Fragments past the last split use the last cascade
+int selectCascade(in Light light, float viewDepth)
 {
-    vec4 lightSpacePos = light.shadowMatrix * vec4(v_worldPos, 1.0);
-    if (light.shadowType==SHADOW_HARD)
-        return calcHardShadowMap(light, lightSpacePos);
-    if (light.shadowType==SHADOW_SOFT)
-        return calcSoftShadowMap(light, lightSpacePos);
-    return 1.0f;
+    for (int c = 0; c < light.cascadeCount - 1; c++) {
+        if (viewDepth < light.cascadeSplits[c])
+            return c;
+    }
+    return light.cascadeCount - 1;
 }
 
+// uv rect of the cascade's tile, cascades share the map as a 2x2 grid
+vec4 cascadeTile(in Light light, int cascade)
+{
+    if (light.cascadeCount == 1)
+        return vec4(0.0, 0.0, 1.0, 1.0);
 
+    vec2 tileMin = vec2(cascade % 2, cascade / 2) * 0.5;
+    return vec4(tileMin, tileMin + vec2(0.5));
+}
 
-uniform sampler2D shadowMaps[MAX_LIGHTS];
+//  Handles shadowing for lights with different shadowing types
+float calculateShadowFactor(in Light light, in sampler2D shadowMap, in vec3 worldPos)
+{
+    float viewDepth = -(u_viewMatrix * vec4(worldPos, 1.0)).z;
+    int cascade = selectCascade(light, viewDepth);
+    vec4 tile = cascadeTile(light, cascade);
 
-uniform Light u_lights[MAX_LIGHTS];
-uniform int u_lightCount;
+    vec4 lightSpacePos = light.shadowMatrices[cascade] * vec4(worldPos, 1.0);
+    float shadow = 1.0;
+    if (light.shadowType==SHADOW_HARD)
+        shadow = calcHardShadowMap(shadowMap, lightSpacePos, tile);
+    else if (light.shadowType==SHADOW_SOFT)
+        shadow = calcSoftShadowMap(shadowMap, lightSpacePos, tile);
+
+    // shadows fade out over the last tenth of the cascaded distance
+    // instead of stopping at the last split
+    if (light.cascadeCount > 1) {
+        float end = light.cascadeSplits[light.cascadeCount - 1];
+        float fade = clamp((end - viewDepth) / (end * 0.1), 0.0, 1.0);
+        shadow = mix(1.0, shadow, fade);
+    }
 
-uniform vec3 u_eyePos;
-uniform vec3 u_sceneAmbient; 
+    return shadow;
+}
 
 struct Material
 {
@@ -168,16 +175,6 @@ struct Material
 
 uniform Material u_material;
 
-struct Fog
-{
-    bool enabled;
-    float start;
-    float end;
-    vec4 color;
-};
-
-uniform Fog u_fogData;
-
 out vec4 fragColor;
 
 vec2 envMapEquirect(vec3 wcNormal, float flipEnvMap) {
@@ -268,12 +265,15 @@ void main()
 
         //vec4 FragPosLightSpace = u_lights[i].shadowMatrix * vec4(v_worldPos, 1.0);
         //float shadowFactor = u_lights[i].shadowEnabled ? CalcShadowMap(u_lights[i].shadowMap,FragPosLightSpace) : 1.0;
-        float shadowFactor = calculateShadowFactor(u_lights[i], v_worldPos);
+        float shadowFactor = calculateShadowFactor(u_lights[i], u_shadowMaps[i], v_worldPos);
 
         diffuse += atten*ndl*u_lights[i].intensity*u_lights[i].color.rgb*shadowFactor;
         specular += atten*spec* u_lights[i].intensity * u_lights[i].color.rgb*shadowFactor;
     }
 
+    // point and spot lights without shadows
+    addClusterLights(v_worldPos, normalize(normal), v, u_material.shininess, diffuse, specular);
+
     vec3 col = u_material.diffuse;
 
     if (u_useDiffuseTex) {
@@ -302,7 +302,7 @@ void main()
         finalColor = mix(finalColor,reflCol,u_reflectionInfluence);
     }
 
-    if(u_fogData.enabled)
+    if(u_fogData.enabled && u_receiveFog)
     {
         float zDist = length(v_worldPos-u_eyePos);
         float fogFactor = clamp((zDist-u_fogData.start)/(u_fogData.end-u_fogData.start),0,1);
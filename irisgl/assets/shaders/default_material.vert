@@ -16,11 +16,15 @@ in vec2 a_texCoord;
 in vec3 a_normal;
 in vec3 a_tangent;
 
-uniform mat4 matrix;
-uniform mat4 u_viewMatrix;
-uniform mat4 u_projMatrix;
+#pragma include <scene_uniforms.glsl>
+
+// INSTANCED is defined by the renderer when drawing batches of the same mesh
+#ifdef INSTANCED
+in mat4 a_instanceMatrix;
+#else
 uniform mat4 u_worldMatrix;
 uniform mat3 u_normalMatrix;
+#endif
 uniform float u_textureScale;
 
 uniform mat4 u_lightSpaceMatrix;
@@ -33,15 +37,23 @@ out mat3 v_tanToWorld;//transforms from tangent space to world space
 
 void main()
 {
-    v_worldPos = (u_worldMatrix*vec4(a_pos,1.0)).xyz;
+#ifdef INSTANCED
+    mat4 worldMatrix = a_instanceMatrix;
+    mat3 normalMatrix = transpose(inverse(mat3(a_instanceMatrix)));
+#else
+    mat4 worldMatrix = u_worldMatrix;
+    mat3 normalMatrix = u_normalMatrix;
+#endif
+
+    v_worldPos = (worldMatrix*vec4(a_pos,1.0)).xyz;
     //gl_Position = matrix*vec4(a_pos,1.0);
-    gl_Position = u_projMatrix*u_viewMatrix*u_worldMatrix*vec4(a_pos,1.0);
+    gl_Position = u_projMatrix*u_viewMatrix*worldMatrix*vec4(a_pos,1.0);
 
     v_texCoord = a_texCoord*u_textureScale;
     //v_texCoord = a_texCoord*2;
 
-    v_normal = normalize((u_normalMatrix*a_normal));
-    vec3 v_tangent = normalize((u_normalMatrix*a_tangent));
+    v_normal = normalize((normalMatrix*a_normal));
+    vec3 v_tangent = normalize((normalMatrix*a_tangent));
     //vec3 v_bitangent = cross(v_normal,v_tangent);
     vec3 v_bitangent = cross(v_tangent,v_normal);
 
@@ -14,12 +14,25 @@ For more information see the LICENSE file
 in vec3 a_pos;
 in vec2 a_texCoord;
 
+// per-particle attributes
+in vec4 a_particlePos;// xyz is the position, w is the rotation in degrees
+in vec4 a_particleParams;// x is the scale, y is the normalized age
+
 out vec2 o_texCoord;
 
 uniform mat4 projectionMatrix;
-uniform mat4 modelViewMatrix;
+uniform mat4 viewMatrix;
 
 void main() {
-    gl_Position = projectionMatrix * modelViewMatrix * vec4(a_pos, 1.0);
+    // offset the corner in view space so the quad always faces the camera
+    float angle = radians(a_particlePos.w);
+    float c = cos(angle);
+    float s = sin(angle);
+    vec2 corner = mat2(c, s, -s, c) * a_pos.xy * a_particleParams.x;
+
+    vec4 viewPos = viewMatrix * vec4(a_particlePos.xyz, 1.0);
+    viewPos.xy += corner;
+
+    gl_Position = projectionMatrix * viewPos;
     o_texCoord = a_texCoord;
 }
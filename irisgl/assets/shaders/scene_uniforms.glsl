@@ -0,0 +1,69 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+// Scene-wide data shared by all shaders that include this file
+// It's uploaded once per frame by the renderer
+// The layout must match SceneUniformBlock in irisgl/src/graphics/renderdata.h
+
+const int MAX_LIGHTS = 8;
+const int MAX_CASCADES = 4;
+const int TYPE_POINT = 0;
+const int TYPE_DIRECTIONAL = 1;
+const int TYPE_SPOT = 2;
+
+struct Light {
+    vec4 color;
+    vec3 position;
+    float distance;
+    vec3 direction;
+    float intensity;
+    int type;
+    float cutOffAngle;
+    float cutOffSoftness;
+    int shadowType;
+    // view depth at which each cascade ends
+    vec4 cascadeSplits;
+    // 1 for lights without cascades
+    int cascadeCount;
+    mat4 shadowMatrices[MAX_CASCADES];
+};
+
+struct Fog
+{
+    vec4 color;
+    float start;
+    float end;
+    bool enabled;
+};
+
+layout(std140) uniform SceneData
+{
+    mat4 u_viewMatrix;
+    mat4 u_projMatrix;
+    vec3 u_eyePos;
+    float u_time;
+    vec3 u_sceneAmbient;
+    int u_lightCount;
+    Fog u_fogData;
+    // directional lights, lights with shadows and the rest if clustering is off
+    Light u_lights[MAX_LIGHTS];
+
+    // see clustered_lights.glsl
+    // the grid size and 1 if clustered lights are used
+    ivec4 u_clusterGrid;
+    // x, y, width and height in pixels
+    vec4 u_clusterViewport;
+    // near depth and slice scale
+    vec4 u_clusterDepth;
+};
+
+// set per item, false if the item's material disables fog
+uniform bool u_receiveFog;
@@ -0,0 +1,21 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#version 150 core
+
+in vec3 a_pos;
+in mat4 a_instanceMatrix;
+
+uniform mat4 u_lightSpaceMatrix;
+
+void main() {
+    gl_Position = u_lightSpaceMatrix * a_instanceMatrix * vec4(a_pos, 1.0);
+}
@@ -18,9 +18,8 @@ in vec3 a_tangent;
 in vec4 a_boneWeights;
 in vec4 a_boneIndices;
 
-uniform mat4 matrix;
-uniform mat4 u_viewMatrix;
-uniform mat4 u_projMatrix;
+#pragma include <scene_uniforms.glsl>
+
 uniform mat4 u_worldMatrix;
 uniform mat3 u_normalMatrix;
 uniform float u_textureScale;
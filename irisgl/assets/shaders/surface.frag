@@ -22,17 +22,13 @@ in vec3 v_normal;
 in vec3 v_worldPos;
 in mat3 v_tanToWorld;
 
-const int MAX_LIGHTS = 8;
-const int TYPE_POINT = 0;
-const int TYPE_DIRECTIONAL = 1;
-const int TYPE_SPOT = 2;
+#pragma include <scene_uniforms.glsl>
+#pragma include <clustered_lights.glsl>
 
 in vec4 FragPosLightSpace;
 uniform sampler2D u_shadowMap;
 uniform bool u_shadowEnabled;
 
-uniform float u_time;
-
 float SampleShadowMap(sampler2D shadowMap, vec2 coords, float compare) {
     return step(compare, texture(shadowMap, coords.xy).r);
 }
@@ -76,23 +72,6 @@ float CalcShadowMap(vec4 fragPosLightSpace) {
     return SampleShadowMapPCF(u_shadowMap, projCoords.xy, projCoords.z, texelSize);
 }
 
-struct Light {
-    int type;
-    vec3 position;
-    vec3 ambient;
-    vec4 color;
-    float distance;
-    float intensity;
-    vec3 direction;
-    float cutOffAngle;
-    float cutOffSoftness;
-};
-uniform Light u_lights[MAX_LIGHTS];
-uniform int u_lightCount;
-
-uniform vec3 u_eyePos;
-uniform vec3 u_sceneAmbient;
-
 struct Material
 {
     vec3 diffuse;
@@ -104,16 +83,6 @@ struct Material
     float alpha;
 };
 
-struct Fog
-{
-    bool enabled;
-    float start;
-    float end;
-    vec4 color;
-};
-
-uniform Fog u_fogData;
-
 out vec4 fragColor;
 
 vec2 envMapEquirect(vec3 wcNormal, float flipEnvMap) {
@@ -223,6 +192,9 @@ void main()
         specular += atten*spec* u_lights[i].intensity * u_lights[i].color.rgb;
     }
 
+    // point and spot lights without shadows
+    addClusterLights(v_worldPos, normalize(normal), v, material.shininess, diffuse, specular);
+
     vec3 col = material.diffuse;
 
     float ShadowFactor = u_shadowEnabled ? CalcShadowMap(FragPosLightSpace) : 1.0;
@@ -231,7 +203,7 @@ void main()
                       (diffuse * col + (material.specular * specular))));
 
 
-    if(u_fogData.enabled)
+    if(u_fogData.enabled && u_receiveFog)
     {
         float zDist = length(v_worldPos-u_eyePos);
         float fogFactor = clamp((zDist-u_fogData.start)/(u_fogData.end-u_fogData.start),0,1);
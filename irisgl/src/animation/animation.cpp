@@ -13,6 +13,7 @@ For more information see the LICENSE file
 #include "keyframeset.h"
 #include "propertyanim.h"
 #include "skeletalanimation.h"
+#include "bakedanimation.h"
 #include "../irisglfwd.h"
 #include <QDebug>
 #include <cmath>
@@ -36,6 +37,31 @@ void Animation::setSkeletalAnimation(const SkeletalAnimationPtr &value)
     calculateAnimationLength();
 }
 
+void Animation::bake(bool quantize)
+{
+    bakedAnimation = BakedAnimation::bake(this, frameRate, quantize);
+}
+
+void Animation::clearBake()
+{
+    bakedAnimation.reset();
+}
+
+bool Animation::isBaked() const
+{
+    return !!bakedAnimation;
+}
+
+BakedAnimationPtr Animation::getBakedAnimation() const
+{
+    return bakedAnimation;
+}
+
+void Animation::setBakedAnimation(const BakedAnimationPtr &value)
+{
+    bakedAnimation = value;
+}
+
 float Animation::getSampleTime(float time)
 {
     if (loop) {
@@ -95,6 +121,8 @@ float Animation::getLength() const
 
 void Animation::setLength(float value)
 {
+    if (length != value)
+        clearBake();
     length = value;
 }
 
@@ -105,6 +133,8 @@ bool Animation::getLooping() const
 
 void Animation::setLooping(bool value)
 {
+    if (loop != value)
+        clearBake();
     loop = value;
 }
 
@@ -114,6 +144,7 @@ void Animation::addPropertyAnim(PropertyAnim *anim)
     
     properties.insert(anim->getName(), anim);
     calculateAnimationLength();
+    clearBake();
 }
 
 void Animation::removePropertyAnim(QString name)
@@ -123,6 +154,7 @@ void Animation::removePropertyAnim(QString name)
 
     if (properties.remove(name) == 0)
         qDebug() << "Animation property "<<name<<" doesnt exist";
+    clearBake();
 }
 
 PropertyAnim* Animation::getPropertyAnim(QString name)
@@ -149,7 +181,6 @@ ColorPropertyAnim *Animation::getColorPropertyAnim(QString name)
 
 bool Animation::hasPropertyAnim(QString name)
 {
-	qDebug() << properties.keys();
     return properties.contains(name);
 }
 
@@ -167,6 +198,8 @@ int Animation::getFrameRate() const
 
 void Animation::setFrameRate(int value)
 {
+    if (frameRate != value)
+        clearBake();
     frameRate = value;
 }
 
@@ -35,6 +35,8 @@ class Animation
     // sample rate
     int frameRate;
 
+    BakedAnimationPtr bakedAnimation;
+
 public:
     QMap<QString,PropertyAnim*> properties;
     SkeletalAnimationPtr skeletalAnimation;
@@ -78,6 +80,18 @@ public:
     bool hasSkeletalAnimation();
     void setSkeletalAnimation(const SkeletalAnimationPtr &value);
 
+    /**
+     * Resamples all the channels at the animation's frame rate so playback
+     * doesnt evaluate any curves. quantize trades precision for memory.
+     * Changing the length, looping, frame rate or property channels clears
+     * the bake. Editing keys directly doesnt, so editors call clearBake()
+     */
+    void bake(bool quantize = false);
+    void clearBake();
+    bool isBaked() const;
+    BakedAnimationPtr getBakedAnimation() const;
+    void setBakedAnimation(const BakedAnimationPtr &value);
+
     // Calculate the time the animation keyframes should be sampled at
     // It takes looping into consideration
     float getSampleTime(float time);
@@ -0,0 +1,165 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "animationrig.h"
+#include "skeletalanimation.h"
+#include "bakedanimation.h"
+#include "../scenegraph/scenenode.h"
+#include "../scenegraph/meshnode.h"
+#include "../graphics/mesh.h"
+#include "../graphics/skeleton.h"
+#include <QHash>
+
+namespace iris
+{
+
+AnimationRig::AnimationRig()
+{
+    animation = nullptr;
+    bakedAnimation = nullptr;
+    hierarchyVersion = 0;
+}
+
+void AnimationRig::build(SceneNode* root, SkeletalAnimationPtr anim, BakedAnimationPtr baked)
+{
+    animation = anim.data();
+    bakedAnimation = baked.data();
+    hierarchyVersion = SceneNode::getHierarchyVersion();
+
+    nodes.clear();
+    parents.clear();
+    channels.clear();
+    bakedChannels.clear();
+    skins.clear();
+
+    // depth first so parents always come before their children
+    // later nodes with the same name take precedence, as names are
+    // how bones and channels are matched
+    QHash<QString, int> nodeIndices;
+    QVector<QPair<SceneNode*, int>> stack;
+    stack.append(qMakePair(root, -1));
+    while (!stack.isEmpty()) {
+        auto entry = stack.takeLast();
+        auto node = entry.first;
+
+        int index = nodes.size();
+        nodes.append(node);
+        parents.append(entry.second);
+        nodeIndices.insert(node->name, index);
+
+        auto boneAnim = anim->boneAnimations.value(node->name);
+        channels.append(boneAnim.data());
+        bakedChannels.append(!!baked ? baked->getBoneTrack(node->name) : nullptr);
+
+        // pushed in reverse so they're visited in order
+        for (int i = node->children.size() - 1; i >= 0; i--)
+            stack.append(qMakePair(node->children[i].data(), index));
+    }
+
+    skeletonSpaceMatrices.resize(nodes.size());
+    cursors.fill(-1, nodes.size() * 3);
+
+    for (int i = 0; i < nodes.size(); i++) {
+        auto node = nodes[i];
+        if (node->getSceneNodeType() != SceneNodeType::Mesh)
+            continue;
+
+        auto meshNode = static_cast<MeshNode*>(node);
+        auto mesh = meshNode->getMesh();
+        if (mesh == nullptr || !mesh->hasSkeleton())
+            continue;
+
+        SkinBinding skin;
+        skin.meshNode = meshNode;
+        skin.nodeIndex = nodeIndices.value(node->name, i);
+
+        auto& bones = mesh->getSkeleton()->bones;
+        skin.boneNodes.resize(bones.size());
+        for (int b = 0; b < bones.size(); b++)
+            skin.boneNodes[b] = nodeIndices.value(bones[b]->name, -1);
+
+        skins.append(skin);
+    }
+}
+
+bool AnimationRig::isValid(const SkeletalAnimationPtr& anim, const BakedAnimationPtr& baked)
+{
+    return animation == anim.data() &&
+           bakedAnimation == baked.data() &&
+           hierarchyVersion == SceneNode::getHierarchyVersion() &&
+           !nodes.isEmpty();
+}
+
+void AnimationRig::evaluate(float time)
+{
+    // the root's parent transform is its transform before it's animated
+    QMatrix4x4 rootTransform = nodes[0]->getLocalTransform();
+
+    if (bakedAnimation) {
+        int frame;
+        float t;
+        bakedAnimation->getFrame(time, frame, t);
+
+        for (int i = 0; i < nodes.size(); i++) {
+            auto track = bakedChannels[i];
+            if (track) {
+                auto node = nodes[i];
+                node->pos = track->position.sample(frame, t).toVector3D();
+                node->rot = track->rotation.sample(frame, t);
+                node->scale = track->scale.sample(frame, t).toVector3D();
+            }
+        }
+    } else {
+        for (int i = 0; i < nodes.size(); i++) {
+            auto boneAnim = channels[i];
+            if (boneAnim) {
+                auto node = nodes[i];
+                int* cursor = cursors.data() + i * 3;
+                node->pos = boneAnim->posKeys->getValueAt(time, QVector3D(), cursor[0]);
+                node->rot = boneAnim->rotKeys->getValueAt(time, QQuaternion(), cursor[1]).normalized();
+                node->scale = boneAnim->scaleKeys->getValueAt(time, QVector3D(), cursor[2]);
+            }
+        }
+    }
+
+    calculateSkeletonSpaceMatrices(rootTransform);
+    applySkins();
+}
+
+void AnimationRig::applyCurrentPose()
+{
+    calculateSkeletonSpaceMatrices(nodes[0]->getLocalTransform());
+    applySkins();
+}
+
+void AnimationRig::swapBuffers()
+{
+    for (auto& skin : skins)
+        skin.meshNode->getMesh()->getSkeleton()->swapBoneTransforms();
+}
+
+void AnimationRig::calculateSkeletonSpaceMatrices(const QMatrix4x4& rootTransform)
+{
+    for (int i = 0; i < nodes.size(); i++) {
+        int parent = parents[i];
+        skeletonSpaceMatrices[i] = (parent < 0 ? rootTransform : skeletonSpaceMatrices[parent]) * nodes[i]->getLocalTransform();
+    }
+}
+
+void AnimationRig::applySkins()
+{
+    for (auto& skin : skins) {
+        auto inverseMeshMatrix = skeletonSpaceMatrices[skin.nodeIndex].inverted();
+        skin.meshNode->getMesh()->getSkeleton()->applyAnimation(inverseMeshMatrix, skeletonSpaceMatrices, skin.boneNodes);
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef ANIMATIONRIG_H
+#define ANIMATIONRIG_H
+
+#include "../irisglfwd.h"
+#include <QVector>
+#include <QMatrix4x4>
+
+namespace iris
+{
+
+class BoneAnimation;
+struct BakedBoneTrack;
+
+/**
+ * Flattened copy of the node hierarchy driven by a skeletal animation
+ * The hierarchy is stored in parent-first order with parent indices, bone
+ * channels and skinned meshes are bound to nodes when the rig is built so
+ * evaluating a pose doesnt do any lookups or allocations.
+ */
+class AnimationRig
+{
+    struct SkinBinding
+    {
+        MeshNode* meshNode;
+        int nodeIndex;
+        // node index of each of the skeleton's bones, -1 if the bone has no node
+        QVector<int> boneNodes;
+    };
+
+    SkeletalAnimation* animation;
+    BakedAnimation* bakedAnimation;
+    quint32 hierarchyVersion;
+
+    QVector<SceneNode*> nodes;
+    QVector<int> parents;// -1 for the root
+    QVector<BoneAnimation*> channels;// null for nodes without a channel
+    QVector<const BakedBoneTrack*> bakedChannels;// used instead of channels when baked
+    // position, rotation and scale key cursors of each channel
+    // the key frames are shared by every instance of a model so the cursors are kept here
+    QVector<int> cursors;
+    QVector<QMatrix4x4> skeletonSpaceMatrices;
+    QVector<SkinBinding> skins;
+
+public:
+    AnimationRig();
+
+    /**
+     * Flattens the hierarchy starting at root and binds anim's channels to it
+     * If baked isnt null its bone tracks are sampled instead of anim's curves
+     */
+    void build(SceneNode* root, SkeletalAnimationPtr anim, BakedAnimationPtr baked = BakedAnimationPtr());
+
+    /**
+     * Returns true if the rig was built for anim and baked and the scene
+     * hierarchy hasnt changed since
+     */
+    bool isValid(const SkeletalAnimationPtr& anim, const BakedAnimationPtr& baked = BakedAnimationPtr());
+
+    /**
+     * Samples the channels at time, updates the nodes' transforms and
+     * the bone transforms of the skinned meshes
+     */
+    void evaluate(float time);
+
+    /**
+     * Updates the skinned meshes using the nodes' current transforms
+     */
+    void applyCurrentPose();
+
+    /**
+     * Makes the skinned meshes' last evaluated poses visible to the renderer
+     */
+    void swapBuffers();
+
+private:
+    void calculateSkeletonSpaceMatrices(const QMatrix4x4& rootTransform);
+    void applySkins();
+};
+
+}
+
+#endif // ANIMATIONRIG_H
@@ -0,0 +1,430 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "bakedanimation.h"
+#include "animation.h"
+#include "propertyanim.h"
+#include "keyframeanimation.h"
+#include "skeletalanimation.h"
+
+#include <QDataStream>
+#include <QtMath>
+#include <cmath>
+
+namespace iris
+{
+
+// "IBAK"
+static const quint32 BAKED_ANIMATION_MAGIC = 0x4942414B;
+static const quint32 BAKED_ANIMATION_VERSION = 1;
+
+BakedVectorTrack::BakedVectorTrack()
+{
+    components = 0;
+    quantized = false;
+    for (int i = 0; i < 4; i++) {
+        minValue[i] = 0;
+        range[i] = 0;
+    }
+}
+
+void BakedVectorTrack::setFrames(const QVector<QVector4D>& frames, int components, bool quantize)
+{
+    this->components = components;
+    this->quantized = quantize;
+    values.clear();
+    quantizedValues.clear();
+
+    if (!quantize) {
+        values.reserve(frames.size() * components);
+        for (auto& frame : frames)
+            for (int c = 0; c < components; c++)
+                values.append(frame[c]);
+        return;
+    }
+
+    for (int c = 0; c < components; c++) {
+        float lo = frames.isEmpty() ? 0 : frames[0][c];
+        float hi = lo;
+        for (auto& frame : frames) {
+            lo = qMin(lo, frame[c]);
+            hi = qMax(hi, frame[c]);
+        }
+        minValue[c] = lo;
+        range[c] = hi - lo;
+    }
+
+    quantizedValues.reserve(frames.size() * components);
+    for (auto& frame : frames) {
+        for (int c = 0; c < components; c++) {
+            float n = range[c] > 0 ? (frame[c] - minValue[c]) / range[c] : 0;
+            quantizedValues.append((quint16)qRound(qBound(0.0f, n, 1.0f) * 65535.0f));
+        }
+    }
+}
+
+bool BakedVectorTrack::isEmpty() const
+{
+    return components == 0;
+}
+
+int BakedVectorTrack::getFrameCount() const
+{
+    if (components == 0)
+        return 0;
+    return (quantized ? quantizedValues.size() : values.size()) / components;
+}
+
+QVector4D BakedVectorTrack::getValue(int frame) const
+{
+    QVector4D value;
+    int index = frame * components;
+    if (quantized) {
+        for (int c = 0; c < components; c++)
+            value[c] = minValue[c] + quantizedValues[index + c] * (range[c] / 65535.0f);
+    } else {
+        for (int c = 0; c < components; c++)
+            value[c] = values[index + c];
+    }
+
+    return value;
+}
+
+void BakedVectorTrack::write(QDataStream& stream) const
+{
+    stream << (qint32)components << quantized;
+    if (quantized) {
+        for (int c = 0; c < 4; c++)
+            stream << minValue[c] << range[c];
+        stream << quantizedValues;
+    } else {
+        stream << values;
+    }
+}
+
+void BakedVectorTrack::read(QDataStream& stream)
+{
+    qint32 comps;
+    stream >> comps >> quantized;
+    components = comps;
+    if (quantized) {
+        for (int c = 0; c < 4; c++)
+            stream >> minValue[c] >> range[c];
+        stream >> quantizedValues;
+    } else {
+        stream >> values;
+    }
+}
+
+// smallest three encoding
+// the largest component is dropped and rebuilt from the other three, which
+// fall within +-1/sqrt(2) and are stored as 15 bits each. The index of the
+// dropped component is stored in the top bits of the first two values
+static void packQuaternion(const QQuaternion& rot, quint16* packed)
+{
+    float c[4] = {rot.x(), rot.y(), rot.z(), rot.scalar()};
+
+    int largest = 0;
+    for (int i = 1; i < 4; i++)
+        if (qAbs(c[i]) > qAbs(c[largest]))
+            largest = i;
+
+    // q and -q are the same rotation so the largest is kept positive
+    float sign = c[largest] < 0 ? -1.0f : 1.0f;
+
+    int j = 0;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest)
+            continue;
+        float n = (c[i] * sign * float(M_SQRT2)) * 0.5f + 0.5f;
+        packed[j++] = (quint16)qRound(qBound(0.0f, n, 1.0f) * 32767.0f);
+    }
+
+    packed[0] |= (largest >> 1) << 15;
+    packed[1] |= (largest & 1) << 15;
+}
+
+static QQuaternion unpackQuaternion(const quint16* packed)
+{
+    int largest = ((packed[0] >> 15) << 1) | (packed[1] >> 15);
+
+    float c[4];
+    float sum = 0;
+    int j = 0;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest)
+            continue;
+        float n = (packed[j++] & 0x7fff) / 32767.0f;
+        c[i] = (n * 2.0f - 1.0f) * float(M_SQRT1_2);
+        sum += c[i] * c[i];
+    }
+    c[largest] = std::sqrt(qMax(0.0f, 1.0f - sum));
+
+    return QQuaternion(c[3], c[0], c[1], c[2]);
+}
+
+BakedRotationTrack::BakedRotationTrack()
+{
+    quantized = false;
+}
+
+void BakedRotationTrack::setFrames(const QVector<QQuaternion>& frames, bool quantize)
+{
+    quantized = quantize;
+    values.clear();
+    quantizedValues.clear();
+
+    if (!quantize) {
+        values.reserve(frames.size());
+        for (auto& frame : frames)
+            values.append(frame.normalized());
+        return;
+    }
+
+    quantizedValues.resize(frames.size() * 3);
+    for (int i = 0; i < frames.size(); i++)
+        packQuaternion(frames[i].normalized(), quantizedValues.data() + i * 3);
+}
+
+bool BakedRotationTrack::isEmpty() const
+{
+    return getFrameCount() == 0;
+}
+
+int BakedRotationTrack::getFrameCount() const
+{
+    return quantized ? quantizedValues.size() / 3 : values.size();
+}
+
+QQuaternion BakedRotationTrack::getValue(int frame) const
+{
+    if (quantized)
+        return unpackQuaternion(quantizedValues.constData() + frame * 3);
+    return values[frame];
+}
+
+void BakedRotationTrack::write(QDataStream& stream) const
+{
+    stream << quantized;
+    if (quantized)
+        stream << quantizedValues;
+    else
+        stream << values;
+}
+
+void BakedRotationTrack::read(QDataStream& stream)
+{
+    stream >> quantized;
+    if (quantized)
+        stream >> quantizedValues;
+    else
+        stream >> values;
+}
+
+BakedAnimation::BakedAnimation()
+{
+    frameRate = 60;
+    frameCount = 0;
+    quantized = false;
+}
+
+BakedAnimationPtr BakedAnimation::bake(Animation* anim, float frameRate, bool quantize)
+{
+    auto baked = BakedAnimationPtr(new BakedAnimation());
+    baked->frameRate = frameRate;
+    baked->quantized = quantize;
+
+    // the last frame is duplicated so frame + 1 is always valid when sampling
+    float length = qMax(0.0f, anim->getLength());
+    int frameCount = qMax(1, (int)std::ceil(length * frameRate)) + 1;
+    baked->frameCount = frameCount;
+
+    QVector<float> times(frameCount);
+    for (int i = 0; i < frameCount; i++)
+        times[i] = qMin(i / frameRate, length);
+
+    QVector<QVector4D> frames(frameCount);
+    QVector<QQuaternion> rotFrames(frameCount);
+
+    for (auto propName : anim->properties.keys()) {
+        auto keyFrames = anim->properties[propName]->getKeyFrames();
+
+        if (propName == "rotation" && keyFrames.size() == 3) {
+            for (int i = 0; i < frameCount; i++) {
+                auto euler = QVector3D(keyFrames[0].keyFrame->getValueAt(times[i]),
+                                       keyFrames[1].keyFrame->getValueAt(times[i]),
+                                       keyFrames[2].keyFrame->getValueAt(times[i]));
+                rotFrames[i] = QQuaternion::fromEulerAngles(euler);
+            }
+            baked->rotation.setFrames(rotFrames, quantize);
+            continue;
+        }
+
+        int components = qMin(keyFrames.size(), 4);
+        for (int i = 0; i < frameCount; i++) {
+            frames[i] = QVector4D();
+            for (int c = 0; c < components; c++)
+                frames[i][c] = keyFrames[c].keyFrame->getValueAt(times[i]);
+        }
+
+        if (propName == "position") {
+            baked->position.setFrames(frames, components, quantize);
+        } else if (propName == "scale") {
+            baked->scale.setFrames(frames, components, quantize);
+        } else {
+            PropertyTrack prop;
+            prop.name = propName;
+            prop.track.setFrames(frames, components, quantize);
+            baked->properties.append(prop);
+        }
+    }
+
+    if (anim->hasSkeletalAnimation()) {
+        auto skelAnim = anim->getSkeletalAnimation();
+        for (auto boneName : skelAnim->boneAnimations.keys()) {
+            auto boneAnim = skelAnim->boneAnimations[boneName];
+
+            BakedBoneTrack bone;
+            bone.name = boneName;
+
+            // frames are sampled in order so the cursors only move forward
+            int cursor = -1;
+            for (int i = 0; i < frameCount; i++)
+                frames[i] = QVector4D(boneAnim->posKeys->getValueAt(times[i], QVector3D(), cursor));
+            bone.position.setFrames(frames, 3, quantize);
+
+            cursor = -1;
+            for (int i = 0; i < frameCount; i++)
+                rotFrames[i] = boneAnim->rotKeys->getValueAt(times[i], QQuaternion(), cursor);
+            bone.rotation.setFrames(rotFrames, quantize);
+
+            cursor = -1;
+            for (int i = 0; i < frameCount; i++)
+                frames[i] = QVector4D(boneAnim->scaleKeys->getValueAt(times[i], QVector3D(), cursor));
+            bone.scale.setFrames(frames, 3, quantize);
+
+            baked->bones.append(bone);
+        }
+    }
+
+    return baked;
+}
+
+void BakedAnimation::getFrame(float time, int& frame, float& t) const
+{
+    float f = qMax(0.0f, time * frameRate);
+    frame = (int)f;
+    if (frame >= frameCount - 1) {
+        frame = qMax(0, frameCount - 2);
+        t = frameCount > 1 ? 1.0f : 0.0f;
+        return;
+    }
+
+    t = f - frame;
+}
+
+bool BakedAnimation::getPropertyValue(const QString& name, float time, QVector4D& value) const
+{
+    for (auto& prop : properties) {
+        if (prop.name == name) {
+            int frame;
+            float t;
+            getFrame(time, frame, t);
+            value = prop.track.sample(frame, t);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const BakedBoneTrack* BakedAnimation::getBoneTrack(const QString& name) const
+{
+    for (auto& bone : bones)
+        if (bone.name == name)
+            return &bone;
+
+    return nullptr;
+}
+
+QByteArray BakedAnimation::serialize() const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << BAKED_ANIMATION_MAGIC << BAKED_ANIMATION_VERSION;
+    stream << frameRate << (qint32)frameCount << quantized;
+
+    position.write(stream);
+    rotation.write(stream);
+    scale.write(stream);
+
+    stream << (qint32)properties.size();
+    for (auto& prop : properties) {
+        stream << prop.name;
+        prop.track.write(stream);
+    }
+
+    stream << (qint32)bones.size();
+    for (auto& bone : bones) {
+        stream << bone.name;
+        bone.position.write(stream);
+        bone.rotation.write(stream);
+        bone.scale.write(stream);
+    }
+
+    return data;
+}
+
+BakedAnimationPtr BakedAnimation::deserialize(const QByteArray& data)
+{
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    stream >> magic >> version;
+    if (magic != BAKED_ANIMATION_MAGIC || version != BAKED_ANIMATION_VERSION)
+        return BakedAnimationPtr();
+
+    auto baked = BakedAnimationPtr(new BakedAnimation());
+    qint32 frames;
+    stream >> baked->frameRate >> frames >> baked->quantized;
+    baked->frameCount = frames;
+
+    baked->position.read(stream);
+    baked->rotation.read(stream);
+    baked->scale.read(stream);
+
+    qint32 count;
+    stream >> count;
+    baked->properties.resize(qMax(0, count));
+    for (auto& prop : baked->properties) {
+        stream >> prop.name;
+        prop.track.read(stream);
+    }
+
+    stream >> count;
+    baked->bones.resize(qMax(0, count));
+    for (auto& bone : baked->bones) {
+        stream >> bone.name;
+        bone.position.read(stream);
+        bone.rotation.read(stream);
+        bone.scale.read(stream);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return BakedAnimationPtr();
+
+    return baked;
+}
+
+}
@@ -0,0 +1,155 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef BAKEDANIMATION_H
+#define BAKEDANIMATION_H
+
+#include "../irisglfwd.h"
+#include <QVector>
+#include <QVector4D>
+#include <QQuaternion>
+#include <QByteArray>
+
+class QDataStream;
+
+namespace iris
+{
+
+/**
+ * Channel of up to 4 floats sampled at a fixed rate
+ * Quantized tracks store each component as 16 bits within the track's range
+ */
+class BakedVectorTrack
+{
+    int components;
+    bool quantized;
+
+    QVector<float> values;
+    QVector<quint16> quantizedValues;
+    float minValue[4];
+    float range[4];
+
+public:
+    BakedVectorTrack();
+
+    void setFrames(const QVector<QVector4D>& frames, int components, bool quantize);
+
+    bool isEmpty() const;
+    int getFrameCount() const;
+
+    QVector4D getValue(int frame) const;
+    QVector4D sample(int frame, float t) const
+    {
+        auto a = getValue(frame);
+        auto b = getValue(frame + 1);
+        return a + (b - a) * t;
+    }
+
+    void write(QDataStream& stream) const;
+    void read(QDataStream& stream);
+};
+
+/**
+ * Rotation channel sampled at a fixed rate
+ * Quantized tracks use the smallest three encoding, 48 bits per rotation
+ */
+class BakedRotationTrack
+{
+    bool quantized;
+
+    QVector<QQuaternion> values;
+    QVector<quint16> quantizedValues;
+
+public:
+    BakedRotationTrack();
+
+    void setFrames(const QVector<QQuaternion>& frames, bool quantize);
+
+    bool isEmpty() const;
+    int getFrameCount() const;
+
+    QQuaternion getValue(int frame) const;
+    QQuaternion sample(int frame, float t) const
+    {
+        return QQuaternion::nlerp(getValue(frame), getValue(frame + 1), t);
+    }
+
+    void write(QDataStream& stream) const;
+    void read(QDataStream& stream);
+};
+
+struct BakedBoneTrack
+{
+    QString name;
+    BakedVectorTrack position;
+    BakedRotationTrack rotation;
+    BakedVectorTrack scale;
+};
+
+/**
+ * An Animation with all of its channels resampled at a fixed frame rate
+ * Sampling it is a lerp (or nlerp for rotations) between two frames so
+ * playing it back doesnt need any curves to be evaluated.
+ * It's a snapshot, animations need to be rebaked after their keys change.
+ */
+class BakedAnimation
+{
+public:
+    struct PropertyTrack
+    {
+        QString name;
+        BakedVectorTrack track;
+    };
+
+    float frameRate;
+    int frameCount;
+    bool quantized;
+
+    // the node's transform, empty if the animation doesnt animate it
+    // rotations are baked from euler angles to quaternions
+    BakedVectorTrack position;
+    BakedRotationTrack rotation;
+    BakedVectorTrack scale;
+
+    // all other animated properties
+    QVector<PropertyTrack> properties;
+
+    // channels of the skeletal animation, if any
+    QVector<BakedBoneTrack> bones;
+
+    BakedAnimation();
+
+    /**
+     * Samples all of anim's channels frameRate times a second
+     */
+    static BakedAnimationPtr bake(Animation* anim, float frameRate, bool quantize = false);
+
+    /**
+     * Returns the frame to sample from for time and the blend factor to the next one
+     */
+    void getFrame(float time, int& frame, float& t) const;
+
+    /**
+     * Returns false if the property wasnt baked
+     */
+    bool getPropertyValue(const QString& name, float time, QVector4D& value) const;
+
+    // returns null if the bone wasnt baked
+    const BakedBoneTrack* getBoneTrack(const QString& name) const;
+
+    QByteArray serialize() const;
+    // returns null if the data isnt a baked animation
+    static BakedAnimationPtr deserialize(const QByteArray& data);
+};
+
+}
+
+#endif // BAKEDANIMATION_H
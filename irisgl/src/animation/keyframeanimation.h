@@ -18,6 +18,8 @@ For more information see the LICENSE file
 #include <QVector4D>
 #include <QQuaternion>
 #include <QColor>
+#include <QVector>
+#include <algorithm>
 
 #include "../math/bezierhelper.h"
 
@@ -70,12 +72,47 @@ template <typename T> bool KeyCompare(const Key<T> * const & a, const Key<T> * c
    return a->time < b->time;
 }
 
+/**
+ * Returns the index i of the segment where times[i] <= time < times[i+1]
+ * time must be within the first and last key times
+ * cursor is the segment found by the last search, it's checked along with the
+ * segment after it first so sampling forward in time is constant time. Anything
+ * else, including a cursor of -1, falls back to a binary search
+ */
+inline int findKeySegment(const QVector<double>& times, double time, int& cursor)
+{
+    int last = times.size() - 1;
+    int i = cursor;
+
+    if (i >= 0 && i < last && times[i] <= time) {
+        if (time < times[i + 1])
+            return i;
+
+        if (i + 1 < last && time < times[i + 2]) {
+            cursor = i + 1;
+            return cursor;
+        }
+    }
+
+    auto upper = std::upper_bound(times.constBegin(), times.constEnd(), time);
+    i = int(upper - times.constBegin()) - 1;
+    cursor = i;
+    return i;
+}
+
 
 template<typename T>
 class KeyFrame
 {
+    // packed copies of the keys' times and values used for sampling
+    // kept in sync with keys by addKey(), removeKey() and sortKeys()
+    QVector<double> keyTimes;
+    QVector<T> keyValues;
+
 public:
     QString name;
+
+    // keys are sorted by time, call sortKeys() after changing a key's time or value
     QVector<Key<T>*> keys;
     float length;//in seconds
 
@@ -86,11 +123,13 @@ public:
 
     void clear()
     {
-        for (size_t i=0;i<keys.size();i++)
+        for (int i=0;i<keys.size();i++)
         {
             delete keys[i];
         }
         keys.clear();
+        keyTimes.clear();
+        keyValues.clear();
     }
 
     float getLength()
@@ -106,13 +145,13 @@ public:
         //sort keys
         this->sortKeys();
         //get last key and use that to determine length
-        auto last = keys.end().c;
-        length = last->time;
+        length = keyTimes.last();
     }
 
     void removeKey(Key<T>* key)
     {
         keys.removeOne(key);
+        updateSamples();
     }
 
     Key<T>* addKey(T value,double time)
@@ -129,6 +168,11 @@ public:
         {
             this->sortKeys();
         }
+        else
+        {
+            keyTimes.append(time);
+            keyValues.append(value);
+        }
 
         // update length
         length = keys[keys.size() - 1]->time;
@@ -136,6 +180,13 @@ public:
         return key;
     }
 
+    void reserve(int numKeys)
+    {
+        keys.reserve(numKeys);
+        keyTimes.reserve(numKeys);
+        keyValues.reserve(numKeys);
+    }
+
     bool hasKeys()
     {
         return keys.size();
@@ -143,53 +194,48 @@ public:
 
     T getValueAt(double time)
     {
-        return getValueAt(time,T());
+        int cursor = -1;
+        return getValueAt(time,T(),cursor);
     }
 
     T getValueAt(double time,T defaultVal)
     {
-        Key<T>* leftKey = Q_NULLPTR;
-        Key<T>* rightKey = Q_NULLPTR;
+        int cursor = -1;
+        return getValueAt(time,defaultVal,cursor);
+    }
 
-        //why bother with a copy?
-        T val = defaultVal;
+    /**
+     * Samples the keys using cursor to find the segment, see findKeySegment()
+     * The cursor belongs to the caller so key frames shared by several
+     * animated objects can be sampled from several threads at once
+     */
+    T getValueAt(double time,T defaultVal,int& cursor)
+    {
+        int numKeys = keyTimes.size();
 
-        this->getKeyFramesAtTime(&leftKey,&rightKey,time);
+        if(numKeys==0)
+            return defaultVal;
 
-        if(leftKey!=Q_NULLPTR && rightKey==Q_NULLPTR)
-        {
-            val = leftKey->value;
-        }
+        //todo: wrap around
+        if(numKeys==1 || time<=keyTimes[0])
+            return keyValues[0];
+
+        if(time>=keyTimes[numKeys-1])
+            return keyValues[numKeys-1];
+
+        int k = findKeySegment(keyTimes, time, cursor);
+
+        //linearly interpolate between frames
+        float t = 0;
+        double timeDiff = keyTimes[k+1] - keyTimes[k];
 
-        if(leftKey!=Q_NULLPTR && rightKey!=Q_NULLPTR)
+        //frameDiff could be 0!!
+        if(timeDiff != 0)
         {
-            //linearly interpolate between frames
-            //float t =0;
-            float timeDiff = rightKey->time - leftKey->time;
-
-            //frameDiff could be 0!!
-            if(timeDiff != 0)
-            {
-                //t = (time-leftKey->time)/timeDiff;
-            }
-
-            if(leftKey!=Q_NULLPTR && rightKey!=Q_NULLPTR)
-            {
-                //linearly interpolate between frames
-                float t =0;
-                float timeDiff = rightKey->time - leftKey->time;
-
-                //frameDiff could be 0!!
-                if(timeDiff != 0)
-                {
-                    t = (time-leftKey->time)/timeDiff;
-                }
-
-                val = interpolate(leftKey->value, rightKey->value, t);
-            }
+            t = (time-keyTimes[k])/timeDiff;
         }
 
-        return val;
+        return interpolate(keyValues[k], keyValues[k+1], t);
     }
 
     void getKeyFramesAtTime(Key<T>** firstKey,Key<T>** lastKey,float time)
@@ -199,61 +245,43 @@ public:
         if(numKeys==0)
             return;
 
-        if(numKeys==1)
-        {
-            *firstKey = keys[0];
-            return;
-        }
-
-        //before first key
         //todo: wrap around
-        if(time<=keys[0]->time)
+        if(numKeys==1 || time<=keyTimes[0])
         {
             *firstKey = keys[0];
             return;
         }
 
-        //after last key
-        //todo: wrap around
-        if(time>=keys[numKeys-1]->time)
+        if(time>=keyTimes[numKeys-1])
         {
             *firstKey = keys[numKeys-1];
             return;
         }
 
-        //find first key and last key
-        for(size_t k = 0;k<keys.size();k++)
-        {
-            Key<T>* key = keys[k];
-
-            if(key->time<=time)
-                *firstKey = key;
-            else
-            {
-                *lastKey = key;
-                break;
-            }
-        }
-
+        int cursor = -1;
+        int k = findKeySegment(keyTimes, time, cursor);
+        *firstKey = keys[k];
+        *lastKey = keys[k+1];
     }
 
     void sortKeys()
     {
-        std::sort(keys.begin(),keys.end(),KeyCompare<T>);
+        std::stable_sort(keys.begin(),keys.end(),KeyCompare<T>);
+        updateSamples();
     }
 
     double getFirstKeyTime()
     {
         Q_ASSERT(keys.size()>0);
 
-        return keys.begin().time;
+        return keyTimes.first();
     }
 
     double getLastKeyTime()
     {
         Q_ASSERT(keys.size()>0);
 
-        return keys.end().time;
+        return keyTimes.last();
     }
 
     virtual ~KeyFrame()
@@ -264,6 +292,17 @@ public:
 
 protected:
     virtual T interpolate(T a,T b,float t)=0;
+
+private:
+    void updateSamples()
+    {
+        keyTimes.resize(keys.size());
+        keyValues.resize(keys.size());
+        for (int i = 0; i < keys.size(); i++) {
+            keyTimes[i] = keys[i]->time;
+            keyValues[i] = keys[i]->value;
+        }
+    }
 };
 
 
@@ -0,0 +1,240 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "assetloader.h"
+#include "texturefile.h"
+#include "../core/meshmanager.h"
+#include "../core/texturemanager.h"
+#include "../core/logger.h"
+#include "../core/performancetimer.h"
+#include "../graphics/mesh.h"
+#include "../graphics/texture2d.h"
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMutexLocker>
+#include <QtConcurrent>
+
+namespace iris
+{
+
+AssetLoader::AssetLoader()
+{
+    loadedCount = 0;
+    totalCount = 0;
+    meshLoadGeneration = 0;
+}
+
+AssetLoader* AssetLoader::getSingleton()
+{
+    static AssetLoader* instance = new AssetLoader();
+    return instance;
+}
+
+Texture2DPtr AssetLoader::loadTexture(const QString& path, bool flipY)
+{
+    auto textureManager = TextureManager::getSingleton();
+    auto cachedTexture = textureManager->findTexture(path, flipY);
+    if (!!cachedTexture)
+        return cachedTexture;
+
+    // checked here since the thread pool has no context
+    bool useCompression = textureManager->isCompressionSupported();
+
+    auto key = flipY ? path + ":flipped" : path;
+
+    QMutexLocker locker(&mutex);
+    if (pendingTextures.contains(key))
+        return pendingTextures[key];
+
+    QImage blank(1, 1, QImage::Format_RGBA8888);
+    blank.fill(Qt::white);
+
+    auto texture = Texture2D::create(blank);
+    texture->source = path;
+    pendingTextures.insert(key, texture);
+    totalCount++;
+    locker.unlock();
+
+    QtConcurrent::run([this, key, path, flipY, useCompression, texture]() {
+        IRIS_PROFILE("load texture");
+
+        // converted images are uploaded as is
+        TextureFileData data;
+        if (useCompression &&
+            TextureManager::getSingleton()->loadTextureFile(path, flipY, data)) {
+            queueUpload([this, key, path, flipY, data, texture](GraphicsDevicePtr device) {
+                Q_UNUSED(device);
+
+                texture->setData(data);
+                finishTexture(key, path, flipY, texture, true);
+            });
+            return;
+        }
+
+        QImage image(path);
+        if (image.isNull()) {
+            irisLog("error loading image: " + path);
+        } else {
+            if (flipY)
+                image = image.mirrored(false, true);
+
+            // QOpenGLTexture converts to this anyway, better here than on the gl thread
+            image = image.convertToFormat(QImage::Format_RGBA8888);
+        }
+
+        queueUpload([this, key, path, flipY, image, texture](GraphicsDevicePtr device) {
+            Q_UNUSED(device);
+
+            // the placeholder is kept if the image couldnt be loaded
+            if (!image.isNull())
+                texture->setImage(image);
+
+            finishTexture(key, path, flipY, texture, !image.isNull());
+        });
+    });
+
+    return texture;
+}
+
+void AssetLoader::loadMeshes(const QString& path, LoadedFunc onLoaded, MeshLoadFunc load)
+{
+    int generation;
+    {
+        QMutexLocker locker(&mutex);
+        totalCount++;
+        generation = meshLoadGeneration;
+    }
+
+    QtConcurrent::run([this, path, onLoaded, load, generation]() {
+        IRIS_PROFILE("load meshes");
+
+        QList<MeshPtr> meshes;
+        QMap<QString, SkeletalAnimationPtr> animations;
+
+        // the file is imported here instead of through the MeshManager so its
+        // cache is only touched from the gl thread once the meshes are ready
+        if (!isMeshLoadCancelled(generation)) {
+            if (load)
+                load(meshes, animations);
+            else
+                MeshManager::load(path, meshes, animations);
+        }
+
+        // meshes are uploaded one at a time so big files are spread over several frames
+        for (auto mesh : meshes) {
+            if (!mesh)
+                continue;
+
+            queueUpload([this, mesh, generation](GraphicsDevicePtr device) {
+                if (!isMeshLoadCancelled(generation))
+                    mesh->upload(device);
+            });
+        }
+
+        queueUpload([this, path, meshes, animations, onLoaded, generation](GraphicsDevicePtr device) {
+            Q_UNUSED(device);
+
+            if (!isMeshLoadCancelled(generation)) {
+                if (!meshes.isEmpty())
+                    MeshManager::getSingleton()->addMeshes(path, meshes, animations);
+
+                onLoaded();
+            }
+
+            finishLoad();
+        });
+    });
+}
+
+void AssetLoader::cancelMeshLoads()
+{
+    QMutexLocker locker(&mutex);
+    meshLoadGeneration++;
+}
+
+bool AssetLoader::isMeshLoadCancelled(int generation)
+{
+    QMutexLocker locker(&mutex);
+    return generation != meshLoadGeneration;
+}
+
+void AssetLoader::processUploads(GraphicsDevicePtr device, float budgetMs)
+{
+    IRIS_PROFILE_GPU("asset uploads", device);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    do {
+        UploadFunc upload;
+        {
+            QMutexLocker locker(&mutex);
+            if (uploads.isEmpty())
+                return;
+            upload = uploads.dequeue();
+        }
+
+        upload(device);
+    } while (timer.nsecsElapsed() < budgetMs * 1000000.0f);
+}
+
+bool AssetLoader::isLoading()
+{
+    QMutexLocker locker(&mutex);
+    return loadedCount < totalCount;
+}
+
+int AssetLoader::getLoadedCount()
+{
+    QMutexLocker locker(&mutex);
+    return loadedCount;
+}
+
+int AssetLoader::getTotalCount()
+{
+    QMutexLocker locker(&mutex);
+    return totalCount;
+}
+
+void AssetLoader::queueUpload(UploadFunc upload)
+{
+    QMutexLocker locker(&mutex);
+    uploads.enqueue(upload);
+}
+
+void AssetLoader::finishTexture(const QString& key, const QString& path, bool flipY,
+                                Texture2DPtr texture, bool loaded)
+{
+    {
+        QMutexLocker locker(&mutex);
+        pendingTextures.remove(key);
+    }
+
+    if (loaded)
+        TextureManager::getSingleton()->addTexture(path, flipY, texture);
+
+    finishLoad();
+}
+
+void AssetLoader::finishLoad()
+{
+    QMutexLocker locker(&mutex);
+    loadedCount++;
+
+    // progress starts over with the next batch of loads
+    if (loadedCount == totalCount) {
+        loadedCount = 0;
+        totalCount = 0;
+    }
+}
+
+}
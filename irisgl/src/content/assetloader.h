@@ -0,0 +1,109 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include "../irisglfwd.h"
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <functional>
+
+namespace iris
+{
+
+/**
+ * Loads meshes and textures in the background
+ *
+ * File reading, mesh parsing and image decoding run on the global thread pool.
+ * Everything that needs the GL context is queued instead and done a few items
+ * at a time by processUploads(), which the view calls every frame, so loading
+ * a big scene doesnt stall the gui.
+ * Textures are returned right away as placeholders that get their image once
+ * it's uploaded, and are shared through the TextureManager.
+ * Meshes are handed to a callback once they're on the gpu.
+ */
+class AssetLoader
+{
+public:
+    typedef std::function<void(QList<MeshPtr>& meshes,
+                                QMap<QString, SkeletalAnimationPtr>& animations)> MeshLoadFunc;
+    typedef std::function<void()> LoadedFunc;
+
+private:
+    typedef std::function<void(GraphicsDevicePtr device)> UploadFunc;
+
+    // filled from the thread pool, emptied on the gl thread
+    QQueue<UploadFunc> uploads;
+    QMutex mutex;
+
+    // textures still loading, so asking for one twice doesnt decode it twice
+    QHash<QString, Texture2DPtr> pendingTextures;
+
+    int loadedCount;
+    int totalCount;
+
+    // bumped by cancelMeshLoads(), loads started before it are dropped
+    int meshLoadGeneration;
+
+    AssetLoader();
+
+public:
+    static AssetLoader* getSingleton();
+
+    /**
+     * Returns a blank texture that gets the image once it's loaded
+     * Must be called with a current context
+     */
+    Texture2DPtr loadTexture(const QString& path, bool flipY = true);
+
+    /**
+     * Loads a model file's meshes in the background and adds them to the MeshManager
+     * load runs on the thread pool, it should fill meshes and animations and
+     * leave meshes empty if the file cant be loaded. If it isnt given the file
+     * is imported by the MeshManager.
+     * onLoaded is called from processUploads() once the meshes are uploaded
+     */
+    void loadMeshes(const QString& path, LoadedFunc onLoaded, MeshLoadFunc load = MeshLoadFunc());
+
+    /**
+     * Drops the mesh loads that are still in progress, their onLoaded isnt called
+     * Called when the scene they were loading for is closed
+     */
+    void cancelMeshLoads();
+
+    /**
+     * Does queued uploads until budgetMs is used up, at least one is done per call
+     * Must be called with a current context, usually once per frame
+     */
+    void processUploads(GraphicsDevicePtr device, float budgetMs = 4.0f);
+
+    bool isLoading();
+
+    // number of assets loaded and requested since the loader was last idle
+    int getLoadedCount();
+    int getTotalCount();
+
+private:
+    void queueUpload(UploadFunc upload);
+    void finishTexture(const QString& key, const QString& path, bool flipY,
+                       Texture2DPtr texture, bool loaded);
+    void finishLoad();
+    bool isMeshLoadCancelled(int generation);
+};
+
+}
+
+#endif // ASSETLOADER_H
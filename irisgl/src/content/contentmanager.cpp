@@ -4,6 +4,8 @@
 #include "../graphics/texture2d.h"
 #include "../graphics/font.h"
 #include "../graphics/shader.h"
+#include "../core/meshmanager.h"
+#include "../core/texturemanager.h"
 
 namespace iris
 {
@@ -15,12 +17,12 @@ ContentManager::ContentManager(GraphicsDevicePtr graphics)
 
 MeshPtr ContentManager::loadMesh(QString meshPath)
 {
-    return Mesh::loadMesh(meshPath);
+    return MeshManager::getSingleton()->getMesh(meshPath);
 }
 
 Texture2DPtr ContentManager::loadTexture(QString texturePath, bool flipY)
 {
-    return Texture2D::load(texturePath, flipY);
+    return TextureManager::getSingleton()->getTexture(texturePath, flipY);
 }
 
 FontPtr ContentManager::loadDefaultFont(int size)
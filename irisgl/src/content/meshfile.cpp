@@ -0,0 +1,414 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "meshfile.h"
+#include "../graphics/mesh.h"
+#include "../graphics/graphicsdevice.h"
+#include "../graphics/vertexlayout.h"
+#include "../graphics/skeleton.h"
+#include "../geometry/trimesh.h"
+#include "../animation/skeletalanimation.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+namespace iris
+{
+
+// "IMSH"
+static const quint32 MESH_FILE_MAGIC = 0x494D5348;
+static const quint32 MESH_FILE_VERSION = 2;
+
+// magic, version and header size
+static const qint64 MESH_FILE_PREFIX_SIZE = 12;
+
+// blobs are aligned so they can be read in place from the mapped file
+static const qint64 MESH_FILE_ALIGNMENT = 16;
+
+/*
+ * Layout:
+ * prefix, header (QDataStream), padding, blobs
+ *
+ * The header has everything but the vertex, index and bvh data, which are
+ * stored as blobs. Blob offsets are relative to the start of the blobs.
+ */
+
+static qint64 alignOffset(qint64 offset)
+{
+    return (offset + MESH_FILE_ALIGNMENT - 1) & ~(MESH_FILE_ALIGNMENT - 1);
+}
+
+// appends data to the blobs and writes its location to the header
+static void writeBlob(QDataStream& header, QByteArray& blobs, const void* data, qint64 size)
+{
+    blobs.append(QByteArray(alignOffset(blobs.size()) - blobs.size(), '\0'));
+    header << (quint64)blobs.size() << (quint64)size;
+    if (size > 0)
+        blobs.append((const char*)data, size);
+}
+
+// returns null if the blob isnt within the file
+static uchar* readBlob(QDataStream& header, uchar* blobs, qint64 blobsSize, qint64& size)
+{
+    quint64 offset, length;
+    header >> offset >> length;
+
+    if (header.status() != QDataStream::Ok ||
+        offset > (quint64)blobsSize ||
+        length > (quint64)blobsSize - offset)
+        return nullptr;
+
+    size = length;
+    return blobs + offset;
+}
+
+template<typename T>
+static bool readArrayBlob(QDataStream& header, uchar* blobs, qint64 blobsSize, QVector<T>& array)
+{
+    qint64 size;
+    auto data = readBlob(header, blobs, blobsSize, size);
+    if (data == nullptr || size % sizeof(T) != 0)
+        return false;
+
+    array.resize(size / sizeof(T));
+    memcpy(array.data(), data, size);
+    return true;
+}
+
+template<typename T>
+static void writeKeys(QDataStream& stream, KeyFrame<T>* keyFrame)
+{
+    stream << (qint32)keyFrame->keys.size();
+    for (auto key : keyFrame->keys)
+        stream << key->time << key->value;
+}
+
+template<typename T>
+static void readKeys(QDataStream& stream, KeyFrame<T>* keyFrame)
+{
+    qint32 count;
+    stream >> count;
+    if (stream.status() != QDataStream::Ok || count < 0)
+        return;
+
+    keyFrame->reserve(count);
+    for (int i = 0; i < count; i++) {
+        double time;
+        T value;
+        stream >> time >> value;
+        if (stream.status() != QDataStream::Ok)
+            return;
+
+        keyFrame->addKey(value, time);
+    }
+}
+
+bool MeshFile::save(const QString& path,
+                    const QList<MeshPtr>& meshes,
+                    const QMap<QString, SkeletalAnimationPtr>& animations,
+                    const QByteArray& sourceHash)
+{
+    QByteArray header;
+    QByteArray blobs;
+
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << sourceHash;
+    stream << (qint32)meshes.size();
+    for (auto& mesh : meshes) {
+        stream << (qint32)mesh->primitiveMode
+               << (qint32)mesh->numVerts
+               << (qint32)mesh->numFaces
+               << mesh->usesIndexBuffer;
+        stream << mesh->boundingSphere.pos << mesh->boundingSphere.radius;
+
+        stream << (qint32)mesh->vertexBuffers.size();
+        for (auto& vertexBuffer : mesh->vertexBuffers) {
+            auto attribs = vertexBuffer->vertexLayout.getAttribs();
+            stream << (qint32)attribs.size();
+            for (auto& attrib : attribs) {
+                stream << (qint32)attrib.usage
+                       << (qint32)attrib.type
+                       << (qint32)attrib.count
+                       << (qint32)attrib.sizeInBytes
+                       << attrib.normalized;
+            }
+
+            writeBlob(stream, blobs, vertexBuffer->data, vertexBuffer->dataSize);
+        }
+
+        stream << !!mesh->idxBuffer;
+        if (!!mesh->idxBuffer) {
+            stream << (quint32)mesh->idxBuffer->indexType;
+            writeBlob(stream, blobs, mesh->idxBuffer->data, mesh->idxBuffer->dataSize);
+        }
+
+        // picking data, the bvh is saved so it doesnt have to be rebuilt
+        auto triMesh = mesh->triMesh;
+        stream << !!triMesh;
+        if (!!triMesh) {
+            if (triMesh->bvhNodes.isEmpty())
+                triMesh->buildBvh();
+
+            writeBlob(stream, blobs, triMesh->triangles.constData(),
+                      triMesh->triangles.size() * sizeof(Triangle));
+            writeBlob(stream, blobs, triMesh->bvhNodes.constData(),
+                      triMesh->bvhNodes.size() * sizeof(TriMeshBvhNode));
+            writeBlob(stream, blobs, triMesh->bvhTriangles.constData(),
+                      triMesh->bvhTriangles.size() * sizeof(int));
+        }
+
+        auto skel = mesh->skeleton;
+        stream << !!skel;
+        if (!!skel) {
+            stream << (qint32)skel->bones.size();
+            for (auto& bone : skel->bones) {
+                int parent = -1;
+                if (!!bone->parentBone)
+                    parent = skel->boneMap.value(bone->parentBone->name, -1);
+
+                stream << bone->name << (qint32)parent;
+                stream << bone->inversePoseMatrix
+                       << bone->poseMatrix
+                       << bone->transformMatrix
+                       << bone->localMatrix;
+            }
+        }
+
+        // the mesh's animations are looked up by name in the file's animations
+        stream << QStringList(mesh->skeletalAnimations.keys());
+    }
+
+    stream << (qint32)animations.size();
+    for (auto iter = animations.begin(); iter != animations.end(); ++iter) {
+        auto anim = iter.value();
+        stream << iter.key() << anim->name << anim->source;
+
+        stream << (qint32)anim->boneAnimations.size();
+        for (auto boneIter = anim->boneAnimations.begin();
+             boneIter != anim->boneAnimations.end();
+             ++boneIter) {
+            stream << boneIter.key();
+            writeKeys(stream, boneIter.value()->posKeys.data());
+            writeKeys(stream, boneIter.value()->rotKeys.data());
+            writeKeys(stream, boneIter.value()->scaleKeys.data());
+        }
+    }
+
+    // written to a temp file first so a failed save doesnt leave a broken file
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream prefix(&file);
+    prefix << MESH_FILE_MAGIC << MESH_FILE_VERSION << (quint32)header.size();
+    file.write(header);
+
+    qint64 headerEnd = MESH_FILE_PREFIX_SIZE + header.size();
+    file.write(QByteArray(alignOffset(headerEnd) - headerEnd, '\0'));
+    file.write(blobs);
+
+    return file.commit();
+}
+
+bool MeshFile::load(const QString& path,
+                    QList<MeshPtr>& meshes,
+                    QMap<QString, SkeletalAnimationPtr>& animations,
+                    const QByteArray& sourceHash)
+{
+    // the buffers keep the file open (and mapped) for as long as they use it
+    auto file = QSharedPointer<QFile>(new QFile(path));
+    if (!file->open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 fileSize = file->size();
+    if (fileSize < MESH_FILE_PREFIX_SIZE)
+        return false;
+
+    auto mapped = file->map(0, fileSize);
+    if (mapped == nullptr)
+        return false;
+
+    auto prefixData = QByteArray::fromRawData((const char*)mapped, MESH_FILE_PREFIX_SIZE);
+    QDataStream prefix(prefixData);
+
+    quint32 magic, version, headerSize;
+    prefix >> magic >> version >> headerSize;
+    if (magic != MESH_FILE_MAGIC || version != MESH_FILE_VERSION)
+        return false;
+
+    qint64 blobsStart = alignOffset(MESH_FILE_PREFIX_SIZE + headerSize);
+    if (blobsStart > fileSize)
+        return false;
+
+    auto blobs = mapped + blobsStart;
+    qint64 blobsSize = fileSize - blobsStart;
+
+    auto headerData = QByteArray::fromRawData((const char*)mapped + MESH_FILE_PREFIX_SIZE,
+                                              headerSize);
+    QDataStream stream(headerData);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    QByteArray hash;
+    stream >> hash;
+    if (!sourceHash.isEmpty() && hash != sourceHash)
+        return false;
+
+    QList<MeshPtr> meshList;
+    QList<QStringList> meshAnimNames;
+
+    qint32 meshCount;
+    stream >> meshCount;
+    for (int m = 0; m < meshCount && stream.status() == QDataStream::Ok; m++) {
+        auto mesh = Mesh::create();
+
+        qint32 primitiveMode, numVerts, numFaces;
+        stream >> primitiveMode >> numVerts >> numFaces >> mesh->usesIndexBuffer;
+        stream >> mesh->boundingSphere.pos >> mesh->boundingSphere.radius;
+        mesh->setPrimitiveMode((PrimitiveMode)primitiveMode);
+        mesh->numVerts = numVerts;
+        mesh->numFaces = numFaces;
+
+        qint32 bufferCount;
+        stream >> bufferCount;
+        for (int b = 0; b < bufferCount && stream.status() == QDataStream::Ok; b++) {
+            VertexLayout layout;
+
+            qint32 attribCount;
+            stream >> attribCount;
+            for (int a = 0; a < attribCount && stream.status() == QDataStream::Ok; a++) {
+                qint32 usage, type, count, sizeInBytes;
+                bool normalized;
+                stream >> usage >> type >> count >> sizeInBytes >> normalized;
+                layout.addAttrib((VertexAttribUsage)usage, type, count, sizeInBytes, normalized);
+            }
+
+            qint64 size;
+            auto data = readBlob(stream, blobs, blobsSize, size);
+            if (data == nullptr)
+                return false;
+
+            auto vertexBuffer = VertexBuffer::create(layout);
+            vertexBuffer->setMappedData(file, data, size);
+            mesh->vertexBuffers.append(vertexBuffer);
+        }
+
+        bool hasIndexBuffer;
+        stream >> hasIndexBuffer;
+        if (hasIndexBuffer) {
+            quint32 indexType;
+            stream >> indexType;
+
+            qint64 size;
+            auto data = readBlob(stream, blobs, blobsSize, size);
+            if (data == nullptr)
+                return false;
+
+            mesh->idxBuffer = IndexBuffer::create();
+            mesh->idxBuffer->setMappedData(file, data, size);
+            mesh->idxBuffer->setIndexType(indexType);
+        }
+
+        bool hasTriMesh;
+        stream >> hasTriMesh;
+        if (hasTriMesh) {
+            auto triMesh = new TriMesh();
+            mesh->triMesh.reset(triMesh);
+
+            if (!readArrayBlob(stream, blobs, blobsSize, triMesh->triangles) ||
+                !readArrayBlob(stream, blobs, blobsSize, triMesh->bvhNodes) ||
+                !readArrayBlob(stream, blobs, blobsSize, triMesh->bvhTriangles))
+                return false;
+        }
+
+        bool hasSkeleton;
+        stream >> hasSkeleton;
+        if (hasSkeleton) {
+            auto skel = Skeleton::create();
+            QVector<int> parents;
+
+            qint32 boneCount;
+            stream >> boneCount;
+            for (int i = 0; i < boneCount && stream.status() == QDataStream::Ok; i++) {
+                QString name;
+                qint32 parent;
+                stream >> name >> parent;
+
+                auto bone = Bone::create(name);
+                stream >> bone->inversePoseMatrix
+                       >> bone->poseMatrix
+                       >> bone->transformMatrix
+                       >> bone->localMatrix;
+
+                skel->addBone(bone);
+                parents.append(parent);
+            }
+
+            for (int i = 0; i < parents.size(); i++) {
+                if (parents[i] >= 0 && parents[i] < skel->bones.size())
+                    skel->bones[parents[i]]->addChild(skel->bones[i]);
+            }
+
+            skel->updateHierarchy();
+            mesh->setSkeleton(skel);
+        }
+
+        QStringList animNames;
+        stream >> animNames;
+        meshAnimNames.append(animNames);
+
+        meshList.append(mesh);
+    }
+
+    QMap<QString, SkeletalAnimationPtr> animMap;
+
+    qint32 animCount;
+    stream >> animCount;
+    for (int i = 0; i < animCount && stream.status() == QDataStream::Ok; i++) {
+        auto anim = SkeletalAnimation::create();
+
+        QString key;
+        stream >> key >> anim->name >> anim->source;
+
+        qint32 boneCount;
+        stream >> boneCount;
+        for (int b = 0; b < boneCount && stream.status() == QDataStream::Ok; b++) {
+            QString boneName;
+            stream >> boneName;
+
+            auto boneAnim = new BoneAnimation();
+            readKeys(stream, boneAnim->posKeys.data());
+            readKeys(stream, boneAnim->rotKeys.data());
+            readKeys(stream, boneAnim->scaleKeys.data());
+            anim->addBoneAnimation(boneName, boneAnim);
+        }
+
+        animMap.insert(key, anim);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    for (int i = 0; i < meshList.size(); i++) {
+        for (auto& animName : meshAnimNames[i]) {
+            if (animMap.contains(animName))
+                meshList[i]->addSkeletalAnimation(animName, animMap[animName]);
+        }
+    }
+
+    meshes = meshList;
+    animations = animMap;
+    return true;
+}
+
+}
@@ -0,0 +1,53 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef MESHFILE_H
+#define MESHFILE_H
+
+#include "../irisglfwd.h"
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+namespace iris
+{
+
+/**
+ * Native binary format for the meshes and skeletal animations in a model file
+ *
+ * Meshes are stored in the layout they're rendered with, along with their
+ * bounds, skeleton and picking bvh, so loading them doesnt need an import.
+ * Vertex and index data is memory mapped and given to the buffers as is.
+ * Files keep the hash of the model they were converted from so they can be
+ * discarded when the model changes.
+ */
+class MeshFile
+{
+public:
+    static bool save(const QString& path,
+                     const QList<MeshPtr>& meshes,
+                     const QMap<QString, SkeletalAnimationPtr>& animations,
+                     const QByteArray& sourceHash);
+
+    /**
+     * Returns false if the file doesnt exist, was written by another version
+     * or if sourceHash is given and doesnt match the hash it was saved with
+     */
+    static bool load(const QString& path,
+                     QList<MeshPtr>& meshes,
+                     QMap<QString, SkeletalAnimationPtr>& animations,
+                     const QByteArray& sourceHash = QByteArray());
+};
+
+}
+
+#endif // MESHFILE_H
@@ -0,0 +1,181 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "texturefile.h"
+#include "../graphics/texturecompressor.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+#include <cstring>
+
+namespace iris
+{
+
+static const char KTX_IDENTIFIER[12] = {
+    '\xAB', 'K', 'T', 'X', ' ', '1', '1', '\xBB', '\r', '\n', '\x1A', '\n'
+};
+static const quint32 KTX_ENDIANNESS = 0x04030201;
+
+// from EXT_texture_compression_s3tc
+static const GLenum COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+static const GLenum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+
+qint64 TextureFileData::getSize() const
+{
+    qint64 size = 0;
+    for (auto& level : levels)
+        size += level.size();
+    return size;
+}
+
+// levels are padded to 4 bytes, block compressed ones never need it
+static int getPadding(quint32 size)
+{
+    return (4 - size % 4) % 4;
+}
+
+bool TextureFile::save(const QString& path, const TextureFileData& data)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    GLenum baseFormat = data.internalFormat == COMPRESSED_RGB_S3TC_DXT1 ? GL_RGB : GL_RGBA;
+
+    stream.writeRawData(KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+    stream << KTX_ENDIANNESS
+           << (quint32)0    // glType, 0 for compressed textures
+           << (quint32)1    // glTypeSize
+           << (quint32)0    // glFormat
+           << (quint32)data.internalFormat
+           << (quint32)baseFormat
+           << (quint32)data.width
+           << (quint32)data.height
+           << (quint32)0    // pixelDepth
+           << (quint32)0    // numberOfArrayElements
+           << (quint32)data.faceCount
+           << (quint32)data.levelCount
+           << (quint32)0;   // bytesOfKeyValueData
+
+    const char padding[4] = {0, 0, 0, 0};
+    for (int level = 0; level < data.levelCount; level++) {
+        // the size is of a single face
+        quint32 imageSize = data.getLevel(level).size();
+        stream << imageSize;
+
+        for (int face = 0; face < data.faceCount; face++) {
+            auto& bytes = data.getLevel(level, face);
+            stream.writeRawData(bytes.constData(), bytes.size());
+            stream.writeRawData(padding, getPadding(imageSize));
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+bool TextureFile::load(const QString& path, TextureFileData& data)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    char identifier[sizeof(KTX_IDENTIFIER)];
+    if (stream.readRawData(identifier, sizeof(identifier)) != sizeof(identifier) ||
+        memcmp(identifier, KTX_IDENTIFIER, sizeof(identifier)) != 0)
+        return false;
+
+    quint32 endianness, glType, glTypeSize, glFormat, internalFormat, baseFormat;
+    quint32 width, height, depth, arrayElements, faceCount, levelCount, keyValueSize;
+    stream >> endianness >> glType >> glTypeSize >> glFormat >> internalFormat >> baseFormat
+           >> width >> height >> depth >> arrayElements >> faceCount >> levelCount >> keyValueSize;
+
+    // big endian files, uncompressed formats, arrays and 3d textures arent supported
+    if (endianness != KTX_ENDIANNESS || glType != 0 || depth != 0 || arrayElements != 0)
+        return false;
+    if (faceCount != 1 && faceCount != 6)
+        return false;
+
+    // 0 means the levels are meant to be generated after loading
+    levelCount = qMax(levelCount, 1u);
+
+    stream.skipRawData(keyValueSize);
+
+    data.levels.clear();
+    data.levels.reserve(levelCount * faceCount);
+    for (quint32 level = 0; level < levelCount; level++) {
+        quint32 imageSize;
+        stream >> imageSize;
+
+        for (quint32 face = 0; face < faceCount; face++) {
+            QByteArray bytes(imageSize, Qt::Uninitialized);
+            if (stream.readRawData(bytes.data(), imageSize) != (int)imageSize)
+                return false;
+            stream.skipRawData(getPadding(imageSize));
+
+            data.levels.append(bytes);
+        }
+    }
+
+    data.internalFormat = internalFormat;
+    data.width = width;
+    data.height = height;
+    data.faceCount = faceCount;
+    data.levelCount = levelCount;
+
+    return stream.status() == QDataStream::Ok;
+}
+
+TextureFileData TextureFile::convert(const QImage& image)
+{
+    TextureFileData data;
+    if (image.isNull())
+        return data;
+
+    auto level = image.convertToFormat(QImage::Format_RGBA8888);
+    bool alpha = TextureCompressor::hasTransparency(level);
+
+    data.internalFormat = alpha ? COMPRESSED_RGBA_S3TC_DXT5 : COMPRESSED_RGB_S3TC_DXT1;
+    data.width = level.width();
+    data.height = level.height();
+    data.faceCount = 1;
+
+    while (true) {
+        data.levels.append(alpha ? TextureCompressor::compressBC3(level)
+                                 : TextureCompressor::compressBC1(level));
+
+        if (level.width() == 1 && level.height() == 1)
+            break;
+
+        // each level is filtered down from the one before it
+        level = level.scaled(qMax(1, level.width() / 2),
+                             qMax(1, level.height() / 2),
+                             Qt::IgnoreAspectRatio,
+                             Qt::SmoothTransformation);
+    }
+
+    data.levelCount = data.levels.size();
+    return data;
+}
+
+}
@@ -0,0 +1,78 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef TEXTUREFILE_H
+#define TEXTUREFILE_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+#include <QVector>
+#include <qopengl.h>
+
+namespace iris
+{
+
+/**
+ * Block compressed mip chain of a texture, or of each face of a cube map
+ */
+struct TextureFileData
+{
+    GLenum internalFormat;
+    int width;
+    int height;
+    int faceCount;
+    int levelCount;
+
+    // stored level by level like in ktx files, at [level * faceCount + face]
+    QVector<QByteArray> levels;
+
+    TextureFileData()
+    {
+        internalFormat = 0;
+        width = 0;
+        height = 0;
+        faceCount = 0;
+        levelCount = 0;
+    }
+
+    const QByteArray& getLevel(int level, int face = 0) const
+    {
+        return levels[level * faceCount + face];
+    }
+
+    qint64 getSize() const;
+};
+
+/**
+ * Reads and writes textures as KTX 1.1 files
+ *
+ * Only block compressed textures are supported, so loading one is just
+ * reading it and handing the levels to the gpu.
+ */
+class TextureFile
+{
+public:
+    static bool save(const QString& path, const TextureFileData& data);
+
+    // returns false if the file doesnt exist or isnt a compressed ktx file
+    static bool load(const QString& path, TextureFileData& data);
+
+    /**
+     * Builds the image's mip chain and compresses each level
+     * BC1 is used for opaque images and BC3 for ones with transparency
+     */
+    static TextureFileData convert(const QImage& image);
+};
+
+}
+
+#endif // TEXTUREFILE_H
@@ -13,7 +13,9 @@ For more information see the LICENSE file
 #define IRISUTILS_H
 
 #include <QDir>
+#include <QFile>
 #include <QCoreApplication>
+#include <QCryptographicHash>
 
 #ifdef Q_OS_WIN32
     #include <Windows.h>
@@ -45,6 +47,17 @@ public:
         QDir dirToRemove(path);
         return dirToRemove.removeRecursively();
     }
+
+    // sha1 of a file's contents, empty if it cant be read
+    static QByteArray hashFile(const QString &path) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return QByteArray();
+
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(&file);
+        return hash.result();
+    }
 };
 
 #endif // IRISUTILS_H
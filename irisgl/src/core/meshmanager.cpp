@@ -0,0 +1,280 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "meshmanager.h"
+#include "../graphics/mesh.h"
+#include "../graphics/graphicshelper.h"
+
+#include <QFile>
+#include <QMutexLocker>
+
+#include "assimp/Importer.hpp"
+#include "assimp/postprocess.h"
+
+namespace iris
+{
+
+MeshManager::MeshManager()
+{
+    useCounter = 0;
+    memoryBudget = 256 * 1024 * 1024;
+}
+
+MeshManager* MeshManager::getSingleton()
+{
+    static MeshManager* instance = new MeshManager();
+    return instance;
+}
+
+MeshPtr MeshManager::getMesh(const QString& path, int index)
+{
+    QList<MeshPtr> meshes;
+    QMap<QString, SkeletalAnimationPtr> animations;
+    if (!acquire(path, meshes, animations))
+        return MeshPtr();
+
+    if (index < 0 || index >= meshes.size())
+        return MeshPtr();
+
+    return share(meshes[index]);
+}
+
+QList<MeshPtr> MeshManager::getMeshes(const QString& path)
+{
+    QList<MeshPtr> meshes;
+    QMap<QString, SkeletalAnimationPtr> animations;
+    if (!acquire(path, meshes, animations))
+        return meshes;
+
+    for (int i = 0; i < meshes.size(); i++)
+        meshes[i] = share(meshes[i]);
+
+    return meshes;
+}
+
+QMap<QString, SkeletalAnimationPtr> MeshManager::getSkeletalAnimations(const QString& path)
+{
+    QList<MeshPtr> meshes;
+    QMap<QString, SkeletalAnimationPtr> animations;
+    acquire(path, meshes, animations);
+
+    return animations;
+}
+
+void MeshManager::addMeshes(const QString& path,
+                            const QList<MeshPtr>& meshes,
+                            const QMap<QString, SkeletalAnimationPtr>& animations)
+{
+    QMutexLocker locker(&mutex);
+    insert(path, meshes, animations);
+    evict();
+}
+
+bool MeshManager::contains(const QString& path)
+{
+    QMutexLocker locker(&mutex);
+
+    auto iter = entries.find(path);
+    return iter != entries.end() && isCached(iter.value());
+}
+
+void MeshManager::remove(const QString& path)
+{
+    QMutexLocker locker(&mutex);
+    entries.remove(path);
+}
+
+void MeshManager::clear()
+{
+    QMutexLocker locker(&mutex);
+    entries.clear();
+}
+
+qint64 MeshManager::getMemoryUsage()
+{
+    QMutexLocker locker(&mutex);
+
+    qint64 usage = 0;
+    for (auto& entry : entries) {
+        if (isCached(entry))
+            usage += entry.memoryUsage;
+    }
+
+    return usage;
+}
+
+qint64 MeshManager::getMemoryBudget() const
+{
+    return memoryBudget;
+}
+
+void MeshManager::setMemoryBudget(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    memoryBudget = bytes;
+    evict();
+}
+
+void MeshManager::collectGarbage()
+{
+    QMutexLocker locker(&mutex);
+    evict();
+}
+
+bool MeshManager::isCached(const CacheEntry& entry) const
+{
+    for (auto& mesh : entry.meshes) {
+        if (mesh.isNull())
+            return false;
+    }
+
+    return true;
+}
+
+MeshPtr MeshManager::share(const MeshPtr& mesh)
+{
+    if (!!mesh && mesh->hasSkeleton())
+        return mesh->createInstance();
+
+    return mesh;
+}
+
+bool MeshManager::findCached(const QString& path,
+                             QList<MeshPtr>& meshes,
+                             QMap<QString, SkeletalAnimationPtr>& animations)
+{
+    auto iter = entries.find(path);
+    if (iter == entries.end() || !isCached(iter.value()))
+        return false;
+
+    auto& entry = iter.value();
+    entry.lastUsed = ++useCounter;
+
+    meshes.clear();
+    for (auto& mesh : entry.meshes)
+        meshes.append(mesh.toStrongRef());
+    animations = entry.animations;
+
+    return true;
+}
+
+bool MeshManager::acquire(const QString& path,
+                          QList<MeshPtr>& meshes,
+                          QMap<QString, SkeletalAnimationPtr>& animations)
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (findCached(path, meshes, animations))
+            return true;
+    }
+
+    // importing can take a while so it's done without holding the lock
+    if (!load(path, meshes, animations))
+        return false;
+
+    QMutexLocker locker(&mutex);
+
+    // another thread may have imported the same file in the meantime,
+    // its meshes are used instead so they stay shared
+    if (!findCached(path, meshes, animations)) {
+        insert(path, meshes, animations);
+        evict();
+    }
+
+    return true;
+}
+
+void MeshManager::insert(const QString& path,
+                         const QList<MeshPtr>& meshes,
+                         const QMap<QString, SkeletalAnimationPtr>& animations)
+{
+    CacheEntry entry;
+    entry.animations = animations;
+    entry.retainedMeshes = meshes;
+    entry.memoryUsage = 0;
+    entry.lastUsed = ++useCounter;
+
+    for (auto mesh : meshes) {
+        entry.meshes.append(mesh.toWeakRef());
+        entry.memoryUsage += mesh->getMemoryUsage();
+    }
+
+    entries.insert(path, entry);
+}
+
+bool MeshManager::load(const QString& path,
+                       QList<MeshPtr>& meshes,
+                       QMap<QString, SkeletalAnimationPtr>& animations)
+{
+    Assimp::Importer importer;
+    const aiScene *scene;
+
+    if (path.startsWith(":") || path.startsWith("qrc:")) {
+        // loads mesh from resource
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        auto data = file.readAll();
+        scene = importer.ReadFileFromMemory((void*)data.data(),
+                                            data.length(),
+                                            aiProcessPreset_TargetRealtime_Fast);
+    } else {
+        scene = importer.ReadFile(path.toStdString().c_str(),
+                                  aiProcessPreset_TargetRealtime_Fast);
+    }
+
+    if (scene == nullptr || scene->mNumMeshes == 0)
+        return false;
+
+    meshes = GraphicsHelper::loadAllMeshesFromAssimpScene(scene);
+    animations = Mesh::extractAnimations(scene, path);
+
+    // Mesh::loadMesh() attaches the file's animations to the first mesh
+    for (auto animName : animations.keys())
+        meshes[0]->addSkeletalAnimation(animName, animations[animName]);
+
+    return true;
+}
+
+void MeshManager::evict()
+{
+    qint64 retainedMemory = 0;
+
+    for (auto iter = entries.begin(); iter != entries.end();) {
+        auto& entry = iter.value();
+        if (entry.retainedMeshes.isEmpty() && !isCached(entry)) {
+            iter = entries.erase(iter);
+            continue;
+        }
+
+        if (!entry.retainedMeshes.isEmpty())
+            retainedMemory += entry.memoryUsage;
+        ++iter;
+    }
+
+    while (retainedMemory > memoryBudget) {
+        CacheEntry* oldest = nullptr;
+        for (auto& entry : entries) {
+            if (!entry.retainedMeshes.isEmpty() &&
+                (oldest == nullptr || entry.lastUsed < oldest->lastUsed))
+                oldest = &entry;
+        }
+
+        if (oldest == nullptr)
+            break;
+
+        // the meshes stay cached if they're still used elsewhere
+        oldest->retainedMeshes.clear();
+        retainedMemory -= oldest->memoryUsage;
+    }
+}
+
+}
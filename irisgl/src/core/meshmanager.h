@@ -12,11 +12,122 @@ For more information see the LICENSE file
 #ifndef MESHMANAGER_H
 #define MESHMANAGER_H
 
+#include "../irisglfwd.h"
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QWeakPointer>
 
+namespace iris
+{
+
+/**
+ * Cache of the meshes and skeletal animations loaded from model files
+ *
+ * Files are imported once and their meshes (along with their GPU buffers)
+ * are shared by everything that asks for them. The cache only holds weak
+ * references to meshes, so a file stays cached for as long as any of its
+ * meshes is in use. Recently used files are also kept alive after they're
+ * no longer used until the cache goes over its memory budget, at which point
+ * the least recently used ones are released.
+ *
+ * Skinned meshes are posed per node, so they're returned as instances that
+ * share the cached mesh's buffers but have their own skeleton.
+ */
 class MeshManager
 {
+    struct CacheEntry
+    {
+        QList<QWeakPointer<Mesh>> meshes;
+        QMap<QString, SkeletalAnimationPtr> animations;
+
+        // keeps the meshes alive when nothing else uses them
+        QList<MeshPtr> retainedMeshes;
+
+        qint64 memoryUsage;
+        quint64 lastUsed;
+    };
+
+    QHash<QString, CacheEntry> entries;
+    quint64 useCounter;
+    qint64 memoryBudget;
+    QMutex mutex;
+
+    MeshManager();
+
 public:
-    void AddMesh();
+    static MeshManager* getSingleton();
+
+    /**
+     * Returns the mesh at index in the model file at path
+     * The file is only imported if it isnt already cached
+     * Returns null if the file or mesh doesnt exist
+     */
+    MeshPtr getMesh(const QString& path, int index = 0);
+    QList<MeshPtr> getMeshes(const QString& path);
+    QMap<QString, SkeletalAnimationPtr> getSkeletalAnimations(const QString& path);
+
+    /**
+     * Caches meshes that were loaded elsewhere, such as by the asset manager
+     */
+    void addMeshes(const QString& path,
+                   const QList<MeshPtr>& meshes,
+                   const QMap<QString, SkeletalAnimationPtr>& animations);
+
+    // returns true if all of the file's meshes are cached
+    bool contains(const QString& path);
+
+    /**
+     * Removes the file from the cache so it's imported again the next time it's used
+     * Meshes that are still in use aren't affected
+     */
+    void remove(const QString& path);
+    void clear();
+
+    // memory used by the cached meshes' buffers, in bytes
+    qint64 getMemoryUsage();
+
+    qint64 getMemoryBudget() const;
+    void setMemoryBudget(qint64 bytes);
+
+    /**
+     * Forgets files whose meshes were all freed and releases the least recently
+     * used files until the memory usage of the ones kept alive is within budget
+     */
+    void collectGarbage();
+
+    /**
+     * Imports the file without touching the cache, safe to call from any thread
+     * The meshes can be cached with addMeshes() once they're ready
+     */
+    static bool load(const QString& path,
+                     QList<MeshPtr>& meshes,
+                     QMap<QString, SkeletalAnimationPtr>& animations);
+
+private:
+    bool isCached(const CacheEntry& entry) const;
+
+    // skinned meshes are handed out as instances with their own skeleton
+    static MeshPtr share(const MeshPtr& mesh);
+
+    // these expect the lock to be held
+    bool findCached(const QString& path,
+                    QList<MeshPtr>& meshes,
+                    QMap<QString, SkeletalAnimationPtr>& animations);
+    void insert(const QString& path,
+                const QList<MeshPtr>& meshes,
+                const QMap<QString, SkeletalAnimationPtr>& animations);
+    void evict();
+
+    /**
+     * Gets the file's meshes from the cache, importing the file if it isnt cached
+     * The returned meshes are strong refs so they cant be evicted while in use
+     */
+    bool acquire(const QString& path,
+                 QList<MeshPtr>& meshes,
+                 QMap<QString, SkeletalAnimationPtr>& animations);
 };
 
+}
+
 #endif // MESHMANAGER_H
@@ -0,0 +1,366 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "performancetimer.h"
+#include "../graphics/gputimer.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+#include <algorithm>
+#include <cstring>
+
+namespace iris
+{
+
+PerformanceTimer::PerformanceTimer()
+{
+    timer.start();
+    enabled = 0;
+
+    gpuEvents.resize(EVENT_CAPACITY);
+    gpuEventHead = 0;
+
+    frameThread = nullptr;
+    frameHead = 0;
+    frameStart = 0;
+}
+
+PerformanceTimer* PerformanceTimer::getSingleton()
+{
+    // zones are opened from worker threads too, function statics are
+    // only initialized once even if several threads get here first
+    static PerformanceTimer* instance = new PerformanceTimer();
+    return instance;
+}
+
+void PerformanceTimer::setEnabled(bool enabled)
+{
+    this->enabled = enabled ? 1 : 0;
+}
+
+bool PerformanceTimer::isEnabled() const
+{
+    return enabled.load() != 0;
+}
+
+qint64 PerformanceTimer::now() const
+{
+    return timer.nsecsElapsed();
+}
+
+qint64 PerformanceTimer::beginZone()
+{
+    getThreadBuffer()->depth++;
+    return now();
+}
+
+void PerformanceTimer::endZone(const char* name, qint64 start)
+{
+    auto buffer = getThreadBuffer();
+    buffer->depth = qMax(0, buffer->depth - 1);
+
+    quint32 head = buffer->head.load();
+    auto& event = buffer->events[head & (EVENT_CAPACITY - 1)];
+    event.name = name;
+    event.start = start;
+    event.end = now();
+    event.depth = buffer->depth;
+
+    // readers only look at events before the head
+    buffer->head.storeRelease(head + 1);
+}
+
+void PerformanceTimer::beginFrame()
+{
+    frameThread = nullptr;
+    if (!isEnabled())
+        return;
+
+    frameThread = getThreadBuffer();
+    frameHead = frameThread->head.load();
+    frameStart = beginZone();
+}
+
+void PerformanceTimer::endFrame()
+{
+    if (frameThread == nullptr || frameThread != getThreadBuffer())
+        return;
+
+    endZone("frame", frameStart);
+
+    // the frame's events are all in this thread's buffer so they can be read directly
+    quint32 head = frameThread->head.load();
+    quint32 count = qMin(head - frameHead, (quint32)EVENT_CAPACITY);
+
+    QVector<ProfileEvent> events;
+    events.reserve(count);
+    for (quint32 i = head - count; i != head; i++)
+        events.append(frameThread->events[i & (EVENT_CAPACITY - 1)]);
+
+    std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+        return a.start < b.start;
+    });
+
+    QVector<ProfileZoneTime> zones;
+    for (auto& event : events)
+        addZoneTime(zones, event, false);
+
+    QMutexLocker locker(&mutex);
+    frameZones = zones;
+    frameThread = nullptr;
+}
+
+void PerformanceTimer::addGpuEvents(const QVector<ProfileEvent>& events)
+{
+    auto sortedEvents = events;
+    std::sort(sortedEvents.begin(), sortedEvents.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+        return a.start < b.start;
+    });
+
+    QVector<ProfileZoneTime> zones;
+    for (auto& event : sortedEvents)
+        addZoneTime(zones, event, true);
+
+    QMutexLocker locker(&mutex);
+    for (auto& event : sortedEvents)
+        gpuEvents[gpuEventHead++ & (EVENT_CAPACITY - 1)] = event;
+
+    gpuFrameZones = zones;
+}
+
+QVector<ProfileZoneTime> PerformanceTimer::getFrameZones()
+{
+    QMutexLocker locker(&mutex);
+
+    // gpu times are from a few frames back, they're matched to the cpu zones by name
+    auto zones = frameZones;
+    for (auto& gpuZone : gpuFrameZones) {
+        bool found = false;
+        for (auto& zone : zones) {
+            if (strcmp(zone.name, gpuZone.name) == 0) {
+                zone.gpuMs = gpuZone.gpuMs;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+            zones.append(gpuZone);
+    }
+
+    return zones;
+}
+
+bool PerformanceTimer::exportChromeTrace(const QString& path)
+{
+    QVector<ThreadBuffer*> buffers;
+    QVector<ProfileEvent> gpuTrace;
+    {
+        QMutexLocker locker(&mutex);
+        buffers = threadBuffers;
+
+        quint32 count = qMin(gpuEventHead, (quint32)EVENT_CAPACITY);
+        for (quint32 i = gpuEventHead - count; i != gpuEventHead; i++)
+            gpuTrace.append(gpuEvents[i & (EVENT_CAPACITY - 1)]);
+    }
+
+    QJsonArray traceEvents;
+
+    auto addThread = [&traceEvents](int tid, const QString& name) {
+        QJsonObject args;
+        args["name"] = name;
+
+        QJsonObject meta;
+        meta["name"] = "thread_name";
+        meta["ph"] = "M";
+        meta["pid"] = 1;
+        meta["tid"] = tid;
+        meta["args"] = args;
+        traceEvents.append(meta);
+    };
+
+    auto addEvents = [&traceEvents](int tid, const QVector<ProfileEvent>& events) {
+        for (auto& event : events) {
+            QJsonObject traceEvent;
+            traceEvent["name"] = QString::fromUtf8(event.name);
+            traceEvent["ph"] = "X";
+            traceEvent["pid"] = 1;
+            traceEvent["tid"] = tid;
+            // in microseconds
+            traceEvent["ts"] = event.start / 1000.0;
+            traceEvent["dur"] = (event.end - event.start) / 1000.0;
+            traceEvents.append(traceEvent);
+        }
+    };
+
+    for (auto buffer : buffers) {
+        QVector<ProfileEvent> events;
+        copyEvents(buffer, events);
+
+        addThread(buffer->threadId, buffer->threadName);
+        addEvents(buffer->threadId, events);
+    }
+
+    int gpuThreadId = buffers.size() + 1;
+    addThread(gpuThreadId, "GPU");
+    addEvents(gpuThreadId, gpuTrace);
+
+    QJsonObject trace;
+    trace["traceEvents"] = traceEvents;
+    trace["displayTimeUnit"] = "ms";
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+void PerformanceTimer::report()
+{
+    qDebug() << "=======================";
+    for (auto& zone : getFrameZones()) {
+        qDebug() << QString(zone.depth * 2, ' ') + zone.name << ": "
+                 << zone.cpuMs << "ms cpu" << zone.gpuMs << "ms gpu";
+    }
+    qDebug() << "=======================";
+}
+
+const char* PerformanceTimer::intern(const QString& name)
+{
+    QMutexLocker locker(&mutex);
+
+    // the set's strings are never modified so their data stays where it is
+    auto iter = names.insert(name.toUtf8());
+    return iter->constData();
+}
+
+PerformanceTimer::ThreadBuffer* PerformanceTimer::getThreadBuffer()
+{
+    static thread_local ThreadBuffer* threadBuffer = nullptr;
+    if (threadBuffer != nullptr)
+        return threadBuffer;
+
+    auto buffer = new ThreadBuffer();
+    buffer->head = 0;
+    buffer->depth = 0;
+
+    auto thread = QThread::currentThread();
+    if (!thread->objectName().isEmpty())
+        buffer->threadName = thread->objectName();
+    else if (QCoreApplication::instance() && QCoreApplication::instance()->thread() == thread)
+        buffer->threadName = "main";
+
+    // buffers are kept after their thread ends so their events can still be exported
+    QMutexLocker locker(&mutex);
+    buffer->threadId = threadBuffers.size() + 1;
+    if (buffer->threadName.isEmpty())
+        buffer->threadName = QString("thread %1").arg(buffer->threadId);
+    threadBuffers.append(buffer);
+
+    threadBuffer = buffer;
+    return buffer;
+}
+
+void PerformanceTimer::copyEvents(ThreadBuffer* buffer, QVector<ProfileEvent>& events)
+{
+    quint32 head = buffer->head.loadAcquire();
+    quint32 count = qMin(head, (quint32)EVENT_CAPACITY);
+    quint32 first = head - count;
+
+    events.clear();
+    events.reserve(count);
+    for (quint32 i = first; i != head; i++)
+        events.append(buffer->events[i & (EVENT_CAPACITY - 1)]);
+
+    // the owning thread could have overwritten the oldest ones while they were copied
+    // the slot of the event at newHead is being written as well
+    quint32 newHead = buffer->head.loadAcquire();
+    int overwritten = (int)(newHead - first) - EVENT_CAPACITY + 1;
+    if (overwritten > 0)
+        events.remove(0, qMin(overwritten, (int)count));
+}
+
+void PerformanceTimer::addZoneTime(QVector<ProfileZoneTime>& zones, const ProfileEvent& event, bool gpu)
+{
+    float ms = (event.end - event.start) / (1000.0f * 1000.0f);
+
+    for (auto& zone : zones) {
+        if (zone.depth == event.depth && strcmp(zone.name, event.name) == 0) {
+            zone.count++;
+            if (gpu)
+                zone.gpuMs += ms;
+            else
+                zone.cpuMs += ms;
+            return;
+        }
+    }
+
+    ProfileZoneTime zone;
+    zone.name = event.name;
+    zone.depth = event.depth;
+    zone.count = 1;
+    zone.cpuMs = gpu ? -1 : ms;
+    zone.gpuMs = gpu ? ms : -1;
+    zones.append(zone);
+}
+
+ProfileZone::ProfileZone(const char* name, GpuTimer* gpuTimer)
+{
+    this->name = name;
+    this->gpuTimer = gpuTimer;
+    begin();
+}
+
+ProfileZone::~ProfileZone()
+{
+    end();
+}
+
+void ProfileZone::restart(const char* name)
+{
+    end();
+    this->name = name;
+    begin();
+}
+
+void ProfileZone::begin()
+{
+    auto timer = PerformanceTimer::getSingleton();
+    active = timer->isEnabled();
+    if (!active)
+        return;
+
+    start = timer->beginZone();
+    if (gpuTimer)
+        gpuTimer->begin(name);
+}
+
+void ProfileZone::end()
+{
+    if (!active)
+        return;
+
+    if (gpuTimer)
+        gpuTimer->end();
+    PerformanceTimer::getSingleton()->endZone(name, start);
+    active = false;
+}
+
+}
@@ -1,51 +1,180 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
 #ifndef PERFORMANCETIMER_H
 #define PERFORMANCETIMER_H
 
+#include <QAtomicInteger>
 #include <QElapsedTimer>
-#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QVector>
 
 namespace iris {
 
+class GpuTimer;
+
+struct ProfileEvent
+{
+    // zone names are never copied, they should be literals or interned
+    const char* name;
+
+    // nanoseconds since the timer was created
+    qint64 start;
+    qint64 end;
+
+    // how many zones this one is nested in
+    int depth;
+};
+
+// total time spent in a zone during the last frame
+struct ProfileZoneTime
+{
+    const char* name;
+    int depth;
+    int count;
+
+    // -1 if the zone wasnt timed on the cpu or gpu
+    float cpuMs;
+    float gpuMs;
+};
+
+/**
+ * Frame profiler
+ *
+ * Zones are timed with ProfileZone (or the IRIS_PROFILE macros) from any
+ * thread. Each thread writes its finished zones to its own ring buffer so
+ * timing a zone never takes a lock. Zones given a GpuTimer are also timed
+ * on the gpu and their results are added once the queries are ready.
+ *
+ * The gl thread marks frames with beginFrame() and endFrame(), the times of
+ * the last frame are given by getFrameZones(). Everything still in the ring
+ * buffers can be saved with exportChromeTrace() and viewed in chrome://tracing
+ */
 class PerformanceTimer
 {
-public:
-    QElapsedTimer timer;
-    QMap<QString, qint64> startTimes;
-    QMap<QString, qint64> endTimes;
+    // must be a power of two
+    static const int EVENT_CAPACITY = 8192;
 
-    PerformanceTimer()
+    struct ThreadBuffer
     {
-        reset();
-    }
+        ProfileEvent events[EVENT_CAPACITY];
 
-    void start(QString name)
-    {
-        startTimes.insert(name, timer.nsecsElapsed());
-    }
+        // number of events ever written, only the owning thread changes it
+        QAtomicInteger<quint32> head;
 
-    void end(QString name)
-    {
-        endTimes.insert(name, timer.nsecsElapsed());
-    }
+        int depth;
+        int threadId;
+        QString threadName;
+    };
 
-    void reset()
-    {
-        startTimes.clear();
-        endTimes.clear();
-        timer.restart();
-    }
+    QElapsedTimer timer;
+    QAtomicInteger<int> enabled;
 
-    void report()
-    {
-        qDebug() << "=======================";
-        for( auto key : endTimes.keys()) {
-            auto diff = endTimes[key] - startTimes[key];
-            auto time = diff /(1000.0f * 1000.0f * 1000.0f);
-            qDebug() << key << ": "<<time<<"s";
-        }
-        qDebug() << "=======================";
-    }
+    // guards the list of buffers, the gpu events and the interned names
+    QMutex mutex;
+    QVector<ThreadBuffer*> threadBuffers;
+
+    QVector<ProfileEvent> gpuEvents;
+    quint32 gpuEventHead;
+    QVector<ProfileZoneTime> gpuFrameZones;
+
+    QSet<QByteArray> names;
+
+    // frames are only timed on the thread that began them
+    ThreadBuffer* frameThread;
+    quint32 frameHead;
+    qint64 frameStart;
+    QVector<ProfileZoneTime> frameZones;
+
+    PerformanceTimer();
+
+public:
+    static PerformanceTimer* getSingleton();
+
+    // zones arent recorded while disabled, it's disabled by default
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // nanoseconds since the timer was created
+    qint64 now() const;
+
+    // returns the start time to pass to endZone()
+    qint64 beginZone();
+    void endZone(const char* name, qint64 start);
+
+    void beginFrame();
+    void endFrame();
+
+    /**
+     * Adds the zones of a frame timed on the gpu, already converted to cpu time
+     * Called by the GpuTimer once its queries are ready
+     */
+    void addGpuEvents(const QVector<ProfileEvent>& events);
+
+    // the zones of the last frame summed by name, in the order they started
+    QVector<ProfileZoneTime> getFrameZones();
+
+    /**
+     * Saves the recorded zones in the chrome trace event format
+     * Gpu zones are shown as their own thread
+     */
+    bool exportChromeTrace(const QString& path);
+
+    // prints the last frame's zones
+    void report();
+
+    /**
+     * Returns a copy of name that lives as long as the timer, for naming zones
+     * with strings that arent literals
+     */
+    const char* intern(const QString& name);
+
+private:
+    ThreadBuffer* getThreadBuffer();
+    static void copyEvents(ThreadBuffer* buffer, QVector<ProfileEvent>& events);
+    static void addZoneTime(QVector<ProfileZoneTime>& zones, const ProfileEvent& event, bool gpu);
+};
+
+/**
+ * Times the scope it's declared in, on the gpu as well if gpuTimer is given
+ */
+class ProfileZone
+{
+    const char* name;
+    qint64 start;
+    GpuTimer* gpuTimer;
+    bool active;
+
+public:
+    explicit ProfileZone(const char* name, GpuTimer* gpuTimer = nullptr);
+    ~ProfileZone();
+
+    // ends the zone and starts another one in its place
+    void restart(const char* name);
+
+private:
+    void begin();
+    void end();
 };
 
 }
+
+#define IRIS_PROFILE_CONCAT_(a, b) a##b
+#define IRIS_PROFILE_CONCAT(a, b) IRIS_PROFILE_CONCAT_(a, b)
+
+#define IRIS_PROFILE(name) \
+    iris::ProfileZone IRIS_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define IRIS_PROFILE_GPU(name, device) \
+    iris::ProfileZone IRIS_PROFILE_CONCAT(profileZone, __LINE__)(name, (device)->getGpuTimer())
+
 #endif // PERFORMANCETIMER_H
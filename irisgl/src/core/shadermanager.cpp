@@ -0,0 +1,197 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "shadermanager.h"
+#include "../graphics/shader.h"
+#include "../graphics/graphicshelper.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+namespace iris
+{
+
+// "IRPB", followed by a version number
+static const quint32 PROGRAM_BINARY_MAGIC = 0x42505249;
+static const quint32 PROGRAM_BINARY_VERSION = 1;
+
+ShaderManager::ShaderManager()
+{
+
+}
+
+ShaderManager* ShaderManager::getSingleton()
+{
+    static ShaderManager* instance = new ShaderManager();
+    return instance;
+}
+
+ShaderPtr ShaderManager::load(const QString& vertexShaderFile, const QString& fragmentShaderFile)
+{
+    return getShader(loadSource(vertexShaderFile), loadSource(fragmentShaderFile));
+}
+
+ShaderPtr ShaderManager::getShader(const QString& vertexShader, const QString& fragmentShader)
+{
+    auto key = Shader::hashSource(vertexShader, fragmentShader) +
+               QByteArray::number((quintptr)QThread::currentThread());
+
+    QMutexLocker locker(&mutex);
+
+    auto shader = shaders.value(key).toStrongRef();
+    if (!!shader)
+        return shader;
+
+    // forget the shaders that were freed
+    for (auto iter = shaders.begin(); iter != shaders.end();) {
+        if (iter.value().isNull())
+            iter = shaders.erase(iter);
+        else
+            iter++;
+    }
+
+    shader = Shader::create(vertexShader, fragmentShader);
+    shaders.insert(key, shader.toWeakRef());
+
+    return shader;
+}
+
+bool ShaderManager::SourceEntry::isUpToDate() const
+{
+    for (int i = 0; i < files.size(); i++) {
+        if (QFileInfo(files[i]).lastModified() != lastModified[i])
+            return false;
+    }
+    return true;
+}
+
+QString ShaderManager::loadSource(const QString& path)
+{
+    SourceEntry entry;
+    bool cached;
+    {
+        QMutexLocker locker(&mutex);
+        cached = sources.contains(path);
+        if (cached)
+            entry = sources.value(path);
+    }
+
+    // checked without holding the lock since it touches the disk
+    if (cached && entry.isUpToDate())
+        return entry.source;
+
+    entry.files.clear();
+    entry.lastModified.clear();
+    entry.files.append(path);
+    entry.lastModified.append(QFileInfo(path).lastModified());
+
+    QStringList includes;
+    entry.source = GraphicsHelper::loadAndProcessShader(path, &includes);
+    for (auto& include : includes) {
+        entry.files.append(include);
+        entry.lastModified.append(QFileInfo(include).lastModified());
+    }
+
+    QMutexLocker locker(&mutex);
+    sources.insert(path, entry);
+
+    return entry.source;
+}
+
+void ShaderManager::setCacheFolder(const QString& folder)
+{
+    QMutexLocker locker(&mutex);
+    cacheFolder = folder;
+}
+
+QString ShaderManager::getCacheFolder()
+{
+    QMutexLocker locker(&mutex);
+    return cacheFolder;
+}
+
+QString ShaderManager::getBinaryPath(const QByteArray& sourceHash)
+{
+    auto folder = getCacheFolder();
+    if (folder.isEmpty())
+        return QString();
+
+    return QDir(folder).filePath(QString::fromLatin1(sourceHash.toHex()) + ".bin");
+}
+
+bool ShaderManager::loadProgramBinary(const QByteArray& sourceHash, const QByteArray& driverId,
+                                      GLenum& format, QByteArray& binary)
+{
+    auto path = getBinaryPath(sourceHash);
+    if (path.isEmpty())
+        return false;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic, version, binaryFormat;
+    QByteArray binaryDriverId;
+    stream >> magic >> version >> binaryDriverId >> binaryFormat >> binary;
+
+    if (stream.status() != QDataStream::Ok ||
+        magic != PROGRAM_BINARY_MAGIC ||
+        version != PROGRAM_BINARY_VERSION ||
+        binaryDriverId != driverId ||
+        binary.isEmpty())
+        return false;
+
+    format = binaryFormat;
+    return true;
+}
+
+void ShaderManager::saveProgramBinary(const QByteArray& sourceHash, const QByteArray& driverId,
+                                      GLenum format, const QByteArray& binary)
+{
+    auto path = getBinaryPath(sourceHash);
+    if (path.isEmpty())
+        return;
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << PROGRAM_BINARY_MAGIC << PROGRAM_BINARY_VERSION << driverId << (quint32)format << binary;
+
+    // it's compiled again next time if it couldnt be saved
+    if (stream.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return;
+    }
+
+    file.commit();
+}
+
+void ShaderManager::clear()
+{
+    QMutexLocker locker(&mutex);
+    sources.clear();
+    shaders.clear();
+}
+
+}
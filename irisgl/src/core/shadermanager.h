@@ -0,0 +1,99 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef SHADERMANAGER_H
+#define SHADERMANAGER_H
+
+#include "../irisglfwd.h"
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QWeakPointer>
+#include <qopengl.h>
+
+namespace iris
+{
+
+/**
+ * Cache of shaders by their preprocessed source
+ *
+ * Shader::load goes through here so everything loading the same files, or
+ * different files that preprocess to the same source, shares one shader and
+ * its program. Defines are inserted into the source so variants such as the
+ * instanced one are keyed separately. Only weak references are kept, and
+ * shaders are only shared within a thread since a program's uniforms cant be
+ * set from two threads at once.
+ *
+ * Preprocessed files are kept until the file or one of the files it
+ * includes is modified.
+ *
+ * If a cache folder is set, GraphicsDevice saves the binary of every program
+ * it links there, named after the hash of the program's source. Those are
+ * loaded on later runs instead of compiling the glsl, unless the driver
+ * changed since they were saved.
+ */
+class ShaderManager
+{
+    struct SourceEntry
+    {
+        QString source;
+        // the file followed by everything it includes
+        QStringList files;
+        QList<QDateTime> lastModified;
+
+        bool isUpToDate() const;
+    };
+
+    QHash<QString, SourceEntry> sources;
+    QHash<QByteArray, QWeakPointer<Shader>> shaders;
+    QString cacheFolder;
+
+    QMutex mutex;
+
+    ShaderManager();
+
+public:
+    static ShaderManager* getSingleton();
+
+    /**
+     * Returns the shader for the two files, loading them if they arent cached
+     * Can be called from any thread
+     */
+    ShaderPtr load(const QString& vertexShaderFile, const QString& fragmentShaderFile);
+
+    // returns the shader for the already preprocessed source
+    ShaderPtr getShader(const QString& vertexShader, const QString& fragmentShader);
+
+    // the file with its includes expanded
+    QString loadSource(const QString& path);
+
+    void setCacheFolder(const QString& folder);
+    QString getCacheFolder();
+
+    /**
+     * Reads the program binary saved for the source hash
+     * Returns false if there isnt one or it was saved by another driver
+     */
+    bool loadProgramBinary(const QByteArray& sourceHash, const QByteArray& driverId,
+                           GLenum& format, QByteArray& binary);
+    void saveProgramBinary(const QByteArray& sourceHash, const QByteArray& driverId,
+                           GLenum format, const QByteArray& binary);
+
+    void clear();
+
+private:
+    QString getBinaryPath(const QByteArray& sourceHash);
+};
+
+}
+
+#endif // SHADERMANAGER_H
@@ -0,0 +1,239 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "texturemanager.h"
+#include "../graphics/texture2d.h"
+#include "../content/texturefile.h"
+#include "irisutils.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QOpenGLContext>
+
+namespace iris
+{
+
+TextureManager::TextureManager()
+{
+    useCounter = 0;
+    memoryBudget = 512 * 1024 * 1024;
+    compressionSupported = -1;
+}
+
+TextureManager* TextureManager::getSingleton()
+{
+    static TextureManager* instance = new TextureManager();
+    return instance;
+}
+
+Texture2DPtr TextureManager::getTexture(const QString& path, bool flipY)
+{
+    auto texture = findTexture(path, flipY);
+    if (!!texture)
+        return texture;
+
+    // loaded without holding the lock since converting an image can take a while
+    TextureFileData data;
+    if (isCompressionSupported() && loadTextureFile(path, flipY, data))
+        texture = Texture2D::create(data);
+    else
+        texture = Texture2D::load(path, flipY);
+
+    if (!texture)
+        return texture;
+
+    texture->source = path;
+    addTexture(path, flipY, texture);
+
+    return texture;
+}
+
+Texture2DPtr TextureManager::findTexture(const QString& path, bool flipY)
+{
+    QMutexLocker locker(&mutex);
+
+    auto iter = entries.find(getKey(path, flipY));
+    if (iter == entries.end() || !isCached(iter.value(), path))
+        return Texture2DPtr();
+
+    iter.value().lastUsed = ++useCounter;
+    return iter.value().texture.toStrongRef();
+}
+
+void TextureManager::addTexture(const QString& path, bool flipY, Texture2DPtr texture)
+{
+    QMutexLocker locker(&mutex);
+
+    CacheEntry entry;
+    entry.texture = texture.toWeakRef();
+    entry.retainedTexture = texture;
+    entry.lastModified = QFileInfo(path).lastModified();
+    entry.memoryUsage = texture->getMemoryUsage();
+    entry.lastUsed = ++useCounter;
+
+    entries.insert(getKey(path, flipY), entry);
+    evict();
+}
+
+bool TextureManager::loadTextureFile(const QString& path, bool flipY, TextureFileData& data)
+{
+    QString folder = getCacheFolder();
+
+    // images in resources are never converted
+    if (folder.isEmpty() || path.startsWith(":") || path.startsWith("qrc:"))
+        return false;
+
+    auto hash = IrisUtils::hashFile(path);
+    if (hash.isEmpty())
+        return false;
+
+    auto cachePath = QDir(folder).filePath(QString::fromLatin1(hash.toHex()) +
+                                           (flipY ? "-flipped.ktx" : ".ktx"));
+    if (TextureFile::load(cachePath, data))
+        return true;
+
+    QImage image(path);
+    if (image.isNull())
+        return false;
+
+    if (flipY)
+        image = image.mirrored(false, true);
+
+    data = TextureFile::convert(image);
+
+    // it's still usable if it couldnt be saved
+    QDir().mkpath(folder);
+    TextureFile::save(cachePath, data);
+
+    return true;
+}
+
+bool TextureManager::convert(const QString& path, bool flipY)
+{
+    TextureFileData data;
+    return loadTextureFile(path, flipY, data);
+}
+
+bool TextureManager::isCompressionSupported()
+{
+    QMutexLocker locker(&mutex);
+
+    if (compressionSupported < 0) {
+        auto context = QOpenGLContext::currentContext();
+        if (context == nullptr)
+            return false;
+
+        compressionSupported = context->hasExtension("GL_EXT_texture_compression_s3tc") ? 1 : 0;
+    }
+
+    return compressionSupported == 1;
+}
+
+void TextureManager::setCacheFolder(const QString& folder)
+{
+    QMutexLocker locker(&mutex);
+    cacheFolder = folder;
+}
+
+QString TextureManager::getCacheFolder()
+{
+    QMutexLocker locker(&mutex);
+    return cacheFolder;
+}
+
+void TextureManager::remove(const QString& path, bool flipY)
+{
+    QMutexLocker locker(&mutex);
+    entries.remove(getKey(path, flipY));
+}
+
+void TextureManager::clear()
+{
+    QMutexLocker locker(&mutex);
+    entries.clear();
+}
+
+qint64 TextureManager::getMemoryUsage()
+{
+    QMutexLocker locker(&mutex);
+
+    qint64 usage = 0;
+    for (auto& entry : entries) {
+        if (!entry.texture.isNull())
+            usage += entry.memoryUsage;
+    }
+
+    return usage;
+}
+
+qint64 TextureManager::getMemoryBudget() const
+{
+    return memoryBudget;
+}
+
+void TextureManager::setMemoryBudget(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    memoryBudget = bytes;
+    evict();
+}
+
+void TextureManager::collectGarbage()
+{
+    QMutexLocker locker(&mutex);
+    evict();
+}
+
+QString TextureManager::getKey(const QString& path, bool flipY)
+{
+    return flipY ? path + ":flipped" : path;
+}
+
+bool TextureManager::isCached(const CacheEntry& entry, const QString& path) const
+{
+    return !entry.texture.isNull() && QFileInfo(path).lastModified() == entry.lastModified;
+}
+
+void TextureManager::evict()
+{
+    qint64 retainedMemory = 0;
+
+    for (auto iter = entries.begin(); iter != entries.end();) {
+        auto& entry = iter.value();
+        if (entry.texture.isNull()) {
+            iter = entries.erase(iter);
+            continue;
+        }
+
+        if (!!entry.retainedTexture)
+            retainedMemory += entry.memoryUsage;
+        ++iter;
+    }
+
+    while (retainedMemory > memoryBudget) {
+        CacheEntry* oldest = nullptr;
+        for (auto& entry : entries) {
+            if (!!entry.retainedTexture &&
+                (oldest == nullptr || entry.lastUsed < oldest->lastUsed))
+                oldest = &entry;
+        }
+
+        if (oldest == nullptr)
+            break;
+
+        // the texture stays cached if it's still used elsewhere
+        oldest->retainedTexture.clear();
+        retainedMemory -= oldest->memoryUsage;
+    }
+}
+
+}
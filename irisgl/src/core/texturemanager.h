@@ -0,0 +1,121 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef TEXTUREMANAGER_H
+#define TEXTUREMANAGER_H
+
+#include "../irisglfwd.h"
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QWeakPointer>
+
+namespace iris
+{
+
+struct TextureFileData;
+
+/**
+ * Cache of the textures loaded from image files
+ *
+ * Works like the MeshManager: textures are shared by everything using the
+ * same file, only weak references are kept, and recently used textures are
+ * kept alive until the cache goes over its gpu memory budget. A texture is
+ * reloaded if its file was modified since it was cached.
+ *
+ * If a cache folder is set, images are converted to block compressed ktx
+ * files with their mip levels, named after the hash of the image's contents.
+ * Those are loaded instead of the image when the gpu supports S3TC.
+ */
+class TextureManager
+{
+    struct CacheEntry
+    {
+        QWeakPointer<Texture2D> texture;
+
+        // keeps the texture alive when nothing else uses it
+        Texture2DPtr retainedTexture;
+
+        QDateTime lastModified;
+        qint64 memoryUsage;
+        quint64 lastUsed;
+    };
+
+    QHash<QString, CacheEntry> entries;
+    QString cacheFolder;
+    quint64 useCounter;
+    qint64 memoryBudget;
+
+    // -1 until it's checked against a context
+    int compressionSupported;
+
+    QMutex mutex;
+
+    TextureManager();
+
+public:
+    static TextureManager* getSingleton();
+
+    /**
+     * Returns the texture for the image at path, loading it if it isnt cached
+     * Setting flipY flips the image on the y-axis
+     * Must be called with a current context
+     */
+    Texture2DPtr getTexture(const QString& path, bool flipY = true);
+
+    // returns the cached texture, or null without loading it
+    Texture2DPtr findTexture(const QString& path, bool flipY = true);
+
+    /**
+     * Caches a texture that was loaded elsewhere, such as by the AssetLoader
+     */
+    void addTexture(const QString& path, bool flipY, Texture2DPtr texture);
+
+    /**
+     * Loads the converted image from the cache folder, converting it first if
+     * it isnt there. Returns false if there's no cache folder or the image cant
+     * be loaded. Can be called from any thread.
+     */
+    bool loadTextureFile(const QString& path, bool flipY, TextureFileData& data);
+
+    // converts the image ahead of time, for when it's imported
+    bool convert(const QString& path, bool flipY = true);
+
+    // checks the current context the first time it's called
+    bool isCompressionSupported();
+
+    void setCacheFolder(const QString& folder);
+    QString getCacheFolder();
+
+    void remove(const QString& path, bool flipY = true);
+    void clear();
+
+    // gpu memory used by the cached textures, in bytes
+    qint64 getMemoryUsage();
+
+    qint64 getMemoryBudget() const;
+    void setMemoryBudget(qint64 bytes);
+
+    /**
+     * Forgets freed textures and releases the least recently used ones until
+     * the memory usage of the ones kept alive is within budget
+     */
+    void collectGarbage();
+
+private:
+    static QString getKey(const QString& path, bool flipY);
+    bool isCached(const CacheEntry& entry, const QString& path) const;
+    void evict();
+};
+
+}
+
+#endif // TEXTUREMANAGER_H
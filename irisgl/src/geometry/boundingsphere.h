@@ -12,6 +12,12 @@ public:
     QVector3D pos;
     float radius;
 
+    // a radius of 0 means the bounds are unknown
+    BoundingSphere()
+    {
+        radius = 0;
+    }
+
     void expand(QVector3D point)
     {
         auto dist = pos.distanceToPoint(point);
@@ -24,6 +30,20 @@ public:
         return pos.distanceToPoint(other.pos) < radius + other.radius;
     }
 
+    // checks if the segment passes through or touches the sphere
+    bool intersectsSegment(const QVector3D& segStart, const QVector3D& segEnd) const
+    {
+        auto dir = segEnd - segStart;
+        float lengthSqrd = dir.lengthSquared();
+
+        // closest point on the segment to the center
+        float t = 0.0f;
+        if (lengthSqrd > 0.0f)
+            t = qBound(0.0f, QVector3D::dotProduct(pos - segStart, dir) / lengthSqrd, 1.0f);
+
+        return ((segStart + dir * t) - pos).lengthSquared() <= radius * radius;
+    }
+
     static BoundingSphere merge(const BoundingSphere& a, const BoundingSphere& b)
     {
         QVector3D center = b.pos - a.pos;
@@ -0,0 +1,277 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "meshoptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace iris
+{
+
+// simulated cache used for scoring, bigger than most real caches so it
+// works well on all of them
+static const int VERTEX_CACHE_SIZE = 32;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRI_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+// fifo cache used to find where the triangle order jumps to another part of the mesh
+static const int OVERDRAW_CACHE_SIZE = 16;
+
+static float getVertexScore(int cachePosition, int remainingTris)
+{
+    // the vertex isnt needed anymore
+    if (remainingTris == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        // the last triangle's vertices get a fixed score so the next triangle
+        // doesnt favor any of its edges
+        if (cachePosition < 3) {
+            score = LAST_TRI_SCORE;
+        } else {
+            float scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    // vertices with few triangles left are finished off first
+    score += VALENCE_BOOST_SCALE * std::pow((float)remainingTris, -VALENCE_BOOST_POWER);
+    return score;
+}
+
+void MeshOptimizer::optimizeVertexCache(QVector<unsigned int>& indices, int vertexCount)
+{
+    int triCount = indices.size() / 3;
+    if (triCount == 0 || vertexCount == 0)
+        return;
+
+    // triangles using each vertex, stored in one array
+    // the first remainingTris[v] of a vertex's triangles havent been added yet
+    QVector<int> triOffsets(vertexCount + 1, 0);
+    for (int i = 0; i < triCount * 3; i++)
+        triOffsets[indices[i] + 1]++;
+    for (int v = 0; v < vertexCount; v++)
+        triOffsets[v + 1] += triOffsets[v];
+
+    QVector<int> remainingTris(vertexCount, 0);
+    QVector<int> vertexTris(triCount * 3);
+    for (int t = 0; t < triCount; t++) {
+        for (int k = 0; k < 3; k++) {
+            int v = indices[t * 3 + k];
+            vertexTris[triOffsets[v] + remainingTris[v]++] = t;
+        }
+    }
+
+    QVector<float> vertexScores(vertexCount);
+    for (int v = 0; v < vertexCount; v++)
+        vertexScores[v] = getVertexScore(-1, remainingTris[v]);
+
+    QVector<float> triScores(triCount);
+    QVector<bool> added(triCount, false);
+
+    int bestTri = 0;
+    for (int t = 0; t < triCount; t++) {
+        triScores[t] = vertexScores[indices[t * 3]] +
+                       vertexScores[indices[t * 3 + 1]] +
+                       vertexScores[indices[t * 3 + 2]];
+        if (triScores[t] > triScores[bestTri])
+            bestTri = t;
+    }
+
+    QVector<unsigned int> result;
+    result.reserve(triCount * 3);
+
+    // lru cache, most recent first
+    // it has room for the vertices pushed out by the last triangle so their scores get updated
+    QVector<int> cache;
+    QVector<int> newCache;
+    cache.reserve(VERTEX_CACHE_SIZE + 3);
+    newCache.reserve(VERTEX_CACHE_SIZE + 3);
+
+    int nextTri = 0;
+    while (bestTri >= 0) {
+        added[bestTri] = true;
+        newCache.clear();
+
+        for (int k = 0; k < 3; k++) {
+            int v = indices[bestTri * 3 + k];
+            result.append(v);
+            if (!newCache.contains(v))
+                newCache.append(v);
+
+            // swap the triangle out of the vertex's remaining triangles
+            int* tris = vertexTris.data() + triOffsets[v];
+            for (int i = 0; i < remainingTris[v]; i++) {
+                if (tris[i] == bestTri) {
+                    std::swap(tris[i], tris[remainingTris[v] - 1]);
+                    remainingTris[v]--;
+                    break;
+                }
+            }
+        }
+
+        int triVertexCount = newCache.size();
+        for (int v : cache) {
+            if (!std::count(newCache.constBegin(), newCache.constBegin() + triVertexCount, v))
+                newCache.append(v);
+        }
+
+        for (int i = 0; i < newCache.size(); i++) {
+            int v = newCache[i];
+            vertexScores[v] = getVertexScore(i < VERTEX_CACHE_SIZE ? i : -1, remainingTris[v]);
+        }
+
+        // only triangles using vertices that were or are in the cache changed score
+        bestTri = -1;
+        float bestScore = -1.0f;
+        for (int v : newCache) {
+            const int* tris = vertexTris.constData() + triOffsets[v];
+            for (int i = 0; i < remainingTris[v]; i++) {
+                int t = tris[i];
+                float score = vertexScores[indices[t * 3]] +
+                              vertexScores[indices[t * 3 + 1]] +
+                              vertexScores[indices[t * 3 + 2]];
+                triScores[t] = score;
+
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestTri = t;
+                }
+            }
+        }
+
+        if (newCache.size() > VERTEX_CACHE_SIZE)
+            newCache.resize(VERTEX_CACHE_SIZE);
+        cache.swap(newCache);
+
+        // none of the cached vertices have triangles left, start over somewhere else
+        if (bestTri < 0) {
+            while (nextTri < triCount && added[nextTri])
+                nextTri++;
+            if (nextTri < triCount)
+                bestTri = nextTri;
+        }
+    }
+
+    indices = result;
+}
+
+void MeshOptimizer::optimizeOverdraw(QVector<unsigned int>& indices, const QVector<QVector3D>& positions)
+{
+    int triCount = indices.size() / 3;
+    if (triCount == 0)
+        return;
+
+    // clusters start wherever a triangle shares no vertices with the cache,
+    // which is where the cache order moves to another part of the mesh.
+    // reordering whole clusters keeps the cache order within them
+    QVector<int> clusterStarts;
+    QVector<int> cacheTimes(positions.size(), -OVERDRAW_CACHE_SIZE);
+    int time = 0;
+    for (int t = 0; t < triCount; t++) {
+        int misses = 0;
+        for (int k = 0; k < 3; k++) {
+            int v = indices[t * 3 + k];
+            if (time - cacheTimes[v] >= OVERDRAW_CACHE_SIZE) {
+                cacheTimes[v] = time++;
+                misses++;
+            }
+        }
+
+        if (t == 0 || misses == 3)
+            clusterStarts.append(t);
+    }
+    clusterStarts.append(triCount);
+
+    int clusterCount = clusterStarts.size() - 1;
+    if (clusterCount < 2)
+        return;
+
+    // area weighted centroids and average normals of each cluster
+    QVector<QVector3D> centroids(clusterCount);
+    QVector<QVector3D> normals(clusterCount);
+    QVector3D meshCentroid;
+    float meshArea = 0;
+
+    for (int c = 0; c < clusterCount; c++) {
+        QVector3D centroid;
+        QVector3D normal;
+        float area = 0;
+
+        for (int t = clusterStarts[c]; t < clusterStarts[c + 1]; t++) {
+            auto p0 = positions[indices[t * 3]];
+            auto p1 = positions[indices[t * 3 + 1]];
+            auto p2 = positions[indices[t * 3 + 2]];
+
+            auto n = QVector3D::crossProduct(p1 - p0, p2 - p0);
+            float triArea = n.length();
+
+            centroid += (p0 + p1 + p2) * (triArea / 3.0f);
+            normal += n;
+            area += triArea;
+        }
+
+        meshCentroid += centroid;
+        meshArea += area;
+
+        centroids[c] = area > 0 ? centroid / area : positions[indices[clusterStarts[c] * 3]];
+        normals[c] = normal.normalized();
+    }
+
+    if (meshArea > 0)
+        meshCentroid /= meshArea;
+
+    // clusters far out from the center and facing away from it occlude
+    // the most of the mesh so they're drawn first
+    QVector<float> sortKeys(clusterCount);
+    QVector<int> order(clusterCount);
+    for (int c = 0; c < clusterCount; c++) {
+        sortKeys[c] = QVector3D::dotProduct(centroids[c] - meshCentroid, normals[c]);
+        order[c] = c;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](int a, int b) {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    QVector<unsigned int> result;
+    result.reserve(indices.size());
+    for (int c : order) {
+        for (int i = clusterStarts[c] * 3; i < clusterStarts[c + 1] * 3; i++)
+            result.append(indices[i]);
+    }
+
+    indices = result;
+}
+
+QVector<int> MeshOptimizer::optimizeVertexFetch(QVector<unsigned int>& indices, int vertexCount)
+{
+    QVector<int> remap(vertexCount, -1);
+    QVector<int> vertexOrder;
+    vertexOrder.reserve(vertexCount);
+
+    for (auto& index : indices) {
+        if (remap[index] < 0) {
+            remap[index] = vertexOrder.size();
+            vertexOrder.append(index);
+        }
+
+        index = remap[index];
+    }
+
+    return vertexOrder;
+}
+
+}
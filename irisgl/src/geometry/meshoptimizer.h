@@ -0,0 +1,53 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <QVector>
+#include <QVector3D>
+
+namespace iris
+{
+
+/**
+ * Reorders triangle lists so they render faster
+ * Meant to be run once when meshes are imported, in the order:
+ * optimizeVertexCache(), optimizeOverdraw(), optimizeVertexFetch()
+ */
+class MeshOptimizer
+{
+public:
+    /**
+     * Reorders triangles so vertices are reused while they're still in the
+     * post-transform cache
+     * Tom Forsyth's linear-speed vertex cache optimisation
+     * https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+     */
+    static void optimizeVertexCache(QVector<unsigned int>& indices, int vertexCount);
+
+    /**
+     * Reorders groups of triangles so the ones most likely to occlude the
+     * rest of the mesh are drawn first, without undoing the cache ordering
+     * Based on Sander et al, Fast Triangle Reordering for Vertex Locality and Reduced Overdraw
+     */
+    static void optimizeOverdraw(QVector<unsigned int>& indices, const QVector<QVector3D>& positions);
+
+    /**
+     * Renumbers vertices in the order the triangles first use them
+     * Returns the original index of each vertex, unused vertices are dropped
+     */
+    static QVector<int> optimizeVertexFetch(QVector<unsigned int>& indices, int vertexCount);
+};
+
+}
+
+#endif // MESHOPTIMIZER_H
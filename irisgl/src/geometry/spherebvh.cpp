@@ -0,0 +1,166 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "spherebvh.h"
+#include <QVarLengthArray>
+#include <algorithm>
+
+namespace iris
+{
+
+#define SPHERE_BVH_MAX_LEAF_SIZE 4
+
+void SphereBvh::build(const QVector<BoundingSphere>& spheres)
+{
+    this->spheres = spheres;
+    nodes.clear();
+    indices.resize(spheres.size());
+
+    if (spheres.isEmpty())
+        return;
+
+    for (int i = 0; i < spheres.size(); i++)
+        indices[i] = i;
+
+    nodes.reserve(spheres.size() * 2);
+    buildNode(0, spheres.size());
+}
+
+void SphereBvh::refit(const QVector<BoundingSphere>& spheres)
+{
+    Q_ASSERT(spheres.size() == this->spheres.size());
+    this->spheres = spheres;
+
+    // children are always stored after their parent
+    for (int i = nodes.size() - 1; i >= 0; i--) {
+        auto& node = nodes[i];
+
+        if (node.count == 0) {
+            auto& left = nodes[i + 1];
+            auto& right = nodes[node.offset];
+            for (int axis = 0; axis < 3; axis++) {
+                node.boundsMin[axis] = qMin(left.boundsMin[axis], right.boundsMin[axis]);
+                node.boundsMax[axis] = qMax(left.boundsMax[axis], right.boundsMax[axis]);
+            }
+            continue;
+        }
+
+        for (int j = node.offset; j < node.offset + node.count; j++) {
+            auto& sphere = spheres[indices[j]];
+            for (int axis = 0; axis < 3; axis++) {
+                float low = sphere.pos[axis] - sphere.radius;
+                float high = sphere.pos[axis] + sphere.radius;
+                node.boundsMin[axis] = j == node.offset ? low : qMin(node.boundsMin[axis], low);
+                node.boundsMax[axis] = j == node.offset ? high : qMax(node.boundsMax[axis], high);
+            }
+        }
+    }
+}
+
+// Spheres are split at the median of the longest axis
+int SphereBvh::buildNode(int start, int count)
+{
+    int nodeIndex = nodes.size();
+    nodes.append(Node());
+
+    auto radiusVec = [](float r) { return QVector3D(r, r, r); };
+
+    auto& first = spheres[indices[start]];
+    QVector3D boundsMin = first.pos - radiusVec(first.radius);
+    QVector3D boundsMax = first.pos + radiusVec(first.radius);
+    QVector3D centerMin = first.pos;
+    QVector3D centerMax = first.pos;
+    for (int i = start + 1; i < start + count; i++) {
+        auto& sphere = spheres[indices[i]];
+        for (int axis = 0; axis < 3; axis++) {
+            boundsMin[axis] = qMin(boundsMin[axis], sphere.pos[axis] - sphere.radius);
+            boundsMax[axis] = qMax(boundsMax[axis], sphere.pos[axis] + sphere.radius);
+            centerMin[axis] = qMin(centerMin[axis], sphere.pos[axis]);
+            centerMax[axis] = qMax(centerMax[axis], sphere.pos[axis]);
+        }
+    }
+
+    nodes[nodeIndex].boundsMin = boundsMin;
+    nodes[nodeIndex].boundsMax = boundsMax;
+    nodes[nodeIndex].offset = start;
+    nodes[nodeIndex].count = count;
+
+    if (count <= SPHERE_BVH_MAX_LEAF_SIZE)
+        return nodeIndex;
+
+    auto extent = centerMax - centerMin;
+    int axis = 0;
+    if (extent.y() > extent[axis]) axis = 1;
+    if (extent.z() > extent[axis]) axis = 2;
+
+    int leftCount = count / 2;
+    auto begin = indices.begin() + start;
+    std::nth_element(begin, begin + leftCount, begin + count, [&](int a, int b) {
+        return spheres[a].pos[axis] < spheres[b].pos[axis];
+    });
+
+    buildNode(start, leftCount);
+    int rightIndex = buildNode(start + leftCount, count - leftCount);
+
+    nodes[nodeIndex].offset = rightIndex;
+    nodes[nodeIndex].count = 0;
+
+    return nodeIndex;
+}
+
+int SphereBvh::getSegmentIntersections(const QVector3D& segStart, const QVector3D& segEnd, QVector<int>& hits)
+{
+    if (nodes.isEmpty())
+        return 0;
+
+    auto dir = segEnd - segStart;
+    QVector3D invDir(dir.x() != 0.0f ? 1.0f / dir.x() : 1e30f,
+                     dir.y() != 0.0f ? 1.0f / dir.y() : 1e30f,
+                     dir.z() != 0.0f ? 1.0f / dir.z() : 1e30f);
+
+    int hitCount = 0;
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        int nodeIndex = stack.last();
+        const Node& node = nodes[nodeIndex];
+        stack.removeLast();
+
+        // slab test against the node's bounds
+        float tmin = 0.0f;
+        float tmax = 1.0f;
+        for (int axis = 0; axis < 3; axis++) {
+            float t1 = (node.boundsMin[axis] - segStart[axis]) * invDir[axis];
+            float t2 = (node.boundsMax[axis] - segStart[axis]) * invDir[axis];
+            tmin = qMax(tmin, qMin(t1, t2));
+            tmax = qMin(tmax, qMax(t1, t2));
+        }
+        if (tmin > tmax)
+            continue;
+
+        if (node.count == 0) {
+            stack.append(node.offset);
+            stack.append(nodeIndex + 1);
+            continue;
+        }
+
+        for (int i = node.offset; i < node.offset + node.count; i++) {
+            if (spheres[indices[i]].intersectsSegment(segStart, segEnd)) {
+                hits.append(indices[i]);
+                hitCount++;
+            }
+        }
+    }
+
+    return hitCount;
+}
+
+}
@@ -0,0 +1,62 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef SPHEREBVH_H
+#define SPHEREBVH_H
+
+#include <QVector3D>
+#include <QVector>
+#include "boundingsphere.h"
+
+namespace iris
+{
+
+/**
+ * Bounding volume hierarchy over a list of bounding spheres
+ * It's used to find the spheres a segment passes through without testing
+ * each one. Nodes are laid out the same way as TriMesh's bvh.
+ */
+class SphereBvh
+{
+    struct Node
+    {
+        QVector3D boundsMin;
+        QVector3D boundsMax;
+        int offset;
+        int count;// 0 for interior nodes
+    };
+
+    QVector<Node> nodes;
+    QVector<int> indices;
+    QVector<BoundingSphere> spheres;
+
+public:
+    void build(const QVector<BoundingSphere>& spheres);
+
+    /**
+     * Updates the bounds for spheres that moved without rebuilding the tree
+     * There must be as many spheres as it was built with, in the same order
+     */
+    void refit(const QVector<BoundingSphere>& spheres);
+
+    /**
+     * Appends the index of each sphere the segment passes through to hits
+     * Returns the number of spheres hit
+     */
+    int getSegmentIntersections(const QVector3D& segStart, const QVector3D& segEnd, QVector<int>& hits);
+
+private:
+    int buildNode(int start, int count);
+};
+
+}
+
+#endif // SPHEREBVH_H
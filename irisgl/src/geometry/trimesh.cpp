@@ -10,10 +10,16 @@ For more information see the LICENSE file
 *************************************************************************/
 
 #include "trimesh.h"
+#include <QVarLengthArray>
+#include <algorithm>
 
 namespace iris
 {
 
+// max triangles in a leaf before a split is forced
+#define BVH_MAX_LEAF_SIZE 8
+#define BVH_NUM_BINS 16
+
 /**
  * Adds points for triangle. Assumes points are in a counter-clockwise rotation.
  * @param a
@@ -25,50 +31,277 @@ void TriMesh::addTriangle(const QVector3D& a,const QVector3D& b,const QVector3D&
     Triangle tri = {a,b,c,QVector3D::crossProduct(b-a,c-a)};
 
     triangles.append(tri);
+
+    // rebuilt by the next query
+    bvhNodes.clear();
+}
+
+static QVector3D minVec(const QVector3D& a, const QVector3D& b)
+{
+    return QVector3D(qMin(a.x(), b.x()), qMin(a.y(), b.y()), qMin(a.z(), b.z()));
+}
+
+static QVector3D maxVec(const QVector3D& a, const QVector3D& b)
+{
+    return QVector3D(qMax(a.x(), b.x()), qMax(a.y(), b.y()), qMax(a.z(), b.z()));
+}
+
+static float surfaceArea(const QVector3D& boundsMin, const QVector3D& boundsMax)
+{
+    auto d = boundsMax - boundsMin;
+    return 2.0f * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+}
+
+void TriMesh::buildBvh()
+{
+    bvhNodes.clear();
+    bvhTriangles.resize(triangles.size());
+
+    if (triangles.isEmpty())
+        return;
+
+    QVector<QVector3D> centroids(triangles.size());
+    QVector<QVector3D> mins(triangles.size());
+    QVector<QVector3D> maxs(triangles.size());
+
+    for (int i = 0; i < triangles.size(); i++) {
+        const Triangle& tri = triangles[i];
+        mins[i] = minVec(minVec(tri.a, tri.b), tri.c);
+        maxs[i] = maxVec(maxVec(tri.a, tri.b), tri.c);
+        centroids[i] = (tri.a + tri.b + tri.c) / 3.0f;
+        bvhTriangles[i] = i;
+    }
+
+    bvhNodes.reserve(triangles.size() * 2);
+    buildBvhNode(centroids, mins, maxs, 0, triangles.size());
+    bvhNodes.squeeze();
+}
+
+// Builds the node for the count triangles starting at start in bvhTriangles
+// Returns the node's index
+int TriMesh::buildBvhNode(QVector<QVector3D>& centroids, QVector<QVector3D>& mins, QVector<QVector3D>& maxs, int start, int count)
+{
+    // bvhNodes can grow while the children are built so nodes are
+    // accessed by index
+    int nodeIndex = bvhNodes.size();
+    bvhNodes.append(TriMeshBvhNode());
+
+    QVector3D boundsMin = mins[bvhTriangles[start]];
+    QVector3D boundsMax = maxs[bvhTriangles[start]];
+    QVector3D centroidMin = centroids[bvhTriangles[start]];
+    QVector3D centroidMax = centroidMin;
+    for (int i = start + 1; i < start + count; i++) {
+        int tri = bvhTriangles[i];
+        boundsMin = minVec(boundsMin, mins[tri]);
+        boundsMax = maxVec(boundsMax, maxs[tri]);
+        centroidMin = minVec(centroidMin, centroids[tri]);
+        centroidMax = maxVec(centroidMax, centroids[tri]);
+    }
+
+    bvhNodes[nodeIndex].boundsMin = boundsMin;
+    bvhNodes[nodeIndex].boundsMax = boundsMax;
+    bvhNodes[nodeIndex].offset = start;
+    bvhNodes[nodeIndex].count = count;
+
+    if (count <= 2)
+        return nodeIndex;
+
+    // bin the centroids along each axis and pick the split with the lowest
+    // surface area cost
+    int bestAxis = -1;
+    int bestSplit = 0;
+    float bestCost = 0.0f;
+
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f)
+            continue;
+
+        int binCounts[BVH_NUM_BINS] = {0};
+        QVector3D binMins[BVH_NUM_BINS];
+        QVector3D binMaxs[BVH_NUM_BINS];
+        float scale = BVH_NUM_BINS / extent;
+
+        for (int i = start; i < start + count; i++) {
+            int tri = bvhTriangles[i];
+            int bin = qMin((int)((centroids[tri][axis] - centroidMin[axis]) * scale), BVH_NUM_BINS - 1);
+            if (binCounts[bin] == 0) {
+                binMins[bin] = mins[tri];
+                binMaxs[bin] = maxs[tri];
+            } else {
+                binMins[bin] = minVec(binMins[bin], mins[tri]);
+                binMaxs[bin] = maxVec(binMaxs[bin], maxs[tri]);
+            }
+            binCounts[bin]++;
+        }
+
+        // area and triangle count to the right of each split, swept from the right
+        float rightAreas[BVH_NUM_BINS];
+        int rightCounts[BVH_NUM_BINS];
+        QVector3D rightMin, rightMax;
+        int rightCount = 0;
+        for (int bin = BVH_NUM_BINS - 1; bin > 0; bin--) {
+            if (binCounts[bin] > 0) {
+                rightMin = rightCount == 0 ? binMins[bin] : minVec(rightMin, binMins[bin]);
+                rightMax = rightCount == 0 ? binMaxs[bin] : maxVec(rightMax, binMaxs[bin]);
+                rightCount += binCounts[bin];
+            }
+            rightCounts[bin] = rightCount;
+            rightAreas[bin] = rightCount > 0 ? surfaceArea(rightMin, rightMax) : 0.0f;
+        }
+
+        QVector3D leftMin, leftMax;
+        int leftCount = 0;
+        for (int split = 1; split < BVH_NUM_BINS; split++) {
+            int bin = split - 1;
+            if (binCounts[bin] > 0) {
+                leftMin = leftCount == 0 ? binMins[bin] : minVec(leftMin, binMins[bin]);
+                leftMax = leftCount == 0 ? binMaxs[bin] : maxVec(leftMax, binMaxs[bin]);
+                leftCount += binCounts[bin];
+            }
+
+            if (leftCount == 0 || rightCounts[split] == 0)
+                continue;
+
+            float cost = leftCount * surfaceArea(leftMin, leftMax) +
+                         rightCounts[split] * rightAreas[split];
+            if (bestAxis == -1 || cost < bestCost) {
+                bestAxis = axis;
+                bestSplit = split;
+                bestCost = cost;
+            }
+        }
+    }
+
+    // all centroids are in the same spot
+    if (bestAxis == -1)
+        return nodeIndex;
+
+    // splitting costs a box test, roughly the same as a triangle test
+    float area = surfaceArea(boundsMin, boundsMax);
+    float leafCost = count * area;
+    if (count <= BVH_MAX_LEAF_SIZE && area + bestCost >= leafCost)
+        return nodeIndex;
+
+    float scale = BVH_NUM_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+    float axisMin = centroidMin[bestAxis];
+    auto begin = bvhTriangles.begin() + start;
+    auto mid = std::partition(begin, begin + count, [&](int tri) {
+        int bin = qMin((int)((centroids[tri][bestAxis] - axisMin) * scale), BVH_NUM_BINS - 1);
+        return bin < bestSplit;
+    });
+
+    int leftCount = mid - begin;
+    if (leftCount == 0 || leftCount == count)
+        return nodeIndex;
+
+    buildBvhNode(centroids, mins, maxs, start, leftCount);
+    int rightIndex = buildBvhNode(centroids, mins, maxs, start + leftCount, count - leftCount);
+
+    bvhNodes[nodeIndex].offset = rightIndex;
+    bvhNodes[nodeIndex].count = 0;
+
+    return nodeIndex;
+}
+
+// Slab test of the segment start + dir * t, with t in [0, maxT], against the node's bounds
+// entryT is where the segment enters the box
+static bool segmentHitsBox(const TriMeshBvhNode& node, const QVector3D& start, const QVector3D& invDir, float maxT, float& entryT)
+{
+    float tmin = 0.0f;
+    float tmax = maxT;
+    for (int axis = 0; axis < 3; axis++) {
+        float t1 = (node.boundsMin[axis] - start[axis]) * invDir[axis];
+        float t2 = (node.boundsMax[axis] - start[axis]) * invDir[axis];
+        tmin = qMax(tmin, qMin(t1, t2));
+        tmax = qMin(tmax, qMax(t1, t2));
+    }
+
+    entryT = tmin;
+    return tmin <= tmax;
+}
+
+static QVector3D inverseDir(const QVector3D& dir)
+{
+    return QVector3D(dir.x() != 0.0f ? 1.0f / dir.x() : 1e30f,
+                     dir.y() != 0.0f ? 1.0f / dir.y() : 1e30f,
+                     dir.z() != 0.0f ? 1.0f / dir.z() : 1e30f);
 }
 
 //https://github.com/qt/qt3d/blob/5476bc6b4b6a12c921da502c24c4e078b04dd3b3/src/render/jobs/pickboundingvolumejob.cpp
 //realtime rendering page 192
-//no need to get uvw, just return true at the first sign of a hit
-bool TriMesh::isHitBySegment(const QVector3D& segmentStart,const QVector3D& segmentEnd,QVector3D& hitPoint)
+// qp is segmentStart - segmentEnd, t is in range 0 and 1 and denotes how far along the segment the hit is
+// only front faces are hit, like the linear tests this replaced
+static bool segmentHitsTriangle(const Triangle& tri, const QVector3D& segmentStart, const QVector3D& qp, float& t)
 {
-    for(auto tri:triangles)
-    {
-        auto ab = tri.b - tri.a;
-        auto ac = tri.c - tri.a;
-        auto qp = segmentStart-segmentEnd;
+    auto ab = tri.b - tri.a;
+    auto ac = tri.c - tri.a;
 
-        //auto normal = tri.normal;
-        auto normal = QVector3D::crossProduct(ab, ac);
-        float d = QVector3D::dotProduct(qp, normal);
+    //auto normal = tri.normal;
+    auto normal = QVector3D::crossProduct(ab, ac);
+    float d = QVector3D::dotProduct(qp, normal);
 
-        //if (d <= 0)
-        //    continue;
-        if (d == 0) continue;
+    if (d <= 0)
+        return false;
 
-        auto ap = segmentStart - tri.a;
-        auto t = QVector3D::dotProduct(ap, normal);
+    auto ap = segmentStart - tri.a;
+    t = QVector3D::dotProduct(ap, normal);
 
-        if (t < 0 || t > d)
-            continue;
+    if (t < 0 || t > d)
+        return false;
 
-        auto e = QVector3D::crossProduct(qp, ap);
-        auto v = QVector3D::dotProduct(ac, e);
+    auto e = QVector3D::crossProduct(qp, ap);
+    auto v = QVector3D::dotProduct(ac, e);
 
-        if (v < 0.0f || v > d)
-            continue;
+    if (v < 0.0f || v > d)
+        return false;
 
-        auto w = -QVector3D::dotProduct(ab, e);
+    auto w = -QVector3D::dotProduct(ab, e);
 
-        if (w < 0.0f || v + w > d)
-            continue;
+    if (w < 0.0f || v + w > d)
+        return false;
+
+    t /= d;
+    return true;
+}
 
-        t /= d;
+//no need to get uvw, just return true at the first sign of a hit
+bool TriMesh::isHitBySegment(const QVector3D& segmentStart,const QVector3D& segmentEnd,QVector3D& hitPoint)
+{
+    if (bvhNodes.isEmpty())
+        buildBvh();
+    if (bvhNodes.isEmpty())
+        return false;
+
+    auto dir = segmentEnd - segmentStart;
+    auto invDir = inverseDir(dir);
+    auto qp = segmentStart - segmentEnd;
+
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        int nodeIndex = stack.last();
+        const TriMeshBvhNode& node = bvhNodes[nodeIndex];
+        stack.removeLast();
+
+        float entryT;
+        if (!segmentHitsBox(node, segmentStart, invDir, 1.0f, entryT))
+            continue;
 
-        //all conditions have been met
-        //todo: fix please. return t instead
-        hitPoint = segmentStart + (segmentEnd-segmentStart)*t;//t is in range 0 and 1 and denotes how far along the distance the hit is
-        return true;
+        if (!node.isLeaf()) {
+            stack.append(node.offset);
+            stack.append(nodeIndex + 1);
+            continue;
+        }
+
+        for (int i = node.offset; i < node.offset + node.count; i++) {
+            float t;
+            if (segmentHitsTriangle(triangles[bvhTriangles[i]], segmentStart, qp, t)) {
+                //all conditions have been met
+                hitPoint = segmentStart + dir * t;
+                return true;
+            }
+        }
     }
 
     return false;
@@ -81,57 +314,124 @@ bool TriMesh::isHitBySegment(const QVector3D& segmentStart,const QVector3D& segm
  */
 int TriMesh::getSegmentIntersections(const QVector3D& segmentStart,const QVector3D& segmentEnd,QList<TriangleIntersectionResult>& results)
 {
-    int hits = 0;
-    for(auto i=0;i<triangles.size();i++)
-    {
-        //auto tri = triangles[i];
-        const Triangle& tri = triangles[i];
-        auto ab = tri.b - tri.a;
-        auto ac = tri.c - tri.a;
-        auto qp = segmentStart-segmentEnd;
+    if (bvhNodes.isEmpty())
+        buildBvh();
+    if (bvhNodes.isEmpty())
+        return 0;
 
-        //auto normal = tri.normal;
-        auto normal = QVector3D::crossProduct(ab, ac);
-        float d = QVector3D::dotProduct(qp, normal);
+    auto dir = segmentEnd - segmentStart;
+    auto invDir = inverseDir(dir);
+    auto qp = segmentStart - segmentEnd;
 
-        if (d <= 0)
+    int hits = 0;
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        int nodeIndex = stack.last();
+        const TriMeshBvhNode& node = bvhNodes[nodeIndex];
+        stack.removeLast();
+
+        float entryT;
+        if (!segmentHitsBox(node, segmentStart, invDir, 1.0f, entryT))
             continue;
 
-        auto ap = segmentStart - tri.a;
-        auto t = QVector3D::dotProduct(ap, normal);
-
-        if (t < 0 || t > d)
+        if (!node.isLeaf()) {
+            stack.append(node.offset);
+            stack.append(nodeIndex + 1);
             continue;
+        }
+
+        for (int i = node.offset; i < node.offset + node.count; i++) {
+            int triIndex = bvhTriangles[i];
+            float t;
+            if (!segmentHitsTriangle(triangles[triIndex], segmentStart, qp, t))
+                continue;
+
+            //all conditions have been met
+            hits++;
+
+            TriangleIntersectionResult result;
+            result.triangleIndex = triIndex;
+            result.hitPoint = segmentStart + dir * t;
+            result.t = t;
+            results.append(result);
+        }
+    }
 
-        auto e = QVector3D::crossProduct(qp, ap);
-        auto v = QVector3D::dotProduct(ac, e);
+    return hits;
+}
 
-        if (v < 0 || v > d)
+/**
+ * Finds the intersection closest to segmentStart
+ * Returns false if the segment doesnt hit the mesh
+ * @return
+ */
+bool TriMesh::getClosestSegmentIntersection(const QVector3D& segmentStart, const QVector3D& segmentEnd, TriangleIntersectionResult& result)
+{
+    if (bvhNodes.isEmpty())
+        buildBvh();
+    if (bvhNodes.isEmpty())
+        return false;
+
+    auto dir = segmentEnd - segmentStart;
+    auto invDir = inverseDir(dir);
+    auto qp = segmentStart - segmentEnd;
+
+    // nodes further than the closest hit so far are skipped
+    float closestT = 1.0f;
+    int closestTri = -1;
+
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        int nodeIndex = stack.last();
+        const TriMeshBvhNode& node = bvhNodes[nodeIndex];
+        stack.removeLast();
+
+        float entryT;
+        if (!segmentHitsBox(node, segmentStart, invDir, closestT, entryT))
             continue;
 
-        auto w = -QVector3D::dotProduct(ab, e);
-
-        if (w < 0.0f || v + w > d)
+        if (!node.isLeaf()) {
+            int left = nodeIndex + 1;
+            int right = node.offset;
+            float leftT, rightT;
+            bool hitsLeft = segmentHitsBox(bvhNodes[left], segmentStart, invDir, closestT, leftT);
+            bool hitsRight = segmentHitsBox(bvhNodes[right], segmentStart, invDir, closestT, rightT);
+
+            // the nearer child is pushed last so it's visited first
+            if (hitsLeft && hitsRight) {
+                if (leftT <= rightT) {
+                    stack.append(right);
+                    stack.append(left);
+                } else {
+                    stack.append(left);
+                    stack.append(right);
+                }
+            } else if (hitsLeft) {
+                stack.append(left);
+            } else if (hitsRight) {
+                stack.append(right);
+            }
             continue;
-
-        t /= d;
-
-        //all conditions have been met
-        hits++;
-
-        auto dist = segmentStart.distanceToPoint(segmentEnd);
-        auto hitPoint = segmentStart + (segmentEnd-segmentStart)*t;
-
-        TriangleIntersectionResult result;
-        result.triangleIndex = i;
-        result.hitPoint = hitPoint;
-        result.t = t;
-        //result.hitPoint = tri.a*u + tri.b*v + tri.c*w;
-        results.append(result);
-        hits++;
+        }
+
+        for (int i = node.offset; i < node.offset + node.count; i++) {
+            float t;
+            if (segmentHitsTriangle(triangles[bvhTriangles[i]], segmentStart, qp, t) && t <= closestT) {
+                closestT = t;
+                closestTri = bvhTriangles[i];
+            }
+        }
     }
 
-    return hits;
+    if (closestTri == -1)
+        return false;
+
+    result.triangleIndex = closestTri;
+    result.hitPoint = segmentStart + dir * closestT;
+    result.t = closestT;
+    return true;
 }
 
 }
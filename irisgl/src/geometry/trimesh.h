@@ -13,6 +13,7 @@ For more information see the LICENSE file
 #define TRIMESH_H
 
 #include <QVector3D>
+#include <QVector>
 #include <QList>
 
 namespace iris
@@ -39,13 +40,37 @@ public:
 };
 
 
+/**
+ * Node of a TriMesh's bounding volume hierarchy
+ * Nodes are stored depth first so an interior node's left child is the node
+ * right after it and offset is the index of its right child. For leaves,
+ * offset is the first of its count triangles in TriMesh::bvhTriangles
+ */
+struct TriMeshBvhNode
+{
+    QVector3D boundsMin;
+    QVector3D boundsMax;
+    int offset;
+    int count;// 0 for interior nodes
+
+    bool isLeaf() const
+    {
+        return count > 0;
+    }
+};
+
 /**
  * This class defines a mesh using triangles. It's used for ray-casting and intersection tests
  */
 class TriMesh
 {
 public:
-    QList<Triangle> triangles;
+    QVector<Triangle> triangles;
+
+    // bounding volume hierarchy over the triangles, see buildBvh()
+    QVector<TriMeshBvhNode> bvhNodes;
+    // triangle indices referenced by the bvh's leaves
+    QVector<int> bvhTriangles;
 
 
     /**
@@ -56,6 +81,13 @@ public:
      */
     void addTriangle(const QVector3D& a, const QVector3D& b, const QVector3D& c);
 
+    /**
+     * Builds the bounding volume hierarchy used by the intersection tests
+     * Splits are picked using the surface area heuristic. It's called after
+     * all triangles are added, otherwise the first query builds it.
+     */
+    void buildBvh();
+
     //https://github.com/qt/qt3d/blob/5476bc6b4b6a12c921da502c24c4e078b04dd3b3/src/render/jobs/pickboundingvolumejob.cpp
     //realtime rendering page 192
     //no need to get uvw, just return true at the first sign of a hit
@@ -68,6 +100,15 @@ public:
      */
     int getSegmentIntersections(const QVector3D& segmentStart, const QVector3D& segmentEnd, QList<TriangleIntersectionResult>& results);
 
+    /**
+     * Finds the intersection closest to segmentStart
+     * Returns false if the segment doesnt hit the mesh
+     * @return
+     */
+    bool getClosestSegmentIntersection(const QVector3D& segmentStart, const QVector3D& segmentEnd, TriangleIntersectionResult& result);
+
+private:
+    int buildBvhNode(QVector<QVector3D>& centroids, QVector<QVector3D>& mins, QVector<QVector3D>& maxs, int start, int count);
 
 };
 
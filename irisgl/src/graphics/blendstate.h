@@ -37,6 +37,16 @@ struct BlendState
         alphaDestBlend = destBlend;
     }
 
+    bool operator==(const BlendState& other) const
+    {
+        return colorSourceBlend == other.colorSourceBlend &&
+               alphaSourceBlend == other.alphaSourceBlend &&
+               colorDestBlend == other.colorDestBlend &&
+               alphaDestBlend == other.alphaDestBlend &&
+               colorBlendEquation == other.colorBlendEquation &&
+               alphaBlendEquation == other.alphaBlendEquation;
+    }
+
 	static BlendState createAlphaBlend();
 	static BlendState createOpaque();
 	static BlendState createAdditive();
@@ -25,6 +25,13 @@ struct DepthState
         depthCompareFunc = GL_LEQUAL;
     }
 
+    bool operator==(const DepthState& other) const
+    {
+        return depthBufferEnabled == other.depthBufferEnabled &&
+               depthWriteEnabled == other.depthWriteEnabled &&
+               depthCompareFunc == other.depthCompareFunc;
+    }
+
     static DepthState Default;
     static DepthState None;
 };
@@ -31,6 +31,7 @@ For more information see the LICENSE file
 #include <QSharedPointer>
 #include <QOpenGLTexture>
 #include <QMatrix4x4>
+#include <QtMath>
 #include "viewport.h"
 #include "utils/billboard.h"
 #include "utils/fullscreenquad.h"
@@ -38,6 +39,7 @@ For more information see the LICENSE file
 #include "rendertarget.h"
 #include "renderlist.h"
 #include "graphicsdevice.h"
+#include "lightclusters.h"
 #include "spritebatch.h"
 #include "font.h"
 #include "../vr/vrdevice.h"
@@ -96,7 +98,14 @@ ForwardRenderer::ForwardRenderer(bool supportsVr)
     postMan = PostProcessManager::create(graphics);
     postContext = new PostProcessContext();
 
-    perfTimer = new PerformanceTimer();
+    sceneUniformBuffer = UniformBuffer::create();
+    renderPass = 0;
+
+    lightClusters = LightClusters::create(gl);
+    clusteredLighting = lightClusters->isSupported();
+
+    instanceBuffer = VertexBuffer::create(VertexLayout::createInstanceMatrix());
+    instanceBuffer->setUsage(GL_STREAM_DRAW);
 
     renderLightBillboards = true;
 }
@@ -139,6 +148,8 @@ GraphicsDevicePtr ForwardRenderer::getGraphicsDevice()
 
 void ForwardRenderer::renderSceneToRenderTarget(RenderTargetPtr rt, CameraNodePtr cam, bool clearRenderLists, bool applyPostProcesses)
 {
+    IRIS_PROFILE_GPU("render to target", graphics);
+
     auto ctx = QOpenGLContext::currentContext();
 
     // reset states
@@ -233,7 +244,6 @@ void ForwardRenderer::renderSceneToRenderTarget(RenderTargetPtr rt, CameraNodePt
 
 void ForwardRenderer::renderScene(float delta, Viewport* vp)
 {
-    //perfTimer->start("total");
     auto ctx = QOpenGLContext::currentContext();
     auto cam = scene->camera;
 
@@ -243,7 +253,6 @@ void ForwardRenderer::renderScene(float delta, Viewport* vp)
     graphics->setRasterizerState(RasterizerState::CullCounterClockwise, true);
 
     // STEP 1: RENDER SCENE
-    //perfTimer->start("render_scene");
     renderData->scene = scene;
 
     cam->setAspectRatio(vp->getAspectRatio());
@@ -282,12 +291,9 @@ void ForwardRenderer::renderScene(float delta, Viewport* vp)
 
     renderNode(renderData, scene);
 
-    //perfTimer->end("render_scene");
     if (renderLightBillboards)
         renderBillboardIcons(renderData);
-    //perfTimer->end("render_icons");
 
-    //perfTimer->start("render_post");
     renderTarget->unbind();
 
 	// reset these states for post processing
@@ -324,15 +330,15 @@ void ForwardRenderer::renderScene(float delta, Viewport* vp)
     scene->geometryRenderList->clear();
     scene->shadowRenderList->clear();
     scene->gizmoRenderList->clear();
-
-    //perfTimer->end("total");
-
-    //perfTimer->report();
-    //perfTimer->reset();
 }
 
 void ForwardRenderer::renderShadows(ScenePtr node)
 {
+    IRIS_PROFILE_GPU("shadows", graphics);
+
+    // groups casters sharing a mesh so they can be instanced
+    scene->shadowRenderList->sort(QVector3D());
+
     for (auto light : scene->lights) {
 		if (light->getShadowMapType() != iris::ShadowMapType::None) {
 			if (light->lightType == iris::LightType::Directional) {
@@ -347,103 +353,276 @@ void ForwardRenderer::renderShadows(ScenePtr node)
 
 void ForwardRenderer::renderDirectionalShadow(LightNodePtr light, ScenePtr node)
 {
-    graphics->setRenderTarget(QList<Texture2DPtr>(),light->shadowMap->shadowTexture);
+    IRIS_PROFILE_GPU("directional shadow", graphics);
+
+    auto shadowMap = light->shadowMap;
+    int cascades = shadowMap->cascadeCount;
+
+    if (cascades > 1) {
+        fitShadowCascades(light);
+    } else {
+        QMatrix4x4 lightProjection, lightView;
+
+        lightProjection.ortho(-128.0f, 128.0f, -64.0f, 64.0f, -64.0f, 128.0f);
+
+        lightView.lookAt(QVector3D(0, 0, 0),
+                         light->getLightDir(),
+                         QVector3D(0.0001f, 1.0001f, 0.0001f));
+        QMatrix4x4 lightSpaceMatrix = lightProjection * lightView;
+        shadowMap->cascadeMatrices[0] = lightSpaceMatrix;
+        shadowMap->cascadeTextureMatrices[0] = lightSpaceMatrix;
+    }
+    shadowMap->shadowMatrix = shadowMap->cascadeTextureMatrices[0];
+
+    // keep the last map if nothing inside the light's volume changed
+    if (!updateShadowCasters(shadowMap, cascades))
+        return;
+
+    graphics->setRenderTarget(QList<Texture2DPtr>(), shadowMap->shadowTexture);
 	graphics->setRasterizerState(RasterizerState::CullClockwise);
 
-    int shadowSize = light->shadowMap->resolution;
+    int shadowSize = shadowMap->resolution;
     graphics->setViewport(QRect(0, 0, shadowSize, shadowSize));
     graphics->clear(QColor());
     //gl->glClear(COLOR_BUFFER_BIT|DEPTH_BUFFER_BIT);
-    QMatrix4x4 lightProjection, lightView;
-    QOpenGLShaderProgram* shader;
 
-    lightProjection.ortho(-128.0f, 128.0f, -64.0f, 64.0f, -64.0f, 128.0f);
+    for (int i = 0; i < cascades; i++) {
+        if (cascades > 1)
+            graphics->setViewport(shadowMap->getCascadeViewport(i));
+        renderShadowCasters(shadowMap->cascadeMatrices[i], shadowCasters[i]);
+    }
+
+	graphics->setRasterizerState(RasterizerState::CullCounterClockwise);
+    graphics->clearRenderTarget();
+}
+
+// Splits the camera's view into slices and fits an orthographic light
+// projection around each one
+// The slices are bounded by spheres and snapped to whole texels so the
+// cascades dont shimmer as the camera moves or turns
+void ForwardRenderer::fitShadowCascades(LightNodePtr light)
+{
+    auto shadowMap = light->shadowMap;
+    int cascades = shadowMap->cascadeCount;
+    auto& proj = renderData->projMatrix;
+
+    // near and far planes of the camera's perspective projection
+    float camNear = proj(2, 3) / (proj(2, 2) - 1.0f);
+    float camFar = proj(2, 3) / (proj(2, 2) + 1.0f);
+    camFar = qMin(camFar, camNear + shadowMap->cascadeDistance);
+
+    // rays through the corners of the view, scaled so their depth is 1
+    QMatrix4x4 invProj = proj.inverted();
+    QMatrix4x4 invView = renderData->viewMatrix.inverted();
+    QVector3D rays[4];
+    for (int i = 0; i < 4; i++) {
+        QVector3D corner = invProj.map(QVector3D(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, 1.0f));
+        rays[i] = corner / -corner.z();
+    }
 
+    QMatrix4x4 lightView;
     lightView.lookAt(QVector3D(0, 0, 0),
                      light->getLightDir(),
                      QVector3D(0.0001f, 1.0001f, 0.0001f));
-    QMatrix4x4 lightSpaceMatrix = lightProjection * lightView;
-    light->shadowMap->shadowMatrix = lightSpaceMatrix;
-
-    for (auto& item : scene->shadowRenderList->getItems()) {
-
-
-        if (item->type == iris::RenderItemType::Mesh && !!item->mesh) {
-            if  (item->mesh->hasSkeleton()) {
-                auto boneTransforms = item->mesh->getSkeleton()->boneTransforms;
-                skinnedShadowShader->bind();
-                skinnedShadowShader->setUniformValue("u_lightSpaceMatrix", lightSpaceMatrix);
-                skinnedShadowShader->setUniformValue("u_worldMatrix", item->worldMatrix);
-                skinnedShadowShader->setUniformValueArray("u_bones", boneTransforms.data(), boneTransforms.size());
-                shader = skinnedShadowShader;
-
-            } else {
-                shadowShader->bind();
-                shadowShader->setUniformValue("u_lightSpaceMatrix", lightSpaceMatrix);
-                shadowShader->setUniformValue("u_worldMatrix", item->worldMatrix);
-                shader = shadowShader;
-            }
-
-
 
-            //item->mesh->draw(gl, shader);
-            item->mesh->draw(graphics);
+    int tileSize = shadowMap->getCascadeResolution();
+    float sliceStart = camNear;
+
+    for (int c = 0; c < cascades; c++) {
+        // blend of logarithmic and uniform splits
+        float t = (c + 1) / (float)cascades;
+        float logSplit = camNear * qPow(camFar / camNear, t);
+        float uniformSplit = camNear + (camFar - camNear) * t;
+        float sliceEnd = 0.75f * logSplit + 0.25f * uniformSplit;
+
+        QVector3D corners[8];
+        QVector3D center;
+        for (int i = 0; i < 4; i++) {
+            corners[i] = invView.map(rays[i] * sliceStart);
+            corners[i + 4] = invView.map(rays[i] * sliceEnd);
+            center += corners[i] + corners[i + 4];
         }
+        center /= 8.0f;
+
+        float radius = 0.0f;
+        for (int i = 0; i < 8; i++)
+            radius = qMax(radius, (corners[i] - center).length());
+        // keep the size from changing with rounding errors
+        radius = qCeil(radius * 16.0f) / 16.0f;
+
+        // move the center in whole texels
+        QVector3D lightCenter = lightView.map(center);
+        float texelSize = (radius * 2.0f) / tileSize;
+        float x = qFloor(lightCenter.x() / texelSize) * texelSize;
+        float y = qFloor(lightCenter.y() / texelSize) * texelSize;
+
+        // extended towards the light to catch casters outside of the slice
+        QMatrix4x4 lightProjection;
+        lightProjection.ortho(x - radius, x + radius,
+                              y - radius, y + radius,
+                              -lightCenter.z() - radius - 128.0f,
+                              -lightCenter.z() + radius);
+
+        shadowMap->cascadeMatrices[c] = lightProjection * lightView;
+        shadowMap->cascadeTextureMatrices[c] = shadowMap->getCascadeTileMatrix(c) * shadowMap->cascadeMatrices[c];
+        shadowMap->cascadeSplits[c] = sliceEnd;
+
+        sliceStart = sliceEnd;
     }
-	graphics->setRasterizerState(RasterizerState::CullCounterClockwise);
-    graphics->clearRenderTarget();
 }
 
 void ForwardRenderer::renderSpotlightShadow(LightNodePtr light, ScenePtr node)
 {
+    IRIS_PROFILE_GPU("spot shadow", graphics);
+
+    QMatrix4x4 lightProjection, lightView;
+
+    lightProjection.perspective(light->spotCutOff*2, 1,0.1f,light->distance);
+
+    lightView.lookAt(light->getGlobalPosition(),
+                     light->getGlobalPosition() + light->getLightDir() + QVector3D(0.0001,0.0001,0.0001),
+                     QVector3D(0.0f, 1.0f, 0.0f));
+    QMatrix4x4 lightSpaceMatrix = lightProjection * lightView;
+    light->shadowMap->shadowMatrix = lightSpaceMatrix;
+    light->shadowMap->cascadeMatrices[0] = lightSpaceMatrix;
+    light->shadowMap->cascadeTextureMatrices[0] = lightSpaceMatrix;
+
+    // keep the last map if nothing inside the light's volume changed
+    if (!updateShadowCasters(light->shadowMap, 1))
+        return;
+
     graphics->setRenderTarget(QList<Texture2DPtr>(),light->shadowMap->shadowTexture);
 	graphics->setRasterizerState(RasterizerState::CullClockwise);
     //gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, shadowFBO);
     //gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, light->shadowMap->shadowTexture->getTextureId(), 0);
-    //gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, light->shadowMap->shadowTexId, 0);
-    //gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowDepthMap, 0);
 
     int shadowSize = light->shadowMap->resolution;
     graphics->setViewport(QRect(0, 0, shadowSize, shadowSize));
     graphics->clear(QColor());
 
-    QMatrix4x4 lightProjection, lightView;
-    QOpenGLShaderProgram* shader;
+    renderShadowCasters(lightSpaceMatrix, shadowCasters[0]);
 
-    lightProjection.perspective(light->spotCutOff*2, 1,0.1f,light->distance);
+	graphics->setRasterizerState(RasterizerState::CullCounterClockwise);
+    graphics->clearRenderTarget();
+}
 
-    lightView.lookAt(light->getGlobalPosition(),
-                     light->getGlobalPosition() + light->getLightDir() + QVector3D(0.0001,0.0001,0.0001),
-                     QVector3D(0.0f, 1.0f, 0.0f));
-    QMatrix4x4 lightSpaceMatrix = lightProjection * lightView;
-    light->shadowMap->shadowMatrix = lightSpaceMatrix;
+// fnv-1a
+static void hashBytes(quint64& hash, const void* data, int size)
+{
+    auto bytes = (const unsigned char*)data;
+    for (int i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
 
-    for (auto& item : scene->shadowRenderList->getItems()) {
+// Fills shadowCasters with the casters inside the frustum of each of the
+// shadow map's first cascadeCount cascades
+// Returns true if the shadow map needs to be rendered again
+bool ForwardRenderer::updateShadowCasters(ShadowMap* shadowMap, int cascadeCount)
+{
+    if (shadowCasters.size() < cascadeCount)
+        shadowCasters.resize(cascadeCount);
 
+    quint64 hash = 14695981039346656037ULL;
 
-        if (item->type == iris::RenderItemType::Mesh && !!item->mesh) {
-            if  (item->mesh->hasSkeleton()) {
-                auto boneTransforms = item->mesh->getSkeleton()->boneTransforms;
+    // animated casters change every frame
+    bool hasAnimatedCasters = false;
+
+    for (int c = 0; c < cascadeCount; c++) {
+        auto& lightSpaceMatrix = shadowMap->cascadeMatrices[c];
+        auto& casters = shadowCasters[c];
+
+        Frustum frustum;
+        frustum.build(lightSpaceMatrix);
+        casters.resize(0);
+
+        hashBytes(hash, lightSpaceMatrix.constData(), sizeof(float) * 16);
+
+        for (auto& item : scene->shadowRenderList->getItems()) {
+            if (item->type != iris::RenderItemType::Mesh || !item->mesh)
+                continue;
+
+            if (item->cullable) {
+                auto sphere = item->boundingSphere;
+                if (!frustum.isSphereInside(&sphere))
+                    continue;
+            }
+
+            casters.append(item);
+
+            auto mesh = item->mesh.data();
+            hashBytes(hash, &mesh, sizeof(mesh));
+            hashBytes(hash, item->worldMatrix.constData(), sizeof(float) * 16);
+
+            if (item->mesh->hasSkeleton())
+                hasAnimatedCasters = true;
+        }
+    }
+
+    bool needsRender = shadowMap->isDirty || hasAnimatedCasters || hash != shadowMap->casterHash;
+    shadowMap->casterHash = hash;
+    shadowMap->isDirty = false;
+
+    return needsRender;
+}
+
+void ForwardRenderer::renderShadowCasters(const QMatrix4x4& lightSpaceMatrix, const QVector<RenderItem*>& items)
+{
+    // the light space matrix is the same for every caster
+    skinnedShadowShader->bind();
+    skinnedShadowShader->setUniformValue("u_lightSpaceMatrix", lightSpaceMatrix);
+    instancedShadowShader->bind();
+    instancedShadowShader->setUniformValue("u_lightSpaceMatrix", lightSpaceMatrix);
+    shadowShader->bind();
+    shadowShader->setUniformValue("u_lightSpaceMatrix", lightSpaceMatrix);
+    QOpenGLShaderProgram* boundShader = shadowShader;
+
+    // only contains meshes, see updateShadowCasters
+    for (int i = 0; i < items.size(); i++) {
+        auto item = items[i];
+
+        if (item->mesh->hasSkeleton()) {
+            auto& boneTransforms = item->mesh->getSkeleton()->boneTransforms;
+            if (boundShader != skinnedShadowShader) {
                 skinnedShadowShader->bind();
-                skinnedShadowShader->setUniformValue("u_lightSpaceMatrix", lightSpaceMatrix);
-                skinnedShadowShader->setUniformValue("u_worldMatrix", item->worldMatrix);
-                skinnedShadowShader->setUniformValueArray("u_bones", boneTransforms.data(), boneTransforms.size());
-                shader = skinnedShadowShader;
+                boundShader = skinnedShadowShader;
+            }
+            skinnedShadowShader->setUniformValue("u_worldMatrix", item->worldMatrix);
+            skinnedShadowShader->setUniformValueArray("u_bones", boneTransforms.data(), boneTransforms.size());
+            item->mesh->draw(graphics);
+            continue;
+        }
 
-            } else {
+        // only the mesh matters for depth so consecutive casters
+        // sharing it can be drawn in a single call
+        int last = i;
+        if (graphics->supportsInstancing()) {
+            while (last + 1 < items.size() && items[last + 1]->mesh == item->mesh)
+                last++;
+        }
+
+        if (last > i) {
+            instanceData.resize(0);
+            for (int j = i; j <= last; j++)
+                addInstance(items[j]->worldMatrix);
+            uploadInstances();
+
+            if (boundShader != instancedShadowShader) {
+                instancedShadowShader->bind();
+                boundShader = instancedShadowShader;
+            }
+            item->mesh->drawInstanced(graphics, instanceBuffer, last - i + 1);
+            i = last;
+        } else {
+            if (boundShader != shadowShader) {
                 shadowShader->bind();
-                shadowShader->setUniformValue("u_lightSpaceMatrix", lightSpaceMatrix);
-                shadowShader->setUniformValue("u_worldMatrix", item->worldMatrix);
-                shader = shadowShader;
+                boundShader = shadowShader;
             }
-
-            //item->mesh->draw(gl, shader);
+            shadowShader->setUniformValue("u_worldMatrix", item->worldMatrix);
             item->mesh->draw(graphics);
         }
     }
-
-	graphics->setRasterizerState(RasterizerState::CullCounterClockwise);
-    graphics->clearRenderTarget();
 }
 
 void ForwardRenderer::renderSceneVr(float delta, Viewport* vp, bool useViewer)
@@ -467,6 +646,9 @@ void ForwardRenderer::renderSceneVr(float delta, Viewport* vp, bool useViewer)
     graphics->setRasterizerState(RasterizerState::CullCounterClockwise);
 
     if (scene->shadowEnabled) {
+        // cascades are fitted to the viewer rather than to each eye
+        renderData->viewMatrix = viewTransform.inverted();
+        renderData->projMatrix = vrDevice->getEyeProjMatrix(0, 0.1f, 1000.0f);
         renderShadows(scene);
     }
 
@@ -483,6 +665,8 @@ void ForwardRenderer::renderSceneVr(float delta, Viewport* vp, bool useViewer)
         auto proj = vrDevice->getEyeProjMatrix(eye,0.1f,1000.0f);
         renderData->projMatrix = proj;
 
+        renderData->frustum.build(proj * view);
+
         //STEP 1: RENDER SCENE
         renderData->scene = scene;
         renderData->eyePos = viewerPos;
@@ -534,27 +718,229 @@ bool ForwardRenderer::isVrSupported()
     return vrDevice->isVrSupported();
 }
 
-void ForwardRenderer::renderNode(RenderData* renderData, ScenePtr scene)
+void ForwardRenderer::setClusteredLightingEnabled(bool enabled)
+{
+    clusteredLighting = enabled && lightClusters->isSupported();
+}
+
+bool ForwardRenderer::isClusteredLightingEnabled()
 {
-    QMatrix4x4 lightView, lightProjection, lightSpaceMatrix;
+    return clusteredLighting;
+}
 
+void ForwardRenderer::updateSceneUniforms(RenderData* renderData, ScenePtr scene)
+{
+    SceneUniformBlock block;
+    memset(&block, 0, sizeof(SceneUniformBlock));
+
+    memcpy(block.viewMatrix, renderData->viewMatrix.constData(), sizeof(float) * 16);
+    memcpy(block.projMatrix, renderData->projMatrix.constData(), sizeof(float) * 16);
+    block.eyePos[0] = renderData->eyePos.x();
+    block.eyePos[1] = renderData->eyePos.y();
+    block.eyePos[2] = renderData->eyePos.z();
+    block.time = scene->getRunningTime();
+    block.sceneAmbient[0] = scene->ambientColor.redF();
+    block.sceneAmbient[1] = scene->ambientColor.greenF();
+    block.sceneAmbient[2] = scene->ambientColor.blueF();
+
+    block.fog.color[0] = renderData->fogColor.redF();
+    block.fog.color[1] = renderData->fogColor.greenF();
+    block.fog.color[2] = renderData->fogColor.blueF();
+    block.fog.color[3] = renderData->fogColor.alphaF();
+    block.fog.start = renderData->fogStart;
+    block.fog.end = renderData->fogEnd;
+    block.fog.enabled = renderData->fogEnabled;
+
+    // the block only has room for SHADER_MAX_LIGHTS lights, the rest are clustered
+    // shadow maps are bound by their light's index so lights with shadows stay in the block
+    blockLights.clear();
+    clusteredLights.clear();
     for (auto light : scene->lights) {
-        if (light->lightType == iris::LightType::Directional && true) { // cast shadows
-            lightProjection.ortho(-128.0f, 128.0f, -64.0f, 64.0f, -64.0f, 128.0f);
+        bool hasShadow = scene->shadowEnabled &&
+                         light->lightType == iris::LightType::Spot &&
+                         light->getShadowMapType() != iris::ShadowMapType::None;
+
+        if (clusteredLighting && light->lightType != iris::LightType::Directional && !hasShadow) {
+            if (light->isVisible())
+                clusteredLights.append(light);
+        } else {
+            blockLights.append(light);
+        }
+    }
 
-            lightView.lookAt(QVector3D(0, 0, 0),
-                             light->getLightDir(),
-                             QVector3D(0.0f, 1.0f, 0.0f));
+    legacyLights = blockLights;
+    for (int i = 0; i < clusteredLights.size() && legacyLights.size() < SHADER_MAX_LIGHTS; i++)
+        legacyLights.append(clusteredLights[i]);
+
+    int lightCount = qMin(blockLights.size(), SHADER_MAX_LIGHTS);
+    block.lightCount = lightCount;
+
+    for (int i = 0; i < lightCount; i++) {
+        auto light = blockLights[i];
+        auto& data = block.lights[i];
+
+        data.type = (int)light->lightType;
+        data.shadowType = (int)iris::ShadowMapType::None;
+
+        // invisible lights are left black
+        if (!light->isVisible())
+            continue;
+
+        auto pos = light->globalTransform.column(3).toVector3D();
+        auto dir = light->getLightDir();
+        data.position[0] = pos.x();
+        data.position[1] = pos.y();
+        data.position[2] = pos.z();
+        data.direction[0] = dir.x();
+        data.direction[1] = dir.y();
+        data.direction[2] = dir.z();
+        data.distance = light->distance;
+        data.cutOffAngle = light->spotCutOff;
+        data.cutOffSoftness = light->spotCutOffSoftness;
+        data.intensity = light->intensity;
+        data.color[0] = light->color.redF();
+        data.color[1] = light->color.greenF();
+        data.color[2] = light->color.blueF();
+        data.color[3] = light->color.alphaF();
+
+        data.cascadeCount = 1;
+
+        if (scene->shadowEnabled) {
+            auto shadowMap = light->shadowMap;
+            if (light->lightType == iris::LightType::Directional)
+                data.cascadeCount = shadowMap->cascadeCount;
+
+            for (int c = 0; c < data.cascadeCount; c++) {
+                memcpy(data.shadowMatrices[c], shadowMap->cascadeTextureMatrices[c].constData(), sizeof(float) * 16);
+                data.cascadeSplits[c] = shadowMap->cascadeSplits[c];
+            }
+
+            if (light->lightType != iris::LightType::Point)
+                data.shadowType = (int)light->shadowMap->shadowType;
 
-            lightSpaceMatrix = lightProjection * lightView;
+            graphics->setTexture(GraphicsDevice::MATERIAL_TEXTURE_UNITS + i, light->shadowMap->shadowTexture);
         }
     }
 
-    auto lightCount = renderData->scene->lights.size();
+    if (clusteredLighting) {
+        auto viewport = graphics->getViewport();
+        lightClusters->update(clusteredLights, renderData->viewMatrix, renderData->projMatrix, viewport);
+        lightClusters->bind();
+
+        block.clusterGrid[0] = LightClusters::GRID_X;
+        block.clusterGrid[1] = LightClusters::GRID_Y;
+        block.clusterGrid[2] = LightClusters::GRID_Z;
+        block.clusterGrid[3] = lightClusters->getLightCount() > 0 ? 1 : 0;
+        block.clusterViewport[0] = viewport.x();
+        block.clusterViewport[1] = viewport.y();
+        block.clusterViewport[2] = viewport.width();
+        block.clusterViewport[3] = viewport.height();
+        block.clusterDepth[0] = lightClusters->getNearDepth();
+        block.clusterDepth[1] = lightClusters->getSliceScale();
+    }
+
+    sceneUniformBuffer->setData(&block, sizeof(SceneUniformBlock));
+    graphics->setUniformBuffer(UniformBlockBinding::SceneData, sceneUniformBuffer);
+}
 
-    scene->geometryRenderList->sort();
+// Sets the uniforms that stay the same for every item in this pass
+// Uniforms are part of the program's state so this only needs to happen
+// the first time a shader is used in a pass
+void ForwardRenderer::setPassUniforms(RenderData* renderData, ScenePtr scene, ShaderPtr shader)
+{
+    if (shader->sceneUniformsPass == renderPass)
+        return;
+    shader->sceneUniformsPass = renderPass;
+
+    auto& loc = shader->builtins;
+    int lightCount = qMin(legacyLights.size(), SHADER_MAX_LIGHTS);
+
+    // shadow maps are bound to texture units 8 and up
+    if (loc.shadowMaps != -1) {
+        GLint units[SHADER_MAX_LIGHTS];
+        for (int i = 0; i < SHADER_MAX_LIGHTS; i++)
+            units[i] = GraphicsDevice::MATERIAL_TEXTURE_UNITS + i;
+        graphics->setShaderUniformArray(loc.shadowMaps, units, SHADER_MAX_LIGHTS);
+    }
+
+    graphics->setShaderUniform(loc.clusterLights,   (int)LightClusters::LIGHTS_UNIT);
+    graphics->setShaderUniform(loc.clusterCells,    (int)LightClusters::CELLS_UNIT);
+    graphics->setShaderUniform(loc.clusterIndices,  (int)LightClusters::INDICES_UNIT);
+
+    // shaders using the SceneData block get the rest from the uniform buffer
+    if (shader->usesSceneUniformBlock())
+        return;
+
+    graphics->setShaderUniform(loc.viewMatrix,      renderData->viewMatrix);
+    graphics->setShaderUniform(loc.projMatrix,      renderData->projMatrix);
+    graphics->setShaderUniform(loc.time,            scene->getRunningTime());
+    graphics->setShaderUniform(loc.eyePos,          renderData->eyePos);
+    graphics->setShaderUniform(loc.sceneAmbient,    QVector3D(scene->ambientColor.redF(),
+                                                              scene->ambientColor.greenF(),
+                                                              scene->ambientColor.blueF()));
+
+    graphics->setShaderUniform(loc.fogColor,    renderData->fogColor);
+    graphics->setShaderUniform(loc.fogStart,    renderData->fogStart);
+    graphics->setShaderUniform(loc.fogEnd,      renderData->fogEnd);
+
+    graphics->setShaderUniform(loc.lightCount, lightCount);
+    for (int i = 0; i < lightCount; i++) {
+        auto light = legacyLights[i];
+        auto& lightLoc = loc.lights[i];
+
+        if (!light->isVisible()) {
+            //quick hack for now
+            graphics->setShaderUniform(lightLoc.color, QColor(0, 0, 0));
+            graphics->setShaderUniform(lightLoc.shadowType, (int)iris::ShadowMapType::None);
+            continue;
+        }
+
+        graphics->setShaderUniform(lightLoc.type,           (int)light->lightType);
+        graphics->setShaderUniform(lightLoc.position,       light->globalTransform.column(3).toVector3D());
+        graphics->setShaderUniform(lightLoc.distance,       light->distance);
+        graphics->setShaderUniform(lightLoc.direction,      light->getLightDir());
+        graphics->setShaderUniform(lightLoc.cutOffAngle,    light->spotCutOff);
+        graphics->setShaderUniform(lightLoc.cutOffSoftness, light->spotCutOffSoftness);
+        graphics->setShaderUniform(lightLoc.intensity,      light->intensity);
+        graphics->setShaderUniform(lightLoc.color,          light->color);
+
+        if (!scene->shadowEnabled) {
+            graphics->setShaderUniform(lightLoc.shadowType, (int)iris::ShadowMapType::None);
+        } else {
+            graphics->setShaderUniform(lightLoc.shadowMap,      GraphicsDevice::MATERIAL_TEXTURE_UNITS + i);
+            graphics->setShaderUniform(lightLoc.shadowMatrix,   light->shadowMap->shadowMatrix);
+            if (light->lightType == iris::LightType::Point)
+                graphics->setShaderUniform(lightLoc.shadowType, (int)iris::ShadowMapType::None);
+            else
+                graphics->setShaderUniform(lightLoc.shadowType, (int)light->shadowMap->shadowType);
+        }
+    }
+}
+
+void ForwardRenderer::renderNode(RenderData* renderData, ScenePtr scene)
+{
+    // scene data and shadow maps are uploaded once for the whole pass
+    renderPass++;
+    updateSceneUniforms(renderData, scene);
+
+    // items are grouped by shader and material so consecutive items
+    // using the same material can skip binding it again
+    scene->geometryRenderList->sort(renderData->eyePos);
+    iris::MaterialPtr activeMaterial;
+    bool activeMaterialInstanced = false;
+
+    // transparent items are sorted after the opaque ones
+    ProfileZone zone("opaque", graphics->getGpuTimer());
+    bool transparent = false;
+
+    auto items = scene->geometryRenderList->getItems();
+    for (int i = 0; i < items.size(); i++) {
+        auto item = items[i];
+        if (!transparent && item->renderLayer >= (int)RenderLayer::Transparent) {
+            zone.restart("transparent");
+            transparent = true;
+        }
 
-    for (auto& item : scene->geometryRenderList->getItems()) {
         if (item->type == iris::RenderItemType::Mesh && !!item->mesh) {
 
             if (item->cullable) {
@@ -567,121 +953,78 @@ void ForwardRenderer::renderNode(RenderData* renderData, ScenePtr scene)
                 }
             }
 
+            // collect the visible items of the run sharing this item's mesh,
+            // material and states so they can be drawn in one call
+            int last = i;
+            instanceData.resize(0);
+            if (canInstance(item)) {
+                addInstance(item->worldMatrix);
+
+                while (last + 1 < items.size() && isSameBatch(item, items[last + 1])) {
+                    last++;
+                    auto other = items[last];
+                    if (other->cullable) {
+                        auto sphere = other->boundingSphere;
+                        if (!renderData->frustum.isSphereInside(&sphere))
+                            continue;
+                    }
+
+                    addInstance(other->worldMatrix);
+                }
+            }
+            int instanceCount = instanceData.size() / 16;
+            bool instanced = instanceCount > 1;
+
             QOpenGLShaderProgram* program = nullptr;
-            iris::MaterialPtr mat;
+            iris::MaterialPtr mat = item->material;
 
-            // if a material is set then use it and get its shaderprogram
+            // finish the previous material only when it changes
+            if (!!activeMaterial && (activeMaterial != mat || activeMaterialInstanced != instanced)) {
+                activeMaterial->end(graphics, scene);
+                activeMaterial->setInstanced(false);
+                activeMaterial.clear();
+            }
 
-            if (!!item->material) {
-                mat = item->material;
-                //program = mat->getProgram();
+            // if a material is set then use it and get its shaderprogram
 
-                mat->begin(graphics, scene);
-				graphics->setShader(mat->shader);
+            if (!!mat) {
+                if (activeMaterial != mat) {
+                    mat->setInstanced(instanced);
+                    graphics->setShader(mat->getActiveShader());
+                    mat->begin(graphics, scene);
+                    activeMaterial = mat;
+                    activeMaterialInstanced = instanced;
+                }
             } else {
                 program = item->shaderProgram;
                 program->bind();
-            }
-
-            // send transform and light data
-			graphics->setShaderUniform("u_worldMatrix",   item->worldMatrix);
-			graphics->setShaderUniform("u_viewMatrix",    renderData->viewMatrix);
-			graphics->setShaderUniform("u_projMatrix",    renderData->projMatrix);
-
-			graphics->setShaderUniform("u_time", scene->getRunningTime());
-
-            if  (item->mesh->hasSkeleton()) {
-                auto& boneTransforms = item->mesh->getSkeleton()->boneTransforms;
-                graphics->setShaderUniformArray("u_bones", boneTransforms.data(), boneTransforms.size());
-				
-			}
-
-			graphics->setShaderUniform("u_normalMatrix",  item->worldMatrix.normalMatrix());
-
-			graphics->setShaderUniform("u_eyePos",        renderData->eyePos);
-			graphics->setShaderUniform("u_sceneAmbient",  QVector3D(scene->ambientColor.redF(),
-                                                                  scene->ambientColor.greenF(),
-                                                                  scene->ambientColor.blueF()));
 
-            if (item->renderStates.fogEnabled && scene->fogEnabled ) {
-				graphics->setShaderUniform("u_fogData.color", renderData->fogColor);
-				graphics->setShaderUniform("u_fogData.start", renderData->fogStart);
-				graphics->setShaderUniform("u_fogData.end",   renderData->fogEnd);
-
-				graphics->setShaderUniform("u_fogData.enabled", true);
-            } else {
-				graphics->setShaderUniform("u_fogData.enabled", false);
-            }
-            /*
-            if (item->renderStates.receiveShadows && scene->shadowEnabled) {
-                program->setUniformValue("u_shadowMap", 8);
-                program->setUniformValue("u_shadowEnabled", true);
-            } else {
-                program->setUniformValue("u_shadowEnabled", false);
+                program->setUniformValue("u_worldMatrix",   item->worldMatrix);
+                program->setUniformValue("u_viewMatrix",    renderData->viewMatrix);
+                program->setUniformValue("u_projMatrix",    renderData->projMatrix);
+                program->setUniformValue("u_normalMatrix",  item->worldMatrix.normalMatrix());
             }
 
+            if (!!mat) {
+                auto shader = mat->getActiveShader();
+                auto& loc = shader->builtins;
 
-            gl->glActiveTexture(GL_TEXTURE8);
-            gl->glBindTexture(GL_TEXTURE_2D, shadowDepthMap);
-
-            program->setUniformValue("u_lightSpaceMatrix",  lightSpaceMatrix);
-            */
-			graphics->setShaderUniform("u_lightCount",        lightCount);
-            int shadowIndex = 8;
-            // only materials get lights passed to it
-            if ( item->renderStates.receiveLighting ) {
-                for (int i=0;i<lightCount;i++)
-                {
-                    QString lightPrefix = QString("u_lights[%0].").arg(i);
-
-                    auto light = renderData->scene->lights[i];
-                    if(!light->isVisible())
-                    {
-                        //quick hack for now
-						graphics->setShaderUniform(lightPrefix+"color", QColor(0,0,0));
-                        continue;
-                    }
+                setPassUniforms(renderData, scene, shader);
 
-					graphics->setShaderUniform(lightPrefix+"type", (int)light->lightType);
-					graphics->setShaderUniform(lightPrefix+"position", light->globalTransform.column(3).toVector3D());
-                    //mat->setUniformValue(lightPrefix+"direction", light->getDirection());
-					graphics->setShaderUniform(lightPrefix+"distance", light->distance);
-					graphics->setShaderUniform(lightPrefix+"direction", light->getLightDir());
-					graphics->setShaderUniform(lightPrefix+"cutOffAngle", light->spotCutOff);
-					graphics->setShaderUniform(lightPrefix+"cutOffSoftness", light->spotCutOffSoftness);
-					graphics->setShaderUniform(lightPrefix+"intensity", light->intensity);
-					graphics->setShaderUniform(lightPrefix+"color", light->color);
-
-					graphics->setShaderUniform(lightPrefix+"constantAtten", 1.0f);
-					graphics->setShaderUniform(lightPrefix+"linearAtten", 0.0f);
-					graphics->setShaderUniform(lightPrefix+"quadtraticAtten", 1.0f);
-
-                    // shadow data
-//                    mat->setUniformValue(lightPrefix+"shadowEnabled",
-//                                         item->renderStates.receiveShadows &&
-//                                         scene->shadowEnabled &&
-//                                         light->lightType != iris::LightType::Point);
-					if (!scene->shadowEnabled) {
-						graphics->setShaderUniform(lightPrefix + "shadowType", (int)iris::ShadowMapType::None);
-					}
-					else {
-						graphics->setShaderUniform(lightPrefix + "shadowMap", shadowIndex);
-						//mat->setUniformValue(QString("shadowMaps[%0].").arg(i), 8);
-						graphics->setShaderUniform(lightPrefix + "shadowMatrix", light->shadowMap->shadowMatrix);
-						if (light->lightType == iris::LightType::Point)
-							graphics->setShaderUniform(lightPrefix + "shadowType", (int)iris::ShadowMapType::None);
-						else
-							graphics->setShaderUniform(lightPrefix + "shadowType", (int)light->shadowMap->shadowType);
-
-
-						graphics->setTexture(shadowIndex, light->shadowMap->shadowTexture);
-						shadowIndex++;
-					}
-                    //shadowDepthMap
-                    //gl->glActiveTexture(GL_TEXTURE8);
-                    //gl->glBindTexture(GL_TEXTURE_2D, light->shadowMap->shadowTexId);
-                    //gl->glBindTexture(GL_TEXTURE_2D, shadowDepthMap);
+                // send per-item data, instances get their world matrix from the instance buffer
+                if (!instanced) {
+                    graphics->setShaderUniform(loc.worldMatrix,   item->worldMatrix);
+                    graphics->setShaderUniform(loc.normalMatrix,  item->worldMatrix.normalMatrix());
                 }
+
+                if (item->mesh->hasSkeleton()) {
+                    auto& boneTransforms = item->mesh->getSkeleton()->boneTransforms;
+                    graphics->setShaderUniformArray(loc.bones, boneTransforms.data(), boneTransforms.size());
+                }
+
+                bool receiveFog = item->renderStates.fogEnabled;
+                graphics->setShaderUniform(loc.receiveFog, receiveFog);
+                graphics->setShaderUniform(loc.fogEnabled, receiveFog && renderData->fogEnabled);
             }
 
             // set render states
@@ -689,19 +1032,71 @@ void ForwardRenderer::renderNode(RenderData* renderData, ScenePtr scene)
             graphics->setDepthState(item->renderStates.depthState);
             graphics->setBlendState(item->renderStates.blendState);
 
-            //item->mesh->draw(gl, program);
-			item->mesh->draw(graphics);
-
-            if (!!mat) {
-                mat->end(graphics, scene);
+            if (instanced) {
+                uploadInstances();
+                item->mesh->drawInstanced(graphics, instanceBuffer, instanceCount);
+            } else {
+                //item->mesh->draw(gl, program);
+                item->mesh->draw(graphics);
             }
+
+            // skip the items drawn or culled as part of this batch
+            i = last;
         }
         else if(item->type == iris::RenderItemType::ParticleSystem) {
+            if (item->cullable) {
+                auto sphere = item->boundingSphere;
+                if (!renderData->frustum.isSphereInside(&sphere))
+                    continue;
+            }
+
+            // particles bind their own shader
+            if (!!activeMaterial) {
+                activeMaterial->end(graphics, scene);
+                activeMaterial->setInstanced(false);
+                activeMaterial.clear();
+            }
+
+            IRIS_PROFILE_GPU("particles", graphics);
             auto ps = item->sceneNode.staticCast<ParticleSystemNode>();
             ps->renderParticles(graphics, renderData, particleShader);
         }
     }
 
+    if (!!activeMaterial) {
+        activeMaterial->end(graphics, scene);
+        activeMaterial->setInstanced(false);
+    }
+}
+
+// Skinned meshes and sorted transparent items are always drawn one at a time
+bool ForwardRenderer::canInstance(RenderItem* item)
+{
+    return graphics->supportsInstancing() &&
+           !!item->material &&
+           !item->mesh->hasSkeleton() &&
+           item->renderLayer < (int)RenderLayer::Transparent &&
+           item->material->supportsInstancing();
+}
+
+bool ForwardRenderer::isSameBatch(RenderItem* first, RenderItem* item)
+{
+    return item->type == iris::RenderItemType::Mesh &&
+           item->mesh == first->mesh &&
+           item->material == first->material &&
+           item->renderStates == first->renderStates;
+}
+
+void ForwardRenderer::addInstance(const QMatrix4x4& worldMatrix)
+{
+    auto data = worldMatrix.constData();
+    for (int i = 0; i < 16; i++)
+        instanceData.append(data[i]);
+}
+
+void ForwardRenderer::uploadInstances()
+{
+    instanceBuffer->setData(instanceData.constData(), instanceData.size() * sizeof(float));
 }
 
 void ForwardRenderer::renderSky(RenderData* renderData)
@@ -737,6 +1132,8 @@ void ForwardRenderer::renderSky(RenderData* renderData)
 
 void ForwardRenderer::renderBillboardIcons(RenderData* renderData)
 {
+    IRIS_PROFILE_GPU("light icons", graphics);
+
     gl->glDisable(GL_CULL_FACE);
 
     auto lightCount = renderData->scene->lights.size();
@@ -885,6 +1282,9 @@ void ForwardRenderer::createShadowShader()
     shadowShader = GraphicsHelper::loadShader(":assets/shaders/shadow_map.vert",
                                               ":assets/shaders/shadow_map.frag");
 
+    instancedShadowShader = GraphicsHelper::loadShader(":assets/shaders/shadow_map_instanced.vert",
+                                                       ":assets/shaders/shadow_map.frag");
+
     shadowShader->bind();
 }
 
@@ -900,6 +1300,12 @@ void ForwardRenderer::createParticleShader()
     particleShader->addShader(vshader);
     particleShader->addShader(fshader);
 
+    // must match ParticleRenderer's vertex buffers
+    particleShader->bindAttributeLocation("a_pos", (int)VertexAttribUsage::Position);
+    particleShader->bindAttributeLocation("a_texCoord", (int)VertexAttribUsage::TexCoord0);
+    particleShader->bindAttributeLocation("a_particlePos", (int)VertexAttribUsage::InstanceMatrix);
+    particleShader->bindAttributeLocation("a_particleParams", (int)VertexAttribUsage::InstanceMatrix + 1);
+
     particleShader->link();
 
     particleShader->bind();
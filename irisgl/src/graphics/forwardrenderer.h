@@ -14,10 +14,11 @@ For more information see the LICENSE file
 
 #include <QOpenGLContext>
 #include <QSharedPointer>
+#include <QVector>
+#include <QMatrix4x4>
 //#include "../libovr/Include/OVR_CAPI_GL.h"
 #include "../irisglfwd.h"
 
-#include "particle.h"
 #include "particlerender.h"
 
 #define OUTLINE_STENCIL_CHANNEL 1
@@ -40,7 +41,8 @@ class FullScreenQuad;
 class VrDevice;
 class PostProcessManager;
 class PostProcessContext;
-class PerformanceTimer;
+struct RenderItem;
+class ShadowMap;
 
 /**
  * This is a basic forward renderer.
@@ -67,6 +69,7 @@ class ForwardRenderer
     QOpenGLShaderProgram* skinnedLineShader;
     QOpenGLShaderProgram* shadowShader;
     QOpenGLShaderProgram* skinnedShadowShader;
+    QOpenGLShaderProgram* instancedShadowShader;
     QOpenGLShaderProgram* particleShader;
     QOpenGLShaderProgram* emitterShader;
 
@@ -80,7 +83,29 @@ class ForwardRenderer
     Texture2DPtr depthRenderTexture;
     Texture2DPtr finalRenderTexture;
 
-    PerformanceTimer* perfTimer;
+    // scene data shared by all shaders through the SceneData uniform block
+    UniformBufferPtr sceneUniformBuffer;
+
+    // point and spot lights without shadows are binned into clusters
+    // instead of taking up one of the few slots in the uniform block
+    LightClustersPtr lightClusters;
+    bool clusteredLighting;
+
+    // lights split once per pass by updateSceneUniforms(), light i of the
+    // block has its shadow map on texture unit 8 + i
+    QList<LightNodePtr> blockLights;
+    QList<LightNodePtr> clusteredLights;
+    // shaders without the block cant read clusters so they get the block's
+    // lights followed by clustered ones, up to SHADER_MAX_LIGHTS
+    QList<LightNodePtr> legacyLights;
+
+    // incremented every time renderNode is called, shaders are stamped with
+    // it once their per-pass uniforms have been set
+    long renderPass;
+
+    // world matrices of the current instance batch, 16 floats per instance
+    QVector<float> instanceData;
+    VertexBufferPtr instanceBuffer;
 
 public:
 
@@ -110,6 +135,10 @@ public:
 
     PostProcessManagerPtr getPostProcessManager();
 
+    // on by default, only the first SHADER_MAX_LIGHTS lights are used when it's off
+    void setClusteredLightingEnabled(bool enabled);
+    bool isClusteredLightingEnabled();
+
     static ForwardRendererPtr create(bool useVr = true);
 
     bool isVrSupported();
@@ -120,6 +149,13 @@ private:
     ForwardRenderer(bool supportsVr = true);
 
     void renderNode(RenderData* renderData, ScenePtr node);
+    void updateSceneUniforms(RenderData* renderData, ScenePtr scene);
+    void setPassUniforms(RenderData* renderData, ScenePtr scene, ShaderPtr shader);
+
+    bool canInstance(RenderItem* item);
+    bool isSameBatch(RenderItem* first, RenderItem* item);
+    void addInstance(const QMatrix4x4& worldMatrix);
+    void uploadInstances();
     void renderSky(RenderData* renderData);
     void renderBillboardIcons(RenderData* renderData);
     void renderSelectedNode(RenderData* renderData, SceneNodePtr node);
@@ -137,7 +173,13 @@ private:
     void createShadowShader();
     void renderShadows(ScenePtr node);
     void renderDirectionalShadow(LightNodePtr lightNode,ScenePtr node);
+    void fitShadowCascades(LightNodePtr lightNode);
     void renderSpotlightShadow(LightNodePtr lightNode,ScenePtr node);
+    bool updateShadowCasters(ShadowMap* shadowMap, int cascadeCount);
+    void renderShadowCasters(const QMatrix4x4& lightSpaceMatrix, const QVector<RenderItem*>& items);
+
+    // casters inside the frustum of each cascade of the light being rendered
+    QVector<QVector<RenderItem*>> shadowCasters;
     void generateShadowBuffer(GLuint size = 1024);
 
     //editor-specific
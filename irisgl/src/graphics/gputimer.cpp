@@ -0,0 +1,157 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "gputimer.h"
+#include "../core/performancetimer.h"
+
+#include <QOpenGLContext>
+
+// from ARB_timer_query
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+
+namespace iris
+{
+
+GpuTimer::GpuTimer(QOpenGLContext* context, QOpenGLFunctions_3_2_Core* gl)
+{
+    this->gl = gl;
+    frameIndex = 0;
+    inFrame = false;
+
+    glQueryCounter = nullptr;
+    glGetQueryObjectui64v = nullptr;
+    if (context->format().version() >= qMakePair(3, 3) || context->hasExtension("GL_ARB_timer_query")) {
+        glQueryCounter = (QueryCounterFunc)context->getProcAddress("glQueryCounter");
+        glGetQueryObjectui64v = (GetQueryObjectui64vFunc)context->getProcAddress("glGetQueryObjectui64v");
+    }
+}
+
+GpuTimer::~GpuTimer()
+{
+    for (auto& frame : frames) {
+        for (auto& zone : frame.zones) {
+            freeQueries.append(zone.startQuery);
+            if (zone.endQuery != 0)
+                freeQueries.append(zone.endQuery);
+        }
+    }
+
+    if (!freeQueries.isEmpty())
+        gl->glDeleteQueries(freeQueries.size(), freeQueries.data());
+}
+
+bool GpuTimer::isSupported()
+{
+    return glQueryCounter != nullptr && glGetQueryObjectui64v != nullptr;
+}
+
+void GpuTimer::beginFrame()
+{
+    inFrame = false;
+    if (!isSupported() || !PerformanceTimer::getSingleton()->isEnabled())
+        return;
+
+    frameIndex = (frameIndex + 1) % (FRAME_LATENCY + 1);
+    auto& frame = frames[frameIndex];
+
+    // this slot was last used FRAME_LATENCY frames ago so its results should be ready
+    resolveFrame(frame);
+
+    frame.cpuTime = PerformanceTimer::getSingleton()->now();
+    gl->glGetInteger64v(GL_TIMESTAMP, &frame.gpuTime);
+
+    inFrame = true;
+    openZones.clear();
+    begin("frame");
+}
+
+void GpuTimer::endFrame()
+{
+    if (!inFrame)
+        return;
+
+    while (!openZones.isEmpty())
+        end();
+
+    inFrame = false;
+}
+
+void GpuTimer::begin(const char* name)
+{
+    if (!inFrame)
+        return;
+
+    Zone zone;
+    zone.name = name;
+    zone.startQuery = getQuery();
+    zone.endQuery = 0;
+    zone.depth = openZones.size();
+    glQueryCounter(zone.startQuery, GL_TIMESTAMP);
+
+    auto& zones = frames[frameIndex].zones;
+    zones.append(zone);
+    openZones.push(zones.size() - 1);
+}
+
+void GpuTimer::end()
+{
+    if (!inFrame || openZones.isEmpty())
+        return;
+
+    auto& zone = frames[frameIndex].zones[openZones.pop()];
+    zone.endQuery = getQuery();
+    glQueryCounter(zone.endQuery, GL_TIMESTAMP);
+}
+
+GLuint GpuTimer::getQuery()
+{
+    if (freeQueries.isEmpty()) {
+        freeQueries.resize(32);
+        gl->glGenQueries(freeQueries.size(), freeQueries.data());
+    }
+
+    auto query = freeQueries.last();
+    freeQueries.removeLast();
+    return query;
+}
+
+void GpuTimer::resolveFrame(Frame& frame)
+{
+    if (frame.zones.isEmpty())
+        return;
+
+    QVector<ProfileEvent> events;
+    for (auto& zone : frame.zones) {
+        if (zone.endQuery != 0) {
+            GLuint64 start, end;
+            glGetQueryObjectui64v(zone.startQuery, GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(zone.endQuery, GL_QUERY_RESULT, &end);
+
+            ProfileEvent event;
+            event.name = zone.name;
+            event.start = frame.cpuTime + (qint64)(start - frame.gpuTime);
+            event.end = frame.cpuTime + (qint64)(end - frame.gpuTime);
+            event.depth = zone.depth;
+            events.append(event);
+
+            freeQueries.append(zone.endQuery);
+        }
+
+        freeQueries.append(zone.startQuery);
+    }
+
+    frame.zones.clear();
+    PerformanceTimer::getSingleton()->addGpuEvents(events);
+}
+
+}
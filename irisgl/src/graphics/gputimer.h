@@ -0,0 +1,89 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <QOpenGLFunctions_3_2_Core>
+#include <QStack>
+#include <QVector>
+
+class QOpenGLContext;
+
+namespace iris
+{
+
+/**
+ * Times zones on the gpu with timestamp queries
+ *
+ * The results of a frame are read FRAME_LATENCY frames after it was
+ * submitted so waiting for them doesnt stall the pipeline. They're handed to
+ * the PerformanceTimer converted to its time so they line up with cpu zones.
+ * Does nothing if the context doesnt support ARB_timer_query.
+ */
+class GpuTimer
+{
+    static const int FRAME_LATENCY = 3;
+
+    // glQueryCounter and glGetQueryObjectui64v are core in gl 3.3
+    typedef void (QOPENGLF_APIENTRYP QueryCounterFunc)(GLuint id, GLenum target);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectui64vFunc)(GLuint id, GLenum pname, GLuint64* params);
+    QueryCounterFunc glQueryCounter;
+    GetQueryObjectui64vFunc glGetQueryObjectui64v;
+
+    QOpenGLFunctions_3_2_Core* gl;
+
+    struct Zone
+    {
+        const char* name;
+        GLuint startQuery;
+        GLuint endQuery;
+        int depth;
+    };
+
+    struct Frame
+    {
+        QVector<Zone> zones;
+
+        // the cpu and gpu time when the frame began, for converting between the two
+        qint64 cpuTime;
+        GLint64 gpuTime;
+    };
+
+    Frame frames[FRAME_LATENCY + 1];
+    int frameIndex;
+    bool inFrame;
+
+    QStack<int> openZones;
+    QVector<GLuint> freeQueries;
+
+public:
+    GpuTimer(QOpenGLContext* context, QOpenGLFunctions_3_2_Core* gl);
+    ~GpuTimer();
+
+    bool isSupported();
+
+    // zones are only timed between these, when the PerformanceTimer is enabled
+    void beginFrame();
+    void endFrame();
+
+    // zones can be nested, see ProfileZone
+    void begin(const char* name);
+    void end();
+
+private:
+    GLuint getQuery();
+    void resolveFrame(Frame& frame);
+};
+
+}
+
+#endif // GPUTIMER_H
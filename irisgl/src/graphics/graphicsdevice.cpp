@@ -5,17 +5,49 @@
 #include "texture2d.h"
 #include "vertexlayout.h"
 #include "shader.h"
+#include "gputimer.h"
+#include "../core/shadermanager.h"
 
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFunctions_3_2_Core>
 #include <QOpenGLFunctions>
+#include <QMap>
+#include <QMutex>
+#include <QCryptographicHash>
+
+// from ARB_get_program_binary
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
 
 namespace iris
 {
 
+// buffers can be released from any thread (meshes are evicted from loader threads)
+// so their gl names are queued and deleted by the next device to begin a frame
+static QMutex releasedBuffersMutex;
+static QVector<GLuint> releasedBuffers;
+
+static void releaseBuffer(GLuint& bufferId)
+{
+    if (bufferId == (GLuint)-1)
+        return;
+
+    QMutexLocker locker(&releasedBuffersMutex);
+    releasedBuffers.append(bufferId);
+    bufferId = -1;
+}
+
 VertexBuffer::VertexBuffer(VertexLayout vertexLayout)
 {
     this->vertexLayout = vertexLayout;
+    usage = GL_STATIC_DRAW;
     bufferId = -1;
     data = nullptr;
     dataSize = 0;
@@ -24,8 +56,9 @@ VertexBuffer::VertexBuffer(VertexLayout vertexLayout)
 
 void VertexBuffer::setData(void *bufferData, unsigned int sizeInBytes)
 {
-    if(data)
-        delete data;
+    if(data && !mappedFile)
+        delete[] (char*)data;
+    mappedFile.clear();
 
     data = new char[sizeInBytes];
     memcpy(this->data, bufferData, sizeInBytes);
@@ -34,11 +67,32 @@ void VertexBuffer::setData(void *bufferData, unsigned int sizeInBytes)
     _isDirty = true;
 }
 
+void VertexBuffer::setMappedData(QSharedPointer<QFile> file, void *bufferData, unsigned int sizeInBytes)
+{
+    if(data && !mappedFile)
+        delete[] (char*)data;
+
+    mappedFile = file;
+    data = bufferData;
+    dataSize = sizeInBytes;
+
+    _isDirty = true;
+}
+
+VertexBuffer::~VertexBuffer()
+{
+    destroy();
+}
+
 void VertexBuffer::destroy()
 {
-    if (data)
-        delete data;
-    // todo: delete gl buffer
+    if (data && !mappedFile)
+        delete[] (char*)data;
+    mappedFile.clear();
+    data = nullptr;
+    dataSize = 0;
+
+    releaseBuffer(bufferId);
 }
 
 void VertexBuffer::upload(QOpenGLFunctions_3_2_Core* gl)
@@ -49,8 +103,7 @@ void VertexBuffer::upload(QOpenGLFunctions_3_2_Core* gl)
         gl->glGenBuffers(1, &bufferId);
 
     gl->glBindBuffer(GL_ARRAY_BUFFER, bufferId);
-    // todo : add buffer usage option (nick)
-    gl->glBufferData(GL_ARRAY_BUFFER, dataSize, data, GL_STATIC_DRAW);
+    gl->glBufferData(GL_ARRAY_BUFFER, dataSize, data, usage);
     gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     _isDirty = false;
@@ -59,6 +112,7 @@ void VertexBuffer::upload(QOpenGLFunctions_3_2_Core* gl)
 IndexBuffer::IndexBuffer()
 {
     this->device = device;
+    indexType = GL_UNSIGNED_INT;
     bufferId = -1;
     data = nullptr;
     dataSize = 0;
@@ -67,8 +121,9 @@ IndexBuffer::IndexBuffer()
 
 void IndexBuffer::setData(void *bufferData, unsigned int sizeInBytes)
 {
-    if(data)
-        delete data;
+    if(data && !mappedFile)
+        delete[] (char*)data;
+    mappedFile.clear();
 
     data = new char[sizeInBytes];
     memcpy(this->data, bufferData, sizeInBytes);
@@ -77,6 +132,18 @@ void IndexBuffer::setData(void *bufferData, unsigned int sizeInBytes)
     _isDirty = true;
 }
 
+void IndexBuffer::setMappedData(QSharedPointer<QFile> file, void *bufferData, unsigned int sizeInBytes)
+{
+    if(data && !mappedFile)
+        delete[] (char*)data;
+
+    mappedFile = file;
+    data = bufferData;
+    dataSize = sizeInBytes;
+
+    _isDirty = true;
+}
+
 void IndexBuffer::upload(QOpenGLFunctions_3_2_Core* gl)
 {
     //auto gl = device->getGL();
@@ -87,13 +154,70 @@ void IndexBuffer::upload(QOpenGLFunctions_3_2_Core* gl)
     gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferId);
     gl->glBufferData(GL_ELEMENT_ARRAY_BUFFER, dataSize, data, GL_STATIC_DRAW);
     gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    _isDirty = false;
+}
+
+IndexBuffer::~IndexBuffer()
+{
+    destroy();
 }
 
 void IndexBuffer::destroy()
+{
+    if (data && !mappedFile)
+        delete[] (char*)data;
+    mappedFile.clear();
+    data = nullptr;
+    dataSize = 0;
+
+    releaseBuffer(bufferId);
+}
+
+UniformBuffer::UniformBuffer()
+{
+    bufferId = -1;
+    data = nullptr;
+    dataSize = 0;
+    _isDirty = true;
+}
+
+UniformBuffer::~UniformBuffer()
 {
     if (data)
-        delete data;
-    // todo: delete gl buffer
+        delete[] (char*)data;
+    releaseBuffer(bufferId);
+}
+
+void UniformBuffer::setData(void *bufferData, unsigned int sizeInBytes)
+{
+    // uniform buffers are updated every frame so only reallocate when the size changes
+    if (data && dataSize != (int)sizeInBytes) {
+        delete[] (char*)data;
+        data = nullptr;
+    }
+
+    if (!data)
+        data = new char[sizeInBytes];
+
+    memcpy(this->data, bufferData, sizeInBytes);
+    dataSize = sizeInBytes;
+
+    _isDirty = true;
+}
+
+void UniformBuffer::upload(QOpenGLFunctions_3_2_Core* gl)
+{
+    if (bufferId == -1)
+        gl->glGenBuffers(1, &bufferId);
+
+    // respecifying the whole store orphans the previous one so
+    // the driver doesnt have to wait for draws still using it
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, bufferId);
+    gl->glBufferData(GL_UNIFORM_BUFFER, dataSize, data, GL_STREAM_DRAW);
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    _isDirty = false;
 }
 
 QOpenGLFunctions_3_2_Core *GraphicsDevice::getGL() const
@@ -117,6 +241,35 @@ GraphicsDevice::GraphicsDevice()
 
     gl->glGenVertexArrays(1, &defautVAO);
 
+    glVertexAttribDivisor = (VertexAttribDivisorFunc)context->getProcAddress("glVertexAttribDivisor");
+    if (!glVertexAttribDivisor && context->hasExtension("GL_ARB_instanced_arrays"))
+        glVertexAttribDivisor = (VertexAttribDivisorFunc)context->getProcAddress("glVertexAttribDivisorARB");
+
+    // program binaries are core in gl 4.1 and come from ARB_get_program_binary before that
+    glGetProgramBinary = nullptr;
+    glProgramBinary = nullptr;
+    glProgramParameteri = nullptr;
+    if (context->format().version() >= qMakePair(4, 1) || context->hasExtension("GL_ARB_get_program_binary")) {
+        glGetProgramBinary = (GetProgramBinaryFunc)context->getProcAddress("glGetProgramBinary");
+        glProgramBinary = (ProgramBinaryFunc)context->getProcAddress("glProgramBinary");
+        glProgramParameteri = (ProgramParameteriFunc)context->getProcAddress("glProgramParameteri");
+    }
+
+    // drivers can support the functions without any binary formats
+    GLint binaryFormatCount = 0;
+    if (glGetProgramBinary && glProgramBinary && glProgramParameteri)
+        gl->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+    programBinariesSupported = binaryFormatCount > 0;
+
+    // binaries are only loaded by the driver that saved them
+    QCryptographicHash driverHash(QCryptographicHash::Sha1);
+    driverHash.addData(QByteArray((const char*)gl->glGetString(GL_VENDOR)));
+    driverHash.addData(QByteArray((const char*)gl->glGetString(GL_RENDERER)));
+    driverHash.addData(QByteArray((const char*)gl->glGetString(GL_VERSION)));
+    driverId = driverHash.result();
+
+    gpuTimer = new GpuTimer(context, gl);
+
     _internalRT = RenderTarget::create(1024,1024);
 
     //set default blend and depth state
@@ -124,6 +277,35 @@ GraphicsDevice::GraphicsDevice()
     this->setDepthState(DepthState::Default, true);
     this->setRasterizerState(RasterizerState::CullCounterClockwise, true);
     activeProgram = nullptr;
+
+    for (auto& bufferId : uniformBufferBindings)
+        bufferId = 0;
+}
+
+GraphicsDevice::~GraphicsDevice()
+{
+    delete gpuTimer;
+}
+
+void GraphicsDevice::beginFrame()
+{
+    // all contexts share objects so any device can delete released buffers
+    {
+        QMutexLocker locker(&releasedBuffersMutex);
+        if (!releasedBuffers.isEmpty()) {
+            gl->glDeleteBuffers(releasedBuffers.size(), releasedBuffers.constData());
+            releasedBuffers.clear();
+        }
+    }
+
+    stats.reset();
+    gpuTimer->beginFrame();
+}
+
+void GraphicsDevice::endFrame()
+{
+    gpuTimer->endFrame();
+    frameStats = stats;
 }
 
 void GraphicsDevice::setViewport(const QRect& vp)
@@ -143,6 +325,7 @@ void GraphicsDevice::setRenderTarget(RenderTargetPtr renderTarget)
 
     activeRT = renderTarget;
     activeRT->bind();
+    stats.stateChanges++;
 }
 
 void GraphicsDevice::setRenderTarget(Texture2DPtr colorTarget)
@@ -175,6 +358,7 @@ void GraphicsDevice::setRenderTarget(QList<Texture2DPtr> colorTargets, Texture2D
 
     activeRT = _internalRT;
     activeRT->bind();
+    stats.stateChanges++;
 }
 
 void GraphicsDevice::clearRenderTarget()
@@ -216,19 +400,21 @@ void GraphicsDevice::setShader(ShaderPtr shader, bool force)
 {
 	if (!!activeShader) {
 		if ((activeShader != shader) || force) {
-			int index = 0;
-			auto& samplers = activeShader->samplers;
-
 			// reset textures to 0
 			// this step might not be needed if all textures units are set to null
 			// when setting a shader
-			for (auto& sampler : samplers)
+			// only material units are reset, the scene units stay bound for the whole pass
+			int count = qMin(activeShader->samplers.size(), MATERIAL_TEXTURE_UNITS);
+			for (int index = 0; index < count; index++)
 			{
-				clearTexture(index++);
+				clearTexture(index);
 			}
 		}
 	}
 
+    if (activeShader != shader || force)
+        stats.stateChanges++;
+
     activeShader = shader;
 	if (!!activeShader) {
 		if (activeShader->isDirty)
@@ -256,35 +442,49 @@ void GraphicsDevice::setShader(ShaderPtr shader, bool force)
 
 void GraphicsDevice::compileShader(iris::ShaderPtr shader)
 {
-	QOpenGLShader *vshader = new QOpenGLShader(QOpenGLShader::Vertex);
-	vshader->compileSourceCode(shader->vertexShader);
-
-	QOpenGLShader *fshader = new QOpenGLShader(QOpenGLShader::Fragment);
-	fshader->compileSourceCode(shader->fragmentShader);
-
 	if (!shader->program)
 		shader->program = new QOpenGLShaderProgram;
 
 	auto& program = shader->program;
 	program->removeAllShaders();
 
-	program->addShader(vshader);
-	program->addShader(fshader);
+	// a binary saved by an earlier run skips compiling the glsl entirely
+	if (!loadProgramBinary(shader)) {
+		QOpenGLShader *vshader = new QOpenGLShader(QOpenGLShader::Vertex);
+		vshader->compileSourceCode(shader->vertexShader);
 
-	program->bindAttributeLocation("a_pos", (int)VertexAttribUsage::Position);
-	program->bindAttributeLocation("a_color", (int)VertexAttribUsage::Color);
-	program->bindAttributeLocation("a_texCoord", (int)VertexAttribUsage::TexCoord0);
-	program->bindAttributeLocation("a_texCoord1", (int)VertexAttribUsage::TexCoord1);
-	program->bindAttributeLocation("a_texCoord2", (int)VertexAttribUsage::TexCoord2);
-	program->bindAttributeLocation("a_texCoord3", (int)VertexAttribUsage::TexCoord3);
-	program->bindAttributeLocation("a_normal", (int)VertexAttribUsage::Normal);
-	program->bindAttributeLocation("a_tangent", (int)VertexAttribUsage::Tangent);
-	program->bindAttributeLocation("a_boneIndices", (int)VertexAttribUsage::BoneIndices);
-	program->bindAttributeLocation("a_boneWeights", (int)VertexAttribUsage::BoneWeights);
+		QOpenGLShader *fshader = new QOpenGLShader(QOpenGLShader::Fragment);
+		fshader->compileSourceCode(shader->fragmentShader);
 
-	program->link();
+		program->addShader(vshader);
+		program->addShader(fshader);
 
-	//todo: check for errors
+		program->bindAttributeLocation("a_pos", (int)VertexAttribUsage::Position);
+		program->bindAttributeLocation("a_color", (int)VertexAttribUsage::Color);
+		program->bindAttributeLocation("a_texCoord", (int)VertexAttribUsage::TexCoord0);
+		program->bindAttributeLocation("a_texCoord1", (int)VertexAttribUsage::TexCoord1);
+		program->bindAttributeLocation("a_texCoord2", (int)VertexAttribUsage::TexCoord2);
+		program->bindAttributeLocation("a_texCoord3", (int)VertexAttribUsage::TexCoord3);
+		program->bindAttributeLocation("a_normal", (int)VertexAttribUsage::Normal);
+		program->bindAttributeLocation("a_tangent", (int)VertexAttribUsage::Tangent);
+		program->bindAttributeLocation("a_boneIndices", (int)VertexAttribUsage::BoneIndices);
+		program->bindAttributeLocation("a_boneWeights", (int)VertexAttribUsage::BoneWeights);
+		program->bindAttributeLocation("a_instanceMatrix", (int)VertexAttribUsage::InstanceMatrix);
+
+		if (programBinariesSupported && !ShaderManager::getSingleton()->getCacheFolder().isEmpty())
+			glProgramParameteri(program->programId(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+		program->link();
+
+		//todo: check for errors
+
+		saveProgramBinary(shader);
+	}
+
+	// uniform locations from the previous program are no longer valid
+	shader->uniformLocations.clear();
+	shader->sceneUniformsPass = -1;
+	shader->materialValuesId = -1;
 
 	//get attribs, uniforms and samplers
 	//http://stackoverflow.com/questions/440144/in-opengl-is-there-a-way-to-get-a-list-of-all-uniforms-attribs-used-by-a-shade
@@ -319,30 +519,156 @@ void GraphicsDevice::compileShader(iris::ShaderPtr shader)
 	for (int i = 0; i<count; i++)
 	{
 		gl->glGetActiveUniform(programId, i, bufSize, &length, &size, &type, name);
+		auto location = gl->glGetUniformLocation(programId, name);
 
 		if (type == GL_SAMPLER_1D || type == GL_SAMPLER_2D || type == GL_SAMPLER_3D || type == GL_SAMPLER_CUBE)
 		{
 			auto sampler = new ShaderSampler();
-			sampler->location = gl->glGetUniformLocation(programId, name);
+			sampler->location = location;
 			sampler->name = std::string(name);
 			shader->samplers.insert(QString(name), sampler);
 		}
 		else
 		{
 			auto uniform = new ShaderValue();
-			uniform->location = gl->glGetUniformLocation(programId, name);
+			uniform->location = location;
 			uniform->name = std::string(name);
 			uniform->type = type;
 			shader->uniforms.insert(QString(name), uniform);
 		}
 
+		// arrays are reported as "name[0]" but are usually set using their base name
+		auto key = QByteArray(name, length);
+		shader->uniformLocations.insert(key, location);
+		if (key.endsWith("[0]"))
+			shader->uniformLocations.insert(key.left(key.length() - 3), location);
+	}
+
+	// bind the shared scene uniform block if the shader uses it
+	auto sceneBlockIndex = gl->glGetUniformBlockIndex(programId, "SceneData");
+	shader->hasSceneBlock = sceneBlockIndex != GL_INVALID_INDEX;
+	if (shader->hasSceneBlock)
+		gl->glUniformBlockBinding(programId, sceneBlockIndex, (GLuint)UniformBlockBinding::SceneData);
+
+	// the material block's layout is read back so CustomMaterial can pack its values to match it
+	shader->materialBlockMembers.clear();
+	shader->materialBlockSize = 0;
+	shader->materialBlockLayout = 0;
+
+	auto materialBlockIndex = gl->glGetUniformBlockIndex(programId, "MaterialData");
+	if (materialBlockIndex != GL_INVALID_INDEX) {
+		gl->glUniformBlockBinding(programId, materialBlockIndex, (GLuint)UniformBlockBinding::MaterialData);
+
+		GLint blockSize, memberCount;
+		gl->glGetActiveUniformBlockiv(programId, materialBlockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize);
+		gl->glGetActiveUniformBlockiv(programId, materialBlockIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+
+		QVector<GLint> indices(memberCount);
+		QVector<GLint> offsets(memberCount);
+		QVector<GLint> types(memberCount);
+		gl->glGetActiveUniformBlockiv(programId, materialBlockIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data());
+		auto memberIndices = (const GLuint*)indices.constData();
+		gl->glGetActiveUniformsiv(programId, memberCount, memberIndices, GL_UNIFORM_OFFSET, offsets.data());
+		gl->glGetActiveUniformsiv(programId, memberCount, memberIndices, GL_UNIFORM_TYPE, types.data());
+
+		// members are sorted by offset so variants of a shader with the same block get the same layout id
+		QMap<int, QByteArray> layout;
+		for (int i = 0; i < memberCount; i++) {
+			gl->glGetActiveUniformName(programId, memberIndices[i], bufSize, &length, name);
+
+			ShaderBlockMember member;
+			member.offset = offsets[i];
+			member.type = types[i];
+			shader->materialBlockMembers.insert(QByteArray(name, length), member);
+
+			layout.insert(offsets[i], QByteArray(name, length) + ':' + QByteArray::number(types[i]));
+		}
+
+		auto layoutKey = QByteArray::number(blockSize);
+		for (const auto& entry : layout)
+			layoutKey += ';' + entry;
+
+		shader->materialBlockSize = blockSize;
+		shader->materialBlockLayout = qHash(layoutKey);
 	}
 
+	shader->resolveBuiltinLocations();
+
 	shader->isDirty = false;
 }
 
+bool GraphicsDevice::loadProgramBinary(iris::ShaderPtr shader)
+{
+	if (!programBinariesSupported)
+		return false;
+
+	GLenum format;
+	QByteArray binary;
+	if (!ShaderManager::getSingleton()->loadProgramBinary(shader->getSourceHash(), driverId, format, binary))
+		return false;
+
+	// linking with no shaders attached only checks the program's link status, which
+	// is false if the driver rejected the binary
+	glProgramBinary(shader->program->programId(), format, binary.constData(), binary.size());
+	return shader->program->link();
+}
+
+void GraphicsDevice::saveProgramBinary(iris::ShaderPtr shader)
+{
+	if (!programBinariesSupported || !shader->program->isLinked())
+		return;
+
+	auto cache = ShaderManager::getSingleton();
+	if (cache->getCacheFolder().isEmpty())
+		return;
+
+	auto programId = shader->program->programId();
+	GLint length = 0;
+	gl->glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	QByteArray binary(length, 0);
+	GLenum format = 0;
+	glGetProgramBinary(programId, length, &length, &format, binary.data());
+	binary.resize(length);
+
+	cache->saveProgramBinary(shader->getSourceHash(), driverId, format, binary);
+}
+
+int GraphicsDevice::getUniformLocation(const char* name)
+{
+	if (!!activeShader)
+		return activeShader->getUniformLocation(name);
+	return activeProgram->uniformLocation(name);
+}
+
+int GraphicsDevice::getUniformLocation(const QString& name)
+{
+	if (!!activeShader)
+		return activeShader->getUniformLocation(name);
+	return activeProgram->uniformLocation(name);
+}
+
+void GraphicsDevice::setUniformBuffer(UniformBlockBinding binding, UniformBufferPtr buffer)
+{
+	if (buffer->isDirty()) {
+		buffer->upload(gl);
+		stats.uniformUploads++;
+	}
+
+	// the binding refers to the buffer object so it stays valid when the data is respecified
+	auto& boundId = uniformBufferBindings[(int)binding];
+	if (boundId != buffer->bufferId) {
+		gl->glBindBufferBase(GL_UNIFORM_BUFFER, (GLuint)binding, buffer->bufferId);
+		boundId = buffer->bufferId;
+		stats.stateChanges++;
+	}
+}
+
 void GraphicsDevice::setTexture(int target, Texture2DPtr texture)
 {
+    stats.stateChanges++;
     gl->glActiveTexture(GL_TEXTURE0+target);
     if (!!texture)
         gl->glBindTexture(GL_TEXTURE_2D, texture->getTextureId());
@@ -393,6 +719,18 @@ void GraphicsDevice::clearIndexBuffer()
     this->indexBuffer.clear();
 }
 
+void GraphicsDevice::uploadVertexBuffer(VertexBufferPtr vertexBuffer)
+{
+    if (vertexBuffer->isDirty())
+        vertexBuffer->upload(gl);
+}
+
+void GraphicsDevice::uploadIndexBuffer(IndexBufferPtr indexBuffer)
+{
+    if (indexBuffer->isDirty())
+        indexBuffer->upload(gl);
+}
+
 void GraphicsDevice::setBlendState(const BlendState &blendState, bool force)
 {
     bool blendEnabled = true;
@@ -408,6 +746,7 @@ void GraphicsDevice::setBlendState(const BlendState &blendState, bool force)
             gl->glEnable(GL_BLEND);
         else
             gl->glDisable(GL_BLEND);
+        stats.stateChanges++;
     }
     this->lastBlendEnabled = blendEnabled;
 
@@ -416,6 +755,7 @@ void GraphicsDevice::setBlendState(const BlendState &blendState, bool force)
         lastBlendState.colorBlendEquation != blendState.colorBlendEquation)) {
 
         gl->glBlendEquationSeparate(blendState.colorBlendEquation, blendState.alphaBlendEquation);
+        stats.stateChanges++;
         lastBlendState.alphaBlendEquation = blendState.alphaBlendEquation;
         lastBlendState.colorBlendEquation = blendState.colorBlendEquation;
     }
@@ -430,6 +770,7 @@ void GraphicsDevice::setBlendState(const BlendState &blendState, bool force)
                                 blendState.colorDestBlend,
                                 blendState.alphaSourceBlend,
                                 blendState.alphaDestBlend);
+        stats.stateChanges++;
 
         lastBlendState.colorSourceBlend = blendState.colorSourceBlend;
         lastBlendState.colorDestBlend = blendState.colorDestBlend;
@@ -447,6 +788,7 @@ void GraphicsDevice::setDepthState(const DepthState &depthStencil, bool force)
             gl->glEnable(GL_DEPTH_TEST);
         else
             gl->glDisable(GL_DEPTH_TEST);
+        stats.stateChanges++;
 
         lastDepthState.depthBufferEnabled = depthStencil.depthBufferEnabled;
     }
@@ -455,6 +797,7 @@ void GraphicsDevice::setDepthState(const DepthState &depthStencil, bool force)
     if (force || (lastDepthState.depthWriteEnabled != depthStencil.depthWriteEnabled))
     {
         gl->glDepthMask(depthStencil.depthWriteEnabled);
+        stats.stateChanges++;
         lastDepthState.depthWriteEnabled = depthStencil.depthWriteEnabled;
     }
 
@@ -462,6 +805,7 @@ void GraphicsDevice::setDepthState(const DepthState &depthStencil, bool force)
     if (force || (lastDepthState.depthCompareFunc != depthStencil.depthCompareFunc))
     {
         gl->glDepthFunc(depthStencil.depthCompareFunc);
+        stats.stateChanges++;
         lastDepthState.depthCompareFunc = depthStencil.depthCompareFunc;
     }
 }
@@ -480,6 +824,7 @@ void GraphicsDevice::setRasterizerState(const RasterizerState &rasterState, bool
             else
                 gl->glFrontFace(GL_CCW);
         }
+        stats.stateChanges++;
 
         lastRasterState.cullMode = rasterState.cullMode;
     }
@@ -487,44 +832,101 @@ void GraphicsDevice::setRasterizerState(const RasterizerState &rasterState, bool
     // polygon fill
     if (force || (lastRasterState.fillMode != rasterState.fillMode)) {
         gl->glPolygonMode(GL_FRONT_AND_BACK, rasterState.fillMode);
+        stats.stateChanges++;
         lastRasterState.fillMode = rasterState.fillMode;
     }
 }
 
-void GraphicsDevice::drawPrimitives(GLenum primitiveType, int start, int count)
+void GraphicsDevice::bindVertexBuffers()
 {
     gl->glBindVertexArray(defautVAO);
     for(auto buffer : vertexBuffers) {
         gl->glBindBuffer(GL_ARRAY_BUFFER, buffer->bufferId);
         buffer->vertexLayout.bind(gl);
-    }
 
-    gl->glDrawArrays(primitiveType, start, count);
+        int divisor = buffer->vertexLayout.getDivisor();
+        if (divisor != 0 && glVertexAttribDivisor) {
+            for (auto& attrib : buffer->vertexLayout.getAttribs())
+                glVertexAttribDivisor((GLuint)attrib.usage, divisor);
+        }
+    }
+}
 
+void GraphicsDevice::unbindVertexBuffers()
+{
     for(auto buffer : vertexBuffers) {
         buffer->vertexLayout.unbind(gl);
+
+        // the default vao is shared so divisors have to be reset
+        if (buffer->vertexLayout.getDivisor() != 0 && glVertexAttribDivisor) {
+            for (auto& attrib : buffer->vertexLayout.getAttribs())
+                glVertexAttribDivisor((GLuint)attrib.usage, 0);
+        }
     }
     gl->glBindVertexArray(0);
 }
 
+static int getTriangleCount(GLenum primitiveType, int count)
+{
+    switch (primitiveType) {
+    case GL_TRIANGLES:
+        return count / 3;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+        return qMax(0, count - 2);
+    default:
+        return 0;
+    }
+}
+
+void GraphicsDevice::drawPrimitives(GLenum primitiveType, int start, int count)
+{
+    bindVertexBuffers();
+    gl->glDrawArrays(primitiveType, start, count);
+    unbindVertexBuffers();
+
+    stats.drawCalls++;
+    stats.triangles += getTriangleCount(primitiveType, count);
+}
+
 // https://stackoverflow.com/a/30106751
 #define BUFFER_OFFSET(i) ((char*)nullptr+(i))
 void GraphicsDevice::drawIndexedPrimitives(GLenum primitiveType, int start, int count)
 {
-    gl->glBindVertexArray(defautVAO);
-    for(auto buffer : vertexBuffers) {
-        gl->glBindBuffer(GL_ARRAY_BUFFER, buffer->bufferId);
-        buffer->vertexLayout.bind(gl);
-    }
+    bindVertexBuffers();
 
     gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,indexBuffer->bufferId);
-    gl->glDrawElements(primitiveType,count,GL_UNSIGNED_INT,BUFFER_OFFSET(start));
+    gl->glDrawElements(primitiveType,count,indexBuffer->indexType,BUFFER_OFFSET(start));
     gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
 
-    for(auto buffer : vertexBuffers) {
-        buffer->vertexLayout.unbind(gl);
-    }
-    gl->glBindVertexArray(0);
+    unbindVertexBuffers();
+
+    stats.drawCalls++;
+    stats.triangles += getTriangleCount(primitiveType, count);
+}
+
+void GraphicsDevice::drawPrimitivesInstanced(GLenum primitiveType, int start, int count, int instanceCount)
+{
+    bindVertexBuffers();
+    gl->glDrawArraysInstanced(primitiveType, start, count, instanceCount);
+    unbindVertexBuffers();
+
+    stats.drawCalls++;
+    stats.triangles += getTriangleCount(primitiveType, count) * instanceCount;
+}
+
+void GraphicsDevice::drawIndexedPrimitivesInstanced(GLenum primitiveType, int start, int count, int instanceCount)
+{
+    bindVertexBuffers();
+
+    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,indexBuffer->bufferId);
+    gl->glDrawElementsInstanced(primitiveType,count,indexBuffer->indexType,BUFFER_OFFSET(start),instanceCount);
+    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+
+    unbindVertexBuffers();
+
+    stats.drawCalls++;
+    stats.triangles += getTriangleCount(primitiveType, count) * instanceCount;
 }
 
 
@@ -12,6 +12,7 @@
 #include "rasterizerstate.h"
 
 class QOpenGLContext;
+class QFile;
 
 namespace iris
 {
@@ -22,6 +23,22 @@ class VertexBuffer;
 typedef QSharedPointer<VertexBuffer> VertexBufferPtr;
 class IndexBuffer;
 typedef QSharedPointer<IndexBuffer> IndexBufferPtr;
+class UniformBuffer;
+typedef QSharedPointer<UniformBuffer> UniformBufferPtr;
+class GpuTimer;
+
+/*
+ * Binding points for uniform blocks shared by all shaders
+ * Shaders declaring a block with one of these names get it bound
+ * to the matching binding point when they're compiled
+ */
+enum class UniformBlockBinding : GLuint
+{
+    SceneData = 0,
+    MaterialData = 1,
+
+    Count
+};
 
 class VertexBuffer
 {
@@ -34,6 +51,12 @@ public:
     VertexLayout vertexLayout;
     GraphicsDevicePtr device;
 
+    // set when data points into a mapped file rather than memory owned by the buffer
+    QSharedPointer<QFile> mappedFile;
+
+    // GL_STATIC_DRAW by default, buffers updated every frame should use GL_STREAM_DRAW
+    GLenum usage;
+
     bool _isDirty;
 
     static VertexBufferPtr create(VertexLayout vertexLayout)
@@ -41,6 +64,8 @@ public:
         return VertexBufferPtr(new VertexBuffer(vertexLayout));
     }
 
+    ~VertexBuffer();
+
     template<typename T>
     void setData(T* data, unsigned int sizeInBytes)
     {
@@ -49,6 +74,17 @@ public:
 
     void setData(void* data, unsigned int sizeinBytes);
 
+    /**
+     * Uses data in a memory mapped file instead of copying it
+     * The file stays mapped for as long as the buffer uses it
+     */
+    void setMappedData(QSharedPointer<QFile> file, void* data, unsigned int sizeInBytes);
+
+    void setUsage(GLenum usage)
+    {
+        this->usage = usage;
+    }
+
     bool isDirty()
     {
         return _isDirty;
@@ -70,6 +106,11 @@ public:
     int dataSize;
     bool _isDirty;
 
+    // GL_UNSIGNED_INT by default, GL_UNSIGNED_SHORT for meshes with up to 65536 vertices
+    GLenum indexType;
+
+    QSharedPointer<QFile> mappedFile;
+
     template<typename T>
     void setData(T* data, unsigned int sizeInBytes)
     {
@@ -78,6 +119,14 @@ public:
 
     void setData(void* data, unsigned int sizeinBytes);
 
+    // see VertexBuffer::setMappedData()
+    void setMappedData(QSharedPointer<QFile> file, void* data, unsigned int sizeInBytes);
+
+    void setIndexType(GLenum indexType)
+    {
+        this->indexType = indexType;
+    }
+
     bool isDirty()
     {
         return _isDirty;
@@ -87,12 +136,76 @@ public:
     {
         return IndexBufferPtr(new IndexBuffer());
     }
+
+    ~IndexBuffer();
 private:
     IndexBuffer();
     void upload(QOpenGLFunctions_3_2_Core* gl);
     void destroy();
 };
 
+/*
+ * Buffer backing a uniform block
+ * The data is expected to already be laid out according to the block's std140 layout
+ */
+class UniformBuffer
+{
+    friend class GraphicsDevice;
+public:
+    void* data;
+    int dataSize;
+    GLuint bufferId;
+    bool _isDirty;
+
+    template<typename T>
+    void setData(T* data, unsigned int sizeInBytes)
+    {
+        setData((void*) data, sizeInBytes);
+    }
+
+    void setData(void* data, unsigned int sizeinBytes);
+
+    bool isDirty()
+    {
+        return _isDirty;
+    }
+
+    static UniformBufferPtr create()
+    {
+        return UniformBufferPtr(new UniformBuffer());
+    }
+
+    ~UniformBuffer();
+private:
+    UniformBuffer();
+    void upload(QOpenGLFunctions_3_2_Core* gl);
+};
+
+/*
+ * Counts of the work sent through the GraphicsDevice in a frame
+ * Calls made to gl directly arent counted
+ */
+struct GraphicsStats
+{
+    int drawCalls;
+    int stateChanges;
+    int uniformUploads;
+    int triangles;
+
+    GraphicsStats()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        drawCalls = 0;
+        stateChanges = 0;
+        uniformUploads = 0;
+        triangles = 0;
+    }
+};
+
 /*
  * This class is intended to wrap all calls to opengl with simpler
  * and easier-to-use functions
@@ -102,6 +215,25 @@ class GraphicsDevice
     QOpenGLFunctions_3_2_Core* gl;
     QOpenGLContext* context;
 
+    // glVertexAttribDivisor is only core in gl 3.3 so it's resolved
+    // from ARB_instanced_arrays when the context doesnt provide it
+    typedef void (QOPENGLF_APIENTRYP VertexAttribDivisorFunc)(GLuint index, GLuint divisor);
+    VertexAttribDivisorFunc glVertexAttribDivisor;
+
+    // resolved the same way from ARB_get_program_binary, null if it isnt supported
+    typedef void (QOPENGLF_APIENTRYP GetProgramBinaryFunc)(GLuint program, GLsizei bufSize, GLsizei* length,
+                                                           GLenum* binaryFormat, void* binary);
+    typedef void (QOPENGLF_APIENTRYP ProgramBinaryFunc)(GLuint program, GLenum binaryFormat,
+                                                        const void* binary, GLsizei length);
+    typedef void (QOPENGLF_APIENTRYP ProgramParameteriFunc)(GLuint program, GLenum pname, GLint value);
+    GetProgramBinaryFunc glGetProgramBinary;
+    ProgramBinaryFunc glProgramBinary;
+    ProgramParameteriFunc glProgramParameteri;
+    bool programBinariesSupported;
+
+    // hash of the vendor, renderer and version strings
+    QByteArray driverId;
+
     QRect viewport;
     RenderTargetPtr _internalRT;
     RenderTargetPtr activeRT;
@@ -118,13 +250,41 @@ class GraphicsDevice
     // comes from active shader for ease-of-access
     QOpenGLShaderProgram* activeProgram;
 
+    // buffers bound to each UniformBlockBinding so they arent rebound for every draw
+    GLuint uniformBufferBindings[(int)UniformBlockBinding::Count];
+
     bool lastBlendEnabled;
     BlendState lastBlendState;
     DepthState lastDepthState;
     RasterizerState lastRasterState;
 
+    GpuTimer* gpuTimer;
+
+    // stats of the frame being rendered and of the last complete one
+    GraphicsStats stats;
+    GraphicsStats frameStats;
+
 public:
+    // units below this are left to materials, the renderer binds
+    // shadow maps and light cluster buffers from here up
+    static const int MATERIAL_TEXTURE_UNITS = 8;
+
     GraphicsDevice();
+    ~GraphicsDevice();
+
+    // resets the stats and starts timing the frame on the gpu
+    void beginFrame();
+    void endFrame();
+
+    const GraphicsStats& getFrameStats()
+    {
+        return frameStats;
+    }
+
+    GpuTimer* getGpuTimer()
+    {
+        return gpuTimer;
+    }
 
     void setViewport(const QRect& vp);
     QRect getViewport();
@@ -141,28 +301,50 @@ public:
 	// if force is set to true, texture units will be reset regardless if the shader
 	// being bound is already bound
     void setShader(ShaderPtr shader, bool force = false);
+    ShaderPtr getActiveShader()
+    {
+        return activeShader;
+    }
+
+    // uniform locations are looked up from the active shader's location cache
     template<typename T>
     void setShaderUniform(const QString& name,const T& value) {
         if (activeProgram)
-            activeProgram->setUniformValue(name.toStdString().c_str(), value);
+            setShaderUniform(getUniformLocation(name), value);
     }
     template<typename T>
     void setShaderUniform(const char* name,const T& value) {
         if (activeProgram)
-            activeProgram->setUniformValue(name, value);
+            setShaderUniform(getUniformLocation(name), value);
+    }
+    template<typename T>
+    void setShaderUniform(int location,const T& value) {
+        if (activeProgram && location != -1) {
+            activeProgram->setUniformValue(location, value);
+            stats.uniformUploads++;
+        }
     }
 
 	template<typename T>
 	void setShaderUniformArray(const QString& name, const T* value, const unsigned int count) {
 		if (activeProgram)
-			activeProgram->setUniformValueArray(name.toStdString().c_str(), value);
+			setShaderUniformArray(getUniformLocation(name), value, count);
 	}
 	template<typename T>
 	void setShaderUniformArray(const char* name, const T* value, const unsigned int count) {
 		if (activeProgram)
-			activeProgram->setUniformValueArray(name, value, count);
+			setShaderUniformArray(getUniformLocation(name), value, count);
+	}
+	template<typename T>
+	void setShaderUniformArray(int location, const T* value, const unsigned int count) {
+		if (activeProgram && location != -1) {
+			activeProgram->setUniformValueArray(location, value, count);
+			stats.uniformUploads++;
+		}
 	}
 
+    void setUniformBuffer(UniformBlockBinding binding, UniformBufferPtr buffer);
+
     void setTexture(int target, Texture2DPtr texture);
     void clearTexture(int target);
 	void compileShader(iris::ShaderPtr shader);
@@ -172,18 +354,39 @@ public:
     void setIndexBuffer(IndexBufferPtr indexBuffer);
     void clearIndexBuffer();
 
+    // uploads dirty buffers without binding them for drawing
+    void uploadVertexBuffer(VertexBufferPtr vertexBuffer);
+    void uploadIndexBuffer(IndexBufferPtr indexBuffer);
+
     void setBlendState(const BlendState& blendState, bool force = false);
     void setDepthState(const DepthState& depthStencil, bool force = false);
     void setRasterizerState(const RasterizerState& rasterState, bool force = false);
 
     void drawPrimitives(GLenum primitiveType,int start, int count);
     void drawIndexedPrimitives(GLenum primitiveType,int start, int count);
+
+    // instanced vertex buffers (layouts with a divisor) are
+    // advanced per instance instead of per vertex
+    void drawPrimitivesInstanced(GLenum primitiveType, int start, int count, int instanceCount);
+    void drawIndexedPrimitivesInstanced(GLenum primitiveType, int start, int count, int instanceCount);
+
+    bool supportsInstancing()
+    {
+        return glVertexAttribDivisor != nullptr;
+    }
+
     QOpenGLFunctions_3_2_Core *getGL() const;
 
     static GraphicsDevicePtr create();
 
 private:
 	void compileShader();
+    bool loadProgramBinary(iris::ShaderPtr shader);
+    void saveProgramBinary(iris::ShaderPtr shader);
+    void bindVertexBuffers();
+    void unbindVertexBuffers();
+    int getUniformLocation(const char* name);
+    int getUniformLocation(const QString& name);
 };
 
 }
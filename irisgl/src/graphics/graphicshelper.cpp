@@ -51,6 +51,7 @@ QOpenGLShaderProgram* GraphicsHelper::loadShader(QString vsPath,QString fsPath)
     program->bindAttributeLocation("a_tangent",(int)VertexAttribUsage::Tangent);
     program->bindAttributeLocation("a_boneIndices",(int)VertexAttribUsage::BoneIndices);
     program->bindAttributeLocation("a_boneWeights",(int)VertexAttribUsage::BoneWeights);
+    program->bindAttributeLocation("a_instanceMatrix",(int)VertexAttribUsage::InstanceMatrix);
 
 
     program->link();
@@ -58,7 +59,7 @@ QOpenGLShaderProgram* GraphicsHelper::loadShader(QString vsPath,QString fsPath)
     return program;
 }
 
-QString GraphicsHelper::loadAndProcessShader(QString shaderPath)
+QString GraphicsHelper::loadAndProcessShader(QString shaderPath, QStringList* includedFiles)
 {
     QRegExp internalFileInclude("\\<(.+\\\\)*((.+)\\.(.+))\\>");
     QRegExp externalFileInclude("\\\"(.+\\\\)*((.+)\\.(.+))\\\"");
@@ -84,7 +85,10 @@ QString GraphicsHelper::loadAndProcessShader(QString shaderPath)
             // remove line with pragma
             lines.removeAt(i);
 
-            auto included = loadAndProcessShader(includeFile);
+            if (includedFiles)
+                includedFiles->append(includeFile);
+
+            auto included = loadAndProcessShader(includeFile, includedFiles);
             lines.insert(i, included.toUtf8());
 
             // todo: include file index in line directive?
@@ -14,6 +14,7 @@ For more information see the LICENSE file
 
 #include <QString>
 #include <QList>
+#include <QStringList>
 #include "../irisglfwd.h"
 #include "../graphics/mesh.h"
 
@@ -45,7 +46,9 @@ class GraphicsHelper
 public:
     static QOpenGLShaderProgram* loadShader(QString vsPath, QString fsPath);
 
-    static QString loadAndProcessShader(QString shaderPath);
+    // expands #pragma include lines, the paths of the included files are
+    // appended to includedFiles if it's given
+    static QString loadAndProcessShader(QString shaderPath, QStringList* includedFiles = nullptr);
 
     /**
      * Loads all meshes from mesh file
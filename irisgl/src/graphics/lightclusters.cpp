@@ -0,0 +1,338 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "lightclusters.h"
+#include "../core/performancetimer.h"
+#include "../scenegraph/lightnode.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_2_Core>
+#include <QtConcurrent>
+#include <QtMath>
+
+namespace iris
+{
+
+LightClusters::LightClusters(QOpenGLFunctions_3_2_Core* gl)
+{
+    this->gl = gl;
+
+    GLint maxUnits = 0;
+    gl->glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxUnits);
+    supported = maxUnits > INDICES_UNIT;
+
+    nearDepth = 0.1f;
+    farDepth = 1000.0f;
+    sliceScale = 1.0f;
+    lightCount = 0;
+
+    GLuint buffers[3];
+    GLuint textures[3];
+    gl->glGenBuffers(3, buffers);
+    gl->glGenTextures(3, textures);
+    lightsBuffer = buffers[0];
+    cellsBuffer = buffers[1];
+    indicesBuffer = buffers[2];
+    lightsTexture = textures[0];
+    cellsTexture = textures[1];
+    indicesTexture = textures[2];
+
+    // the textures keep pointing to their buffers when the buffers are respecified
+    upload(lightsBuffer, nullptr, 0);
+    upload(cellsBuffer, nullptr, 0);
+    upload(indicesBuffer, nullptr, 0);
+
+    gl->glBindTexture(GL_TEXTURE_BUFFER, lightsTexture);
+    gl->glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, lightsBuffer);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, cellsTexture);
+    gl->glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, cellsBuffer);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, indicesTexture);
+    gl->glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, indicesBuffer);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    slices.resize(GRID_Z);
+    for (int z = 0; z < GRID_Z; z++)
+        slices[z].z = z;
+}
+
+LightClustersPtr LightClusters::create(QOpenGLFunctions_3_2_Core* gl)
+{
+    return LightClustersPtr(new LightClusters(gl));
+}
+
+LightClusters::~LightClusters()
+{
+    if (QOpenGLContext::currentContext() == nullptr)
+        return;
+
+    GLuint buffers[] = {lightsBuffer, cellsBuffer, indicesBuffer};
+    GLuint textures[] = {lightsTexture, cellsTexture, indicesTexture};
+    gl->glDeleteBuffers(3, buffers);
+    gl->glDeleteTextures(3, textures);
+}
+
+bool LightClusters::isSupported()
+{
+    return supported;
+}
+
+void LightClusters::update(const QList<LightNodePtr>& lights,
+                           const QMatrix4x4& viewMatrix,
+                           const QMatrix4x4& projMatrix,
+                           const QRect& viewport)
+{
+    IRIS_PROFILE("light clusters");
+
+    this->viewport = viewport;
+    if (bounds.isEmpty() || projMatrix != boundsProjMatrix)
+        updateBounds(projMatrix);
+
+    viewLights.clear();
+    lightData.clear();
+
+    for (auto& light : lights) {
+        if (light->lightType == LightType::Directional || light->distance <= 0)
+            continue;
+
+        auto worldPos = light->globalTransform.column(3).toVector3D();
+        auto worldDir = light->getLightDir();
+
+        ClusterLight clusterLight;
+        clusterLight.position = viewMatrix.map(worldPos);
+        clusterLight.direction = viewMatrix.mapVector(worldDir).normalized();
+        clusterLight.range = light->distance;
+        clusterLight.center = clusterLight.position;
+        clusterLight.radius = light->distance;
+
+        // spots wider than a hemisphere are treated as point lights
+        float angle = qDegreesToRadians(light->spotCutOff);
+        clusterLight.spot = light->lightType == LightType::Spot && angle < M_PI_2;
+        clusterLight.cosAngle = qCos(angle);
+        clusterLight.sinAngle = qSin(angle);
+
+        // tightest sphere around the cone
+        if (clusterLight.spot) {
+            if (angle > M_PI_4) {
+                clusterLight.center += clusterLight.direction * clusterLight.cosAngle * clusterLight.range;
+                clusterLight.radius = clusterLight.sinAngle * clusterLight.range;
+            } else {
+                float radius = clusterLight.range / (2.0f * clusterLight.cosAngle);
+                clusterLight.center += clusterLight.direction * radius;
+                clusterLight.radius = radius;
+            }
+        }
+
+        float minDepth = -clusterLight.center.z() - clusterLight.radius;
+        float maxDepth = -clusterLight.center.z() + clusterLight.radius;
+        if (maxDepth < nearDepth || minDepth > farDepth)
+            continue;
+
+        clusterLight.minSlice = getSlice(minDepth);
+        clusterLight.maxSlice = getSlice(maxDepth);
+        viewLights.append(clusterLight);
+
+        // layout read by clustered_lights.glsl, 4 texels per light
+        // the color is premultiplied by the intensity
+        lightData << worldPos.x() << worldPos.y() << worldPos.z() << light->distance
+                  << light->color.redF() * light->intensity
+                  << light->color.greenF() * light->intensity
+                  << light->color.blueF() * light->intensity
+                  << (float)light->lightType
+                  << worldDir.x() << worldDir.y() << worldDir.z() << light->spotCutOff
+                  << light->spotCutOffSoftness << 0.0f << 0.0f << 0.0f;
+    }
+
+    lightCount = viewLights.size();
+
+    // each slice writes to its own lists so they can be binned at the same time
+    if (lightCount > 0) {
+        QtConcurrent::blockingMap(slices, [this](Slice& slice) {
+            binSlice(slice);
+        });
+    }
+
+    // slices are joined into one list of indices
+    cellData.fill(0, GRID_X * GRID_Y * GRID_Z * 2);
+    indexData.clear();
+    if (lightCount > 0) {
+        for (auto& slice : slices) {
+            quint32 offset = indexData.size();
+            quint32* cells = cellData.data() + slice.z * GRID_X * GRID_Y * 2;
+            for (int i = 0; i < GRID_X * GRID_Y; i++) {
+                cells[i * 2] = offset + slice.cells[i * 2];
+                cells[i * 2 + 1] = slice.cells[i * 2 + 1];
+            }
+
+            indexData += slice.indices;
+        }
+    }
+
+    upload(lightsBuffer, lightData.constData(), lightData.size() * sizeof(float));
+    upload(cellsBuffer, cellData.constData(), cellData.size() * sizeof(quint32));
+    upload(indicesBuffer, indexData.constData(), indexData.size() * sizeof(quint32));
+}
+
+void LightClusters::bind()
+{
+    gl->glActiveTexture(GL_TEXTURE0 + LIGHTS_UNIT);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, lightsTexture);
+    gl->glActiveTexture(GL_TEXTURE0 + CELLS_UNIT);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, cellsTexture);
+    gl->glActiveTexture(GL_TEXTURE0 + INDICES_UNIT);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, indicesTexture);
+    gl->glActiveTexture(GL_TEXTURE0);
+}
+
+// Finds the view space bounds of every cluster by unprojecting the
+// corners of the tiles to the depths of the slices
+void LightClusters::updateBounds(const QMatrix4x4& projMatrix)
+{
+    boundsProjMatrix = projMatrix;
+    auto invProj = projMatrix.inverted();
+
+    nearDepth = qMax(-(invProj * QVector3D(0, 0, -1)).z(), 0.01f);
+    farDepth = qMax(-(invProj * QVector3D(0, 0, 1)).z(), nearDepth * 2.0f);
+    sliceScale = GRID_Z / qLn(farDepth / nearDepth);
+
+    // the line through each tile corner from the near to the far plane
+    QVector<QVector3D> nearCorners, farCorners;
+    for (int y = 0; y <= GRID_Y; y++) {
+        for (int x = 0; x <= GRID_X; x++) {
+            float ndcX = -1.0f + 2.0f * x / GRID_X;
+            float ndcY = -1.0f + 2.0f * y / GRID_Y;
+            nearCorners.append(invProj * QVector3D(ndcX, ndcY, -1));
+            farCorners.append(invProj * QVector3D(ndcX, ndcY, 1));
+        }
+    }
+
+    auto cornerAtDepth = [&](int corner, float depth) {
+        auto a = nearCorners[corner];
+        auto b = farCorners[corner];
+        float t = (-depth - a.z()) / (b.z() - a.z());
+        return a + (b - a) * t;
+    };
+
+    bounds.resize(GRID_X * GRID_Y * GRID_Z);
+    for (int z = 0; z < GRID_Z; z++) {
+        float minDepth = nearDepth * qExp(z / sliceScale);
+        float maxDepth = nearDepth * qExp((z + 1) / sliceScale);
+
+        for (int y = 0; y < GRID_Y; y++) {
+            for (int x = 0; x < GRID_X; x++) {
+                int corners[] = {
+                    y * (GRID_X + 1) + x,
+                    y * (GRID_X + 1) + x + 1,
+                    (y + 1) * (GRID_X + 1) + x,
+                    (y + 1) * (GRID_X + 1) + x + 1
+                };
+
+                auto& cluster = bounds[(z * GRID_Y + y) * GRID_X + x];
+                cluster.min = cornerAtDepth(corners[0], minDepth);
+                cluster.max = cluster.min;
+                for (int corner : corners) {
+                    for (float depth : {minDepth, maxDepth}) {
+                        auto point = cornerAtDepth(corner, depth);
+                        cluster.min = QVector3D(qMin(cluster.min.x(), point.x()),
+                                                qMin(cluster.min.y(), point.y()),
+                                                qMin(cluster.min.z(), point.z()));
+                        cluster.max = QVector3D(qMax(cluster.max.x(), point.x()),
+                                                qMax(cluster.max.y(), point.y()),
+                                                qMax(cluster.max.z(), point.z()));
+                    }
+                }
+
+                cluster.center = (cluster.min + cluster.max) * 0.5f;
+                cluster.radius = (cluster.max - cluster.min).length() * 0.5f;
+            }
+        }
+    }
+}
+
+int LightClusters::getSlice(float depth)
+{
+    if (depth <= nearDepth)
+        return 0;
+
+    return qBound(0, (int)(qLn(depth / nearDepth) * sliceScale), GRID_Z - 1);
+}
+
+void LightClusters::binSlice(Slice& slice)
+{
+    slice.cells.fill(0, GRID_X * GRID_Y * 2);
+    slice.indices.clear();
+
+    QVector<int> sliceLights;
+    for (int i = 0; i < viewLights.size(); i++) {
+        if (viewLights[i].minSlice <= slice.z && slice.z <= viewLights[i].maxSlice)
+            sliceLights.append(i);
+    }
+
+    if (sliceLights.isEmpty())
+        return;
+
+    const ClusterBounds* sliceBounds = bounds.constData() + slice.z * GRID_X * GRID_Y;
+    for (int c = 0; c < GRID_X * GRID_Y; c++) {
+        auto& cluster = sliceBounds[c];
+        slice.cells[c * 2] = slice.indices.size();
+
+        for (int i : sliceLights) {
+            auto& light = viewLights[i];
+
+            // sphere against box
+            float distSqrd = 0;
+            for (int axis = 0; axis < 3; axis++) {
+                float v = light.center[axis];
+                if (v < cluster.min[axis])
+                    distSqrd += (cluster.min[axis] - v) * (cluster.min[axis] - v);
+                else if (v > cluster.max[axis])
+                    distSqrd += (v - cluster.max[axis]) * (v - cluster.max[axis]);
+            }
+
+            if (distSqrd > light.radius * light.radius)
+                continue;
+
+            // cone against the cluster's bounding sphere
+            // https://bartwronski.com/2017/04/13/cull-that-cone/
+            if (light.spot) {
+                auto v = cluster.center - light.position;
+                float lenSqrd = QVector3D::dotProduct(v, v);
+                float v1Len = QVector3D::dotProduct(v, light.direction);
+                float closestDist = light.cosAngle * qSqrt(qMax(0.0f, lenSqrd - v1Len * v1Len)) -
+                                    v1Len * light.sinAngle;
+
+                if (closestDist > cluster.radius ||
+                    v1Len > cluster.radius + light.range ||
+                    v1Len < -cluster.radius)
+                    continue;
+            }
+
+            slice.indices.append(i);
+        }
+
+        slice.cells[c * 2 + 1] = slice.indices.size() - slice.cells[c * 2];
+    }
+}
+
+void LightClusters::upload(GLuint buffer, const void* data, int size)
+{
+    // empty buffers arent valid texture buffers
+    static const quint32 empty[4] = {0, 0, 0, 0};
+    if (size == 0) {
+        data = empty;
+        size = sizeof(empty);
+    }
+
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    gl->glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STREAM_DRAW);
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+}
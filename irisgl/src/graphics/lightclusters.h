@@ -0,0 +1,172 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef LIGHTCLUSTERS_H
+#define LIGHTCLUSTERS_H
+
+#include "../irisglfwd.h"
+#include <QList>
+#include <QMatrix4x4>
+#include <QRect>
+#include <QVector>
+#include <QVector3D>
+#include <qopengl.h>
+
+class QOpenGLFunctions_3_2_Core;
+
+namespace iris
+{
+
+/**
+ * Assigns point and spot lights to clusters for clustered forward shading
+ *
+ * The view frustum is divided into a grid of tiles on screen and slices in
+ * depth, the slices get exponentially deeper further from the camera. Each
+ * frame the lights are tested against the bounds of every cluster they can
+ * touch, one depth slice per thread. The results are uploaded as three
+ * texture buffers read by clustered_lights.glsl: the lights, an offset and
+ * count per cluster, and the light indices those point into. Fragments only
+ * loop over the lights of their own cluster.
+ */
+class LightClusters
+{
+public:
+    static const int GRID_X = 16;
+    static const int GRID_Y = 9;
+    static const int GRID_Z = 24;
+
+    // texture units the buffers are bound to, after the shadow maps
+    static const int LIGHTS_UNIT = 16;
+    static const int CELLS_UNIT = 17;
+    static const int INDICES_UNIT = 18;
+
+private:
+    struct ClusterBounds
+    {
+        QVector3D min;
+        QVector3D max;
+
+        // bounding sphere, for the spot cone test
+        QVector3D center;
+        float radius;
+    };
+
+    // a light in view space
+    struct ClusterLight
+    {
+        QVector3D center;
+        float radius;
+
+        bool spot;
+        QVector3D position;
+        QVector3D direction;
+        float range;
+        float cosAngle;
+        float sinAngle;
+
+        int minSlice;
+        int maxSlice;
+    };
+
+    struct Slice
+    {
+        int z;
+
+        // offset into indices and count for each cluster in the slice
+        QVector<quint32> cells;
+        QVector<quint32> indices;
+    };
+
+    QOpenGLFunctions_3_2_Core* gl;
+    bool supported;
+
+    GLuint lightsBuffer;
+    GLuint cellsBuffer;
+    GLuint indicesBuffer;
+    GLuint lightsTexture;
+    GLuint cellsTexture;
+    GLuint indicesTexture;
+
+    // cluster bounds only change with the projection
+    QMatrix4x4 boundsProjMatrix;
+    QVector<ClusterBounds> bounds;
+
+    float nearDepth;
+    float farDepth;
+    float sliceScale;
+
+    QRect viewport;
+    int lightCount;
+
+    QVector<ClusterLight> viewLights;
+    QVector<Slice> slices;
+    QVector<float> lightData;
+    QVector<quint32> cellData;
+    QVector<quint32> indexData;
+
+    LightClusters(QOpenGLFunctions_3_2_Core* gl);
+
+public:
+    static LightClustersPtr create(QOpenGLFunctions_3_2_Core* gl);
+    ~LightClusters();
+
+    // false if there arent enough texture units for the buffers
+    bool isSupported();
+
+    /**
+     * Bins the lights into the clusters of the view and uploads them
+     * Directional lights are skipped, lights should be visible
+     */
+    void update(const QList<LightNodePtr>& lights,
+                const QMatrix4x4& viewMatrix,
+                const QMatrix4x4& projMatrix,
+                const QRect& viewport);
+
+    // binds the buffers to their texture units
+    void bind();
+
+    int getLightCount()
+    {
+        return lightCount;
+    }
+
+    QRect getViewport()
+    {
+        return viewport;
+    }
+
+    // view depth of the first and last slice
+    float getNearDepth()
+    {
+        return nearDepth;
+    }
+
+    float getFarDepth()
+    {
+        return farDepth;
+    }
+
+    // slice = log(depth / near) * sliceScale
+    float getSliceScale()
+    {
+        return sliceScale;
+    }
+
+private:
+    void updateBounds(const QMatrix4x4& projMatrix);
+    int getSlice(float depth);
+    void binSlice(Slice& slice);
+    void upload(GLuint buffer, const void* data, int size);
+};
+
+}
+
+#endif // LIGHTCLUSTERS_H
@@ -30,8 +30,9 @@ int RenderLayer::Gizmo = 6000;//the scene depth is cleared before this pass
 void Material::begin(GraphicsDevicePtr device,ScenePtr scene)
 {
     //shader->program->bind();
-	device->setShader(shader);
+	device->setShader(getActiveShader());
     this->bindTextures(device);
+    invalidateShaderValues();
 }
 
 void Material::beginCube(GraphicsDevicePtr device,ScenePtr scene)
@@ -80,7 +81,7 @@ void Material::bindTextures(GraphicsDevicePtr device)
 
         if (!!tex) {
             tex->texture->bind();
-            shader->program->setUniformValue(it.key().toStdString().c_str(), count);
+            getActiveShader()->program->setUniformValue(it.key().toStdString().c_str(), count);
         } else {
 			device->clearTexture(count);
         }
@@ -137,7 +138,42 @@ void Material::setTextureCount(int count)
 
 QOpenGLShaderProgram* Material::getProgram()
 {
-	return shader->program;
+	return getActiveShader()->program;
+}
+
+void Material::invalidateShaderValues()
+{
+    auto shader = getActiveShader();
+    if (!!shader)
+        shader->materialValuesId = -1;
+}
+
+bool Material::supportsInstancing()
+{
+    return !!shader && !!shader->getInstancedVariant();
+}
+
+void Material::setInstanced(bool instanced)
+{
+    this->instanced = instanced;
+}
+
+ShaderPtr Material::getActiveShader()
+{
+    if (instanced && !!shader) {
+        auto variant = shader->getInstancedVariant();
+        if (!!variant)
+            return variant;
+    }
+
+    return shader;
+}
+
+long Material::generateMaterialId()
+{
+    return nextId++;
 }
 
+long Material::nextId = 0;
+
 }
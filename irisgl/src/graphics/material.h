@@ -45,6 +45,10 @@ class Material
 	friend class ForwardRenderer;
 public:
     int renderLayer;
+
+    // unique id used to group items by material when sorting render lists
+    long materialId;
+
     //QOpenGLShaderProgram* program;
 	ShaderPtr shader;
     QMap<QString, Texture2DPtr> textures;
@@ -56,6 +60,8 @@ public:
     Material() {
         acceptsLighting = true;
         numTextures = 0;
+        instanced = false;
+        materialId = generateMaterialId();
     }
 
     virtual ~Material() {}
@@ -109,9 +115,26 @@ public:
 
     void createProgramFromShaderSource(QString vsFile, QString fsFile);
 
+    /**
+     * Returns true if the material's shader has an instanced variant
+     */
+    bool supportsInstancing();
+
+    /**
+     * Makes begin() use the instanced variant of the shader
+     * This is set by the renderer when drawing a batch of instances
+     */
+    void setInstanced(bool instanced);
+
+    /**
+     * Returns the shader that will be used by begin()
+     */
+    ShaderPtr getActiveShader();
+
     template<typename T>
     void setUniformValue(QString name,T value) {
         getProgram()->setUniformValue(name.toStdString().c_str(), value);
+        invalidateShaderValues();
     }
 
 	virtual MaterialPtr duplicate() {
@@ -129,6 +152,19 @@ protected:
     void setTextureCount(int count);
 
 	QOpenGLShaderProgram* getProgram();
+
+    /**
+     * Shaders are shared by every material loading the same source, so this
+     * tells CustomMaterial the active shader's uniforms may no longer hold its
+     * values. Materials setting uniforms on the program themselves call it.
+     */
+    void invalidateShaderValues();
+
+    bool instanced;
+
+private:
+    static long generateMaterialId();
+    static long nextId;
 };
 
 }
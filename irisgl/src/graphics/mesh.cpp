@@ -28,6 +28,7 @@ For more information see the LICENSE file
 #include "graphicsdevice.h"
 #include "vertexlayout.h"
 #include "../geometry/trimesh.h"
+#include "../geometry/meshoptimizer.h"
 #include "skeleton.h"
 #include "../animation/skeletalanimation.h"
 #include "../geometry/boundingsphere.h"
@@ -56,13 +57,29 @@ QMatrix4x4 aiMatrixToQMatrix(aiMatrix4x4 aiMat) {
 
 Mesh::Mesh()
 {
-	triMesh = nullptr;
 	_isDirty = 0;
 	lastShaderId = -1;
 	numVerts = 0;
 	usesIndexBuffer = false;
 }
 
+#define MAX_BONE_INDICES 4
+
+// normals and tangents are stored as 3 normalized shorts padded to 8 bytes
+static char* writeDirection(char* dest, const aiVector3D& dir)
+{
+    auto n = QVector3D(dir.x, dir.y, dir.z).normalized();
+    qint16 packed[4] = {
+        (qint16)qRound(n.x() * 32767.0f),
+        (qint16)qRound(n.y() * 32767.0f),
+        (qint16)qRound(n.z() * 32767.0f),
+        0
+    };
+
+    memcpy(dest, packed, sizeof(packed));
+    return dest + sizeof(packed);
+}
+
 // http://ogldev.atspace.co.uk/www/tutorial38/tutorial38.html
 Mesh::Mesh(aiMesh* mesh)
 {
@@ -70,7 +87,7 @@ Mesh::Mesh(aiMesh* mesh)
     lastShaderId = -1;
     //gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
 
-    triMesh = new TriMesh();
+    triMesh.reset(new TriMesh());
 
     this->vertexLayout = nullptr;
     numVerts = mesh->mNumFaces*3;
@@ -82,36 +99,57 @@ Mesh::Mesh(aiMesh* mesh)
         return;
         //throw QString("Mesh has no positions!!");
 
-    this->addVertexArray(VertexAttribUsage::Position, (void*)mesh->mVertices, sizeof(aiVector3D) * mesh->mNumVertices, GL_FLOAT,3);
+    // Assimp doesnt give the indices in an array
+    // So some calculation still has to be done
+    QVector<unsigned int> indices;
+    indices.reserve(mesh->mNumFaces * 3);
+    for(unsigned i = 0; i < mesh->mNumFaces; i++)
+    {
+        auto face = mesh->mFaces[i];
 
+        if (face.mNumIndices!=3)
+            continue;
 
-    if(mesh->HasTextureCoords(0))
-        this->addVertexArray(VertexAttribUsage::TexCoord0, (void*)mesh->mTextureCoords[0], sizeof(aiVector3D) * mesh->mNumVertices, GL_FLOAT,3);
-    if(mesh->HasTextureCoords(1))
-        this->addVertexArray(VertexAttribUsage::TexCoord1, (void*)mesh->mTextureCoords[1], sizeof(aiVector3D) * mesh->mNumVertices, GL_FLOAT,3);
-    if(mesh->HasNormals())
-        this->addVertexArray(VertexAttribUsage::Normal, (void*)mesh->mNormals, sizeof(aiVector3D) * mesh->mNumVertices, GL_FLOAT,3);
-    if(mesh->HasTangentsAndBitangents())
-        this->addVertexArray(VertexAttribUsage::Tangent, (void*)mesh->mTangents, sizeof(aiVector3D) * mesh->mNumVertices, GL_FLOAT,3);
+        indices.append(face.mIndices[0]);
+        indices.append(face.mIndices[1]);
+        indices.append(face.mIndices[2]);
+    }
 
+    QVector<QVector3D> positions(mesh->mNumVertices);
+    for (unsigned i = 0; i < mesh->mNumVertices; i++)
+        positions[i] = QVector3D(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+
+    // reorder the triangles for the vertex cache and overdraw, then the
+    // vertices in the order they're used. vertexOrder maps the new
+    // vertices to assimp's
+    MeshOptimizer::optimizeVertexCache(indices, mesh->mNumVertices);
+    MeshOptimizer::optimizeOverdraw(indices, positions);
+    auto vertexOrder = MeshOptimizer::optimizeVertexFetch(indices, mesh->mNumVertices);
+    int vertexCount = vertexOrder.size();
+
+    triMesh->triangles.reserve(indices.size() / 3);
+    for (int i = 0; i < indices.size(); i += 3) {
+        triMesh->addTriangle(positions[vertexOrder[indices[i]]],
+                             positions[vertexOrder[indices[i + 1]]],
+                             positions[vertexOrder[indices[i + 2]]]);
+    }
+    triMesh->buildBvh();
+
+    // bone weights for skeletal animation, per assimp vertex
+    QVector<float> boneIndices;
+    QVector<float> boneWeights;
     if (mesh->HasBones()) {
-        // bone weights for skeletal animation
-    #define MAX_BONE_INDICES 4
-        QVector<float> boneIndices;
         boneIndices.resize(MAX_BONE_INDICES * mesh->mNumVertices);
         boneIndices.fill(0);
-        QVector<float> boneWeights;
         boneWeights.resize(MAX_BONE_INDICES * mesh->mNumVertices);
         boneWeights.fill(0);
 
-
         for (unsigned i = 0;i<mesh->mNumBones; i++) {
             auto bone = mesh->mBones[i];
 
             for (unsigned j = 0;j<bone->mNumWeights ; j++) {
                 auto weight = bone->mWeights[j];
                 auto baseIndex = weight.mVertexId * MAX_BONE_INDICES;
-                //qDebug() << weight.mVertexId << " - " << i << " - " << weight.mWeight;
                 // find empty slot and set weight
                 for(unsigned k = 0; k<MAX_BONE_INDICES; k++) {
                     if (baseIndex + k < (unsigned)boneWeights.size()) { //just in case
@@ -121,47 +159,95 @@ Mesh::Mesh(aiMesh* mesh)
                             boneWeights[baseIndex + k] = weight.mWeight;
                             break;
                         }
-                    } else {
-                        //qDebug() << "Invalid vertex index "<<baseIndex + k;
                     }
                 }
             }
         }
+    }
 
-//        for ( auto i =0 ; i < boneWeights.size(); i++) {
-//            qDebug() << boneIndices[i] << " - " << boneWeights[i];
-//        }
+    // all attributes are interleaved in a single buffer
+    // texcoords only use 2 components, directions are stored as normalized shorts,
+    // bone indices as bytes and bone weights as normalized bytes
+    bool hasTexCoords0 = mesh->HasTextureCoords(0);
+    bool hasTexCoords1 = mesh->HasTextureCoords(1);
+    bool hasNormals = mesh->HasNormals();
+    bool hasTangents = mesh->HasTangentsAndBitangents();
+    bool hasBones = mesh->HasBones();
 
-        //this->addVertexArray(VertexAttribUsage::BoneIndices, (void*)boneIndices.data(), sizeof(int) * boneIndices.size(), GL_INT, MAX_BONE_INDICES);
-        this->addVertexArray(VertexAttribUsage::BoneIndices, (void*)boneIndices.data(), sizeof(float) * boneIndices.size(), GL_FLOAT, MAX_BONE_INDICES);
-        this->addVertexArray(VertexAttribUsage::BoneWeights, (void*)boneWeights.data(), sizeof(float) * boneWeights.size(), GL_FLOAT, MAX_BONE_INDICES);
+    VertexLayout layout;
+    layout.addAttrib(VertexAttribUsage::Position, GL_FLOAT, 3, sizeof(GLfloat) * 3);
+    if (hasTexCoords0)
+        layout.addAttrib(VertexAttribUsage::TexCoord0, GL_FLOAT, 2, sizeof(GLfloat) * 2);
+    if (hasTexCoords1)
+        layout.addAttrib(VertexAttribUsage::TexCoord1, GL_FLOAT, 2, sizeof(GLfloat) * 2);
+    if (hasNormals)
+        layout.addAttrib(VertexAttribUsage::Normal, GL_SHORT, 3, sizeof(GLshort) * 4, true);
+    if (hasTangents)
+        layout.addAttrib(VertexAttribUsage::Tangent, GL_SHORT, 3, sizeof(GLshort) * 4, true);
+    if (hasBones) {
+        layout.addAttrib(VertexAttribUsage::BoneIndices, GL_UNSIGNED_BYTE, MAX_BONE_INDICES, MAX_BONE_INDICES);
+        layout.addAttrib(VertexAttribUsage::BoneWeights, GL_UNSIGNED_BYTE, MAX_BONE_INDICES, MAX_BONE_INDICES, true);
     }
 
-    // Assimp doesnt give the indices in an array
-    // So some calculation still has to be done
-    QVector<unsigned int> indices;
-    indices.reserve(mesh->mNumFaces * 3);
-    triMesh->triangles.reserve(mesh->mNumFaces);
-    for(unsigned i = 0; i < mesh->mNumFaces; i++)
-    {
+    QByteArray vertexData(layout.getStride() * vertexCount, 0);
+    char* dest = vertexData.data();
 
-        auto face = mesh->mFaces[i];
+    for (int i = 0; i < vertexCount; i++) {
+        int v = vertexOrder[i];
 
-        if (face.mNumIndices!=3)
-            continue;
+        memcpy(dest, &mesh->mVertices[v], sizeof(GLfloat) * 3);
+        dest += sizeof(GLfloat) * 3;
 
-        indices.append(face.mIndices[0]);
-        indices.append(face.mIndices[1]);
-        indices.append(face.mIndices[2]);
+        if (hasTexCoords0) {
+            memcpy(dest, &mesh->mTextureCoords[0][v], sizeof(GLfloat) * 2);
+            dest += sizeof(GLfloat) * 2;
+        }
+
+        if (hasTexCoords1) {
+            memcpy(dest, &mesh->mTextureCoords[1][v], sizeof(GLfloat) * 2);
+            dest += sizeof(GLfloat) * 2;
+        }
 
-        auto a = mesh->mVertices[face.mIndices[0]];
-        auto b = mesh->mVertices[face.mIndices[1]];
-        auto c = mesh->mVertices[face.mIndices[2]];
+        if (hasNormals)
+            dest = writeDirection(dest, mesh->mNormals[v]);
 
-        triMesh->addTriangle(QVector3D(a.x, a.y, a.z),
-                             QVector3D(b.x, b.y, b.z),
-                             QVector3D(c.x, c.y, c.z));
+        if (hasTangents)
+            dest = writeDirection(dest, mesh->mTangents[v]);
+
+        if (hasBones) {
+            const float* weights = boneWeights.constData() + v * MAX_BONE_INDICES;
+
+            float total = 0;
+            int largest = 0;
+            for (int k = 0; k < MAX_BONE_INDICES; k++) {
+                dest[k] = (char)(quint8)boneIndices[v * MAX_BONE_INDICES + k];
+                total += weights[k];
+                if (weights[k] > weights[largest])
+                    largest = k;
+            }
+            dest += MAX_BONE_INDICES;
+
+            // the weights are renormalized so they still add up to 1 once quantized,
+            // the rounding error goes to the largest weight
+            quint8 packed[MAX_BONE_INDICES] = {0};
+            if (total > 0) {
+                int sum = 0;
+                for (int k = 0; k < MAX_BONE_INDICES; k++) {
+                    packed[k] = (quint8)qRound(weights[k] / total * 255.0f);
+                    sum += packed[k];
+                }
+                packed[largest] += 255 - sum;
+            }
+
+            memcpy(dest, packed, MAX_BONE_INDICES);
+            dest += MAX_BONE_INDICES;
+        }
     }
+
+    auto vb = VertexBuffer::create(layout);
+    vb->setData(vertexData.data(), vertexData.size());
+    vertexBuffers.append(vb);
+
     /*
     gl->glGenBuffers(1, &indexBuffer);
     gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
@@ -170,7 +256,18 @@ Mesh::Mesh(aiMesh* mesh)
     */
     usesIndexBuffer = true;
     idxBuffer = IndexBuffer::create();
-    idxBuffer->setData(indices.data(), sizeof(unsigned int) * indices.size());
+
+    // 16 bit indices are used whenever they can address all of the vertices
+    if (vertexCount <= 0x10000) {
+        QVector<quint16> shortIndices(indices.size());
+        for (int i = 0; i < indices.size(); i++)
+            shortIndices[i] = (quint16)indices[i];
+
+        idxBuffer->setData(shortIndices.data(), sizeof(quint16) * shortIndices.size());
+        idxBuffer->setIndexType(GL_UNSIGNED_SHORT);
+    } else {
+        idxBuffer->setData(indices.data(), sizeof(unsigned int) * indices.size());
+    }
 
     // the true size
     numVerts = indices.size();
@@ -184,7 +281,6 @@ Mesh::Mesh(aiMesh* mesh)
 Mesh::Mesh(void* data,int dataSize,int numElements,VertexLayout* vertexLayout)
 {
     lastShaderId = -1;
-    triMesh = nullptr;
     numVerts = numElements;
 /*
     gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
@@ -325,6 +421,56 @@ void Mesh::draw(GraphicsDevicePtr device)
     }
 }
 
+void Mesh::drawInstanced(GraphicsDevicePtr device, VertexBufferPtr instanceBuffer, int instanceCount)
+{
+	if (numVerts == 0 || instanceCount == 0)
+		return;
+
+    auto buffers = vertexBuffers;
+    buffers.append(instanceBuffer);
+    device->setVertexBuffers(buffers);
+    if (!!idxBuffer) {
+        device->setIndexBuffer(idxBuffer);
+        device->drawIndexedPrimitivesInstanced(glPrimitive, 0, numVerts, instanceCount);
+    } else {
+        device->drawPrimitivesInstanced(glPrimitive, 0, numVerts, instanceCount);
+    }
+}
+
+void Mesh::upload(GraphicsDevicePtr device)
+{
+    for (auto vertexBuffer : vertexBuffers)
+        device->uploadVertexBuffer(vertexBuffer);
+
+    if (!!idxBuffer)
+        device->uploadIndexBuffer(idxBuffer);
+}
+
+MeshPtr Mesh::createInstance()
+{
+    auto mesh = new Mesh(*this);
+    if (!!skeleton)
+        mesh->skeleton = skeleton->clone();
+
+    return MeshPtr(mesh);
+}
+
+qint64 Mesh::getMemoryUsage()
+{
+    qint64 size = 0;
+    for (auto& buffer : vertexBuffers)
+        size += buffer->dataSize;
+    if (!!idxBuffer)
+        size += idxBuffer->dataSize;
+    if (!!triMesh) {
+        size += triMesh->triangles.size() * sizeof(Triangle);
+        size += triMesh->bvhNodes.size() * sizeof(TriMeshBvhNode);
+        size += triMesh->bvhTriangles.size() * sizeof(int);
+    }
+
+    return size;
+}
+
 MeshPtr Mesh::loadMesh(QString filePath)
 {
     // legacy -- update TODO
@@ -426,6 +572,7 @@ SkeletonPtr Mesh::extractSkeleton(const aiMesh *mesh, const aiScene *scene)
     };
 
     evalChildren(scene->mRootNode);
+    skel->updateHierarchy();
 
     return skel;
 }
@@ -444,8 +591,6 @@ MeshPtr Mesh::create()
 Mesh::~Mesh()
 {
     //delete vertexLayout;
-	if (triMesh)
-		delete triMesh;
 }
 
 void Mesh::setVertexCount(const unsigned int count)
@@ -531,7 +676,7 @@ BoundingSphere Mesh::calculateBoundingSphere(const aiMesh *mesh)
     }
 
     BoundingSphere sphere;
-    sphere.pos = QVector3D(averagePos.x, averagePos.y, averagePos.x);
+    sphere.pos = QVector3D(averagePos.x, averagePos.y, averagePos.z);
     sphere.radius = qSqrt(maxDistSqrd);
     return sphere;
 }
@@ -45,7 +45,11 @@ enum class VertexAttribUsage : int
     BiTangent = 8,
     BoneIndices = 9,
     BoneWeights = 10,
-    Count = 11
+    Count = 11,
+
+    // per-instance attributes aren't stored in meshes so they come after Count
+    // the instance matrix is a mat4 so it takes up 4 consecutive locations
+    InstanceMatrix = 11
 };
 
 struct MeshMaterialData
@@ -90,6 +94,8 @@ enum class PrimitiveMode
 //todo: switch to using mesh pointer
 class Mesh
 {
+    friend class MeshFile;
+
     SkeletonPtr skeleton;
     QMap<QString, SkeletalAnimationPtr> skeletalAnimations;
 
@@ -118,10 +124,11 @@ public:
     int numVerts;
     int numFaces;
 
-    TriMesh* triMesh;
+    // shared with instances of this mesh
+    QSharedPointer<TriMesh> triMesh;
     TriMesh* getTriMesh()
     {
-        return triMesh;
+        return triMesh.data();
     }
 
 
@@ -136,6 +143,25 @@ public:
     //void draw(QOpenGLFunctions_3_2_Core* gl, QOpenGLShaderProgram* mat);
     void draw(GraphicsDevicePtr device);
 
+    /**
+     * Draws instanceCount copies of the mesh in a single draw call
+     * instanceBuffer holds the per-instance attributes and should have
+     * an instanced vertex layout
+     */
+    void drawInstanced(GraphicsDevicePtr device, VertexBufferPtr instanceBuffer, int instanceCount);
+
+    // uploads the vertex and index buffers now instead of when the mesh is first drawn
+    void upload(GraphicsDevicePtr device);
+
+    /**
+     * Creates a mesh that shares this mesh's geometry and GPU buffers
+     * The skeleton is copied so instances of skinned meshes can be posed independently
+     */
+    MeshPtr createInstance();
+
+    // size of the mesh's vertex, index and collision data in bytes
+    qint64 getMemoryUsage();
+
     static MeshPtr loadMesh(QString filePath);
     static MeshPtr loadAnimatedMesh(QString filePath);
     static SkeletonPtr extractSkeleton(const aiMesh* mesh, const aiScene* scene);
@@ -159,16 +185,19 @@ public:
                 auto boneAnim = new BoneAnimation();
 
                 // extract tracks
+                boneAnim->posKeys->reserve(nodeAnim->mNumPositionKeys);
                 for (unsigned k = 0; k<nodeAnim->mNumPositionKeys; k++) {
                     auto key = nodeAnim->mPositionKeys[k];
                     boneAnim->posKeys->addKey(QVector3D(key.mValue.x, key.mValue.y, key.mValue.z), key.mTime);
                 }
 
+                boneAnim->rotKeys->reserve(nodeAnim->mNumRotationKeys);
                 for (unsigned k = 0; k<nodeAnim->mNumRotationKeys; k++) {
                     auto key = nodeAnim->mRotationKeys[k];
                     boneAnim->rotKeys->addKey(QQuaternion(key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z), key.mTime);
                 }
 
+                boneAnim->scaleKeys->reserve(nodeAnim->mNumScalingKeys);
                 for (unsigned k = 0; k<nodeAnim->mNumScalingKeys; k++) {
                     auto key = nodeAnim->mScalingKeys[k];
                     boneAnim->scaleKeys->addKey(QVector3D(key.mValue.x, key.mValue.y, key.mValue.z), key.mTime);
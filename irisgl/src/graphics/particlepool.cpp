@@ -0,0 +1,172 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "particlepool.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define PARTICLEPOOL_USE_SSE
+#endif
+
+namespace iris {
+
+#define PARTICLE_GRAVITY -50.0f
+
+ParticlePool::ParticlePool()
+{
+    count = 0;
+    capacity = 0;
+}
+
+void ParticlePool::setCapacity(int capacity)
+{
+    capacity = qMax(capacity, 0);
+    this->capacity = capacity;
+    count = qMin(count, capacity);
+
+    for (auto arr : {&posX, &posY, &posZ, &velX, &velY, &velZ, &gravity, &age, &life, &rotation, &scale})
+        arr->resize(capacity);
+}
+
+bool ParticlePool::add(const QVector3D& pos, const QVector3D& vel, float gravity, float life, float rotation, float scale)
+{
+    if (count >= capacity)
+        return false;
+
+    int i = count++;
+    posX[i] = pos.x();
+    posY[i] = pos.y();
+    posZ[i] = pos.z();
+    velX[i] = vel.x();
+    velY[i] = vel.y();
+    velZ[i] = vel.z();
+    this->gravity[i] = gravity;
+    age[i] = 0.0f;
+    this->life[i] = life;
+    this->rotation[i] = rotation;
+    this->scale[i] = scale;
+
+    return true;
+}
+
+void ParticlePool::remove(int index)
+{
+    int last = --count;
+    if (index == last)
+        return;
+
+    posX[index] = posX[last];
+    posY[index] = posY[last];
+    posZ[index] = posZ[last];
+    velX[index] = velX[last];
+    velY[index] = velY[last];
+    velZ[index] = velZ[last];
+    gravity[index] = gravity[last];
+    age[index] = age[last];
+    life[index] = life[last];
+    rotation[index] = rotation[last];
+    scale[index] = scale[last];
+}
+
+void ParticlePool::update(float delta, bool dissipate, bool dissipateInv, float maxScale)
+{
+    float* px = posX.data();
+    float* py = posY.data();
+    float* pz = posZ.data();
+    float* vx = velX.data();
+    float* vy = velY.data();
+    float* vz = velZ.data();
+    float* grav = gravity.data();
+    float* ages = age.data();
+    float* lives = life.data();
+    float* scales = scale.data();
+
+    float gravityStep = PARTICLE_GRAVITY * delta;
+    int i = 0;
+
+#ifdef PARTICLEPOOL_USE_SSE
+    __m128 dt = _mm_set1_ps(delta);
+    __m128 g = _mm_set1_ps(gravityStep);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 sclMax = _mm_set1_ps(maxScale);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 velY4 = _mm_add_ps(_mm_loadu_ps(vy + i), _mm_mul_ps(g, _mm_loadu_ps(grav + i)));
+        _mm_storeu_ps(vy + i, velY4);
+
+        _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(_mm_loadu_ps(vx + i), dt)));
+        _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(velY4, dt)));
+        _mm_storeu_ps(pz + i, _mm_add_ps(_mm_loadu_ps(pz + i), _mm_mul_ps(_mm_loadu_ps(vz + i), dt)));
+
+        __m128 age4 = _mm_add_ps(_mm_loadu_ps(ages + i), dt);
+        _mm_storeu_ps(ages + i, age4);
+
+        if (dissipate) {
+            __m128 t = _mm_div_ps(age4, _mm_loadu_ps(lives + i));
+            if (dissipateInv)
+                _mm_storeu_ps(scales + i, _mm_mul_ps(sclMax, t));
+            else
+                _mm_storeu_ps(scales + i, _mm_mul_ps(_mm_loadu_ps(scales + i), _mm_sub_ps(one, t)));
+        }
+    }
+#endif
+
+    // whatever is left over, or everything when sse isnt available
+    for (; i < count; i++) {
+        vy[i] += gravityStep * grav[i];
+        px[i] += vx[i] * delta;
+        py[i] += vy[i] * delta;
+        pz[i] += vz[i] * delta;
+        ages[i] += delta;
+
+        if (dissipate) {
+            float t = ages[i] / lives[i];
+            if (dissipateInv)
+                scales[i] = maxScale * t;
+            else
+                scales[i] *= 1.0f - t;
+        }
+    }
+
+    for (int p = 0; p < count;) {
+        if (ages[p] > lives[p])
+            remove(p);
+        else
+            p++;
+    }
+}
+
+BoundingSphere ParticlePool::calculateBoundingSphere()
+{
+    BoundingSphere sphere;
+    if (count == 0)
+        return sphere;
+
+    QVector3D boundsMin(posX[0], posY[0], posZ[0]);
+    QVector3D boundsMax = boundsMin;
+    float maxScale = 0.0f;
+    for (int i = 0; i < count; i++) {
+        boundsMin.setX(qMin(boundsMin.x(), posX[i]));
+        boundsMin.setY(qMin(boundsMin.y(), posY[i]));
+        boundsMin.setZ(qMin(boundsMin.z(), posZ[i]));
+        boundsMax.setX(qMax(boundsMax.x(), posX[i]));
+        boundsMax.setY(qMax(boundsMax.y(), posY[i]));
+        boundsMax.setZ(qMax(boundsMax.z(), posZ[i]));
+        maxScale = qMax(maxScale, qAbs(scale[i]));
+    }
+
+    // quads span -scale to scale on both axes
+    sphere.pos = (boundsMin + boundsMax) * 0.5f;
+    sphere.radius = (boundsMax - boundsMin).length() * 0.5f + maxScale * 1.4143f;
+    return sphere;
+}
+
+}
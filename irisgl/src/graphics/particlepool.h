@@ -0,0 +1,92 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef PARTICLEPOOL_H
+#define PARTICLEPOOL_H
+
+#include <QVector>
+#include <QVector3D>
+#include "../geometry/boundingsphere.h"
+
+namespace iris {
+
+/**
+ * Fixed capacity storage for a particle system's particles
+ * Each attribute is kept in its own array so they can be updated four at a
+ * time. Only the first getCount() entries of each array are alive, dead
+ * particles are replaced by the last alive one.
+ */
+class ParticlePool
+{
+public:
+    QVector<float> posX, posY, posZ;
+    QVector<float> velX, velY, velZ;
+    QVector<float> gravity;// how much gravity affects the particle
+    QVector<float> age;
+    QVector<float> life;
+    QVector<float> rotation;
+    QVector<float> scale;
+
+    ParticlePool();
+
+    /**
+     * Resizes the pool. Particles past the new capacity are dropped.
+     * @param capacity
+     */
+    void setCapacity(int capacity);
+
+    int getCapacity() const
+    {
+        return capacity;
+    }
+
+    int getCount() const
+    {
+        return count;
+    }
+
+    bool isFull() const
+    {
+        return count >= capacity;
+    }
+
+    /**
+     * Adds a particle
+     * Returns false if the pool is full
+     */
+    bool add(const QVector3D& pos, const QVector3D& vel, float gravity, float life, float rotation, float scale);
+
+    // swaps the last particle into index
+    void remove(int index);
+
+    void clear()
+    {
+        count = 0;
+    }
+
+    /**
+     * Moves the particles and removes the ones that outlived their life
+     * When dissipating, particles shrink as they age or grow to maxScale if
+     * dissipateInv is true
+     */
+    void update(float delta, bool dissipate, bool dissipateInv, float maxScale);
+
+    // sphere enclosing every alive particle's quad
+    BoundingSphere calculateBoundingSphere();
+
+private:
+    int count;
+    int capacity;
+};
+
+}
+
+#endif // PARTICLEPOOL_H
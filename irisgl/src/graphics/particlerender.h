@@ -16,20 +16,28 @@ For more information see the LICENSE file
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFunctions_3_2_Core>
 #include <QOpenGLContext>
-#include "particle.h"
+#include "particlepool.h"
 #include "renderdata.h"
 #include "texture2d.h"
 #include "../core/irisutils.h"
 #include "graphicsdevice.h"
 #include "blendstate.h"
+#include "vertexlayout.h"
 
 namespace iris {
 
+/**
+ * Draws a particle system's particles as camera-facing quads
+ * Each particle's position, rotation, scale and age are streamed into an
+ * instance buffer and the whole system is drawn in one instanced call.
+ * The quads are billboarded in particle.vert
+ */
 class ParticleRenderer {
 
 private:
-    GLuint quadVAO, quadVBO;
-    QOpenGLFunctions_3_2_Core* gl;
+    VertexBufferPtr quadBuffer;
+    VertexBufferPtr instanceBuffer;
+    QVector<float> instanceData;
 	DepthState depthState;
 
 public:
@@ -37,8 +45,6 @@ public:
 
     QSharedPointer<iris::Texture2D> icon;
     ParticleRenderer() {
-        this->gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
-
         GLfloat quadVertices[] = {
             -1.f,  1.f, 0.f,    0.0f, 1.0f,
             -1.f, -1.f, 0.f,    0.0f, 0.0f,
@@ -46,51 +52,20 @@ public:
              1.f, -1.f, 0.f,    1.0f, 0.0f,
         };
 
-        gl->glGenVertexArrays(1, &quadVAO);
-        gl->glGenBuffers(1, &quadVBO);
-        gl->glBindVertexArray(quadVAO);
-        gl->glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-        gl->glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-        gl->glEnableVertexAttribArray(0);
-        gl->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), nullptr);
-        gl->glEnableVertexAttribArray(1);
-        gl->glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE,
-                                  5 * sizeof(GLfloat),
-                                  (GLvoid*) (3 * sizeof(GLfloat)));
-        gl->glBindVertexArray(0);
+        VertexLayout quadLayout;
+        quadLayout.addAttrib(VertexAttribUsage::Position, GL_FLOAT, 3, sizeof(GLfloat) * 3);
+        quadLayout.addAttrib(VertexAttribUsage::TexCoord0, GL_FLOAT, 2, sizeof(GLfloat) * 2);
+        quadBuffer = VertexBuffer::create(quadLayout);
+        quadBuffer->setData(quadVertices, sizeof(quadVertices));
+
+        // refilled every frame so the old storage is orphaned on upload
+        instanceBuffer = VertexBuffer::create(VertexLayout::createParticleInstance());
+        instanceBuffer->setUsage(GL_STREAM_DRAW);
 
         useAdditive = true;
 		depthState = DepthState(true, false);
     }
 
-    void updateModelViewMatrix(QOpenGLShaderProgram *shader,
-                               QVector3D pos,
-                               float rot,
-                               float scale,
-                               QMatrix4x4 viewMatrix)
-    {
-        QMatrix4x4 modelMatrix;
-        modelMatrix.translate(pos);
-
-        modelMatrix(0, 0) = viewMatrix(0, 0);
-        modelMatrix(0, 1) = viewMatrix(1, 0);
-        modelMatrix(0, 2) = viewMatrix(2, 0);
-
-        modelMatrix(1, 0) = viewMatrix(0, 1);
-        modelMatrix(1, 1) = viewMatrix(1, 1);
-        modelMatrix(1, 2) = viewMatrix(2, 1);
-
-        modelMatrix(2, 0) = viewMatrix(0, 2);
-        modelMatrix(2, 1) = viewMatrix(1, 2);
-        modelMatrix(2, 2) = viewMatrix(2, 2);
-
-        modelMatrix.rotate((float) rot, QVector3D(0, 0, 1));
-        modelMatrix.scale(scale, scale, scale);
-
-        QMatrix4x4 modelViewMatrix = viewMatrix * modelMatrix;
-        shader->setUniformValue("modelViewMatrix", modelViewMatrix);
-    }
-
     void setIcon(QSharedPointer<iris::Texture2D> icon) {
         this->icon = icon;
     }
@@ -98,47 +73,60 @@ public:
     void render(GraphicsDevicePtr device,
 				QOpenGLShaderProgram *shader,
                 iris::RenderData* renderData,
-                std::vector<Particle*>& particles)
+                ParticlePool& particles)
     {
+        int count = particles.getCount();
+        if (count == 0)
+            return;
+
         shader->bind();
 
         shader->setUniformValue("projectionMatrix", renderData->projMatrix);
-        QMatrix4x4 viewMatrix = renderData->viewMatrix;
-
-        gl->glBindVertexArray(quadVAO);
-        //gl->glEnable(GL_BLEND);
-		
+        shader->setUniformValue("viewMatrix", renderData->viewMatrix);
 
         if (useAdditive) {
-            //gl->glBlendFunc(GL_SRC_ALPHA, GL_ONE);
             device->setBlendState(BlendState(GL_SRC_ALPHA, GL_ONE));
         } else {
-            //gl->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 			device->setBlendState(BlendState::createAlphaBlend());
         }
 
-        //gl->glDepthMask(GL_FALSE);
 		device->setDepthState(depthState);
 
-        for (auto particle : particles) {
-            updateModelViewMatrix(
-                        shader,
-                        particle->getPosition(),
-                        particle->getRotation(),
-                        particle->getScale(),
-                        viewMatrix
-                    );
-
-            if (!!icon) {
-                gl->glActiveTexture(GL_TEXTURE0);
-                icon->texture->bind();
-            }
-            gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        if (!!icon)
+            device->setTexture(0, icon);
+
+        // 2 vec4s per particle, see VertexLayout::createParticleInstance
+        instanceData.resize(count * 8);
+        float* data = instanceData.data();
+        for (int i = 0; i < count; i++) {
+            data[0] = particles.posX[i];
+            data[1] = particles.posY[i];
+            data[2] = particles.posZ[i];
+            data[3] = particles.rotation[i];
+            data[4] = particles.scale[i];
+            data[5] = particles.life[i] > 0 ? particles.age[i] / particles.life[i] : 1.0f;
+            data[6] = 0.0f;
+            data[7] = 0.0f;
+            data += 8;
         }
 
-        //gl->glDepthMask(GL_TRUE);
-        //gl->glDisable(GL_BLEND);
-        gl->glBindVertexArray(0);
+        if (device->supportsInstancing()) {
+            instanceBuffer->setData(instanceData.data(), sizeof(float) * instanceData.size());
+            device->setVertexBuffers({quadBuffer, instanceBuffer});
+            device->drawPrimitivesInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+        } else {
+            // without divisors the particle attributes are
+            // set as constants before drawing each quad
+            auto gl = device->getGL();
+            int posLoc = (int)VertexAttribUsage::InstanceMatrix;
+            device->setVertexBuffer(quadBuffer);
+            for (int i = 0; i < count; i++) {
+                auto particle = instanceData.constData() + i * 8;
+                gl->glVertexAttrib4fv(posLoc, particle);
+                gl->glVertexAttrib4fv(posLoc + 1, particle + 4);
+                device->drawPrimitives(GL_TRIANGLE_STRIP, 0, 4);
+            }
+        }
 
         shader->release();
     }
@@ -7,6 +7,8 @@
 #include "utils/fullscreenquad.h"
 #include "texture2d.h"
 #include "postprocess.h"
+#include "graphicsdevice.h"
+#include "../core/performancetimer.h"
 
 #include "../postprocesses/coloroverlaypostprocess.h"
 #include "../postprocesses/radialblurpostprocess.h"
@@ -86,11 +88,15 @@ void PostProcessManager::blit(iris::Texture2DPtr source, iris::Texture2DPtr dest
 
 void PostProcessManager::process(PostProcessContext *context)
 {
+    IRIS_PROFILE_GPU("post process", device);
+
     context->manager = this;
 
     blit(context->sceneTexture, context->finalTexture);
 
+    auto timer = PerformanceTimer::getSingleton();
     for (auto process : postProcesses) {
+        ProfileZone zone(timer->intern(process->getName()), device->getGpuTimer());
         process->process(context);
     }
 }
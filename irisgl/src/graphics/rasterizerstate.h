@@ -30,6 +30,11 @@ struct RasterizerState
     {
     }
 
+    bool operator==(const RasterizerState& other) const
+    {
+        return cullMode == other.cullMode && fillMode == other.fillMode;
+    }
+
     static RasterizerState CullCounterClockwise;
     static RasterizerState CullClockwise;
     static RasterizerState CullNone;
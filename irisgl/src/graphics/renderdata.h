@@ -14,11 +14,60 @@ For more information see the LICENSE file
 
 #include "../irisglfwd.h"
 #include "../geometry/frustum.h"
+#include "shader.h"
+#include "shadowmap.h"
 #include <QColor>
 
 namespace iris
 {
 
+/*
+ * CPU-side mirrors of the std140 structs declared in scene_uniforms.glsl
+ * Members are ordered so no explicit padding is needed apart from the
+ * trailing fields, any change here must be reflected in the shader.
+ */
+struct SceneUniformLight
+{
+    float color[4];
+    float position[3];
+    float distance;
+    float direction[3];
+    float intensity;
+    int type;
+    float cutOffAngle;
+    float cutOffSoftness;
+    int shadowType;
+    float cascadeSplits[ShadowMap::MaxCascades];
+    int cascadeCount;
+    float _pad0[3];
+    float shadowMatrices[ShadowMap::MaxCascades][16];
+};
+
+struct SceneUniformFog
+{
+    float color[4];
+    float start;
+    float end;
+    int enabled;
+    float _pad0;
+};
+
+struct SceneUniformBlock
+{
+    float viewMatrix[16];
+    float projMatrix[16];
+    float eyePos[3];
+    float time;
+    float sceneAmbient[3];
+    int lightCount;
+    SceneUniformFog fog;
+    SceneUniformLight lights[SHADER_MAX_LIGHTS];
+
+    int clusterGrid[4];
+    float clusterViewport[4];
+    float clusterDepth[4];
+};
+
 struct RenderData
 {
     ScenePtr scene;
@@ -16,6 +16,7 @@ void RenderItem::reset()
 
     cullable = false;
     renderLayer = (int)RenderLayer::Opaque;
+    sortKey = 0;
 }
 
 }
@@ -52,8 +52,13 @@ struct RenderItem
     //used if no material is specified
     int renderLayer;
 
+    // generated by RenderList::sort from the layer, shader, material,
+    // mesh and distance to the camera
+    quint64 sortKey;
+
     RenderItem() {
         type = RenderItemType::None;
+        sortKey = 0;
         //renderLayer = (int)RenderLayer::Opaque;
         worldMatrix.setToIdentity();
     }
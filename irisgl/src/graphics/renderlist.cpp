@@ -1,5 +1,8 @@
 #include "renderlist.h"
 #include "renderitem.h"
+#include "shader.h"
+#include <cstring>
+#include <algorithm>
 
 namespace iris {
 
@@ -67,11 +70,85 @@ void RenderList::clear()
     used.clear();
 }
 
-void RenderList::sort()
+// Sort key layout, from the most significant bit:
+// opaque:      layer(16) shader(12) material(12) mesh(10) depth(14)
+// transparent: layer(16) inverted depth(24) shader(12) material(12)
+// ids are truncated to fit so collisions only cost an extra state change
+quint64 RenderList::generateSortKey(RenderItem* item, const QVector3D& eyePos)
 {
-    qSort(renderList.begin(), renderList.end(), [](const RenderItem* a, const RenderItem* b) {
-        return a->renderLayer < b->renderLayer;
-    });
+    quint64 layer = qBound(0, item->renderLayer, 0xFFFF);
+
+    quint64 shaderId = 0;
+    quint64 materialId = 0;
+    if (!!item->material) {
+        materialId = item->material->materialId & 0xFFF;
+        if (!!item->material->shader)
+            shaderId = item->material->shader->getShaderId() & 0xFFF;
+    }
+
+    quint64 meshId = (quintptr(item->mesh.data()) >> 4) & 0x3FF;
+
+    // the bits of a positive float sort the same way as its value
+    float dist = (item->worldMatrix.column(3).toVector3D() - eyePos).length();
+    quint32 distBits;
+    memcpy(&distBits, &dist, sizeof(float));
+
+    if (item->renderLayer >= (int)RenderLayer::Transparent) {
+        // back to front
+        quint64 depth = ((~distBits) >> 7) & 0xFFFFFF;
+        return (layer << 48) | (depth << 24) | (shaderId << 12) | materialId;
+    }
+
+    // front to back within each state group
+    quint64 depth = (distBits >> 17) & 0x3FFF;
+    return (layer << 48) | (shaderId << 36) | (materialId << 24) | (meshId << 14) | depth;
+}
+
+void RenderList::sort(const QVector3D& eyePos)
+{
+    const int count = renderList.size();
+    if (count < 2)
+        return;
+
+    sortEntries.resize(count);
+    sortTemp.resize(count);
+
+    for (int i = 0; i < count; i++) {
+        auto item = renderList[i];
+        item->sortKey = generateSortKey(item, eyePos);
+        sortEntries[i].key = item->sortKey;
+        sortEntries[i].item = item;
+    }
+
+    // lsd radix sort, one byte per pass
+    // it's stable so items with equal keys keep their submission order
+    SortEntry* src = sortEntries.data();
+    SortEntry* dst = sortTemp.data();
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        int offsets[256] = {0};
+        for (int i = 0; i < count; i++)
+            offsets[(src[i].key >> shift) & 0xFF]++;
+
+        // all keys share this byte so the pass wouldnt change the order
+        if (offsets[(src[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        int total = 0;
+        for (int b = 0; b < 256; b++) {
+            int bucketSize = offsets[b];
+            offsets[b] = total;
+            total += bucketSize;
+        }
+
+        for (int i = 0; i < count; i++)
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+        std::swap(src, dst);
+    }
+
+    for (int i = 0; i < count; i++)
+        renderList[i] = src[i].item;
 }
 
 RenderList::~RenderList()
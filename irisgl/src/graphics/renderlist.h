@@ -14,6 +14,18 @@ class RenderList
     QVector<RenderItem*> used;
 
     QVector<RenderItem*> renderList;
+
+    struct SortEntry
+    {
+        quint64 key;
+        RenderItem* item;
+    };
+
+    // scratch buffers for the radix sort, kept around to avoid reallocating every frame
+    QVector<SortEntry> sortEntries;
+    QVector<SortEntry> sortTemp;
+
+    static quint64 generateSortKey(RenderItem* item, const QVector3D& eyePos);
 public:
     RenderList();
 //    QVector<RenderItem*>& getItems();
@@ -30,7 +42,13 @@ public:
 
     void clear();
 
-    void sort();
+    /**
+     * Sorts items by render layer first, then by state for opaque items and
+     * by distance for transparent ones so that items sharing a shader and
+     * material are drawn together
+     * @param eyePos position of the camera the list is rendered from
+     */
+    void sort(const QVector3D& eyePos);
 
     ~RenderList();
 };
@@ -20,6 +20,18 @@ struct RenderStates
     bool receiveLighting;
 
 	RenderStates();
+
+    bool operator==(const RenderStates& other) const
+    {
+        return renderLayer == other.renderLayer &&
+               blendState == other.blendState &&
+               depthState == other.depthState &&
+               rasterState == other.rasterState &&
+               fogEnabled == other.fogEnabled &&
+               castShadows == other.castShadows &&
+               receiveShadows == other.receiveShadows &&
+               receiveLighting == other.receiveLighting;
+    }
 };
 
 }
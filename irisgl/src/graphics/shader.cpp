@@ -19,6 +19,8 @@ For more information see the LICENSE file
 #include "mesh.h"
 #include "texture.h"
 #include "graphicshelper.h"
+#include "../core/shadermanager.h"
+#include <QCryptographicHash>
 
 namespace iris
 {
@@ -55,9 +57,7 @@ void Shader::setFragmentShader(QString fragmentShader)
 
 ShaderPtr Shader::load(QString vertexShaderFile,QString fragmentShaderFile)
 {
-	QString vertexShader = GraphicsHelper::loadAndProcessShader(vertexShaderFile);
-	QString fragmentShader = GraphicsHelper::loadAndProcessShader(fragmentShaderFile);
-    return create(vertexShader,fragmentShader);
+    return ShaderManager::getSingleton()->load(vertexShaderFile, fragmentShaderFile);
 }
 
 ShaderPtr Shader::create(QString vertexShader, QString fragmentShader)
@@ -78,6 +78,12 @@ Shader::Shader()
 {
 	isDirty = true;
 	program = nullptr;
+    hasSceneBlock = false;
+    sceneUniformsPass = -1;
+    materialBlockSize = 0;
+    materialBlockLayout = 0;
+    materialValuesId = -1;
+    materialValuesRevision = 0;
 
     shaderId = generateNodeId();
 }
@@ -85,6 +91,44 @@ Shader::Shader()
 void Shader::_setDirty()
 {
 	isDirty = true;
+	instancedVariant.clear();
+	sourceHash.clear();
+}
+
+QByteArray Shader::getSourceHash()
+{
+    if (sourceHash.isEmpty())
+        sourceHash = hashSource(vertexShader, fragmentShader);
+    return sourceHash;
+}
+
+QByteArray Shader::hashSource(const QString& vertexShader, const QString& fragmentShader)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(vertexShader.toUtf8());
+    hash.addData("\0", 1);
+    hash.addData(fragmentShader.toUtf8());
+    return hash.result();
+}
+
+// inserts a #define right after the #version directive
+static QString addShaderDefine(const QString& source, const QString& define)
+{
+    auto versionIndex = source.indexOf("#version");
+    auto insertIndex = versionIndex == -1 ? 0 : source.indexOf('\n', versionIndex) + 1;
+    return QString(source).insert(insertIndex, QString("#define %1\n").arg(define));
+}
+
+ShaderPtr Shader::getInstancedVariant()
+{
+    if (!vertexShader.contains("a_instanceMatrix"))
+        return ShaderPtr();
+
+    if (!instancedVariant)
+        instancedVariant = ShaderManager::getSingleton()->getShader(addShaderDefine(vertexShader, "INSTANCED"),
+                                                                    fragmentShader);
+
+    return instancedVariant;
 }
 
 ShaderValue* Shader::getUniform(QString name)
@@ -95,6 +139,70 @@ ShaderValue* Shader::getUniform(QString name)
     return nullptr;
 }
 
+int Shader::getUniformLocation(const char* name)
+{
+    // fromRawData avoids copying the name for lookups
+    auto key = QByteArray::fromRawData(name, (int)qstrlen(name));
+    auto iter = uniformLocations.constFind(key);
+    if (iter != uniformLocations.constEnd())
+        return iter.value();
+
+    int location = -1;
+    if (program)
+        location = program->uniformLocation(name);
+
+    // unused uniforms are cached too so they arent looked up again
+    uniformLocations.insert(QByteArray(name), location);
+    return location;
+}
+
+int Shader::getUniformLocation(const QString& name)
+{
+    return getUniformLocation(name.toLatin1().constData());
+}
+
+void Shader::resolveBuiltinLocations()
+{
+    builtins.worldMatrix    = getUniformLocation("u_worldMatrix");
+    builtins.normalMatrix   = getUniformLocation("u_normalMatrix");
+    builtins.viewMatrix     = getUniformLocation("u_viewMatrix");
+    builtins.projMatrix     = getUniformLocation("u_projMatrix");
+    builtins.time           = getUniformLocation("u_time");
+    builtins.eyePos         = getUniformLocation("u_eyePos");
+    builtins.sceneAmbient   = getUniformLocation("u_sceneAmbient");
+    builtins.lightCount     = getUniformLocation("u_lightCount");
+    builtins.bones          = getUniformLocation("u_bones");
+    builtins.receiveFog     = getUniformLocation("u_receiveFog");
+
+    builtins.fogColor       = getUniformLocation("u_fogData.color");
+    builtins.fogStart       = getUniformLocation("u_fogData.start");
+    builtins.fogEnd         = getUniformLocation("u_fogData.end");
+    builtins.fogEnabled     = getUniformLocation("u_fogData.enabled");
+
+    builtins.shadowMaps     = getUniformLocation("u_shadowMaps");
+
+    builtins.clusterLights  = getUniformLocation("u_clusterLights");
+    builtins.clusterCells   = getUniformLocation("u_clusterCells");
+    builtins.clusterIndices = getUniformLocation("u_clusterIndices");
+
+    for (int i = 0; i < SHADER_MAX_LIGHTS; i++) {
+        auto prefix = QString("u_lights[%0].").arg(i);
+        auto& light = builtins.lights[i];
+
+        light.type              = getUniformLocation(prefix + "type");
+        light.position          = getUniformLocation(prefix + "position");
+        light.distance          = getUniformLocation(prefix + "distance");
+        light.direction         = getUniformLocation(prefix + "direction");
+        light.cutOffAngle       = getUniformLocation(prefix + "cutOffAngle");
+        light.cutOffSoftness    = getUniformLocation(prefix + "cutOffSoftness");
+        light.intensity         = getUniformLocation(prefix + "intensity");
+        light.color             = getUniformLocation(prefix + "color");
+        light.shadowMap         = getUniformLocation(prefix + "shadowMap");
+        light.shadowMatrix      = getUniformLocation(prefix + "shadowMatrix");
+        light.shadowType        = getUniformLocation(prefix + "shadowType");
+    }
+}
+
 long Shader::generateNodeId()
 {
     return nextId++;
@@ -14,6 +14,8 @@ For more information see the LICENSE file
 
 #include "../irisglfwd.h"
 #include <QVariant>
+#include <QHash>
+#include <QVector>
 #include <qopengl.h>
 
 class QOpenGLShaderProgram;
@@ -61,14 +63,82 @@ public:
     TexturePtr texture;
 };
 
+// maximum number of lights the built-in shaders accept
+// this must match MAX_LIGHTS in the shaders
+#define SHADER_MAX_LIGHTS 8
+
+/**
+ * Locations of the members of a single u_lights[i] entry.
+ * These are resolved once when the shader is linked so lights can be
+ * uploaded without building uniform names every frame.
+ */
+struct ShaderLightLocations
+{
+    int type;
+    int position;
+    int distance;
+    int direction;
+    int cutOffAngle;
+    int cutOffSoftness;
+    int intensity;
+    int color;
+    int shadowMap;
+    int shadowMatrix;
+    int shadowType;
+};
+
+/**
+ * Locations of the uniforms the renderer sets for every shader
+ * A value of -1 means the shader doesnt use the uniform
+ */
+struct ShaderBuiltinLocations
+{
+    int worldMatrix;
+    int normalMatrix;
+    int viewMatrix;
+    int projMatrix;
+    int time;
+    int eyePos;
+    int sceneAmbient;
+    int lightCount;
+    int bones;
+    int receiveFog;
+
+    int fogColor;
+    int fogStart;
+    int fogEnd;
+    int fogEnabled;
+
+    int shadowMaps;
+
+    // texture buffers of the clustered lights
+    int clusterLights;
+    int clusterCells;
+    int clusterIndices;
+
+    ShaderLightLocations lights[SHADER_MAX_LIGHTS];
+};
+
+/**
+ * A member of the MaterialData uniform block
+ */
+struct ShaderBlockMember
+{
+    int offset;
+    GLenum type;
+};
+
 class Shader
 {
     friend class Material;
+    friend class CustomMaterial;
 	friend class VertexLayout;
 	friend class GraphicsDevice;
 	friend class SpriteBatch;
+	friend class ForwardRenderer;
 
 public:
+    // shaders are shared by everything loading the same source, see ShaderManager
     static ShaderPtr load(QString vertexShaderFile, QString fragmentShaderFile);
     static ShaderPtr create(QString vertexShader, QString fragmentShader);
 	static ShaderPtr create();
@@ -80,6 +150,45 @@ public:
 
 	void _setDirty();
 
+    /**
+     * Returns the location of the uniform or -1 if the shader doesnt have it
+     * Locations are cached so the name is only looked up by gl once
+     */
+    int getUniformLocation(const char* name);
+    int getUniformLocation(const QString& name);
+
+    /**
+     * Returns true if the shader declares the SceneData uniform block
+     */
+    bool usesSceneUniformBlock() const
+    {
+        return hasSceneBlock;
+    }
+
+    /**
+     * Returns true if the shader declares the MaterialData uniform block
+     */
+    bool usesMaterialUniformBlock() const
+    {
+        return materialBlockSize > 0;
+    }
+
+    long getShaderId() const
+    {
+        return shaderId;
+    }
+
+    // sha1 of the vertex and fragment source, identifies the program in the caches
+    QByteArray getSourceHash();
+    static QByteArray hashSource(const QString& vertexShader, const QString& fragmentShader);
+
+    /**
+     * Returns this shader compiled with INSTANCED defined, which makes the vertex
+     * shader take its world matrix from the a_instanceMatrix attribute.
+     * Returns a null pointer if the vertex shader doesnt support instancing
+     */
+    ShaderPtr getInstancedVariant();
+
 private:
 	QOpenGLShaderProgram * program;
 	long shaderId;
@@ -122,7 +231,34 @@ protected:
 
     QList<ShaderValue*> updatedUniforms;
 
+    ShaderPtr instancedVariant;
+
+    // uniform locations by name, filled at link time
+    QHash<QByteArray, int> uniformLocations;
+    ShaderBuiltinLocations builtins;
+    bool hasSceneBlock;
+
+    // the renderer pass in which scene uniforms were last uploaded to this
+    // shader's program. shaders without the SceneData block keep their scene
+    // uniforms in program state so they only need to be set once per pass
+    long sceneUniformsPass;
+
+    // members of the MaterialData block by name, with the block's size and an id
+    // of its layout that's the same for shaders declaring the same block
+    QHash<QByteArray, ShaderBlockMember> materialBlockMembers;
+    int materialBlockSize;
+    uint materialBlockLayout;
+
+    // the material whose values were last set on this shader's program and
+    // the revision of those values, so a material used by many meshes in a
+    // row only sets them once
+    long materialValuesId;
+    int materialValuesRevision;
+
+    void resolveBuiltinLocations();
+
 	QString vertexShader, fragmentShader;
+	QByteArray sourceHash;
 };
 
 }
@@ -11,6 +11,13 @@ ShadowMap::ShadowMap()
     resolution = 1024*2;
     shadowTexture = Texture2D::createShadowDepth(resolution, resolution);
     bias = 0.01f;
+    casterHash = 0;
+    isDirty = true;
+
+    cascadeCount = 1;
+    cascadeDistance = 200.0f;
+    for (int i = 0; i < MaxCascades; i++)
+        cascadeSplits[i] = 0.0f;
     /*
     auto gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
     gl->glGenTextures(1, &shadowTexId);
@@ -31,6 +38,35 @@ void ShadowMap::setResolution(int size)
 {
     resolution = size;
     shadowTexture->resize(size, size);
+    isDirty = true;
+}
+
+void ShadowMap::setCascadeCount(int count)
+{
+    cascadeCount = qBound(1, count, MaxCascades);
+    isDirty = true;
+}
+
+int ShadowMap::getCascadeResolution()
+{
+    // cascades share the texture as a 2x2 grid of tiles
+    return cascadeCount > 1 ? resolution / 2 : resolution;
+}
+
+QRect ShadowMap::getCascadeViewport(int cascade)
+{
+    int size = getCascadeResolution();
+    return QRect((cascade % 2) * size, (cascade / 2) * size, size, size);
+}
+
+QMatrix4x4 ShadowMap::getCascadeTileMatrix(int cascade)
+{
+    QMatrix4x4 tile;
+    if (cascadeCount > 1) {
+        tile.translate(-0.5f + (cascade % 2), -0.5f + (cascade / 2), 0.0f);
+        tile.scale(0.5f, 0.5f, 1.0f);
+    }
+    return tile;
 }
 
 
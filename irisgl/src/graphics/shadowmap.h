@@ -4,6 +4,7 @@
 #include <qopengl.h>
 #include "../irisglfwd.h"
 #include <QMatrix4x4>
+#include <QRect>
 
 namespace iris
 {
@@ -19,6 +20,8 @@ enum class ShadowMapType : int
 class ShadowMap
 {
 public:
+    static const int MaxCascades = 4;
+
     ShadowMapType shadowType;
     Texture2DPtr shadowTexture;
     //GLuint shadowTexId;
@@ -26,9 +29,37 @@ public:
     int resolution;
     float bias;
 
+    // directional lights can split the camera's view into cascadeCount slices
+    // each slice is rendered into its own tile of shadowTexture so nearby
+    // objects get more texels. 1 disables cascades
+    int cascadeCount;
+    // cascades only cover this distance from the camera
+    float cascadeDistance;
+
+    // light view-projection used to render each cascade
+    QMatrix4x4 cascadeMatrices[MaxCascades];
+    // cascadeMatrices remapped to each cascade's tile, used for sampling
+    QMatrix4x4 cascadeTextureMatrices[MaxCascades];
+    // view depth at which each cascade ends
+    float cascadeSplits[MaxCascades];
+
+    // the map is only re-rendered when the light or one of the casters inside
+    // its frustum changes. casterHash identifies the light matrices and the casters
+    // the map was last rendered with, isDirty forces the next render
+    quint64 casterHash;
+    bool isDirty;
+
     ShadowMap();
 
     void setResolution(int size);
+
+    void setCascadeCount(int count);
+
+    // size of the tiles the cascades are rendered to
+    int getCascadeResolution();
+    QRect getCascadeViewport(int cascade);
+    // maps a cascade's clip space to its tile of the shadow texture
+    QMatrix4x4 getCascadeTileMatrix(int cascade);
 };
 
 
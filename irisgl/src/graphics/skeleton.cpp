@@ -1,7 +1,6 @@
 #include "../irisglfwd.h"
 #include "skeleton.h"
 #include "../animation/skeletalanimation.h"
-#include <functional>
 
 namespace iris
 {
@@ -13,86 +12,110 @@ BonePtr Skeleton::getBone(QString name)
     return BonePtr();// null
 }
 
+void Skeleton::updateHierarchy()
+{
+    parentIndices.resize(bones.size());
+    for (int i = 0; i < bones.size(); i++) {
+        auto parent = bones[i]->parentBone;
+        parentIndices[i] = !!parent ? boneMap.value(parent->name, -1) : -1;
+    }
+
+    // parents are added before their children
+    evaluationOrder.clear();
+    evaluationOrder.reserve(bones.size());
+    QVector<int> stack;
+    for (int i = 0; i < bones.size(); i++) {
+        if (parentIndices[i] == -1)
+            stack.append(i);
+    }
+    while (!stack.isEmpty()) {
+        int index = stack.takeLast();
+        evaluationOrder.append(index);
+        for (auto child : bones[index]->childBones)
+            stack.append(boneMap.value(child->name));
+    }
+}
+
+SkeletonPtr Skeleton::clone()
+{
+    auto skel = Skeleton::create();
+    for (auto& bone : bones) {
+        auto copy = Bone::create(bone->name);
+        copy->inversePoseMatrix = bone->inversePoseMatrix;
+        copy->poseMatrix = bone->poseMatrix;
+        copy->transformMatrix = bone->transformMatrix;
+        copy->localMatrix = bone->localMatrix;
+        copy->skinMatrix = bone->skinMatrix;
+        skel->addBone(copy);
+    }
+
+    // bones are added to their parents in the same order as the original
+    for (int i = 0; i < bones.size(); i++) {
+        for (auto& child : bones[i]->childBones)
+            skel->bones[i]->addChild(skel->bones[boneMap.value(child->name)]);
+    }
+
+    skel->boneTransforms = boneTransforms;
+    skel->updateHierarchy();
+
+    return skel;
+}
+
 void Skeleton::applyAnimation(iris::SkeletalAnimationPtr anim, float time)
 {
-    for (auto i = 0; i < bones.size(); i++) {
-        bones[i]->transformMatrix.setToIdentity();
-        bones[i]->localMatrix.setToIdentity();
-        bones[i]->skinMatrix.setToIdentity();
+    if (evaluationOrder.size() != bones.size())
+        updateHierarchy();
+
+    if (boundAnimation != anim.data()) {
+        boundAnimation = anim.data();
+        boneChannels.resize(bones.size());
+        for (int i = 0; i < bones.size(); i++)
+            boneChannels[i] = anim->boneAnimations.value(bones[i]->name).data();
     }
 
-    //qDebug() << "== Animation Begin ==";
-    for (auto boneName : anim->boneAnimations.keys()) {
-        auto boneAnim = anim->boneAnimations[boneName];
-        auto bone = bones[boneMap[boneName]];
-        //qDebug()<< boneName;
-        if ( boneMap.contains(boneName))
-        {
-            //qDebug()<< boneName <<" verified";
-            auto pos = boneAnim->posKeys->getValueAt(time);
-            auto rot = boneAnim->rotKeys->getValueAt(time);
-            auto scale = boneAnim->scaleKeys->getValueAt(time);
-
-
-            bone->localMatrix.setToIdentity();
-            bone->localMatrix.translate(pos);
-            bone->localMatrix.rotate(rot);
-            bone->localMatrix.scale(scale);
+    for (auto i : evaluationOrder) {
+        auto& bone = bones[i];
+        auto boneAnim = boneChannels[i];
+
+        bone->localMatrix.setToIdentity();
+        if (boneAnim) {
+            bone->localMatrix.translate(boneAnim->posKeys->getValueAt(time));
+            bone->localMatrix.rotate(boneAnim->rotKeys->getValueAt(time));
+            bone->localMatrix.scale(boneAnim->scaleKeys->getValueAt(time));
         }
+
+        int parent = parentIndices[i];
+        if (parent < 0)
+            bone->transformMatrix = bone->localMatrix;
         else
-        {
-            bone->localMatrix.setToIdentity();
-            //bone->localMatrix = bone->poseMatrix;
-            //qDebug()<< boneName <<" unverified";
-        }
-    }
-    //qDebug() << "== Animation End ==";
-
-    //recursively calculate final transform
-    std::function<void(BonePtr)> calcFinalTransform;
-    calcFinalTransform = [&calcFinalTransform](BonePtr bone)
-    {
-        for (auto child : bone->childBones) {
-            child->transformMatrix = bone->transformMatrix * child->localMatrix;
-            child->skinMatrix = child->transformMatrix * child->inversePoseMatrix;
-            //qDebug() << child->transformMatrix;
-            calcFinalTransform(child);
-        }
-    };
-
-    //auto rootBone = bones[0];//its assumed that the first bone is the root bone
-    //auto rootBone = this->getRootBone();
-    auto roots = this->getRootBones();
-    for (auto rootBone : roots) {
-        rootBone->transformMatrix = rootBone->localMatrix;
-        //rootBone->transformMatrix.setToIdentity();
-        rootBone->skinMatrix = rootBone->transformMatrix * rootBone->inversePoseMatrix;
-        calcFinalTransform(rootBone);
-    }
+            bone->transformMatrix = bones[parent]->transformMatrix * bone->localMatrix;
 
-    //assign transforms to list
-    for (auto i = 0; i < bones.size(); i++) {
-        boneTransforms[i] = bones[i]->skinMatrix;
+        bone->skinMatrix = bone->transformMatrix * bone->inversePoseMatrix;
+        nextBoneTransforms[i] = bone->skinMatrix;
     }
+
+    hasNextPose = true;
 }
 
 // https://github.com/acgessler/open3mod/blob/master/open3mod/SceneAnimator.cs#L338
-void Skeleton::applyAnimation(QMatrix4x4 inverseMeshMatrix, QMap<QString, QMatrix4x4> skeletonSpaceMatrices)
+void Skeleton::applyAnimation(const QMatrix4x4& inverseMeshMatrix,
+                              const QVector<QMatrix4x4>& skeletonSpaceMatrices,
+                              const QVector<int>& boneNodes)
 {
     for (auto i = 0; i < bones.size(); i++) {
-        auto bone = bones[i];
-        if (skeletonSpaceMatrices.contains(bone->name)) {
-            //bones->transformMatrix.setToIdentity();
-            //bones->localMatrix.setToIdentity();
-
+        auto& bone = bones[i];
+        int node = boneNodes[i];
+        if (node != -1) {
             // https://github.com/acgessler/open3mod/blob/master/open3mod/SceneAnimator.cs#L356
-            bone->skinMatrix = inverseMeshMatrix * skeletonSpaceMatrices[bone->name] * bone->inversePoseMatrix;
+            bone->skinMatrix = inverseMeshMatrix * skeletonSpaceMatrices[node] * bone->inversePoseMatrix;
         }
         else {
             bone->skinMatrix.setToIdentity();
         }
-        boneTransforms[i] = bone->skinMatrix;
+        nextBoneTransforms[i] = bone->skinMatrix;
     }
+
+    hasNextPose = true;
 }
 
 }
@@ -4,10 +4,13 @@
 #include "../irisglfwd.h"
 #include <Qt>
 #include <QMatrix4x4>
+#include <QVector>
 
 namespace iris
 {
 
+class BoneAnimation;
+
 class Bone : public QEnableSharedFromThis<Bone>
 {
     Bone(){}
@@ -44,13 +47,32 @@ public:
 
 class Skeleton
 {
-    Skeleton(){}
+    Skeleton()
+    {
+        boundAnimation = nullptr;
+        hasNextPose = false;
+    }
+
+    bool hasNextPose;
+
+    // channel of each bone in boundAnimation, resolved the first time it's applied
+    SkeletalAnimation* boundAnimation;
+    QVector<BoneAnimation*> boneChannels;
+
 public:
     QMap<QString, int> boneMap;
     QList<BonePtr> bones;
 
+    // flattened hierarchy, see updateHierarchy()
+    QVector<int> parentIndices;// -1 for root bones
+    QVector<int> evaluationOrder;// bone indices with parents before their children
+
     BonePtr getBone(QString name);
+
+    // poses are double buffered so a pose is never read while it's being evaluated
+    // boneTransforms is read when rendering, applyAnimation() writes to nextBoneTransforms
     QVector<QMatrix4x4> boneTransforms;
+    QVector<QMatrix4x4> nextBoneTransforms;
 
     void addBone(BonePtr bone)
     {
@@ -60,6 +82,19 @@ public:
         QMatrix4x4 transform;
         transform.setToIdentity();
         boneTransforms.append(transform);
+        nextBoneTransforms.append(transform);
+    }
+
+    /**
+     * Makes the pose written by the last applyAnimation() the one that's rendered
+     * Does nothing if no new pose was written
+     */
+    void swapBoneTransforms()
+    {
+        if (hasNextPose) {
+            boneTransforms.swap(nextBoneTransforms);
+            hasNextPose = false;
+        }
     }
 
     BonePtr getRootBone()
@@ -79,9 +114,26 @@ public:
         return roots;
     }
 
+    /**
+     * Flattens the bone hierarchy into parentIndices and evaluationOrder
+     * Must be called after the bones' parents are set
+     */
+    void updateHierarchy();
+
+    /**
+     * Returns a copy of the skeleton and its bones
+     */
+    SkeletonPtr clone();
+
     void applyAnimation(SkeletalAnimationPtr anim, float time);
 
-    void applyAnimation(QMatrix4x4 inverseMeshMatrix, QMap<QString, QMatrix4x4> skeletonSpaceMatrices);
+    /**
+     * Calculates the bone transforms from the skeleton-space matrices of the nodes
+     * bound to each bone. boneNodes holds the index of each bone's matrix, or -1
+     */
+    void applyAnimation(const QMatrix4x4& inverseMeshMatrix,
+                        const QVector<QMatrix4x4>& skeletonSpaceMatrices,
+                        const QVector<int>& boneNodes);
 
     static SkeletonPtr create()
     {
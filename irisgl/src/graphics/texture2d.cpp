@@ -13,6 +13,8 @@ For more information see the LICENSE file
 #include <QDebug>
 #include <QOpenGLFunctions_3_2_Core>
 #include "../core/logger.h"
+#include "../core/texturemanager.h"
+#include "../content/texturefile.h"
 
 namespace iris
 {
@@ -49,11 +51,92 @@ Texture2DPtr Texture2D::create(QImage image)
     return QSharedPointer<Texture2D>(new Texture2D(texture));
 }
 
+// compressed formats are uploaded directly since QOpenGLTexture cant
+// allocate storage for them with every version of Qt
+static QOpenGLTexture* createCompressedTexture(const TextureFileData& data)
+{
+    auto gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
+    bool cubeMap = data.faceCount == 6;
+
+    auto texture = new QOpenGLTexture(cubeMap ? QOpenGLTexture::TargetCubeMap : QOpenGLTexture::Target2D);
+    texture->setFormat((QOpenGLTexture::TextureFormat)data.internalFormat);
+    texture->setSize(data.width, data.height);
+    texture->setMipLevels(data.levelCount);
+    texture->create();
+
+    GLenum target = cubeMap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    texture->bind();
+    gl->glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, data.levelCount - 1);
+
+    for (int level = 0; level < data.levelCount; level++) {
+        for (int face = 0; face < data.faceCount; face++) {
+            auto& bytes = data.getLevel(level, face);
+            gl->glCompressedTexImage2D(cubeMap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D,
+                                       level,
+                                       data.internalFormat,
+                                       qMax(1, data.width >> level),
+                                       qMax(1, data.height >> level),
+                                       0,
+                                       bytes.size(),
+                                       bytes.constData());
+        }
+    }
+
+    texture->release();
+
+    texture->setMinMagFilters(QOpenGLTexture::LinearMipMapLinear, QOpenGLTexture::Linear);
+    if (cubeMap)
+        texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+    return texture;
+}
+
+// combines the converted faces, fails if they dont all have the same format and size
+static bool loadCubeMapFaces(const QString* paths, TextureFileData& cubeData)
+{
+    auto textureManager = TextureManager::getSingleton();
+    if (!textureManager->isCompressionSupported())
+        return false;
+
+    for (int face = 0; face < 6; face++) {
+        TextureFileData faceData;
+        if (paths[face].isEmpty() || !textureManager->loadTextureFile(paths[face], false, faceData))
+            return false;
+
+        if (face == 0) {
+            cubeData = faceData;
+            cubeData.faceCount = 6;
+            cubeData.levels.fill(QByteArray(), faceData.levelCount * 6);
+        } else if (faceData.internalFormat != cubeData.internalFormat ||
+                   faceData.width != cubeData.width ||
+                   faceData.height != cubeData.height ||
+                   faceData.levelCount != cubeData.levelCount) {
+            return false;
+        }
+
+        for (int level = 0; level < faceData.levelCount; level++)
+            cubeData.levels[level * 6 + face] = faceData.getLevel(level);
+    }
+
+    return true;
+}
+
+Texture2DPtr Texture2D::create(const TextureFileData& data)
+{
+    return Texture2DPtr(new Texture2D(createCompressedTexture(data)));
+}
+
 Texture2DPtr Texture2D::createCubeMap(QString negZ, QString posZ,
                                       QString posY, QString negY,
                                       QString negX, QString posX,
                                       QImage *info)
 {
+    // faces in gl's order
+    QString faces[6] = {posX, negX, posY, negY, posZ, negZ};
+    TextureFileData cubeData;
+    if (loadCubeMapFaces(faces, cubeData))
+        return create(cubeData);
+
     int width, height, depth;
 
     const QImage pos_x = QImage(posX).convertToFormat(QImage::Format_RGBA8888);
@@ -186,6 +269,61 @@ void Texture2D::resize(int width, int height)
     texture->allocateStorage();
 }
 
+void Texture2D::setImage(QImage image)
+{
+    auto newTexture = new QOpenGLTexture(image);
+    newTexture->setMinMagFilters(QOpenGLTexture::LinearMipMapLinear, QOpenGLTexture::Linear);
+    newTexture->setWrapMode(QOpenGLTexture::DirectionS, texture->wrapMode(QOpenGLTexture::DirectionS));
+    newTexture->setWrapMode(QOpenGLTexture::DirectionT, texture->wrapMode(QOpenGLTexture::DirectionT));
+
+    texture->destroy();
+    delete texture;
+    texture = newTexture;
+}
+
+void Texture2D::setData(const TextureFileData& data)
+{
+    auto newTexture = createCompressedTexture(data);
+    newTexture->setWrapMode(QOpenGLTexture::DirectionS, texture->wrapMode(QOpenGLTexture::DirectionS));
+    newTexture->setWrapMode(QOpenGLTexture::DirectionT, texture->wrapMode(QOpenGLTexture::DirectionT));
+
+    texture->destroy();
+    delete texture;
+    texture = newTexture;
+}
+
+qint64 Texture2D::getMemoryUsage()
+{
+    qint64 pixels = (qint64)texture->width() * texture->height();
+    if (texture->target() == QOpenGLTexture::TargetCubeMap)
+        pixels *= 6;
+
+    qint64 size;
+    switch (texture->format()) {
+    case QOpenGLTexture::RGB_DXT1:
+    case QOpenGLTexture::RGBA_DXT1:
+        size = pixels / 2;
+        break;
+    case QOpenGLTexture::RGBA_DXT3:
+    case QOpenGLTexture::RGBA_DXT5:
+        size = pixels;
+        break;
+    default:
+        size = pixels * 4;
+    }
+
+    // a full mip chain adds a third
+    if (texture->mipLevels() > 1)
+        size += size / 3;
+
+    return size;
+}
+
+Texture2D::~Texture2D()
+{
+    delete texture;
+}
+
 Texture2D::Texture2D(QOpenGLTexture *tex)
 {
     this->texture = tex;
@@ -23,6 +23,8 @@ class QOpenGLFunctions_3_2_Core;
 namespace iris
 {
 
+struct TextureFileData;
+
 class Texture2D: public Texture
 {
 
@@ -60,6 +62,14 @@ public:
      */
     static Texture2DPtr create(QImage image);
 
+    /**
+     * Creates texture from block compressed mip levels
+     * It's a cube map if data has six faces
+     * @param data
+     * @return
+     */
+    static Texture2DPtr create(const TextureFileData& data);
+
     static Texture2DPtr create(int width, int height,QOpenGLTexture::TextureFormat texFormat = QOpenGLTexture::RGBAFormat);
     static Texture2DPtr createDepth(int width, int height);
     static Texture2DPtr createShadowDepth(int width, int height);
@@ -78,6 +88,21 @@ public:
     static Texture2DPtr createCubeMap(QString, QString, QString, QString, QString, QString, QImage *i = nullptr);
     void resize(int width, int height);
 
+    /**
+     * Replaces the texture with one created from image, keeping the wrap modes
+     * Must be called with a current context
+     * @param image
+     */
+    void setImage(QImage image);
+
+    // same as setImage() for compressed textures
+    void setData(const TextureFileData& data);
+
+    // estimated size of the texture and its mip levels on the gpu in bytes
+    qint64 getMemoryUsage();
+
+    ~Texture2D();
+
     QPixmap readData();
 
     int getWidth();
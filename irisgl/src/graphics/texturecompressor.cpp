@@ -0,0 +1,215 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "texturecompressor.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace iris
+{
+
+// copies a 4x4 block of rgba pixels, blocks going past the edge of
+// the image repeat the edge pixels
+static void readBlock(const QImage& image, int blockX, int blockY, quint8* block)
+{
+    for (int y = 0; y < 4; y++) {
+        int py = qMin(blockY * 4 + y, image.height() - 1);
+        auto line = image.constScanLine(py);
+
+        for (int x = 0; x < 4; x++) {
+            int px = qMin(blockX * 4 + x, image.width() - 1);
+            memcpy(block + (y * 4 + x) * 4, line + px * 4, 4);
+        }
+    }
+}
+
+static quint16 packRgb565(const int* rgb)
+{
+    return (((rgb[0] * 31 + 127) / 255) << 11) |
+           (((rgb[1] * 63 + 127) / 255) << 5) |
+           ((rgb[2] * 31 + 127) / 255);
+}
+
+static void unpackRgb565(quint16 color, int* rgb)
+{
+    int r = (color >> 11) & 31;
+    int g = (color >> 5) & 63;
+    int b = color & 31;
+
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void writeColorBlock(const quint8* block, quint8* out)
+{
+    int minColor[3] = {255, 255, 255};
+    int maxColor[3] = {0, 0, 0};
+
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            minColor[c] = qMin(minColor[c], (int)block[i * 4 + c]);
+            maxColor[c] = qMax(maxColor[c], (int)block[i * 4 + c]);
+        }
+    }
+
+    // inset the box a little so the endpoints are closer to the colors they stand for
+    for (int c = 0; c < 3; c++) {
+        int inset = (maxColor[c] - minColor[c]) >> 4;
+        minColor[c] += inset;
+        maxColor[c] -= inset;
+    }
+
+    quint16 color0 = packRgb565(maxColor);
+    quint16 color1 = packRgb565(minColor);
+
+    // color0 > color1 selects the four color mode
+    if (color0 < color1)
+        std::swap(color0, color1);
+
+    quint32 indices = 0;
+    if (color0 != color1) {
+        int palette[4][3];
+        unpackRgb565(color0, palette[0]);
+        unpackRgb565(color1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            int bestDist = INT_MAX;
+            for (int p = 0; p < 4; p++) {
+                int dist = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = block[i * 4 + c] - palette[p][c];
+                    dist += d * d;
+                }
+
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = p;
+                }
+            }
+
+            indices |= (quint32)best << (i * 2);
+        }
+    }
+
+    out[0] = color0 & 0xff;
+    out[1] = color0 >> 8;
+    out[2] = color1 & 0xff;
+    out[3] = color1 >> 8;
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (indices >> (i * 8)) & 0xff;
+}
+
+static void writeAlphaBlock(const quint8* block, quint8* out)
+{
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    for (int i = 0; i < 16; i++) {
+        minAlpha = qMin(minAlpha, (int)block[i * 4 + 3]);
+        maxAlpha = qMax(maxAlpha, (int)block[i * 4 + 3]);
+    }
+
+    quint64 indices = 0;
+    if (minAlpha != maxAlpha) {
+        // alpha0 > alpha1 selects the eight value mode
+        int palette[8];
+        palette[0] = maxAlpha;
+        palette[1] = minAlpha;
+        for (int p = 2; p < 8; p++)
+            palette[p] = ((8 - p) * maxAlpha + (p - 1) * minAlpha) / 7;
+
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            int bestDist = INT_MAX;
+            for (int p = 0; p < 8; p++) {
+                int dist = qAbs(block[i * 4 + 3] - palette[p]);
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = p;
+                }
+            }
+
+            indices |= (quint64)best << (i * 3);
+        }
+    }
+
+    out[0] = maxAlpha;
+    out[1] = minAlpha;
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (indices >> (i * 8)) & 0xff;
+}
+
+static QByteArray compress(const QImage& source, bool alpha)
+{
+    if (source.isNull())
+        return QByteArray();
+
+    auto image = source.convertToFormat(QImage::Format_RGBA8888);
+    int blocksX = (image.width() + 3) / 4;
+    int blocksY = (image.height() + 3) / 4;
+
+    QByteArray data(blocksX * blocksY * (alpha ? 16 : 8), 0);
+    auto out = (quint8*)data.data();
+
+    quint8 block[64];
+    for (int y = 0; y < blocksY; y++) {
+        for (int x = 0; x < blocksX; x++) {
+            readBlock(image, x, y, block);
+
+            // bc3 blocks are an alpha block followed by a bc1 color block
+            if (alpha) {
+                writeAlphaBlock(block, out);
+                out += 8;
+            }
+
+            writeColorBlock(block, out);
+            out += 8;
+        }
+    }
+
+    return data;
+}
+
+QByteArray TextureCompressor::compressBC1(const QImage& image)
+{
+    return compress(image, false);
+}
+
+QByteArray TextureCompressor::compressBC3(const QImage& image)
+{
+    return compress(image, true);
+}
+
+bool TextureCompressor::hasTransparency(const QImage& image)
+{
+    if (!image.hasAlphaChannel())
+        return false;
+
+    auto rgba = image.convertToFormat(QImage::Format_RGBA8888);
+    for (int y = 0; y < rgba.height(); y++) {
+        auto line = rgba.constScanLine(y);
+        for (int x = 0; x < rgba.width(); x++) {
+            if (line[x * 4 + 3] != 255)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+}
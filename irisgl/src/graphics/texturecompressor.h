@@ -0,0 +1,41 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef TEXTURECOMPRESSOR_H
+#define TEXTURECOMPRESSOR_H
+
+#include <QByteArray>
+#include <QImage>
+
+namespace iris
+{
+
+/**
+ * Block compresses images to the S3TC formats
+ * Endpoints come from the bounding box of each block's colors, which is fast
+ * enough to run when textures are imported, but not as good as an offline compressor
+ */
+class TextureCompressor
+{
+public:
+    // BC1 (DXT1), 8 bytes per 4x4 block, alpha is ignored
+    static QByteArray compressBC1(const QImage& image);
+
+    // BC3 (DXT5), 16 bytes per 4x4 block
+    static QByteArray compressBC3(const QImage& image);
+
+    // true if any pixel isnt fully opaque
+    static bool hasTransparency(const QImage& image);
+};
+
+}
+
+#endif // TEXTURECOMPRESSOR_H
@@ -20,6 +20,7 @@ VertexLayout::VertexLayout()
 {
     //gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
     stride = 0;
+    divisor = 0;
 }
 
 QList<VertexAttribute> VertexLayout::getAttribs()
@@ -27,9 +28,9 @@ QList<VertexAttribute> VertexLayout::getAttribs()
 	return attribs;
 }
 
-void VertexLayout::addAttrib(VertexAttribUsage usage,int type,int count,int sizeOfAttribInBytes)
+void VertexLayout::addAttrib(VertexAttribUsage usage,int type,int count,int sizeOfAttribInBytes,bool normalized)
 {
-    VertexAttribute attrib = {usage, type, count, sizeOfAttribInBytes};
+    VertexAttribute attrib = {usage, type, count, sizeOfAttribInBytes, normalized};
     attribs.append(attrib);
 
     stride += sizeOfAttribInBytes;
@@ -40,6 +41,43 @@ int VertexLayout::getStride()
     return stride;
 }
 
+void VertexLayout::setDivisor(int divisor)
+{
+    this->divisor = divisor;
+}
+
+int VertexLayout::getDivisor()
+{
+    return divisor;
+}
+
+VertexLayout VertexLayout::createInstanceMatrix()
+{
+    VertexLayout layout;
+
+    // a mat4 attribute is passed as 4 vec4 columns
+    for (int i = 0; i < 4; i++)
+        layout.addAttrib((VertexAttribUsage)((int)VertexAttribUsage::InstanceMatrix + i),
+                         GL_FLOAT, 4, sizeof(GLfloat) * 4);
+    layout.setDivisor(1);
+
+    return layout;
+}
+
+VertexLayout VertexLayout::createParticleInstance()
+{
+    VertexLayout layout;
+
+    // position and rotation
+    layout.addAttrib(VertexAttribUsage::InstanceMatrix, GL_FLOAT, 4, sizeof(GLfloat) * 4);
+    // scale and normalized age
+    layout.addAttrib((VertexAttribUsage)((int)VertexAttribUsage::InstanceMatrix + 1),
+                     GL_FLOAT, 4, sizeof(GLfloat) * 4);
+    layout.setDivisor(1);
+
+    return layout;
+}
+
 // https://stackoverflow.com/a/30106751
 #define BUFFER_OFFSET(i) ((char*)nullptr+(i))
 
@@ -49,7 +87,8 @@ void VertexLayout::bind(QOpenGLFunctions_3_2_Core* gl)
     for(auto attrib: attribs)
     {
         //gl->glVertexAttribPointer((GLuint)attrib.usage, attrib.count, (GLenum)attrib.type, GL_FALSE, stride, (void*)offset);
-        gl->glVertexAttribPointer((GLuint)attrib.usage, attrib.count, (GLenum)attrib.type, GL_FALSE, stride, BUFFER_OFFSET(offset));
+        gl->glVertexAttribPointer((GLuint)attrib.usage, attrib.count, (GLenum)attrib.type,
+                                  attrib.normalized ? GL_TRUE : GL_FALSE, stride, BUFFER_OFFSET(offset));
         gl->glEnableVertexAttribArray((int)attrib.usage);
         offset += attrib.sizeInBytes;
     }
@@ -28,29 +28,47 @@ struct VertexAttribute
 
     int type;//GL_FLOAT,GL_INT, etc
     int count;//2 for vec2, 3 for vec3, etc
-    int sizeInBytes;
+    int sizeInBytes;// can be bigger than the data to pad the next attribute
+
+    // integer types are mapped to 0..1 (or -1..1 when signed) instead of being converted as is
+    bool normalized;
 };
 
 class VertexLayout
 {
     QList<VertexAttribute> attribs;
     int stride;
+    int divisor;
     QOpenGLFunctions_3_2_Core* gl;
 
 public:
     VertexLayout();
 
 	QList<VertexAttribute> getAttribs();
-    void addAttrib(VertexAttribUsage usage, int type, int count, int sizeInBytes);
+    void addAttrib(VertexAttribUsage usage, int type, int count, int sizeInBytes, bool normalized = false);
 
     int getStride();
 
+    /**
+     * Sets how many instances are drawn before the attributes advance
+     * 0 (the default) means the attributes are per-vertex
+     */
+    void setDivisor(int divisor);
+    int getDivisor();
+
     //todo: make this more efficient
     void bind(QOpenGLFunctions_3_2_Core* gl);
     void unbind(QOpenGLFunctions_3_2_Core* gl);
 
     //default vertex layout for meshes
     static VertexLayout* createMeshDefault();
+
+    // per-instance world matrix layout used for instanced rendering
+    static VertexLayout createInstanceMatrix();
+
+    // per-particle layout used by ParticleRenderer, two vec4s that
+    // share the instance matrix's first two locations
+    static VertexLayout createParticleInstance();
 };
 
 }
@@ -66,11 +66,15 @@ class AnimableProperty;
 class Bone;
 class Skeleton;
 class SkeletalAnimation;
+class AnimationRig;
+class BakedAnimation;
 template<typename T> class Key;
 typedef Key<float> FloatKey;
 class BoundingSphere;
 class VertexBuffer;
 class IndexBuffer;
+class UniformBuffer;
+class LightClusters;
 class GraphicsDevice;
 class ContentManager;
 class SpriteBatch;
@@ -101,8 +105,12 @@ typedef QSharedPointer<PostProcessManager> PostProcessManagerPtr;
 typedef QSharedPointer<Bone> BonePtr;
 typedef QSharedPointer<Skeleton> SkeletonPtr;
 typedef QSharedPointer<SkeletalAnimation> SkeletalAnimationPtr;
+typedef QSharedPointer<AnimationRig> AnimationRigPtr;
+typedef QSharedPointer<BakedAnimation> BakedAnimationPtr;
 typedef QSharedPointer<VertexBuffer> VertexBufferPtr;
 typedef QSharedPointer<IndexBuffer> IndexBufferPtr;
+typedef QSharedPointer<UniformBuffer> UniformBufferPtr;
+typedef QSharedPointer<LightClusters> LightClustersPtr;
 typedef QSharedPointer<GraphicsDevice> GraphicsDevicePtr;
 typedef QSharedPointer<ContentManager> ContentManagerPtr;
 typedef QSharedPointer<SpriteBatch> SpriteBatchPtr;
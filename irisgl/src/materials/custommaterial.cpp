@@ -14,27 +14,42 @@ For more information see the LICENSE file
 #include <QJsonDocument>
 
 #include <QOpenGLShaderProgram>
+#include <QOpenGLFunctions_3_2_Core>
 
 #include "custommaterial.h"
 #include "../graphics/texture2d.h"
 #include "../graphics/shader.h"
 #include "../graphics/graphicsdevice.h"
 #include "../core/irisutils.h"
+#include "../content/assetloader.h"
+#include "../core/texturemanager.h"
 
 namespace iris
 {
 
-void CustomMaterial::setTextureWithUniform(const QString &uniform, const QString &texturePath)
+CustomMaterial::CustomMaterial()
 {
-    auto texture = iris::Texture2D::load(texturePath);
+    valuesRevision = 0;
+    valuesDirty = true;
+
+    uniformBufferRevision = -1;
+    uniformBufferLayout = 0;
+}
+
+void CustomMaterial::setTextureWithUniform(const QString &uniform, const QString &texturePath, bool loadAsync)
+{
+    auto texture = loadAsync ? AssetLoader::getSingleton()->loadTexture(texturePath)
+                             : TextureManager::getSingleton()->getTexture(texturePath);
     if (!!texture) {
         addTexture(uniform, texture);
     } else {
         removeTexture(uniform);
     }
+
+    valuesDirty = true;
 }
 
-void CustomMaterial::setValue(const QString &name, const QVariant &value)
+void CustomMaterial::setValue(const QString &name, const QVariant &value, bool loadAsync)
 {
 	if (onValueChange(name, value)) {
 		for (auto prop : this->properties) {
@@ -45,7 +60,7 @@ void CustomMaterial::setValue(const QString &name, const QVariant &value)
 					_prop->toggle = !value.toString().isEmpty();
 					if (!value.toString().isEmpty()) {
 						prop->setValue(value.toString());
-						setTextureWithUniform(prop->uniform, value.toString());
+						setTextureWithUniform(prop->uniform, value.toString(), loadAsync);
 					}
 				}
 
@@ -54,33 +69,116 @@ void CustomMaterial::setValue(const QString &name, const QVariant &value)
 				}
 			}
 		}
+
+		valuesDirty = true;
 	}
 }
 
-void CustomMaterial::setUniformValues(GraphicsDevicePtr device, Property *prop)
+void CustomMaterial::compileValues()
 {
-	auto program = getProgram();
-    if (prop->type == PropertyType::Bool) {
-		device->setShaderUniform(prop->uniform.toStdString().c_str(), prop->getValue().toBool());
-    }
+    values.clear();
+    for (auto prop : properties) {
+        MaterialValue value;
+        value.type = prop->type;
+        value.uniform = prop->uniform.toLatin1();
+        memset(value.data, 0, sizeof(value.data));
+
+        if (prop->type == PropertyType::Bool) {
+            value.data[0] = prop->getValue().toBool() ? 1.0f : 0.0f;
+        } else if (prop->type == PropertyType::Float) {
+            value.data[0] = prop->getValue().toFloat();
+        } else if (prop->type == PropertyType::Color) {
+            auto color = prop->getValue().value<QColor>();
+            value.data[0] = color.redF();
+            value.data[1] = color.greenF();
+            value.data[2] = color.blueF();
+            value.data[3] = color.alphaF();
+        } else if (prop->type == PropertyType::Texture) {
+            // the texture itself goes in textureBindings, this is its toggle
+            auto tprop = static_cast<TextureProperty*>(prop);
+            value.type = PropertyType::Bool;
+            value.uniform = tprop->toggleValue.toLatin1();
+            value.data[0] = tprop->toggle ? 1.0f : 0.0f;
+        } else {
+            continue;
+        }
 
-    if (prop->type == PropertyType::Float) {
-		device->setShaderUniform(prop->uniform.toStdString().c_str(), prop->getValue().toFloat());
+        if (!value.uniform.isEmpty())
+            values.append(value);
     }
 
-    // TODO, figure out a way for the default material to mix values... the ambient for one
-    if (prop->type == PropertyType::Color) {
-		device->setShaderUniform(prop->uniform.toStdString().c_str(),
-                                 QVector3D(prop->getValue().value<QColor>().redF(),
-                                           prop->getValue().value<QColor>().greenF(),
-                                           prop->getValue().value<QColor>().blueF()));
+    textureBindings.clear();
+    for (auto it = textures.begin(); it != textures.end(); it++) {
+        TextureBinding binding;
+        binding.uniform = it.key().toLatin1();
+        binding.texture = it.value();
+        textureBindings.append(binding);
     }
 
-    if (prop->type == iris::PropertyType::Texture) {
-        auto tprop = static_cast<TextureProperty*>(prop);
-		device->setShaderUniform(tprop->toggleValue.toStdString().c_str(), tprop->toggle);
-		//device->setShaderUniform(tprop->toggleValue.toStdString().c_str(), true);
+    valuesRevision++;
+    valuesDirty = false;
+}
+
+void CustomMaterial::updateUniformBuffer(ShaderPtr shader)
+{
+    if (!!uniformBuffer &&
+        uniformBufferRevision == valuesRevision &&
+        uniformBufferLayout == shader->materialBlockLayout)
+        return;
+
+    const auto& members = shader->materialBlockMembers;
+    QByteArray data(shader->materialBlockSize, 0);
+
+    for (const auto& value : values) {
+        auto member = members.constFind(value.uniform);
+
+        // a block declared as "uniform MaterialData {...} u_material;" has its
+        // members named MaterialData.diffuse and so on, not u_material.diffuse
+        if (member == members.constEnd()) {
+            auto dot = value.uniform.indexOf('.');
+            if (dot != -1)
+                member = members.constFind("MaterialData" + value.uniform.mid(dot));
+        }
+
+        if (member == members.constEnd())
+            continue;
+
+        // bools and ints are 4 bytes in std140
+        int floatCount = 0;
+        bool isInt = false;
+        switch (member->type) {
+        case GL_BOOL:
+        case GL_INT:
+        case GL_UNSIGNED_INT:
+            isInt = true;
+            floatCount = 1;
+            break;
+        case GL_FLOAT:      floatCount = 1; break;
+        case GL_FLOAT_VEC2: floatCount = 2; break;
+        case GL_FLOAT_VEC3: floatCount = 3; break;
+        case GL_FLOAT_VEC4: floatCount = 4; break;
+        default:
+            continue;
+        }
+
+        if (member->offset + floatCount * (int)sizeof(float) > data.size())
+            continue;
+
+        auto dest = data.data() + member->offset;
+        if (isInt) {
+            GLint intValue = value.data[0] != 0.0f ? 1 : 0;
+            memcpy(dest, &intValue, sizeof(GLint));
+        } else {
+            memcpy(dest, value.data, floatCount * sizeof(float));
+        }
     }
+
+    if (!uniformBuffer)
+        uniformBuffer = UniformBuffer::create();
+    uniformBuffer->setData(data.data(), data.size());
+
+    uniformBufferRevision = valuesRevision;
+    uniformBufferLayout = shader->materialBlockLayout;
 }
 
 QString CustomMaterial::firstTextureSlot() const
@@ -105,11 +203,54 @@ QJsonObject CustomMaterial::loadShaderFromDisk(const QString &filePath)
 
 void CustomMaterial::begin(GraphicsDevicePtr device, ScenePtr scene)
 {
-    Material::begin(device, scene);
+    auto shader = getActiveShader();
+    device->setShader(shader);
+    if (!shader)
+        return;
+
+    if (valuesDirty)
+        compileValues();
+
+    // bound textures arent part of the program so they're set for every draw
+    int count = 0;
+    for (; count < textureBindings.size(); count++)
+        device->setTexture(count, textureBindings[count].texture);
+
+    // bind the rest of the textures to 0
+    for (; count < numTextures; count++)
+        device->clearTexture(count);
+
+    if (shader->usesMaterialUniformBlock()) {
+        updateUniformBuffer(shader);
+        device->setUniformBuffer(UniformBlockBinding::MaterialData, uniformBuffer);
+    }
+
+    // uniforms outside the block keep their values in the program
+    if (shader->materialValuesId == materialId && shader->materialValuesRevision == valuesRevision)
+        return;
+
+    for (const auto& value : values) {
+        // members of the block dont have a location
+        auto location = shader->getUniformLocation(value.uniform.constData());
+        if (location == -1)
+            continue;
+
+        if (value.type == PropertyType::Bool) {
+            device->setShaderUniform(location, value.data[0] != 0.0f ? 1 : 0);
+        } else if (value.type == PropertyType::Float) {
+            device->setShaderUniform(location, value.data[0]);
+        } else if (value.type == PropertyType::Color) {
+            device->setShaderUniform(location, QVector3D(value.data[0], value.data[1], value.data[2]));
+        }
+    }
 
-    for (auto prop : this->properties) {
-        setUniformValues(device, prop);
+    for (int i = 0; i < textureBindings.size(); i++) {
+        auto location = shader->getUniformLocation(textureBindings[i].uniform.constData());
+        device->setShaderUniform(location, i);
     }
+
+    shader->materialValuesId = materialId;
+    shader->materialValuesRevision = valuesRevision;
 }
 
 void CustomMaterial::end(GraphicsDevicePtr device, ScenePtr scene)
@@ -220,11 +361,14 @@ void CustomMaterial::createWidgets(const QJsonArray &widgetProps)
             if (properties.size() < widgetProps.size()) this->properties.append(clrProp);
         }
     }
+
+    valuesDirty = true;
 }
 
 void CustomMaterial::purge()
 {
     this->properties.clear();
+    valuesDirty = true;
 }
 
 void CustomMaterial::setName(const QString &name)
@@ -329,6 +473,7 @@ CustomMaterialPtr CustomMaterial::create()
 void CustomMaterial::setProperties(QList<Property*> props)
 {
     this->properties = props;
+    valuesDirty = true;
 }
 
 QList<Property *> CustomMaterial::getProperties()
@@ -15,12 +15,23 @@ For more information see the LICENSE file
 #include "../graphics/material.h"
 #include "../irisglfwd.h"
 #include "../core/property.h"
+#include <QVector>
 
 class QOpenGLFunctions_3_2_Core;
 
 namespace iris
 {
 
+/**
+ * Material built from a shader definition's list of properties
+ *
+ * The properties are compiled into values ready for upload and a table of
+ * the textures to bind, these are only rebuilt when a value is set. Shaders
+ * declaring a MaterialData uniform block get the values packed into a
+ * uniform buffer that's bound with a single call. Values outside the block
+ * are set as plain uniforms, which is skipped when the shader's program
+ * already has this material's values.
+ */
 class CustomMaterial : public Material
 {
 public:
@@ -31,14 +42,14 @@ public:
 
     void generate(const QString&, bool project = false);
     void generate(const QJsonObject&);
-    void setTextureWithUniform(const QString&, const QString&);
-    void setValue(const QString&, const QVariant&);
+    // with loadAsync set textures are loaded in the background and blank until they're ready
+    void setTextureWithUniform(const QString&, const QString&, bool loadAsync = false);
+    void setValue(const QString&, const QVariant&, bool loadAsync = false);
     void setBaseMaterialProperties(const QJsonObject&);
     void setName(const QString&);
     void setGuid(const QString&);
     void setProperties(QList<Property*> props);
     QList<Property*> getProperties();
-    void setUniformValues(GraphicsDevicePtr device, Property*);
     void purge();
 
     QString getName() const;
@@ -58,13 +69,44 @@ public:
 
 	CustomMaterialPtr createFromShader(iris::ShaderPtr shader);
 
-    CustomMaterial() = default;
+    CustomMaterial();
     QString materialName;
     QString materialGuid;
 	QString materialPath;
 
     QJsonObject loadShaderFromDisk(const QString &);
     void createWidgets(const QJsonArray&);
+
+private:
+    // a property's value converted to what's uploaded for it
+    struct MaterialValue
+    {
+        QByteArray uniform;
+        PropertyType type;
+
+        // colors are rgba, bools are 0 or 1
+        float data[4];
+    };
+
+    struct TextureBinding
+    {
+        QByteArray uniform;
+        Texture2DPtr texture;
+    };
+
+    QVector<MaterialValue> values;
+    QVector<TextureBinding> textureBindings;
+
+    // bumped every time the values or texture bindings are rebuilt
+    int valuesRevision;
+    bool valuesDirty;
+
+    UniformBufferPtr uniformBuffer;
+    int uniformBufferRevision;
+    uint uniformBufferLayout;
+
+    void compileValues();
+    void updateUniformBuffer(ShaderPtr shader);
 };
 
 
@@ -89,6 +89,7 @@ void DefaultMaterial::begin(GraphicsDevicePtr device,ScenePtr scene)
     program->setUniformValue("u_useSpecularTex",useSpecularTex);
     program->setUniformValue("u_useReflectionTex",useReflectionTex);
 
+    invalidateShaderValues();
 }
 
 void DefaultMaterial::end(GraphicsDevicePtr device, ScenePtr scene)
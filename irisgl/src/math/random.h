@@ -0,0 +1,65 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <QtGlobal>
+
+namespace iris
+{
+
+/**
+ * Small xorshift random number generator
+ * Each instance has its own state so it's cheaper than rand() and
+ * doesnt interfere with other users
+ */
+class Random
+{
+    quint32 state;
+
+public:
+    Random(quint32 seed = 2463534242u)
+    {
+        setSeed(seed);
+    }
+
+    void setSeed(quint32 seed)
+    {
+        // a state of 0 would only ever produce 0
+        state = seed != 0 ? seed : 2463534242u;
+    }
+
+    // https://en.wikipedia.org/wiki/Xorshift
+    quint32 nextInt()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // returns a value in the range [0, 1)
+    float next()
+    {
+        // the top 24 bits fit exactly in a float's mantissa
+        return (nextInt() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float range(float min, float max)
+    {
+        return min + (max - min) * next();
+    }
+};
+
+}
+
+#endif // RANDOM_H
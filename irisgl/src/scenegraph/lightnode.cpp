@@ -4,6 +4,7 @@
 #include "../animation/keyframeset.h"
 #include "../animation/animation.h"
 #include "../animation/propertyanim.h"
+#include "../animation/bakedanimation.h"
 #include "../core/property.h"
 #include "../graphics/shadowmap.h"
 
@@ -63,22 +64,38 @@ QVariant LightNode::getPropertyValue(QString valueName)
     return SceneNode::getPropertyValue(valueName);
 }
 
-void LightNode::updateAnimation(float time)
+void LightNode::applyPropertyAnimation(float time)
 {
-    if (!!animation) {
-        if(animation->hasPropertyAnim("intensity"))
-            intensity = animation->getFloatPropertyAnim("intensity")->getValue(time);
-        if(animation->hasPropertyAnim("lightColor"))
-            color = animation->getColorPropertyAnim("lightColor")->getValue(time);
-        if(animation->hasPropertyAnim("distance"))
-            distance = animation->getFloatPropertyAnim("distance")->getValue(time);
-        if(animation->hasPropertyAnim("spotCutOff"))
-            spotCutOff = animation->getFloatPropertyAnim("spotCutOff")->getValue(time);
-        if(animation->hasPropertyAnim("spotCutOffSoftness"))
-            spotCutOffSoftness = animation->getFloatPropertyAnim("spotCutOffSoftness")->getValue(time);
+    if (animation->isBaked()) {
+        auto baked = animation->getBakedAnimation();
+        QVector4D value;
+        if (baked->getPropertyValue("intensity", time, value))
+            intensity = value.x();
+        if (baked->getPropertyValue("lightColor", time, value))
+            color = QColor(value.x() * 255, value.y() * 255, value.z() * 255, value.w() * 255);
+        if (baked->getPropertyValue("distance", time, value))
+            distance = value.x();
+        if (baked->getPropertyValue("spotCutOff", time, value))
+            spotCutOff = value.x();
+        if (baked->getPropertyValue("spotCutOffSoftness", time, value))
+            spotCutOffSoftness = value.x();
+
+        SceneNode::applyPropertyAnimation(time);
+        return;
     }
 
-    SceneNode::updateAnimation(time);
+    if(animation->hasPropertyAnim("intensity"))
+        intensity = animation->getFloatPropertyAnim("intensity")->getValue(time);
+    if(animation->hasPropertyAnim("lightColor"))
+        color = animation->getColorPropertyAnim("lightColor")->getValue(time);
+    if(animation->hasPropertyAnim("distance"))
+        distance = animation->getFloatPropertyAnim("distance")->getValue(time);
+    if(animation->hasPropertyAnim("spotCutOff"))
+        spotCutOff = animation->getFloatPropertyAnim("spotCutOff")->getValue(time);
+    if(animation->hasPropertyAnim("spotCutOffSoftness"))
+        spotCutOffSoftness = animation->getFloatPropertyAnim("spotCutOffSoftness")->getValue(time);
+
+    SceneNode::applyPropertyAnimation(time);
 }
 
 LightNode::LightNode()
@@ -114,6 +131,8 @@ SceneNodePtr LightNode::createDuplicate()
 	light->shadowMap->bias = this->shadowMap->bias;
 	light->shadowMap->shadowType = this->shadowMap->shadowType;
 	light->shadowMap->setResolution(this->shadowMap->resolution);
+	light->shadowMap->setCascadeCount(this->shadowMap->cascadeCount);
+	light->shadowMap->cascadeDistance = this->shadowMap->cascadeDistance;
 	light->icon = this->icon;
 	light->iconSize = this->iconSize;
 
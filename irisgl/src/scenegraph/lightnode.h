@@ -91,8 +91,10 @@ public:
     virtual QList<Property*> getProperties() override;
     virtual QVariant getPropertyValue(QString valueName) override;
 
-    void updateAnimation(float time) override;
+protected:
+    void applyPropertyAnimation(float time) override;
 
+public:
 	ShadowMap* getShadowMap()
 	{
 		return shadowMap;
@@ -118,6 +120,17 @@ public:
 		return shadowMap->resolution;
 	}
 
+	// only used by directional lights, 1 disables cascades
+	void setShadowCascadeCount(int count)
+	{
+		shadowMap->setCascadeCount(count);
+	}
+
+	int getShadowCascadeCount()
+	{
+		return shadowMap->cascadeCount;
+	}
+
 	SceneNodePtr createDuplicate() override;
 
 private:
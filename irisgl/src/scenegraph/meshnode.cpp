@@ -38,6 +38,7 @@ For more information see the LICENSE file
 #include "../scenegraph/scene.h"
 #include "../scenegraph/scenenode.h"
 #include "../core/irisutils.h"
+#include "../core/meshmanager.h"
 #include "../animation/animableproperty.h"
 
 #include "../graphics/skeleton.h"
@@ -76,11 +77,12 @@ QList<Property*> MeshNode::getProperties()
 
 void MeshNode::setMesh(QString source)
 {
-    mesh = Mesh::loadMesh(source);
+    mesh = MeshManager::getSingleton()->getMesh(source);
     meshPath = source;
     meshIndex = 0;
 
     renderItem->mesh = mesh;
+    invalidateHierarchy();
 }
 
 //should not be used on plain scene meshes
@@ -88,6 +90,7 @@ void MeshNode::setMesh(MeshPtr mesh)
 {
     this->mesh = mesh;
     renderItem->mesh = mesh;
+    invalidateHierarchy();
 }
 
 MeshPtr MeshNode::getMesh()
@@ -105,7 +108,11 @@ void MeshNode::setMaterial(MaterialPtr material)
 void MeshNode::submitRenderItems()
 {
     if (visible) {
-        renderItem->cullable = false;
+        // skinned meshes move outside their bind pose bounds when animated
+        // and meshes that weren't built from assimp don't have bounds yet
+        renderItem->cullable = !!mesh &&
+                               mesh->boundingSphere.radius > 0 &&
+                               !mesh->hasSkeleton();
 
         renderItem->worldMatrix = this->globalTransform;
  
@@ -11,6 +11,7 @@ For more information see the LICENSE file
 
 #include <QFileInfo>
 #include <QDir>
+#include <QHash>
 
 #include <cmath>
 #ifndef M_PI
@@ -21,12 +22,12 @@ For more information see the LICENSE file
 #include "meshnode.h"
 #include "particlesystemnode.h"
 #include "../graphics/mesh.h"
+#include "../core/meshmanager.h"
 
 #include "../graphics/vertexlayout.h"
 #include "../materials/defaultmaterial.h"
 #include "../materials/materialhelper.h"
 #include "../graphics/renderitem.h"
-#include "../graphics/particle.h"
 #include "../graphics/particlerender.h"
 #include "../graphics/renderlist.h"
 
@@ -62,13 +63,17 @@ ParticleSystemNode::ParticleSystemNode() {
 
     speedError = lifeError = scaleError = 0;
 
+    maxParticles = 2048;
+    pool.setCapacity(maxParticles);
+    random.setSeed(qHash((quintptr)this));
+
     renderer = new ParticleRenderer();
 
     renderItem = new RenderItem();
     renderItem->type = RenderItemType::ParticleSystem;
 
     boundsRenderItem = new RenderItem();
-    boundsRenderItem->mesh = Mesh::loadMesh(":assets/models/cube.obj");
+    boundsRenderItem->mesh = MeshManager::getSingleton()->getMesh(":assets/models/cube.obj");
 
     auto mat = DefaultMaterial::create();
     mat->setDiffuseColor(QColor(255, 255, 255));
@@ -99,6 +104,10 @@ void ParticleSystemNode::submitRenderItems()
     renderItem->worldMatrix = this->globalTransform;
     renderItem->renderLayer = (int)RenderLayer::Transparent;
 
+    // particles are in world space
+    renderItem->boundingSphere = pool.calculateBoundingSphere();
+    renderItem->cullable = renderItem->boundingSphere.radius > 0;
+
     this->scene->geometryRenderList->add(renderItem);
     this->scene->geometryRenderList->add(boundsRenderItem);
 }
@@ -112,12 +121,15 @@ void ParticleSystemNode::generateParticles(float delta) {
         emitParticle();
     }
 
-    if (static_cast <float> (rand()) / static_cast <float> (RAND_MAX) < partialParticle) {
+    if (random.next() < partialParticle) {
         emitParticle();
     }
 }
 
 void ParticleSystemNode::emitParticle() {
+    if (pool.isFull())
+        return;
+
     QVector4D dir = QVector4D(QVector3D(0, 1, 0), 0);
     QVector4D particleDirection = this->globalTransform * dir;
 
@@ -130,33 +142,31 @@ void ParticleSystemNode::emitParticle() {
     float scl = generateValue(particleScale, scaleError);
     float ll = generateValue(lifeLength, lifeError);
 
-    // reuse particles! this is bad.
-    // change later after atlases
     boundDimension = QVector3D(1, 1, 1) * this->scale;
-    addParticle(new Particle(this->getGlobalPosition() + boundDimension * generateRandomUnitVector(),
-                             velocity,
-                             gravityComplement,
-                             ll,
-                             generateRotation(),
-                             scl));
+    pool.add(this->getGlobalPosition() + boundDimension * generateRandomUnitVector(),
+             velocity,
+             gravityComplement,
+             ll,
+             generateRotation(),
+             scl);
 }
 
 float ParticleSystemNode::generateValue(float average, float errorMargin) {
-    float offset = (static_cast<float>(rand()) / static_cast<float>(RAND_MAX) - 0.5f) * 2.f * errorMargin;
+    float offset = (random.next() - 0.5f) * 2.f * errorMargin;
     return average + offset;
 }
 
 float ParticleSystemNode::generateRotation() {
     if (randomRotation) {
-        return static_cast<float>(rand()) / static_cast<float>(RAND_MAX / 360.f);
+        return random.next() * 360.f;
     } else {
         return 0;
     }
 }
 
 QVector3D ParticleSystemNode::generateRandomUnitVector() {
-    float theta = (float) (static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.f * M_PI);
-    float z = (static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.f) - 1.f;
+    float theta = (float) (random.next() * 2.f * M_PI);
+    float z = (random.next() * 2.f) - 1.f;
     float rootOneMinusZSquared = (float) sqrt(1 - z * z);
     float x = (float) (rootOneMinusZSquared * cos(theta));
     float y = (float) (rootOneMinusZSquared * sin(theta));
@@ -166,40 +176,20 @@ QVector3D ParticleSystemNode::generateRandomUnitVector() {
 void ParticleSystemNode::update(float delta) {
     SceneNode::update(delta);
 
+    // maxParticles is public so it can change between updates
+    if (pool.getCapacity() != maxParticles)
+        pool.setCapacity(maxParticles);
+
     generateParticles(delta);
-    //std::list<Particle*>::iterator it = particles.begin();
-
-	for (int i = 0; i < particles.size(); i++) {
-		auto p = particles[i];
-
-        p->velocity += QVector3D(0, p->GRAVITY * p->gravityEffect * delta, 0);
-        //p.velocity.setY(p.velocity.y() + GRAVITY * gravityEffect * delta);
-        QVector3D change = p->velocity;
-        change *= delta;
-        p->position += change;
-        //p.position += p->velocity * delta;
-        p->elapsedTime += delta;
-
-        // in the future we can call behavior management here, add more forces such as wind
-        if (dissipate && p->elapsedTime > 0) {
-            if (dissipateInv) {
-                p->scale = MathHelper::lerp((p->elapsedTime / p->lifeLength), 0, particleScale);
-            } else {
-                p->scale *= 1.0f - (p->elapsedTime / p->lifeLength);
-            }
-        }
-
-        if (p->elapsedTime > p->lifeLength) {
-			particles.erase(particles.begin() + i);
-			i--;
-        }
-    }
+
+    // in the future we can call behavior management here, add more forces such as wind
+    pool.update(delta, dissipate, dissipateInv, particleScale);
 }
 
 void ParticleSystemNode::renderParticles(GraphicsDevicePtr device, RenderData* renderData, QOpenGLShaderProgram* shader)
 {
     renderer->icon = texture;
-    renderer->render(device, shader, renderData, this->particles);
+    renderer->render(device, shader, renderData, pool);
 }
 
 SceneNodePtr ParticleSystemNode::createDuplicate()
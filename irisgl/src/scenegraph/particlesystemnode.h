@@ -16,6 +16,8 @@ For more information see the LICENSE file
 #include "../scenegraph/scenenode.h"
 #include "../core/irisutils.h"
 #include "../graphics/texture2d.h"
+#include "../graphics/particlepool.h"
+#include "../math/random.h"
 
 class QOpenGLShaderProgram;
 
@@ -23,7 +25,6 @@ namespace iris
 {
 
 class RenderItem;
-class Particle;
 class ParticleRenderer;
 
 class ParticleSystemNode : public SceneNode
@@ -51,6 +52,7 @@ public:
     float lifeLength;
     float particleScale;
 
+    // capacity of the particle pool, no particles are emitted once it's full
     int maxParticles;
     float billboardScale;
 
@@ -158,8 +160,8 @@ public:
 
     void renderParticles(GraphicsDevicePtr device, RenderData* renderData, QOpenGLShaderProgram* shader);
 
-    void addParticle(Particle *particle) {
-        particles.push_back(particle);
+    int getParticleCount() {
+        return pool.getCount();
     }
 
     ~ParticleSystemNode();
@@ -171,7 +173,8 @@ public:
 private:
     ParticleSystemNode();
 
-    std::vector<Particle*> particles;
+    ParticlePool pool;
+    Random random;
 
     MaterialPtr material;
     RenderItem* renderItem;
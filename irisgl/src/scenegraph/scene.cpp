@@ -20,7 +20,9 @@ For more information see the LICENSE file
 #include "../graphics/renderitem.h"
 #include "../materials/defaultskymaterial.h"
 #include "../geometry/trimesh.h"
+#include "../geometry/spherebvh.h"
 #include "../core/irisutils.h"
+#include "../core/meshmanager.h"
 #include "../graphics/renderlist.h"
 
 namespace iris
@@ -33,7 +35,7 @@ Scene::Scene()
     // rootNode->setScene(this->sharedFromThis());
 
     // todo: move this to ui code
-    skyMesh = Mesh::loadMesh(":assets/models/sky.obj");
+    skyMesh = MeshManager::getSingleton()->getMesh(":assets/models/sky.obj");
 
 //    QString x1 = IrisUtils::getAbsoluteAssetPath("app/content/textures/left.jpg");
 //    QString x2 = IrisUtils::getAbsoluteAssetPath("app/content/textures/right.jpg");
@@ -69,12 +71,15 @@ Scene::Scene()
     gizmoRenderList = new RenderList();
 
 	time = 0;
+    changed = true;
+    pickBvhDirty = true;
 }
 
 void Scene::setSkyTexture(Texture2DPtr tex)
 {
     skyTexture = tex;
     skyMaterial->setSkyTexture(tex);
+    markChanged();
 }
 
 QString Scene::getSkyTextureSource()
@@ -86,17 +91,20 @@ void Scene::clearSkyTexture()
 {
     skyTexture.clear();
     skyMaterial->clearSkyTexture();
+    markChanged();
 }
 
 void Scene::setSkyColor(QColor color)
 {
     this->skyColor = color;
     skyMaterial->setSkyColor(color);
+    markChanged();
 }
 
 void Scene::setAmbientColor(QColor color)
 {
     this->ambientColor = color;
+    markChanged();
 }
 
 void Scene::updateSceneAnimation(float time)
@@ -104,10 +112,24 @@ void Scene::updateSceneAnimation(float time)
     rootNode->updateAnimation(time);
 }
 
+bool Scene::hasChanges()
+{
+    return changed;
+}
+
+void Scene::markChanged()
+{
+    changed = true;
+    pickBvhDirty = true;
+}
+
 void Scene::update(float dt)
 {
+    changed = false;
+
 	time += dt;
     rootNode->update(dt);
+    updatePickBvh();
 
     // cameras aren't always a part of the scene hierarchy, so their matrices are updated here
     if (!!camera) {
@@ -137,7 +159,74 @@ void Scene::rayCast(const QVector3D& segStart,
                     const QVector3D& segEnd,
                     QList<PickingResult>& hitList)
 {
-    rayCast(rootNode, segStart, segEnd, hitList);
+    // only meshes whose bounds the segment passes through are tested
+    QVector<int> hits;
+    pickBvh.getSegmentIntersections(segStart, segEnd, hits);
+    for (auto index : hits) {
+        if (pickMeshes[index]->isPickable())
+            rayCastMesh(pickMeshes[index], segStart, segEnd, hitList);
+    }
+
+    for (auto& meshNode : unboundedPickMeshes) {
+        if (meshNode->isPickable())
+            rayCastMesh(meshNode, segStart, segEnd, hitList);
+    }
+}
+
+void Scene::updatePickBvh()
+{
+    // meshes loaded in the background only become pickable once their trimesh is there
+    auto isCandidate = [](const MeshNodePtr& meshNode) {
+        return !!meshNode->getMesh() && meshNode->getMesh()->getTriMesh() != nullptr;
+    };
+
+    // the candidates are compared in the order they're collected below
+    int boundedCount = 0;
+    int unboundedCount = 0;
+    bool rebuild = false;
+    for (auto& meshNode : meshes) {
+        if (!isCandidate(meshNode))
+            continue;
+
+        if (meshNode->getMesh()->boundingSphere.radius <= 0) {
+            rebuild |= unboundedCount >= unboundedPickMeshes.size() ||
+                       unboundedPickMeshes[unboundedCount] != meshNode;
+            unboundedCount++;
+        } else {
+            rebuild |= boundedCount >= pickMeshes.size() || pickMeshes[boundedCount] != meshNode;
+            boundedCount++;
+        }
+    }
+    rebuild |= boundedCount != pickMeshes.size() || unboundedCount != unboundedPickMeshes.size();
+
+    if (!rebuild && !pickBvhDirty)
+        return;
+    pickBvhDirty = false;
+
+    if (rebuild) {
+        pickMeshes.clear();
+        unboundedPickMeshes.clear();
+        for (auto& meshNode : meshes) {
+            if (!isCandidate(meshNode))
+                continue;
+
+            if (meshNode->getMesh()->boundingSphere.radius <= 0)
+                unboundedPickMeshes.append(meshNode);
+            else
+                pickMeshes.append(meshNode);
+        }
+    }
+
+    QVector<BoundingSphere> spheres;
+    spheres.reserve(pickMeshes.size());
+    for (auto& meshNode : pickMeshes)
+        spheres.append(meshNode->getTransformedBoundingSphere());
+
+    // moved nodes only need their bounds refitted, the tree is rebuilt when nodes come and go
+    if (rebuild)
+        pickBvh.build(spheres);
+    else
+        pickBvh.refit(spheres);
 }
 
 void Scene::rayCast(const QSharedPointer<iris::SceneNode>& sceneNode,
@@ -150,29 +239,11 @@ void Scene::rayCast(const QSharedPointer<iris::SceneNode>& sceneNode,
     {
         auto meshNode = sceneNode.staticCast<iris::MeshNode>();
         auto mesh = meshNode->getMesh();
-        if(mesh != nullptr)
+        if (mesh != nullptr && mesh->getTriMesh() != nullptr)
         {
-            auto triMesh = meshNode->getMesh()->getTriMesh();
-
-            // transform segment to local space
-            auto invTransform = meshNode->globalTransform.inverted();
-            auto a = invTransform * segStart;
-            auto b = invTransform * segEnd;
-
-            QList<iris::TriangleIntersectionResult> results;
-            if (int resultCount = triMesh->getSegmentIntersections(a, b, results)) {
-                for (auto triResult : results) {
-                    // convert hit to world space
-                    auto hitPoint = meshNode->globalTransform * triResult.hitPoint;
-
-                    PickingResult pick;
-                    pick.hitNode = sceneNode;
-                    pick.hitPoint = hitPoint;
-                    pick.distanceFromStartSqrd = (hitPoint - segStart).lengthSquared();
-
-                    hitList.append(pick);
-                }
-            }
+            if (mesh->boundingSphere.radius <= 0 ||
+                meshNode->getTransformedBoundingSphere().intersectsSegment(segStart, segEnd))
+                rayCastMesh(meshNode, segStart, segEnd, hitList);
         }
     }
 
@@ -181,8 +252,38 @@ void Scene::rayCast(const QSharedPointer<iris::SceneNode>& sceneNode,
     }
 }
 
+void Scene::rayCastMesh(const MeshNodePtr& meshNode,
+                        const QVector3D& segStart,
+                        const QVector3D& segEnd,
+                        QList<PickingResult>& hitList)
+{
+    auto triMesh = meshNode->getMesh()->getTriMesh();
+
+    // transform segment to local space
+    auto invTransform = meshNode->globalTransform.inverted();
+    auto a = invTransform * segStart;
+    auto b = invTransform * segEnd;
+
+    QList<iris::TriangleIntersectionResult> results;
+    if (triMesh->getSegmentIntersections(a, b, results)) {
+        for (auto triResult : results) {
+            // convert hit to world space
+            auto hitPoint = meshNode->globalTransform * triResult.hitPoint;
+
+            PickingResult pick;
+            pick.hitNode = meshNode;
+            pick.hitPoint = hitPoint;
+            pick.distanceFromStartSqrd = (hitPoint - segStart).lengthSquared();
+
+            hitList.append(pick);
+        }
+    }
+}
+
 void Scene::addNode(SceneNodePtr node)
 {
+    markChanged();
+
     if (!!node->scene)
     {
         //qDebug() << "Node already has scene";
@@ -216,6 +317,8 @@ void Scene::addNode(SceneNodePtr node)
 
 void Scene::removeNode(SceneNodePtr node)
 {
+    markChanged();
+
     if (node->sceneNodeType == SceneNodeType::Light) {
         lights.removeOne(node.staticCast<iris::LightNode>());
     }
@@ -262,11 +365,13 @@ ScenePtr Scene::create()
 void Scene::setOutlineWidth(int width)
 {
     outlineWidth = width;
+    markChanged();
 }
 
 void Scene::setOutlineColor(QColor color)
 {
     outlineColor = color;
+    markChanged();
 }
 
 void Scene::cleanup()
@@ -282,6 +387,9 @@ void Scene::cleanup()
 
     lights.clear();
     meshes.clear();
+    pickMeshes.clear();
+    unboundedPickMeshes.clear();
+    pickBvh.build(QVector<BoundingSphere>());
     particleSystems.clear();
     viewers.clear();
 
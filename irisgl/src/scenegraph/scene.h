@@ -17,6 +17,7 @@ For more information see the LICENSE file
 #include "../graphics/texture2d.h"
 #include "../materials/defaultskymaterial.h"
 #include "../geometry/frustum.h"
+#include "../geometry/spherebvh.h"
 
 namespace iris
 {
@@ -89,6 +90,20 @@ public:
 	// time counter to pass to shaders that do time-based animation
 	float time;
 
+private:
+    // set when something that changes how the scene looks is changed, cleared by update()
+    bool changed;
+
+    // bvh over the bounds of pickable meshes, kept up to date by update()
+    SphereBvh pickBvh;
+    QVector<MeshNodePtr> pickMeshes;
+    // meshes without bounds are always tested
+    QVector<MeshNodePtr> unboundedPickMeshes;
+    bool pickBvhDirty;
+
+    void updatePickBvh();
+public:
+
     Scene();
 public:
     static ScenePtr create();
@@ -117,10 +132,22 @@ public:
     void setSkyColor(QColor color);
     void setAmbientColor(QColor color);
 
+    /**
+     * Returns true if nodes were added, removed or moved or the scene's settings
+     * were changed since the last update(), so views know when to redraw
+     * Changes made directly to fields or materials should call markChanged()
+     */
+    bool hasChanges();
+    void markChanged();
+
     void updateSceneAnimation(float time);
     void update(float dt);
     void render();
 
+    /**
+     * Tests the segment against every pickable mesh
+     * Uses the bounds from the last update(), like the meshes' transforms
+     */
     void rayCast(const QVector3D& segStart,
                  const QVector3D& segEnd,
                  QList<PickingResult>& hitList);
@@ -130,6 +157,15 @@ public:
                  const QVector3D& segEnd,
                  QList<iris::PickingResult>& hitList);
 
+    /**
+     * Tests the segment against the mesh's triangles
+     * Hits are appended to hitList
+     */
+    void rayCastMesh(const MeshNodePtr& meshNode,
+                     const QVector3D& segStart,
+                     const QVector3D& segEnd,
+                     QList<PickingResult>& hitList);
+
     /**
      * Adds node to scene. If node is a LightNode then it is added to a list of lights.
      * @param node
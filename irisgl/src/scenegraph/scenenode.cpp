@@ -20,10 +20,13 @@ For more information see the LICENSE file
 #include "../animation/animableproperty.h"
 #include "../animation/keyframeanimation.h"
 #include "../animation/skeletalanimation.h"
+#include "../animation/animationrig.h"
+#include "../animation/bakedanimation.h"
 #include "../core/property.h"
 #include "../math/mathhelper.h"
 
-#include <functional>
+#include <QtConcurrent>
+
 
 namespace iris
 {
@@ -72,6 +75,7 @@ QString SceneNode::getName()
 void SceneNode::setName(QString name)
 {
     this->name = name;
+    invalidateHierarchy();
 }
 
 long SceneNode::getNodeId()
@@ -115,6 +119,9 @@ void SceneNode::setLocalTransform(QMatrix4x4 transformMatrix)
 void SceneNode::setTransformDirty()
 {
     transformDirty = true;
+    if (!!scene)
+        scene->markChanged();
+
     if (!!parent)
     {
         parent->setHasDirtyChildren();
@@ -232,6 +239,7 @@ void SceneNode::insertChild(int position, SceneNodePtr node, bool keepTransform)
 
     children.insert(position, node);
     node->setParent(self);
+    invalidateHierarchy();
     if (!!scene) {
         node->setScene(self->scene);
         //scene->addNode(node);
@@ -271,6 +279,7 @@ void SceneNode::removeChild(SceneNodePtr node)
     children.removeOne(node);
     node->parent = QSharedPointer<SceneNode>(Q_NULLPTR);
     node->removeFromScene();
+    invalidateHierarchy();
 }
 
 bool SceneNode::isRootNode()
@@ -280,96 +289,95 @@ bool SceneNode::isRootNode()
 }
 
 void SceneNode::updateAnimation(float time)
+{
+    QVector<QVector<SkeletalAnimationJob>> jobs;
+    gatherAnimations(time, 0, jobs);
+
+    // skeletons in a level dont share nodes so they can be evaluated in parallel,
+    // nested skeletons are evaluated after the ones containing them
+    for (auto& level : jobs) {
+        if (level.size() > 1)
+            QtConcurrent::blockingMap(level, SceneNode::evaluateSkeletalAnimation);
+        else
+            evaluateSkeletalAnimation(level[0]);
+    }
+
+    // only publish the poses once they're all complete
+    for (auto& level : jobs) {
+        for (auto& job : level)
+            job.rig->swapBuffers();
+    }
+
+    // animations write transforms directly, so the scene's pick bvh
+    // and cached picks are refreshed after every animated update
+    if (!!scene)
+        scene->markChanged();
+}
+
+void SceneNode::applyPropertyAnimation(float time)
+{
+    time = animation->getSampleTime(time);
+
+    if (animation->isBaked()) {
+        auto baked = animation->getBakedAnimation();
+        int frame;
+        float t;
+        baked->getFrame(time, frame, t);
+
+        if (!baked->position.isEmpty())
+            pos = baked->position.sample(frame, t).toVector3D();
+        if (!baked->rotation.isEmpty())
+            rot = baked->rotation.sample(frame, t);
+        if (!baked->scale.isEmpty())
+            scale = baked->scale.sample(frame, t).toVector3D();
+        return;
+    }
+
+    if (animation->hasPropertyAnim("position")) {
+        pos = animation->getVector3PropertyAnim("position")->getValue(time);
+    }
+    if (animation->hasPropertyAnim("rotation")) {
+        auto r = animation->getVector3PropertyAnim("rotation")->getValue(time);
+        rot = QQuaternion::fromEulerAngles(r);
+    }
+    if (animation->hasPropertyAnim("scale")) {
+        scale = animation->getVector3PropertyAnim("scale")->getValue(time);
+    }
+}
+
+void SceneNode::gatherAnimations(float time, int depth, QVector<QVector<SkeletalAnimationJob>>& jobs)
 {
     if (!!animation) {
+        applyPropertyAnimation(time);
 
         time = animation->getSampleTime(time);
-        if (animation->hasPropertyAnim("position")) {
-            pos = animation->getVector3PropertyAnim("position")->getValue(time);
-        }
-        if (animation->hasPropertyAnim("rotation")) {
-            auto r = animation->getVector3PropertyAnim("rotation")->getValue(time);
-            rot = QQuaternion::fromEulerAngles(r);
-        }
-        if (animation->hasPropertyAnim("scale")) {
-            scale = animation->getVector3PropertyAnim("scale")->getValue(time);
-        }
-
         if (animation->hasSkeletalAnimation()) {
-            QMap<QString, QMatrix4x4> skeletonSpaceMatrices;
-            // The skeleton begins at this node, the root
-
-            // recursively update the animation for each node
-            std::function<void(SkeletalAnimationPtr anim, SceneNodePtr node, QMatrix4x4 parentTransform)> animateHierarchy;
-            animateHierarchy = [&animateHierarchy, time, &skeletonSpaceMatrices](SkeletalAnimationPtr anim, SceneNodePtr node, QMatrix4x4 parentTransform)
-            {
-                // skeleton-space transform of current node
-                QMatrix4x4 skelTrans;
-                skelTrans.setToIdentity();
-
-                if (anim->boneAnimations.contains(node->name)) {
-                    auto boneAnim = anim->boneAnimations[node->name];
-
-                    node->pos = boneAnim->posKeys->getValueAt(time);
-                    node->rot = boneAnim->rotKeys->getValueAt(time).normalized();
-                    //node->scale = QVector3D(1,1,1);
-                    node->scale = boneAnim->scaleKeys->getValueAt(time);
-                }
-
-                auto localTrans = node->getLocalTransform(); //calculates the local transform matrix
-                skelTrans = parentTransform * localTrans; //skeleton space transform
-                skeletonSpaceMatrices.insert(node->name, skelTrans);
-
-                for(auto child : node->children) {
-                    animateHierarchy(anim, child, skelTrans);
-                }
-            };
-
-            QMatrix4x4 rootTransform;
-            //rootTransform.setToIdentity();
-            rootTransform = this->getLocalTransform();
-            animateHierarchy(animation->getSkeletalAnimation(), this->sharedFromThis(), rootTransform);
-
-            applyAnimationPose(this->sharedFromThis(), skeletonSpaceMatrices);
+            // building the rig isnt thread safe so it's done here
+            updateAnimationRig();
+
+            if (jobs.size() <= depth)
+                jobs.resize(depth + 1);
+            jobs[depth].append({animationRig.data(), time});
+            depth++;
         }
     }
 
     for (auto child : children) {
-        child->updateAnimation(time);
+        child->gatherAnimations(time, depth, jobs);
     }
 }
 
+void SceneNode::evaluateSkeletalAnimation(SkeletalAnimationJob& job)
+{
+    job.rig->evaluate(job.time);
+}
+
 void SceneNode::applyDefaultPose()
 {
-    if (!!animation) {
-    if (animation->hasSkeletalAnimation()) {
-        QMap<QString, QMatrix4x4> skeletonSpaceMatrices;
-        // The skeleton begins at this node, the root
-
-        // recursively update the animation for each node
-        std::function<void(SkeletalAnimationPtr anim, SceneNodePtr node, QMatrix4x4 parentTransform)> animateHierarchy;
-        animateHierarchy = [&animateHierarchy, &skeletonSpaceMatrices](SkeletalAnimationPtr anim, SceneNodePtr node, QMatrix4x4 parentTransform)
-        {
-            // skeleton-space transform of current node
-            QMatrix4x4 skelTrans;
-            skelTrans.setToIdentity();
-
-            auto localTrans = node->getLocalTransform(); //calculates the local transform matrix
-            skelTrans = parentTransform * localTrans; //skeleton space transform
-            skeletonSpaceMatrices.insert(node->name, skelTrans);
-
-            for(auto child : node->children) {
-                animateHierarchy(anim, child, skelTrans);
-            }
-        };
-
-        QMatrix4x4 rootTransform;
-        rootTransform.setToIdentity();
-        rootTransform = this->getLocalTransform();
-        animateHierarchy(animation->getSkeletalAnimation(), this->sharedFromThis(), rootTransform);
-
-        applyAnimationPose(this->sharedFromThis(), skeletonSpaceMatrices);
-    }
+    if (!!animation && animation->hasSkeletalAnimation()) {
+        updateAnimationRig();
+        animationRig->applyCurrentPose();
+        animationRig->swapBuffers();
     }
 
     for (auto child : children) {
@@ -377,22 +385,25 @@ void SceneNode::applyDefaultPose()
     }
 }
 
-void SceneNode::applyAnimationPose(SceneNodePtr node, QMap<QString, QMatrix4x4> skeletonSpaceMatrices)
+void SceneNode::updateAnimationRig()
 {
-    if (skeletonSpaceMatrices.contains(node->name)) {
-        if (node->sceneNodeType == SceneNodeType::Mesh) {
-            auto meshNode = node.staticCast<MeshNode>();
-            auto mesh = meshNode->getMesh();
-            if (mesh != nullptr && mesh->hasSkeleton()) {
-                auto inverseMeshMatrix = skeletonSpaceMatrices[node->name].inverted();
-                mesh->getSkeleton()->applyAnimation(inverseMeshMatrix, skeletonSpaceMatrices);
-            }
-        }
-    }
+    auto skelAnim = animation->getSkeletalAnimation();
+    auto baked = animation->getBakedAnimation();
+    if (!animationRig)
+        animationRig = AnimationRigPtr(new AnimationRig());
 
-    for (auto child : node->children) {
-        applyAnimationPose(child, skeletonSpaceMatrices);
-    }
+    if (!animationRig->isValid(skelAnim, baked))
+        animationRig->build(this, skelAnim, baked);
+}
+
+quint32 SceneNode::getHierarchyVersion()
+{
+    return hierarchyVersion.loadAcquire();
+}
+
+void SceneNode::invalidateHierarchy()
+{
+    hierarchyVersion.fetchAndAddOrdered(1);
 }
 
 void SceneNode::update(float dt)
@@ -525,5 +536,6 @@ SceneNodePtr SceneNode::duplicate()
 }
 
 long SceneNode::nextId = 0;
+QAtomicInteger<quint32> SceneNode::hierarchyVersion(0);
 
 }
@@ -16,6 +16,7 @@ For more information see the LICENSE file
 #include <QQuaternion>
 #include <QMatrix4x4>
 #include <QVector3D>
+#include <QAtomicInteger>
 
 namespace iris
 {
@@ -74,6 +75,10 @@ public:
 
     friend class Renderer;
     friend class Scene;
+    friend class AnimationRig;
+
+    // flattened hierarchy used to evaluate skeletal animations, built on demand
+    AnimationRigPtr animationRig;
 
     // If a node is attached to parents then it inherits animations
     // It also cant have its own animation
@@ -231,9 +236,20 @@ public:
      * - Particle systems use this to update animations
      */
     virtual void update(float dt);
-    virtual void updateAnimation(float time);
+
+    /*
+     * Applies the animations of this node and its descendants at time
+     * Independent skeletal animations are evaluated in parallel
+     */
+    void updateAnimation(float time);
     void applyDefaultPose();
-    void applyAnimationPose(SceneNodePtr node, QMap<QString, QMatrix4x4> skeletonSpaceMatrices);
+
+    /*
+     * Incremented whenever a node is added, removed or renamed anywhere
+     * Used to know when cached flattened hierarchies need rebuilding
+     */
+    static quint32 getHierarchyVersion();
+    static void invalidateHierarchy();
 
     /*
      * This is the function used to add render items
@@ -242,6 +258,13 @@ public:
      */
     virtual void submitRenderItems(){}
 
+protected:
+    /*
+     * Applies this node's property animations
+     * Only called when the node has an animation
+     */
+    virtual void applyPropertyAnimation(float time);
+
 private:
     void setParent(SceneNodePtr node);
     void setScene(ScenePtr scene);
@@ -249,6 +272,20 @@ private:
 
     static long generateNodeId();
     static long nextId;
+    // read by rigs evaluated on worker threads
+    static QAtomicInteger<quint32> hierarchyVersion;
+
+    void updateAnimationRig();
+
+    struct SkeletalAnimationJob
+    {
+        AnimationRig* rig;
+        float time;
+    };
+
+    // skeletal animations are grouped by how deeply they're nested in other skeletal animations
+    void gatherAnimations(float time, int depth, QVector<QVector<SkeletalAnimationJob>>& jobs);
+    static void evaluateSkeletalAnimation(SkeletalAnimationJob& job);
 };
 
 }
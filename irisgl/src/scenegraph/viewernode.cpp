@@ -13,6 +13,7 @@ For more information see the LICENSE file
 #include "../scenegraph/scene.h"
 #include "../scenegraph/scenenode.h"
 #include "../graphics/mesh.h"
+#include "../core/meshmanager.h"
 #include "../materials/defaultmaterial.h"
 #include "../graphics/texture2d.h"
 #include "../graphics/renderitem.h"
@@ -37,7 +38,7 @@ ViewerNode::ViewerNode()
     //renderItem->material = this->material;
     //renderItem->mesh = headModel;
 
-    auto cube = Mesh::loadMesh(":/assets/models/cube.obj");
+    auto cube = MeshManager::getSingleton()->getMesh(":/assets/models/cube.obj");
 
     leftHandenderItem = new RenderItem();
     leftHandenderItem->type = RenderItemType::Mesh;
@@ -15,6 +15,8 @@ void AddSceneNodeCommand::undo()
 {
     sceneNode->removeFromParent();
     UiManager::sceneHierarchyWidget->removeChild(sceneNode);
+    UiManager::markSceneNodeDirty(sceneNode);
+    UiManager::markSceneNodeDirty(parentNode);
     UiManager::mainWindow->sceneNodeSelected(iris::SceneNodePtr());
 }
 
@@ -22,5 +24,7 @@ void AddSceneNodeCommand::redo()
 {
     parentNode->addChild(sceneNode, false);
     UiManager::sceneHierarchyWidget->insertChild(sceneNode);
+    UiManager::markSceneNodeDirty(sceneNode);
+    UiManager::markSceneNodeDirty(parentNode);
     UiManager::mainWindow->sceneNodeSelected(sceneNode);
 }
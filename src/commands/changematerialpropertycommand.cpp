@@ -1,6 +1,7 @@
 #include "changematerialpropertycommand.h"
 #include "../irisgl/src/core/property.h"
 #include "../irisgl/src/materials/custommaterial.h"
+#include "../uimanager.h"
 
 
 ChangeMaterialPropertyCommand::ChangeMaterialPropertyCommand(iris::CustomMaterialPtr material, QString name, QVariant oldValue, QVariant newValue)
@@ -35,6 +36,8 @@ void ChangeMaterialPropertyCommand::setMaterialProperty(QString name, QVariant v
     if (prop->type == iris::PropertyType::Texture) {
         material->setTextureWithUniform(prop->uniform, value.toString());
     } else {
-        prop->setValue(value);
+        material->setValue(name, value);
     }
+
+    UiManager::markMaterialDirty(material);
 }
@@ -0,0 +1,23 @@
+#include "changemeshmaterialcommand.h"
+#include "../irisgl/src/scenegraph/meshnode.h"
+#include "../irisgl/src/materials/material.h"
+#include "../uimanager.h"
+
+ChangeMeshMaterialCommand::ChangeMeshMaterialCommand(iris::MeshNodePtr meshNode, iris::MaterialPtr oldMaterial, iris::MaterialPtr newMaterial)
+{
+    this->meshNode = meshNode;
+    this->oldMaterial = oldMaterial;
+    this->newMaterial = newMaterial;
+}
+
+void ChangeMeshMaterialCommand::undo()
+{
+    meshNode->setMaterial(oldMaterial);
+    UiManager::markSceneNodeDirty(meshNode);
+}
+
+void ChangeMeshMaterialCommand::redo()
+{
+    meshNode->setMaterial(newMaterial);
+    UiManager::markSceneNodeDirty(meshNode);
+}
@@ -0,0 +1,21 @@
+#ifndef CHANGEMESHMATERIALCOMMAND_H
+#define CHANGEMESHMATERIALCOMMAND_H
+
+#include <QUndoCommand>
+#include "../irisgl/src/irisglfwd.h"
+
+// replaces a mesh's material, like when a material is dropped on it
+class ChangeMeshMaterialCommand : public QUndoCommand
+{
+    iris::MeshNodePtr meshNode;
+    iris::MaterialPtr oldMaterial;
+    iris::MaterialPtr newMaterial;
+
+public:
+    ChangeMeshMaterialCommand(iris::MeshNodePtr meshNode, iris::MaterialPtr oldMaterial, iris::MaterialPtr newMaterial);
+
+    void undo() override;
+    void redo() override;
+};
+
+#endif // CHANGEMESHMATERIALCOMMAND_H
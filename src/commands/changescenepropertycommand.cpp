@@ -0,0 +1,85 @@
+#include "changescenepropertycommand.h"
+#include <QImage>
+#include "../irisgl/src/graphics/texture2d.h"
+#include "../irisgl/src/scenegraph/scene.h"
+#include "../uimanager.h"
+#include "../widgets/scenenodepropertieswidget.h"
+
+ChangeScenePropertyCommand::ChangeScenePropertyCommand(iris::ScenePtr scene, QString name, QVariant oldValue, QVariant newValue)
+{
+    this->scene = scene;
+    propName = name;
+    this->oldValue = oldValue;
+    this->newValue = newValue;
+}
+
+void ChangeScenePropertyCommand::undo()
+{
+    setSceneProperty(propName, oldValue);
+}
+
+void ChangeScenePropertyCommand::redo()
+{
+    setSceneProperty(propName, newValue);
+}
+
+int ChangeScenePropertyCommand::id() const
+{
+    return 1;
+}
+
+bool ChangeScenePropertyCommand::mergeWith(const QUndoCommand *other)
+{
+    auto command = static_cast<const ChangeScenePropertyCommand*>(other);
+    if (command->scene != scene || command->propName != propName)
+        return false;
+
+    newValue = command->newValue;
+    return true;
+}
+
+void ChangeScenePropertyCommand::setSceneProperty(QString name, QVariant value)
+{
+    if (name == "skyColor") {
+        scene->setSkyColor(value.value<QColor>());
+    } else if (name == "ambientColor") {
+        scene->setAmbientColor(value.value<QColor>());
+    } else if (name == "fogColor") {
+        scene->fogColor = value.value<QColor>();
+    } else if (name == "fogStart") {
+        scene->fogStart = value.toFloat();
+    } else if (name == "fogEnd") {
+        scene->fogEnd = value.toFloat();
+    } else if (name == "fogEnabled") {
+        scene->fogEnabled = value.toBool();
+    } else if (name == "shadowEnabled") {
+        scene->shadowEnabled = value.toBool();
+    } else if (name == "skyBoxTextures") {
+        auto textures = value.toStringList();
+        for (int i = 0; i < 6; i++)
+            scene->skyBoxTextures[i] = textures.value(i);
+
+        QImage *info = nullptr;
+        for (int i = 0; i < 6; i++) {
+            if (!scene->skyBoxTextures[i].isEmpty()) {
+                info = new QImage(scene->skyBoxTextures[i]);
+                break;
+            }
+        }
+
+        if (info) {
+            scene->setSkyTexture(iris::Texture2D::createCubeMap(scene->skyBoxTextures[0],
+                                                                scene->skyBoxTextures[1],
+                                                                scene->skyBoxTextures[2],
+                                                                scene->skyBoxTextures[3],
+                                                                scene->skyBoxTextures[4],
+                                                                scene->skyBoxTextures[5],
+                                                                info));
+        } else {
+            scene->clearSkyTexture();
+        }
+    }
+
+    UiManager::markSceneChanged();
+    UiManager::propertyWidget->refreshSceneSettings(scene);
+}
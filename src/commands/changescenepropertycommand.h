@@ -0,0 +1,30 @@
+#ifndef CHANGESCENEPROPERTYCOMMAND_H
+#define CHANGESCENEPROPERTYCOMMAND_H
+
+#include <QUndoCommand>
+#include <QVariant>
+#include "../irisgl/src/irisglfwd.h"
+
+// changes one of the scene's settings, like its sky or fog
+class ChangeScenePropertyCommand : public QUndoCommand
+{
+    iris::ScenePtr scene;
+    QString propName;
+    QVariant oldValue;
+    QVariant newValue;
+
+public:
+    ChangeScenePropertyCommand(iris::ScenePtr scene, QString name, QVariant oldValue, QVariant newValue);
+
+    void undo() override;
+    void redo() override;
+
+    // sliders and color pickers change a property many times in a row, those are one step
+    int id() const override;
+    bool mergeWith(const QUndoCommand *other) override;
+
+private:
+    void setSceneProperty(QString name, QVariant value);
+};
+
+#endif // CHANGESCENEPROPERTYCOMMAND_H
@@ -15,6 +15,8 @@ void DeleteSceneNodeCommand::undo()
 {
     parentNode->insertChild(position, sceneNode, false);
     UiManager::sceneHierarchyWidget->insertChild(sceneNode);
+    UiManager::markSceneNodeDirty(sceneNode);
+    UiManager::markSceneNodeDirty(parentNode);
     UiManager::mainWindow->sceneNodeSelected(sceneNode);
 }
 
@@ -22,5 +24,7 @@ void DeleteSceneNodeCommand::redo()
 {
     UiManager::sceneHierarchyWidget->removeChild(sceneNode);
     sceneNode->removeFromParent();// important that this is done after!
+    UiManager::markSceneNodeDirty(sceneNode);
+    UiManager::markSceneNodeDirty(parentNode);
     UiManager::mainWindow->sceneNodeSelected(iris::SceneNodePtr());
 }
@@ -40,6 +40,7 @@ void TransformSceneNodeCommand::undo()
 	sceneNode->setLocalPos(oldPos);
 	sceneNode->setLocalRot(oldRot);
 	sceneNode->setLocalScale(oldScale);
+	UiManager::markSceneNodeDirty(sceneNode);
 	UiManager::propertyWidget->refreshTransform();
 }
 
@@ -48,5 +49,6 @@ void TransformSceneNodeCommand::redo()
 	sceneNode->setLocalPos(newPos);
 	sceneNode->setLocalRot(newRot);
 	sceneNode->setLocalScale(newScale);
+	UiManager::markSceneNodeDirty(sceneNode);
 	UiManager::propertyWidget->refreshTransform();
 }
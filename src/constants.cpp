@@ -17,6 +17,7 @@ namespace Contants
     QString JAH_FOLDER        = "/Jahshaka";
     QString ASSET_FOLDER      = "/AssetStore";
     QString JAH_DATABASE      = "JahLibrary.db";
+    QString AUTOSAVE_DATABASE = "Autosave.db";
     QString DEF_EXPORT_FILE   = "export.zip";
     QSize   TILE_SIZE         = QSize(460, 215);
     int     UI_FONT_SIZE      = 10;
@@ -35,11 +36,17 @@ namespace Contants
 	QString SHADER_EXT		    = "shader";
 	QString MATERIAL_EXT		= "material";
 	QString ASSET_EXT			= "jaf";
+	QString MESH_CACHE_FOLDER	= "Cache";
+	QString MESH_CACHE_EXT		= "mesh";
+	QString TEXTURE_CACHE_FOLDER	= "Cache/Textures";
+	QString SHADER_CACHE_FOLDER	= "/ShaderCache";
 
 	QString UPDATE_CHECK_URL	= "http://api.dev.jahfx.com/applications/5d7c5a71-f8ec-4c73-a2dc-de7b99ed824f/update/";
 
     int FPS_90                  = 11; // milliseconds
     int FPS_60                  = 17; // milliseconds
+    float ASSET_UPLOAD_BUDGET   = 4;  // milliseconds per frame
+    int AUTOSAVE_INTERVAL       = 5000; // milliseconds
 
     namespace Reserved
     {
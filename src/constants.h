@@ -29,6 +29,7 @@ namespace Constants
     extern QString JAH_FOLDER;
     extern QString ASSET_FOLDER;
     extern QString JAH_DATABASE;
+    extern QString AUTOSAVE_DATABASE;
     extern QString DEF_EXPORT_FILE;
     extern QSize   TILE_SIZE;
     extern int     UI_FONT_SIZE;
@@ -47,11 +48,17 @@ namespace Constants
 	extern QString SHADER_EXT;
 	extern QString MATERIAL_EXT;
 	extern QString ASSET_EXT;
+	extern QString MESH_CACHE_FOLDER;
+	extern QString MESH_CACHE_EXT;
+	extern QString TEXTURE_CACHE_FOLDER;
+	extern QString SHADER_CACHE_FOLDER;
 
 	extern QString UPDATE_CHECK_URL;
 
     extern int FPS_90;
     extern int FPS_60;
+    extern float ASSET_UPLOAD_BUDGET;
+    extern int AUTOSAVE_INTERVAL;
 
     namespace Reserved
     {
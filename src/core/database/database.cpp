@@ -5,6 +5,7 @@
 #include "../../globals.h"
 #include "../guidmanager.h"
 #include "io/assetmanager.h"
+#include "io/scenefile.h"
 
 #include <QDebug>
 #include <QJsonDocument>
@@ -772,6 +773,15 @@ bool Database::updateAssetProperties(const QString &guid, const QByteArray &asse
     return executeAndCheckQuery(query, "UpdateAssetProperties");
 }
 
+bool Database::updateSceneBlob(const QString &guid, const QByteArray &sceneBlob)
+{
+    QSqlQuery query;
+    query.prepare("UPDATE projects SET scene = ? WHERE guid = ?");
+    query.addBindValue(sceneBlob);
+    query.addBindValue(guid);
+    return executeAndCheckQuery(query, "UpdateSceneBlob");
+}
+
 AssetRecord Database::fetchAsset(const QString &guid)
 {
     QSqlQuery query;
@@ -1445,6 +1455,20 @@ QVector<ProjectTileData> Database::fetchProjects()
     return tileData;
 }
 
+QMap<QString, QByteArray> Database::fetchSceneBlobs()
+{
+    QSqlQuery query;
+    query.prepare("SELECT guid, scene FROM projects");
+    executeAndCheckQuery(query, "FetchSceneBlobs");
+
+    QMap<QString, QByteArray> blobs;
+    while (query.next()) {
+        blobs.insert(query.value(0).toString(), query.value(1).toByteArray());
+    }
+
+    return blobs;
+}
+
 QByteArray Database::getSceneBlobGlobal() const
 {
     QSqlQuery query;
@@ -2123,17 +2147,7 @@ bool Database::importProject(const QString &inFilePath, const QString &newSceneG
         "VALUES (:name, :scene, :thumbnail, :version, :last_written, :last_accessed, :guid)"
     );
 
-    auto doc = QJsonDocument::fromBinaryData(sceneBlob);
-    QString docToString = doc.toJson(QJsonDocument::Compact);
-
-    QMapIterator<QString, QString> i(assetGuids);
-    while (i.hasNext()) {
-        i.next();
-        docToString.replace(i.key(), i.value());
-    }
-
-    QJsonDocument updatedDoc = QJsonDocument::fromJson(docToString.toUtf8());
-    sceneBlob = updatedDoc.toBinaryData();
+    sceneBlob = SceneFile::replaceStrings(sceneBlob, assetGuids);
 
     query3.bindValue(":name", sceneName);
     query3.bindValue(":scene", sceneBlob);
@@ -83,6 +83,7 @@ public:
     bool updateAssetAsset(const QString &guid, const QByteArray &asset);
     bool updateAssetMetadata(const QString &guid, const QString &name, const QByteArray &tags);
     bool updateAssetProperties(const QString &guid, const QByteArray &asset);
+    bool updateSceneBlob(const QString &guid, const QByteArray &sceneBlob);
 
     // FETCH ================================================================================
     AssetRecord fetchAsset(const QString &guid);
@@ -135,6 +136,7 @@ public:
 
     QString getVersion();
 
+    QMap<QString, QByteArray> fetchSceneBlobs();
     QByteArray getSceneBlobGlobal() const;
 	void updateGlobalDependencyDepender(const int &type, const QString &depender, const QString &dependee);
 	void updateGlobalDependencyDependee(const int &type, const QString &depender, const QString &dependee);
@@ -36,6 +36,16 @@ bool KeyboardState::isKeyUp(int key)
     return !isKeyDown(key);
 }
 
+bool KeyboardState::isAnyKeyDown()
+{
+    for (auto state : keyStates) {
+        if (state)
+            return true;
+    }
+
+    return false;
+}
+
 void KeyboardState::reset()
 {
     keyStates = QHash<int,bool>();
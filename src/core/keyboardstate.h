@@ -29,6 +29,8 @@ public:
 
     static bool isKeyUp(int key);
 
+    static bool isAnyKeyDown();
+
     static void reset();
 };
 
@@ -0,0 +1,232 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "scenesaver.h"
+
+#include <QBuffer>
+#include <QMutexLocker>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+#include "../constants.h"
+#include "../irisgl/src/core/logger.h"
+#include "../irisgl/src/core/performancetimer.h"
+
+static bool executeQuery(QSqlQuery& query, const QString& name)
+{
+    if (!query.exec()) {
+        irisLog(QString("%1 query failed to execute! %2").arg(name, query.lastError().text()));
+        return false;
+    }
+
+    return true;
+}
+
+SceneSaver::SceneSaver(const QString& databasePath, const QString& autosavePath, QObject* parent) :
+    QThread(parent),
+    databasePath(databasePath),
+    autosavePath(autosavePath),
+    busy(false),
+    shutdown(false)
+{
+
+}
+
+SceneSaver::~SceneSaver()
+{
+    QMutexLocker locker(&requestMutex);
+    shutdown = true;
+    requestsAvailable.wakeAll();
+    locker.unlock();
+
+    wait();
+}
+
+void SceneSaver::saveProject(const QString& guid, const SceneFileParts& scene, const QImage& thumbnail)
+{
+    SceneSaveRequest request;
+    request.type = SceneSaveType::Project;
+    request.guid = guid;
+    request.scene = scene;
+    request.thumbnail = thumbnail;
+    addRequest(request);
+}
+
+void SceneSaver::saveSnapshot(const QString& guid, const SceneFileParts& scene)
+{
+    SceneSaveRequest request;
+    request.type = SceneSaveType::Snapshot;
+    request.guid = guid;
+    request.scene = scene;
+    addRequest(request);
+}
+
+void SceneSaver::clearSnapshot(const QString& guid)
+{
+    SceneSaveRequest request;
+    request.type = SceneSaveType::ClearSnapshot;
+    request.guid = guid;
+    addRequest(request);
+}
+
+void SceneSaver::addRequest(const SceneSaveRequest& request)
+{
+    QMutexLocker locker(&requestMutex);
+
+    // queued snapshots of the project are out of date now
+    for (int i = requests.size() - 1; i >= 0; i--) {
+        if (requests[i].type == SceneSaveType::Snapshot && requests[i].guid == request.guid)
+            requests.removeAt(i);
+    }
+
+    requests.append(request);
+    requestsAvailable.wakeOne();
+}
+
+void SceneSaver::waitForSaves()
+{
+    QMutexLocker locker(&requestMutex);
+    while (!requests.isEmpty() || busy)
+        requestsDone.wait(&requestMutex);
+}
+
+QByteArray SceneSaver::fetchSnapshot(const QString& guid)
+{
+    QByteArray scene;
+
+    {
+        auto db = QSqlDatabase::addDatabase(Constants::DB_DRIVER, "scenesaver_fetch");
+        db.setDatabaseName(autosavePath);
+
+        if (openAutosaveDatabase(db)) {
+            QSqlQuery query(db);
+            query.prepare("SELECT scene FROM snapshots WHERE guid = ?");
+            query.addBindValue(guid);
+            if (executeQuery(query, "FetchSnapshot") && query.first())
+                scene = query.value(0).toByteArray();
+        }
+
+        db.close();
+    }
+
+    QSqlDatabase::removeDatabase("scenesaver_fetch");
+    return scene;
+}
+
+bool SceneSaver::openAutosaveDatabase(QSqlDatabase& db)
+{
+    if (!db.open()) {
+        irisLog("Couldnt open the autosave database! " + db.lastError().text());
+        return false;
+    }
+
+    // snapshots are written often, wal lets them be written without blocking readers
+    QSqlQuery pragma(db);
+    pragma.exec("PRAGMA journal_mode = WAL");
+    pragma.exec("PRAGMA synchronous = NORMAL");
+
+    QSqlQuery query(db);
+    query.prepare("CREATE TABLE IF NOT EXISTS snapshots (guid VARCHAR(32) PRIMARY KEY, scene BLOB, saved_at DATETIME)");
+    return executeQuery(query, "CreateSnapshotsTable");
+}
+
+void SceneSaver::run()
+{
+    setPriority(QThread::LowPriority);
+
+    {
+        // connections can only be used by the thread that made them
+        auto db = QSqlDatabase::addDatabase(Constants::DB_DRIVER, "scenesaver");
+        db.setDatabaseName(databasePath);
+        if (!db.open())
+            irisLog("Couldnt open the database for saving! " + db.lastError().text());
+
+        auto autosaveDb = QSqlDatabase::addDatabase(Constants::DB_DRIVER, "scenesaver_autosave");
+        autosaveDb.setDatabaseName(autosavePath);
+        openAutosaveDatabase(autosaveDb);
+
+        forever {
+            QMutexLocker locker(&requestMutex);
+            while (requests.isEmpty() && !shutdown)
+                requestsAvailable.wait(&requestMutex);
+
+            // queued requests are still written when shutting down
+            if (requests.isEmpty())
+                break;
+
+            auto request = requests.takeFirst();
+            busy = true;
+            locker.unlock();
+
+            processRequest(request, db, autosaveDb);
+
+            locker.relock();
+            busy = false;
+            requestsDone.wakeAll();
+        }
+
+        db.close();
+        autosaveDb.close();
+    }
+
+    QSqlDatabase::removeDatabase("scenesaver");
+    QSqlDatabase::removeDatabase("scenesaver_autosave");
+}
+
+void SceneSaver::processRequest(const SceneSaveRequest& request, QSqlDatabase& db, QSqlDatabase& autosaveDb)
+{
+    IRIS_PROFILE("store scene");
+
+    switch (request.type) {
+        case SceneSaveType::Project: {
+            auto scene = SceneFile::assemble(request.scene);
+
+            QByteArray thumb;
+            QBuffer buffer(&thumb);
+            buffer.open(QIODevice::WriteOnly);
+            request.thumbnail.save(&buffer, "PNG");
+
+            QSqlQuery query(db);
+            query.prepare("UPDATE projects SET scene = ?, last_written = datetime(), thumbnail = ? WHERE guid = ?");
+            query.addBindValue(scene);
+            query.addBindValue(thumb);
+            query.addBindValue(request.guid);
+
+            // the snapshot is kept if the save failed
+            if (!executeQuery(query, "SaveProject"))
+                break;
+
+            QSqlQuery clearQuery(autosaveDb);
+            clearQuery.prepare("DELETE FROM snapshots WHERE guid = ?");
+            clearQuery.addBindValue(request.guid);
+            executeQuery(clearQuery, "ClearSnapshot");
+
+            emit projectSaved(request.guid, thumb);
+        }
+        break;
+        case SceneSaveType::Snapshot: {
+            QSqlQuery query(autosaveDb);
+            query.prepare("INSERT OR REPLACE INTO snapshots (guid, scene, saved_at) VALUES (?, ?, datetime())");
+            query.addBindValue(request.guid);
+            query.addBindValue(SceneFile::assemble(request.scene));
+            executeQuery(query, "SaveSnapshot");
+        }
+        break;
+        case SceneSaveType::ClearSnapshot: {
+            QSqlQuery query(autosaveDb);
+            query.prepare("DELETE FROM snapshots WHERE guid = ?");
+            query.addBindValue(request.guid);
+            executeQuery(query, "ClearSnapshot");
+        }
+        break;
+    }
+}
@@ -0,0 +1,97 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef SCENESAVER_H
+#define SCENESAVER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "../io/scenefile.h"
+
+class QSqlDatabase;
+
+enum class SceneSaveType
+{
+    Project,
+    Snapshot,
+    ClearSnapshot
+};
+
+struct SceneSaveRequest
+{
+    SceneSaveType type;
+    QString guid;
+    SceneFileParts scene;
+    QImage thumbnail;
+};
+
+/**
+ * Writes scene blobs to the database on its own thread
+ *
+ * Scenes are handed over as records and assembled into a blob here. Project
+ * saves replace the scene in the projects table, the thumbnail is encoded
+ * here too. Snapshots are autosaves of scenes with unsaved changes,
+ * they're kept in their own database in wal mode so writing them doesnt
+ * block the library database. A project's snapshot is deleted when it's
+ * saved, one that's still there when the project is opened is from a session
+ * that didnt end properly.
+ *
+ * Only the latest queued snapshot of a project is written. Requests are
+ * finished before the saver is destroyed.
+ */
+class SceneSaver : public QThread
+{
+    Q_OBJECT
+
+    QString databasePath;
+    QString autosavePath;
+
+    QMutex requestMutex;
+    QWaitCondition requestsAvailable;
+    QWaitCondition requestsDone;
+    QList<SceneSaveRequest> requests;
+    bool busy;
+    bool shutdown;
+
+public:
+    SceneSaver(const QString& databasePath, const QString& autosavePath, QObject* parent = nullptr);
+    ~SceneSaver();
+
+    void saveProject(const QString& guid, const SceneFileParts& scene, const QImage& thumbnail);
+    void saveSnapshot(const QString& guid, const SceneFileParts& scene);
+    void clearSnapshot(const QString& guid);
+
+    // blocks until every queued request is written
+    void waitForSaves();
+
+    // the project's snapshot or an empty array if there's none, read on the calling thread
+    QByteArray fetchSnapshot(const QString& guid);
+
+signals:
+    void projectSaved(const QString& guid, const QByteArray& thumbnail);
+
+protected:
+    void run() override;
+
+private:
+    void addRequest(const SceneSaveRequest& request);
+    void processRequest(const SceneSaveRequest& request, QSqlDatabase& db, QSqlDatabase& autosaveDb);
+
+    static bool openAutosaveDatabase(QSqlDatabase& db);
+};
+
+#endif // SCENESAVER_H
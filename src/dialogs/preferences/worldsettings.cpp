@@ -50,6 +50,8 @@ WorldSettings::WorldSettings(Database *handle, SettingsManager* settings) :
     connect(ui->outlineWidth,   SIGNAL(valueChanged(double)),   SLOT(outlineWidthChanged(double)));
     connect(ui->outlineColor,   SIGNAL(onColorChanged(QColor)), SLOT(outlineColorChanged(QColor)));
     connect(ui->showFPS,        SIGNAL(toggled(bool)),          SLOT(showFpsChanged(bool)));
+    connect(ui->continuousRendering, SIGNAL(toggled(bool)),     SLOT(continuousRenderingChanged(bool)));
+    connect(ui->frameCap,       SIGNAL(valueChanged(double)),   SLOT(frameCapChanged(double)));
 	connect(ui->autoSave,       SIGNAL(toggled(bool)),          SLOT(enableAutoSave(bool)));
 	connect(ui->openInPlayer,   SIGNAL(toggled(bool)),          SLOT(enableOpenInPlayer(bool)));
 
@@ -93,6 +95,12 @@ WorldSettings::WorldSettings(Database *handle, SettingsManager* settings) :
 	showFps = settings->getValue("show_fps", false).toBool();
 	ui->showFPS->setChecked(showFps);
 
+    continuousRendering = settings->getValue("continuous_rendering", false).toBool();
+    ui->continuousRendering->setChecked(continuousRendering);
+
+    frameCap = settings->getValue("frame_cap", 60).toInt();
+    ui->frameCap->setValue(frameCap);
+
 	autoSave = settings->getValue("auto_save", true).toBool();
 	ui->autoSave->setChecked(autoSave);
 
@@ -137,6 +145,18 @@ void WorldSettings::showFpsChanged(bool show)
     if (UiManager::sceneViewWidget) UiManager::sceneViewWidget->setShowFps(show);
 }
 
+void WorldSettings::continuousRenderingChanged(bool state)
+{
+    settings->setValue("continuous_rendering", continuousRendering = state);
+    if (UiManager::sceneViewWidget) UiManager::sceneViewWidget->setContinuousRendering(state);
+}
+
+void WorldSettings::frameCapChanged(double fps)
+{
+    settings->setValue("frame_cap", frameCap = (int) fps);
+    if (UiManager::sceneViewWidget) UiManager::sceneViewWidget->setFrameCap(frameCap);
+}
+
 void WorldSettings::enableAutoSave(bool state)
 {
 	settings->setValue("auto_save", autoSave = state);
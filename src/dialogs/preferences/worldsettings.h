@@ -34,6 +34,8 @@ public:
     QString defaultProjectDirectory;
     QString defaultEditorPath;
     bool showFps;
+    bool continuousRendering;
+    int frameCap;
 	bool autoSave;
 	bool openInPlayer;
 	bool autoUpdate;
@@ -47,6 +49,8 @@ private slots:
     void outlineWidthChanged(double width);
     void outlineColorChanged(QColor color);
     void showFpsChanged(bool show);
+    void continuousRenderingChanged(bool state);
+    void frameCapChanged(double fps);
 	void enableAutoSave(bool state);
 	void enableOpenInPlayer(bool state);
     void changeDefaultDirectory();
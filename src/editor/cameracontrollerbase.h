@@ -41,6 +41,12 @@ public:
     virtual void update(float dt);
     virtual void end();
 
+    // true while the camera keeps moving on its own, such as when it's easing to a target
+    virtual bool isAnimating()
+    {
+        return false;
+    }
+
     void resetMouseStates();
 
 
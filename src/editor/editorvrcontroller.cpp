@@ -13,6 +13,7 @@ For more information see the LICENSE file
 #include "../irisgl/src/graphics/renderitem.h"
 #include "../irisgl/src/graphics/material.h"
 #include "../irisgl/src/graphics/mesh.h"
+#include "../irisgl/src/core/meshmanager.h"
 #include "../irisgl/src/materials/defaultmaterial.h"
 #include "../irisgl/src/vr/vrdevice.h"
 #include "../irisgl/src/vr/vrmanager.h"
@@ -31,7 +32,7 @@ For more information see the LICENSE file
 EditorVrController::EditorVrController()
 {
     //auto cube = iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/content/primitives/cube.obj"));
-    auto leftHandModel = iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/content/models/external_controller01_left.obj"));
+    auto leftHandModel = iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/content/models/external_controller01_left.obj"));
 
     auto mat = iris::DefaultMaterial::create();
     mat->setDiffuseTexture(
@@ -43,13 +44,13 @@ EditorVrController::EditorVrController()
     leftHandRenderItem->material = mat;
     leftHandRenderItem->mesh = leftHandModel;
 
-    auto rightHandModel = iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/content/models/external_controller01_right.obj"));
+    auto rightHandModel = iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/content/models/external_controller01_right.obj"));
     rightHandRenderItem = new iris::RenderItem();
     rightHandRenderItem->type = iris::RenderItemType::Mesh;
     rightHandRenderItem->material = mat;
     rightHandRenderItem->mesh = rightHandModel;
 
-    beamMesh = iris::Mesh::loadMesh(
+    beamMesh = iris::MeshManager::getSingleton()->getMesh(
                 IrisUtils::getAbsoluteAssetPath("app/content/models/beam.obj"));
     auto beamMat = iris::DefaultMaterial::create();
     beamMat->setDiffuseColor(QColor(255,100,100));
@@ -124,6 +124,11 @@ void OrbitalCameraController::update(float dt)
 	updateCameraRot();
 }
 
+bool OrbitalCameraController::isAnimating()
+{
+	return qAbs(yaw - targetYaw) > 0.01f || qAbs(pitch - targetPitch) > 0.01f;
+}
+
 void OrbitalCameraController::onKeyPressed(Qt::Key key)
 {
 
@@ -61,6 +61,7 @@ public:
 	void onKeyReleased(Qt::Key key);
 
 	void update(float dt) override;
+	bool isAnimating() override;
 
 	void focusOnNode(iris::SceneNodePtr sceneNode);
 
@@ -0,0 +1,270 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "pickingrenderer.h"
+#include "irisgl/src/graphics/graphicsdevice.h"
+#include "irisgl/src/graphics/graphicshelper.h"
+#include "irisgl/src/graphics/mesh.h"
+#include "irisgl/src/graphics/rendertarget.h"
+#include "irisgl/src/graphics/skeleton.h"
+#include "irisgl/src/graphics/texture2d.h"
+
+#include "irisgl/src/scenegraph/cameranode.h"
+#include "irisgl/src/scenegraph/meshnode.h"
+#include "irisgl/src/scenegraph/scene.h"
+#include "irisgl/src/scenegraph/scenenode.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+
+PickingRenderer::PickingRenderer()
+{
+    gl = nullptr;
+    meshShader = nullptr;
+    skinnedShader = nullptr;
+
+    for (auto& readback : readbacks) {
+        readback.pbo = 0;
+        readback.fence = 0;
+        readback.generation = 0;
+    }
+    nextReadback = 0;
+
+    generation = 0;
+    picked = false;
+    hasResult = false;
+}
+
+void PickingRenderer::loadAssets()
+{
+    gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
+
+    meshShader = iris::GraphicsHelper::loadShader(":assets/shaders/color.vert",
+                                                  ":shaders/picking.frag");
+    skinnedShader = iris::GraphicsHelper::loadShader(":assets/shaders/skinned_color.vert",
+                                                     ":shaders/picking.frag");
+
+    // integer textures cant be filtered
+    idTexture = iris::Texture2D::create(PICK_SIZE, PICK_SIZE, QOpenGLTexture::R32U);
+    idTexture->setFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+
+    renderTarget = iris::RenderTarget::create(PICK_SIZE, PICK_SIZE);
+    renderTarget->addTexture(idTexture);
+
+    for (auto& readback : readbacks) {
+        gl->glGenBuffers(1, &readback.pbo);
+        gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+        gl->glBufferData(GL_PIXEL_PACK_BUFFER, PICK_SIZE * PICK_SIZE * sizeof(GLuint),
+                         nullptr, GL_STREAM_READ);
+    }
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void PickingRenderer::pick(iris::GraphicsDevicePtr device,
+                           iris::ScenePtr scene,
+                           iris::CameraNodePtr cam,
+                           const QSize& viewSize,
+                           const QPointF& point)
+{
+    auto viewProjMatrix = cam->projMatrix * cam->viewMatrix;
+    if (picked && point == pickedPoint && viewProjMatrix == pickedViewProjMatrix)
+        return;
+
+    // both readbacks are still in flight, try again next frame
+    auto& readback = readbacks[nextReadback];
+    if (readback.fence != 0)
+        return;
+
+    picked = true;
+    pickedPoint = point;
+    pickedViewProjMatrix = viewProjMatrix;
+
+    // narrows the projection down to the pixels around the point
+    float x = (2.0f * point.x()) / viewSize.width() - 1.0f;
+    float y = 1.0f - (2.0f * point.y()) / viewSize.height();
+    QMatrix4x4 pickMatrix;
+    pickMatrix.scale((float)viewSize.width() / PICK_SIZE, (float)viewSize.height() / PICK_SIZE, 1.0f);
+    pickMatrix.translate(-x, -y, 0.0f);
+    auto projMatrix = pickMatrix * cam->projMatrix;
+
+    readback.point = point;
+    readback.viewProjMatrix = viewProjMatrix;
+    readback.generation = generation;
+    readback.nodes.clear();
+
+    auto vp = device->getViewport();
+    device->setRenderTarget(renderTarget);
+    device->setViewport(QRect(0, 0, PICK_SIZE, PICK_SIZE));
+
+    const GLuint clearId[] = {0, 0, 0, 0};
+    gl->glClearBufferuiv(GL_COLOR, 0, clearId);
+    device->clear(GL_DEPTH_BUFFER_BIT, QColor(), 1.0f);
+
+    // triangles are picked from both sides when raycasting too
+    device->setBlendState(iris::BlendState::Opaque);
+    device->setDepthState(iris::DepthState::Default);
+    device->setRasterizerState(iris::RasterizerState::CullNone);
+
+    renderNode(device, scene->getRootNode(), cam, projMatrix, readback);
+
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    gl->glReadPixels(0, 0, PICK_SIZE, PICK_SIZE, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    device->clearRenderTarget();
+    device->setViewport(vp);
+    nextReadback = (nextReadback + 1) % READBACK_COUNT;
+}
+
+void PickingRenderer::renderNode(iris::GraphicsDevicePtr device,
+                                 iris::SceneNodePtr node,
+                                 iris::CameraNodePtr cam,
+                                 const QMatrix4x4& projMatrix,
+                                 Readback& readback)
+{
+    // same nodes as SceneViewWidget::doScenePicking
+    if (node->getSceneNodeType() == iris::SceneNodeType::Mesh && node->isPickable()) {
+        auto meshNode = node.staticCast<iris::MeshNode>();
+        auto mesh = meshNode->getMesh();
+
+        if (mesh != nullptr) {
+            readback.nodes.append(node);
+
+            auto shader = mesh->hasSkeleton() ? skinnedShader : meshShader;
+            shader->bind();
+            shader->setUniformValue("u_worldMatrix", node->globalTransform);
+            shader->setUniformValue("u_viewMatrix", cam->viewMatrix);
+            shader->setUniformValue("u_projMatrix", projMatrix);
+            shader->setUniformValue("u_id", (GLuint)readback.nodes.size());
+
+            if (mesh->hasSkeleton()) {
+                auto boneTransforms = mesh->getSkeleton()->boneTransforms;
+                shader->setUniformValueArray("u_bones", boneTransforms.data(), boneTransforms.size());
+            }
+
+            mesh->draw(device);
+        }
+    }
+
+    for (auto child : node->children)
+        renderNode(device, child, cam, projMatrix, readback);
+}
+
+bool PickingRenderer::resolve()
+{
+    bool changed = false;
+
+    // readbacks finish in the order they were made
+    for (int i = 0; i < READBACK_COUNT; i++) {
+        auto& readback = readbacks[(nextReadback + i) % READBACK_COUNT];
+        if (readback.fence == 0)
+            continue;
+
+        auto status = gl->glClientWaitSync(readback.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        gl->glDeleteSync(readback.fence);
+        readback.fence = 0;
+
+        if (readback.generation == generation)
+            changed |= readResult(readback);
+        readback.nodes.clear();
+    }
+
+    return changed;
+}
+
+bool PickingRenderer::readResult(Readback& readback)
+{
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    auto ids = (const GLuint*)gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                                   PICK_SIZE * PICK_SIZE * sizeof(GLuint),
+                                                   GL_MAP_READ_BIT);
+
+    // the id under the cursor
+    GLuint id = 0;
+    if (ids != nullptr) {
+        const int center = PICK_SIZE / 2;
+        id = ids[center * PICK_SIZE + center];
+
+        gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    QWeakPointer<iris::SceneNode> node;
+    if (id > 0 && id <= (GLuint)readback.nodes.size())
+        node = readback.nodes[id - 1];
+
+    bool changed = !hasResult || node != resultNode;
+
+    hasResult = true;
+    resultPoint = readback.point;
+    resultViewProjMatrix = readback.viewProjMatrix;
+    resultNode = node;
+
+    return changed;
+}
+
+bool PickingRenderer::isPending()
+{
+    for (auto& readback : readbacks) {
+        if (readback.fence != 0)
+            return true;
+    }
+
+    return false;
+}
+
+void PickingRenderer::invalidate()
+{
+    generation++;
+    picked = false;
+    hasResult = false;
+    resultNode.clear();
+}
+
+bool PickingRenderer::getPickedNode(const QPointF& point, iris::CameraNodePtr cam, iris::SceneNodePtr& node)
+{
+    if (!hasResult)
+        return false;
+
+    // press positions can be fractional on high dpi screens
+    if ((point - resultPoint).manhattanLength() > 1.0f)
+        return false;
+
+    if (cam->projMatrix * cam->viewMatrix != resultViewProjMatrix)
+        return false;
+
+    node = resultNode.toStrongRef();
+    return true;
+}
+
+iris::SceneNodePtr PickingRenderer::getHoveredNode()
+{
+    if (!hasResult)
+        return iris::SceneNodePtr();
+
+    return resultNode.toStrongRef();
+}
+
+PickingRenderer::~PickingRenderer()
+{
+    if (gl == nullptr)
+        return;
+
+    for (auto& readback : readbacks) {
+        if (readback.fence != 0)
+            gl->glDeleteSync(readback.fence);
+        gl->glDeleteBuffers(1, &readback.pbo);
+    }
+}
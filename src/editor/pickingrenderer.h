@@ -0,0 +1,123 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef PICKINGRENDERER_H
+#define PICKINGRENDERER_H
+
+#include "irisgl/src/irisglfwd.h"
+#include <QMatrix4x4>
+#include <QOpenGLFunctions_3_2_Core>
+#include <QPointF>
+#include <QSize>
+#include <QVector>
+#include <QWeakPointer>
+
+class QOpenGLShaderProgram;
+
+/**
+ * Picks meshes on the gpu with an id buffer
+ *
+ * The pickable meshes are drawn into a single pixel R32UI target under the
+ * cursor, each with its index in the pass as its color, so the picked node
+ * is always the one the cursor ray hits.
+ * The ids are copied to a pixel buffer and read a frame or two later, once
+ * the gpu is done with them, so picking never stalls the pipeline. A result
+ * is only used if it was
+ * rendered at the same point with the same camera and the scene hasnt
+ * changed since, otherwise the caller should fall back to raycasting.
+ */
+class PickingRenderer
+{
+    // only the pixel under the cursor, a wider area can pick meshes the cursor ray misses
+    static const int PICK_SIZE = 1;
+    static const int READBACK_COUNT = 2;
+
+    struct Readback
+    {
+        GLuint pbo;
+        GLsync fence;
+
+        QPointF point;
+        QMatrix4x4 viewProjMatrix;
+        int generation;
+
+        // nodes indexed by their id minus one
+        QVector<QWeakPointer<iris::SceneNode>> nodes;
+    };
+
+    QOpenGLFunctions_3_2_Core* gl;
+    QOpenGLShaderProgram* meshShader;
+    QOpenGLShaderProgram* skinnedShader;
+
+    iris::RenderTargetPtr renderTarget;
+    iris::Texture2DPtr idTexture;
+
+    Readback readbacks[READBACK_COUNT];
+    int nextReadback;
+
+    // bumped when the scene changes so older readbacks are discarded
+    int generation;
+
+    // the last pick made, so the same one isnt rendered again every frame
+    bool picked;
+    QPointF pickedPoint;
+    QMatrix4x4 pickedViewProjMatrix;
+
+    bool hasResult;
+    QPointF resultPoint;
+    QMatrix4x4 resultViewProjMatrix;
+    QWeakPointer<iris::SceneNode> resultNode;
+
+public:
+    PickingRenderer();
+    ~PickingRenderer();
+
+    void loadAssets();
+
+    /**
+     * Picks at point, in widget coordinates, with the ids read back on a later frame
+     * Does nothing if the point, camera and scene are the same as the last pick's
+     * or if all the readbacks are in flight, resolve() frees them
+     */
+    void pick(iris::GraphicsDevicePtr device,
+              iris::ScenePtr scene,
+              iris::CameraNodePtr cam,
+              const QSize& viewSize,
+              const QPointF& point);
+
+    // reads the readbacks the gpu is done with, returns true if the picked node changed
+    bool resolve();
+
+    // true while readbacks are waiting on the gpu
+    bool isPending();
+
+    // discards results and readbacks from before the scene changed
+    void invalidate();
+
+    /**
+     * Gives the node last picked at point, which is null if there was nothing there
+     * Returns false if there's no result for point and cam as they are now
+     */
+    bool getPickedNode(const QPointF& point, iris::CameraNodePtr cam, iris::SceneNodePtr& node);
+
+    // the node under the cursor as of the last result
+    iris::SceneNodePtr getHoveredNode();
+
+private:
+    void renderNode(iris::GraphicsDevicePtr device,
+                    iris::SceneNodePtr node,
+                    iris::CameraNodePtr cam,
+                    const QMatrix4x4& projMatrix,
+                    Readback& readback);
+    bool readResult(Readback& readback);
+};
+
+#endif // PICKINGRENDERER_H
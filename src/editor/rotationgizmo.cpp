@@ -6,6 +6,7 @@
 #include "irisgl/src/math/intersectionhelper.h"
 #include "irisgl/src/math/mathhelper.h"
 #include "irisgl/src/core/irisutils.h"
+#include "irisgl/src/core/meshmanager.h"
 #include "irisgl/src/scenegraph/scene.h"
 #include "irisgl/src/scenegraph/cameranode.h"
 #include "irisgl/src/graphics/graphicshelper.h"
@@ -150,9 +151,9 @@ RotationGizmo::RotationGizmo() :
 
 void RotationGizmo::loadAssets()
 {
-	handleMeshes.append(iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/models/rot_x.obj")));
-	handleMeshes.append(iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/models/rot_y.obj")));
-	handleMeshes.append(iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/models/rot_z.obj")));
+	handleMeshes.append(iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/models/rot_x.obj")));
+	handleMeshes.append(iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/models/rot_y.obj")));
+	handleMeshes.append(iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/models/rot_z.obj")));
 
 	shader = iris::GraphicsHelper::loadShader(
 		IrisUtils::getAbsoluteAssetPath("app/shaders/gizmo.vert"),
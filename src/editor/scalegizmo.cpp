@@ -6,6 +6,7 @@
 #include "irisgl/src/math/intersectionhelper.h"
 #include "irisgl/src/math/mathhelper.h"
 #include "irisgl/src/core/irisutils.h"
+#include "irisgl/src/core/meshmanager.h"
 #include "irisgl/src/scenegraph/scene.h"
 #include "irisgl/src/graphics/vertexlayout.h"
 #include "irisgl/src/scenegraph/cameranode.h"
@@ -140,11 +141,11 @@ ScaleGizmo::ScaleGizmo() :
 
 void ScaleGizmo::loadAssets()
 {
-	handleMeshes.append(iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/models/scale_x.obj")));
-	handleMeshes.append(iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/models/scale_y.obj")));
-	handleMeshes.append(iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/models/scale_z.obj")));
+	handleMeshes.append(iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/models/scale_x.obj")));
+	handleMeshes.append(iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/models/scale_y.obj")));
+	handleMeshes.append(iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/models/scale_z.obj")));
 
-	centerMesh = iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/models/axis_cube.obj"));
+	centerMesh = iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/models/axis_cube.obj"));
 
 	shader = iris::GraphicsHelper::loadShader(
 		IrisUtils::getAbsoluteAssetPath("app/shaders/gizmo.vert"),
@@ -339,6 +339,8 @@ ThumbnailGenerator::ThumbnailGenerator()
 
     auto context = new QOpenGLContext();
     context->setFormat(format);
+    // share buffers with the editor's contexts since meshes are cached
+    context->setShareContext(QOpenGLContext::globalShareContext());
     context->create();
     context->moveToThread(renderThread);
     renderThread->context = context;
@@ -6,6 +6,7 @@
 #include "irisgl/src/math/intersectionhelper.h"
 #include "irisgl/src/math/mathhelper.h"
 #include "irisgl/src/core/irisutils.h"
+#include "irisgl/src/core/meshmanager.h"
 #include "irisgl/src/scenegraph/scene.h"
 #include "irisgl/src/scenegraph/cameranode.h"
 #include "irisgl/src/graphics/graphicsdevice.h"
@@ -136,11 +137,11 @@ TranslationGizmo::TranslationGizmo() :
 
 void TranslationGizmo::loadAssets()
 {
-	handleMeshes.append(iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/models/axis_x.obj")));
-	handleMeshes.append(iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/models/axis_y.obj")));
-	handleMeshes.append(iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/models/axis_z.obj")));
+	handleMeshes.append(iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/models/axis_x.obj")));
+	handleMeshes.append(iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/models/axis_y.obj")));
+	handleMeshes.append(iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/models/axis_z.obj")));
 
-	centerMesh = iris::Mesh::loadMesh(IrisUtils::getAbsoluteAssetPath("app/models/axis_sphere.obj"));
+	centerMesh = iris::MeshManager::getSingleton()->getMesh(IrisUtils::getAbsoluteAssetPath("app/models/axis_sphere.obj"));
 
 	shader = iris::GraphicsHelper::loadShader(
 		IrisUtils::getAbsoluteAssetPath("app/shaders/gizmo.vert"),
@@ -13,13 +13,24 @@ For more information see the LICENSE file
 
 #include <QPixmap>
 #include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
 
+#include "irisgl/src/core/irisutils.h"
 #include "irisgl/src/core/property.h"
+#include "irisgl/src/core/texturemanager.h"
+#include "irisgl/src/content/meshfile.h"
+#include "irisgl/src/graphics/graphicshelper.h"
 #include "irisgl/src/materials/custommaterial.h"
 #include "irisgl/src/scenegraph/scenenode.h"
 #include "irisgl/src/scenegraph/meshnode.h"
 
+#include "core/database/database.h"
+#include "io/assetmanager.h"
 #include "io/scenewriter.h"
+#include "globals.h"
 
 // Thanks to Qt not allowing updating its json values and instead returning temp objects
 // This class updates a meshnode with the values in a material definition
@@ -159,3 +170,67 @@ iris::SceneNodePtr AssetHelper::extractTexturesAndMaterialFromMesh(
 
     return node;
 }
+
+QString AssetHelper::getMeshCachePath(const QString &assetGuid)
+{
+    return IrisUtils::join(Globals::project->getProjectFolder(),
+                           Constants::MESH_CACHE_FOLDER,
+                           assetGuid + "." + Constants::MESH_CACHE_EXT);
+}
+
+bool AssetHelper::writeMeshCache(const QString &assetGuid,
+                                 const QByteArray &sourceHash,
+                                 const QList<iris::MeshPtr> &meshes,
+                                 const QMap<QString, iris::SkeletalAnimationPtr> &animations)
+{
+    auto cachePath = getMeshCachePath(assetGuid);
+    QDir().mkpath(QFileInfo(cachePath).absolutePath());
+    return iris::MeshFile::save(cachePath, meshes, animations, sourceHash);
+}
+
+bool AssetHelper::convertMesh(const QString &filePath, const QString &assetGuid)
+{
+    QList<iris::MeshPtr> meshes;
+    QMap<QString, iris::SkeletalAnimationPtr> animations;
+    iris::GraphicsHelper::loadAllMeshesAndAnimationsFromFile(filePath, meshes, animations);
+    if (meshes.isEmpty()) return false;
+
+    return writeMeshCache(assetGuid, IrisUtils::hashFile(filePath), meshes, animations);
+}
+
+QString AssetHelper::getTextureCacheFolder()
+{
+    return IrisUtils::join(Globals::project->getProjectFolder(), Constants::TEXTURE_CACHE_FOLDER);
+}
+
+bool AssetHelper::convertTexture(const QString &filePath)
+{
+    return iris::TextureManager::getSingleton()->convert(filePath);
+}
+
+void AssetHelper::addShaderAssets(Database *db)
+{
+    for (const auto &asset : db->fetchAssetsByType(static_cast<int>(ModelTypes::File))) {
+        auto assetFile = new AssetFile;
+        assetFile->fileName = asset.name;
+        assetFile->assetGuid = asset.guid;
+        assetFile->path = IrisUtils::join(Globals::project->getProjectFolder(), asset.name);
+        AssetManager::addAsset(assetFile);
+    }
+
+    for (const auto &asset : db->fetchAssetsByType(static_cast<int>(ModelTypes::Shader))) {
+        QFile *templateShaderFile = new QFile(IrisUtils::join(Globals::project->getProjectFolder(), asset.name));
+        templateShaderFile->open(QIODevice::ReadOnly | QIODevice::Text);
+        QJsonObject shaderDefinition = QJsonDocument::fromJson(templateShaderFile->readAll()).object();
+        templateShaderFile->close();
+        // shaderDefinition["name"] = QFileInfo(asset.name).baseName();
+        shaderDefinition.insert("guid", asset.guid);
+
+        auto assetShader = new AssetShader;
+        assetShader->assetGuid = asset.guid;
+        assetShader->fileName = QFileInfo(asset.name).baseName();
+        assetShader->path = IrisUtils::join(Globals::project->getProjectFolder(), asset.name);
+        assetShader->setValue(QVariant::fromValue(shaderDefinition));
+        AssetManager::addAsset(assetShader);
+    }
+}
@@ -19,6 +19,8 @@ For more information see the LICENSE file
 #include "constants.h"
 #include "core/project.h"
 
+class Database;
+
 class AssetHelper
 {
 public:
@@ -27,6 +29,23 @@ public:
     static ModelTypes getAssetTypeFromExtension(const QString &fileSuffix);
     static iris::SceneNodePtr extractTexturesAndMaterialFromMesh(const QString &filePath,
                                                                  QStringList &textureList);
+
+    // models are converted to the native mesh format and cached by asset guid
+    static QString getMeshCachePath(const QString &assetGuid);
+    static bool writeMeshCache(const QString &assetGuid,
+                               const QByteArray &sourceHash,
+                               const QList<iris::MeshPtr> &meshes,
+                               const QMap<QString, iris::SkeletalAnimationPtr> &animations);
+
+    // converts a model when it's imported so it never has to be imported to be loaded
+    static bool convertMesh(const QString &filePath, const QString &assetGuid);
+
+    // textures are compressed with their mip levels and cached by the hash of the image
+    static QString getTextureCacheFolder();
+    static bool convertTexture(const QString &filePath);
+
+    // adds the current project's shaders and the files they use to the AssetManager
+    static void addShaderAssets(Database *db);
 };
 
 #endif
\ No newline at end of file
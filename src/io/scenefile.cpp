@@ -0,0 +1,381 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "scenefile.h"
+
+#include <QIODevice>
+#include <QtEndian>
+#include <QJsonDocument>
+
+#include "../irisgl/src/scenegraph/scenenode.h"
+#include "../irisgl/src/scenegraph/meshnode.h"
+#include "../irisgl/src/materials/material.h"
+#include "../irisgl/src/core/performancetimer.h"
+
+// "JSCN"
+const quint32 SceneFile::MAGIC = 0x4A53434E;
+const quint32 SceneFile::VERSION = 1;
+
+// what follows a value's tag
+enum class ValueTag : quint8
+{
+    Variant,
+    String
+};
+
+static void setupStream(QDataStream& stream)
+{
+    stream.setVersion(QDataStream::Qt_5_0);
+    // doubles are stored in single precision too
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+}
+
+static QByteArray writeHeader(const QVector<QString>& strings)
+{
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    setupStream(stream);
+
+    stream << SceneFile::MAGIC << SceneFile::VERSION << (quint32)strings.size();
+    for (auto& string : strings)
+        stream << string;
+
+    return header;
+}
+
+bool SceneFile::isSceneFile(const QByteArray& blob)
+{
+    if (blob.size() < 8)
+        return false;
+
+    QDataStream stream(blob);
+    quint32 magic;
+    stream >> magic;
+    return magic == MAGIC;
+}
+
+QByteArray SceneFile::replaceStrings(const QByteArray& blob, const QMap<QString, QString>& replacements)
+{
+    SceneFileReader reader(blob);
+    if (!reader.readHeader()) {
+        // json scenes are converted by SceneWriter when they're next saved
+        auto doc = QJsonDocument::fromBinaryData(blob);
+        if (!doc.isObject())
+            return blob;
+
+        QString docToString = doc.toJson(QJsonDocument::Compact);
+        for (auto iter = replacements.constBegin(); iter != replacements.constEnd(); ++iter)
+            docToString.replace(iter.key(), iter.value());
+
+        return QJsonDocument::fromJson(docToString.toUtf8()).toBinaryData();
+    }
+
+    auto strings = reader.strings;
+    for (auto& string : strings) {
+        for (auto iter = replacements.constBegin(); iter != replacements.constEnd(); ++iter)
+            string.replace(iter.key(), iter.value());
+    }
+
+    // the body only has indices into the table so it's copied as is
+    auto bodyStart = reader.data().device()->pos();
+    return writeHeader(strings) + blob.mid(bodyStart);
+}
+
+QByteArray SceneFile::assemble(const SceneFileParts& parts)
+{
+    IRIS_PROFILE("assemble scene");
+
+    SceneFileWriter file;
+    file.writeRecord(parts.settings);
+
+    file.data() << (quint32)parts.nodes.size();
+    for (auto& node : parts.nodes) {
+        file.data() << node.first;
+        file.writeRecord(node.second);
+    }
+
+    file.writeRecord(parts.trailer);
+    return file.toByteArray();
+}
+
+quint8 SceneFileKeys::packFlags(int leftTangent, int rightTangent, int handleMode)
+{
+    return (quint8)((leftTangent & 3) | ((rightTangent & 3) << 2) | ((handleMode & 1) << 4));
+}
+
+void SceneFileKeys::unpackFlags(quint8 flags, int& leftTangent, int& rightTangent, int& handleMode)
+{
+    leftTangent = flags & 3;
+    rightTangent = (flags >> 2) & 3;
+    handleMode = (flags >> 4) & 1;
+}
+
+SceneFileWriter::SceneFileWriter(bool recording) :
+    stream(&body, QIODevice::WriteOnly),
+    recording(recording)
+{
+    setupStream(stream);
+}
+
+void SceneFileWriter::writeString(const QString& string)
+{
+    if (recording) {
+        recordStrings.append(qMakePair(body.size(), string));
+        stream << (quint32)0;
+        return;
+    }
+
+    auto iter = stringIds.constFind(string);
+    if (iter != stringIds.constEnd()) {
+        stream << iter.value();
+        return;
+    }
+
+    quint32 id = strings.size();
+    strings.append(string);
+    stringIds.insert(string, id);
+    stream << id;
+}
+
+void SceneFileWriter::writeValue(const QVariant& value)
+{
+    if (value.type() == QVariant::String) {
+        stream << (quint8)ValueTag::String;
+        writeString(value.toString());
+    } else {
+        stream << (quint8)ValueTag::Variant << value;
+    }
+}
+
+void SceneFileWriter::writeColor(const QColor& color)
+{
+    stream << (quint8)color.red() << (quint8)color.green() << (quint8)color.blue() << (quint8)color.alpha();
+}
+
+void SceneFileWriter::writeVector3(const QVector3D& vec)
+{
+    stream << vec.x() << vec.y() << vec.z();
+}
+
+void SceneFileWriter::writeKeys(const SceneFileKeys& keys)
+{
+    stream << (quint32)keys.times.size();
+    for (auto time : keys.times)        stream << time;
+    for (auto value : keys.values)      stream << value;
+    for (auto slope : keys.leftSlopes)  stream << slope;
+    for (auto slope : keys.rightSlopes) stream << slope;
+    for (auto flags : keys.flags)       stream << flags;
+}
+
+void SceneFileWriter::writeRecord(const SceneFileRecord& record)
+{
+    if (recording) {
+        for (auto& string : record.strings)
+            recordStrings.append(qMakePair(body.size() + string.first, string.second));
+        stream.writeRawData(record.data.constData(), record.data.size());
+        return;
+    }
+
+    auto data = record.data;
+    for (auto& string : record.strings) {
+        auto iter = stringIds.constFind(string.second);
+        quint32 id;
+        if (iter != stringIds.constEnd()) {
+            id = iter.value();
+        } else {
+            id = strings.size();
+            strings.append(string.second);
+            stringIds.insert(string.second, id);
+        }
+
+        // QDataStream writes big endian
+        qToBigEndian(id, (uchar*)data.data() + string.first);
+    }
+
+    stream.writeRawData(data.constData(), data.size());
+}
+
+QByteArray SceneFileWriter::toByteArray()
+{
+    return writeHeader(strings) + body;
+}
+
+SceneFileRecord SceneFileWriter::toRecord()
+{
+    SceneFileRecord record;
+    record.data = body;
+    record.strings = recordStrings;
+    return record;
+}
+
+void SceneFileCache::markDirty(iris::SceneNodePtr node)
+{
+    dirtyNodes.insert(node->getNodeId());
+    revision++;
+}
+
+void SceneFileCache::markDirty(iris::MaterialPtr material)
+{
+    dirtyMaterials.insert(material.data());
+    revision++;
+}
+
+void SceneFileCache::markChanged()
+{
+    revision++;
+}
+
+bool SceneFileCache::findRecord(iris::SceneNodePtr node, SceneFileRecord& record)
+{
+    auto id = node->getNodeId();
+    savedNodes.insert(id);
+
+    if (dirtyNodes.contains(id))
+        return false;
+
+    if (node->sceneNodeType == iris::SceneNodeType::Mesh &&
+        dirtyMaterials.contains(node.staticCast<iris::MeshNode>()->getMaterial().data()))
+        return false;
+
+    auto iter = records.constFind(id);
+    if (iter == records.constEnd())
+        return false;
+
+    record = iter.value();
+    return true;
+}
+
+void SceneFileCache::insertRecord(iris::SceneNodePtr node, const SceneFileRecord& record)
+{
+    auto id = node->getNodeId();
+    records.insert(id, record);
+    dirtyNodes.remove(id);
+
+    if (node->sceneNodeType == iris::SceneNodeType::Mesh)
+        dirtyMaterials.remove(node.staticCast<iris::MeshNode>()->getMaterial().data());
+}
+
+void SceneFileCache::beginSave()
+{
+    savedNodes.clear();
+}
+
+void SceneFileCache::endSave()
+{
+    for (auto iter = records.begin(); iter != records.end();) {
+        if (!savedNodes.contains(iter.key()))
+            iter = records.erase(iter);
+        else
+            ++iter;
+    }
+
+    dirtyNodes.intersect(savedNodes);
+}
+
+void SceneFileCache::clear()
+{
+    records.clear();
+    dirtyNodes.clear();
+    dirtyMaterials.clear();
+    savedNodes.clear();
+}
+
+SceneFileReader::SceneFileReader(const QByteArray& blob) :
+    stream(blob),
+    version(0)
+{
+    setupStream(stream);
+}
+
+bool SceneFileReader::readHeader()
+{
+    quint32 magic, stringCount;
+    stream >> magic >> version >> stringCount;
+
+    if (stream.status() != QDataStream::Ok ||
+        magic != SceneFile::MAGIC ||
+        version == 0 || version > SceneFile::VERSION)
+        return false;
+
+    // every string takes at least 4 bytes, dont trust a count the blob cant hold
+    if (stringCount > stream.device()->bytesAvailable() / 4)
+        return false;
+
+    strings.resize(stringCount);
+    for (auto& string : strings)
+        stream >> string;
+
+    return stream.status() == QDataStream::Ok;
+}
+
+QString SceneFileReader::readString()
+{
+    quint32 id = 0;
+    stream >> id;
+
+    if (id >= (quint32)strings.size()) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return QString();
+    }
+
+    return strings[id];
+}
+
+QVariant SceneFileReader::readValue()
+{
+    quint8 tag = 0;
+    stream >> tag;
+
+    if (tag == (quint8)ValueTag::String)
+        return readString();
+
+    QVariant value;
+    stream >> value;
+    return value;
+}
+
+QColor SceneFileReader::readColor()
+{
+    quint8 r = 0, g = 0, b = 0, a = 255;
+    stream >> r >> g >> b >> a;
+    return QColor(r, g, b, a);
+}
+
+QVector3D SceneFileReader::readVector3()
+{
+    float x = 0, y = 0, z = 0;
+    stream >> x >> y >> z;
+    return QVector3D(x, y, z);
+}
+
+void SceneFileReader::readKeys(SceneFileKeys& keys)
+{
+    quint32 count = 0;
+    stream >> count;
+
+    // a key takes 17 bytes
+    if (count > stream.device()->bytesAvailable() / 17) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        count = 0;
+    }
+
+    keys.times.resize(count);
+    keys.values.resize(count);
+    keys.leftSlopes.resize(count);
+    keys.rightSlopes.resize(count);
+    keys.flags.resize(count);
+
+    for (auto& time : keys.times)           stream >> time;
+    for (auto& value : keys.values)         stream >> value;
+    for (auto& slope : keys.leftSlopes)     stream >> slope;
+    for (auto& slope : keys.rightSlopes)    stream >> slope;
+    for (auto& flags : keys.flags)          stream >> flags;
+}
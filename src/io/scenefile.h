@@ -0,0 +1,233 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef SCENEFILE_H
+#define SCENEFILE_H
+
+#include <QByteArray>
+#include <QColor>
+#include <QDataStream>
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <QVector3D>
+
+#include "../irisgl/src/irisglfwd.h"
+
+/**
+ * Binary format of the scene blobs stored in the projects table
+ *
+ * The file starts with a magic number, the format version and a table of
+ * every string used in the scene, the rest of the file refers to strings by
+ * their index in the table. After the scene's settings the nodes are stored
+ * as one flat list in depth first order, each with the index of its parent
+ * (-1 for children of the root node) followed by its type specific data and
+ * animations. A keyframe's keys are stored as packed arrays of times, values,
+ * slopes and tangent flags. The editor data and post processes come last.
+ *
+ * Enums are stored as their values so new values must only be appended. The
+ * version is bumped when the layout changes, readers check it to skip fields
+ * that older files dont have.
+ *
+ * Scenes saved before this format are QJsonDocument binary blobs. The Upgrader
+ * converts those at startup by reading them with SceneReader and writing them
+ * with SceneWriter, so there's only one encoder to keep up to date. SceneReader
+ * still reads them for worlds imported since, they're converted when saved.
+ */
+struct SceneFileParts;
+
+class SceneFile
+{
+public:
+    static const quint32 MAGIC;
+    static const quint32 VERSION;
+
+    static bool isSceneFile(const QByteArray& blob);
+
+    /**
+     * Replaces text in every string of the scene without reading the rest of it
+     * Used to give the assets of imported scenes new guids, json scenes are
+     * handled too
+     */
+    static QByteArray replaceStrings(const QByteArray& blob, const QMap<QString, QString>& replacements);
+
+    // writes the header and string table and copies the parts after it
+    static QByteArray assemble(const SceneFileParts& parts);
+};
+
+// keys of a keyframe, packed into one array per field
+struct SceneFileKeys
+{
+    QVector<double> times;
+    QVector<float> values;
+    QVector<float> leftSlopes;
+    QVector<float> rightSlopes;
+
+    // left tangent type in bits 0-1, right tangent type in bits 2-3 and handle mode in bit 4
+    QVector<quint8> flags;
+
+    static quint8 packFlags(int leftTangent, int rightTangent, int handleMode);
+    static void unpackFlags(quint8 flags, int& leftTangent, int& rightTangent, int& handleMode);
+};
+
+/**
+ * Data written by a recording SceneFileWriter
+ * Strings are left as placeholders along with their offsets since their
+ * indices depend on the file the record is copied into
+ */
+struct SceneFileRecord
+{
+    QByteArray data;
+    QVector<QPair<int, QString>> strings;
+};
+
+/**
+ * A scene written as records, assemble() turns it into a scene blob
+ * Only copies are kept so it can be assembled on another thread
+ */
+struct SceneFileParts
+{
+    // the scene's settings and what comes after the nodes
+    SceneFileRecord settings;
+    SceneFileRecord trailer;
+
+    // in depth first order, each with the index of its parent
+    QVector<QPair<qint32, SceneFileRecord>> nodes;
+};
+
+class SceneFileWriter
+{
+    QByteArray body;
+    QDataStream stream;
+
+    QHash<QString, quint32> stringIds;
+    QVector<QString> strings;
+
+    bool recording;
+    QVector<QPair<int, QString>> recordStrings;
+
+public:
+    // a recording writer's data is taken with toRecord() instead of toByteArray()
+    SceneFileWriter(bool recording = false);
+
+    // the stream the body is written to, strings should go through writeString()
+    QDataStream& data()
+    {
+        return stream;
+    }
+
+    // writes the string's index in the table, adding it if it's new
+    void writeString(const QString& string);
+
+    // strings go through the string table, everything else is written as a QVariant
+    void writeValue(const QVariant& value);
+
+    void writeColor(const QColor& color);
+    void writeVector3(const QVector3D& vec);
+    void writeKeys(const SceneFileKeys& keys);
+
+    // copies the record, filling in the indices of its strings
+    void writeRecord(const SceneFileRecord& record);
+
+    // the header and string table followed by everything written so far
+    QByteArray toByteArray();
+
+    SceneFileRecord toRecord();
+};
+
+/**
+ * Node records kept between saves so unchanged nodes arent written again
+ *
+ * A node's record is everything written for it except its parent index and
+ * children. Records are dropped when the node or its material is marked
+ * dirty, which the undo commands do when they change them, and when a save
+ * doesnt write the node anymore.
+ */
+class SceneFileCache
+{
+    QHash<long, SceneFileRecord> records;
+    QSet<long> dirtyNodes;
+    QSet<iris::Material*> dirtyMaterials;
+
+    // nodes written by the current save
+    QSet<long> savedNodes;
+
+    // bumped by every change so saves can tell if there's anything new
+    quint32 revision = 0;
+
+public:
+    void markDirty(iris::SceneNodePtr node);
+    void markDirty(iris::MaterialPtr material);
+
+    // for the scene's settings, they arent kept in a record
+    void markChanged();
+
+    quint32 getRevision()
+    {
+        return revision;
+    }
+
+    // returns false if there's no record or the node changed since it was made
+    bool findRecord(iris::SceneNodePtr node, SceneFileRecord& record);
+    void insertRecord(iris::SceneNodePtr node, const SceneFileRecord& record);
+
+    void beginSave();
+    // drops the records of nodes that werent in the saved scene
+    void endSave();
+
+    void clear();
+};
+
+class SceneFileReader
+{
+    friend class SceneFile;
+
+    QDataStream stream;
+    QVector<QString> strings;
+    quint32 version;
+
+public:
+    SceneFileReader(const QByteArray& blob);
+
+    /**
+     * Reads the header and string table
+     * Returns false if the blob isnt a scene file or was saved by a newer version
+     */
+    bool readHeader();
+
+    quint32 getVersion()
+    {
+        return version;
+    }
+
+    QDataStream& data()
+    {
+        return stream;
+    }
+
+    // false once the data runs out or a string index is out of range
+    bool isValid()
+    {
+        return stream.status() == QDataStream::Ok;
+    }
+
+    QString readString();
+    QVariant readValue();
+    QColor readColor();
+    QVector3D readVector3();
+    void readKeys(SceneFileKeys& keys);
+};
+
+#endif // SCENEFILE_H
@@ -13,6 +13,7 @@ For more information see the LICENSE file
 #include "assetiobase.h"
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonValue>
@@ -21,7 +22,9 @@ For more information see the LICENSE file
 
 #include "materialreader.hpp"
 #include "scenereader.h"
+#include "scenefile.h"
 #include "assetmanager.h"
+#include "assethelper.h"
 
 #include "../globals.h"
 #include "../constants.h"
@@ -33,6 +36,11 @@ For more information see the LICENSE file
 #include "../irisgl/src/scenegraph/scene.h"
 #include "../irisgl/src/scenegraph/scenenode.h"
 #include "../irisgl/src/core/irisutils.h"
+#include "../irisgl/src/core/logger.h"
+#include "../irisgl/src/core/performancetimer.h"
+#include "../irisgl/src/core/meshmanager.h"
+#include "../irisgl/src/content/meshfile.h"
+#include "../irisgl/src/content/assetloader.h"
 #include "../irisgl/src/scenegraph/meshnode.h"
 #include "../irisgl/src/scenegraph/cameranode.h"
 #include "../irisgl/src/scenegraph/viewernode.h"
@@ -45,6 +53,7 @@ For more information see the LICENSE file
 #include "../irisgl/src/graphics/graphicshelper.h"
 #include "../irisgl/src/graphics/mesh.h"
 #include "../irisgl/src/animation/animation.h"
+#include "../irisgl/src/animation/bakedanimation.h"
 #include "../irisgl/src/animation/keyframeanimation.h"
 #include "../irisgl/src/animation/keyframeset.h"
 #include "../irisgl/src/animation/propertyanim.h"
@@ -64,14 +73,38 @@ iris::ScenePtr SceneReader::readScene(const QString &projectPath,
                                       iris::PostProcessManagerPtr postMan,
                                       EditorData **editorData)
 {
+    IRIS_PROFILE("read scene");
     dir = projectPath;
-    auto doc = QJsonDocument::fromBinaryData(sceneBlob);
-    auto projectObj = doc.object();
 
-    auto scene = readScene(projectObj);
+    iris::ScenePtr scene;
 
-    if (editorData) *editorData = readEditorData(projectObj);
-    readPostProcessData(projectObj, postMan);
+    if (SceneFile::isSceneFile(sceneBlob)) {
+        SceneFileReader file(sceneBlob);
+        if (!file.readHeader()) {
+            irisLog("The scene was saved by a newer version and can't be read!");
+            return iris::Scene::create();
+        }
+
+        scene = readScene(file);
+
+        // read either way since the post processes come after it
+        auto editor = readEditorData(file);
+        if (editorData) *editorData = editor;
+        else delete editor;
+
+        readPostProcessData(file, postMan);
+
+        if (!file.isValid()) irisLog("The scene blob is incomplete, some of the scene wasn't read!");
+    } else {
+        // saved before SceneFile, it's written as one when the scene is next saved
+        auto doc = QJsonDocument::fromBinaryData(sceneBlob);
+        auto projectObj = doc.object();
+
+        scene = readScene(projectObj);
+
+        if (editorData) *editorData = readEditorData(projectObj);
+        readPostProcessData(projectObj, postMan);
+    }
 
     for (auto node : scene->rootNode->children) {
         node->applyDefaultPose();
@@ -113,22 +146,7 @@ void SceneReader::readPostProcessData(QJsonObject &projectObj, iris::PostProcess
             auto processObj = processVal.toObject();
             auto name = processObj["name"].toString("");
 
-            iris::PostProcessPtr process;
-
-            if(name == "bloom")
-               process = iris::BloomPostProcess::create();
-            if(name == "color_overlay")
-               process = iris::ColorOverlayPostProcess::create();
-            //if(name == "greyscale")
-            //   process = iris::GreyscalePostProcess::create();
-            if(name == "radial_blur")
-               process = iris::RadialBlurPostProcess::create();
-            if(name == "ssao")
-               process = iris::SSAOPostProcess::create();
-            if(name == "fxaa")
-               process = iris::FxaaPostProcess::create();
-            //if(name == "material")
-            //   process = iris::MaterialPostProcess::create();
+            auto process = createPostProcess(name);
 
             if (!!process) {
                 auto propertyObj = processObj["properties"].toObject();
@@ -148,6 +166,28 @@ void SceneReader::readPostProcessData(QJsonObject &projectObj, iris::PostProcess
     }
 }
 
+iris::PostProcessPtr SceneReader::createPostProcess(const QString &name)
+{
+    iris::PostProcessPtr process;
+
+    if(name == "bloom")
+       process = iris::BloomPostProcess::create();
+    if(name == "color_overlay")
+       process = iris::ColorOverlayPostProcess::create();
+    //if(name == "greyscale")
+    //   process = iris::GreyscalePostProcess::create();
+    if(name == "radial_blur")
+       process = iris::RadialBlurPostProcess::create();
+    if(name == "ssao")
+       process = iris::SSAOPostProcess::create();
+    if(name == "fxaa")
+       process = iris::FxaaPostProcess::create();
+    //if(name == "material")
+    //   process = iris::MaterialPostProcess::create();
+
+    return process;
+}
+
 iris::ScenePtr SceneReader::readScene(QJsonObject& projectObj)
 {
     auto scene = iris::Scene::create();
@@ -158,46 +198,16 @@ iris::ScenePtr SceneReader::readScene(QJsonObject& projectObj)
     //read properties
     auto skyBox = sceneObj["skyBox"].toObject();
 
-    auto front = !skyBox["front"].toString("").isEmpty()
-            ? getAbsolutePath(skyBox["front"].toString())
-            : QString();
-    auto back = !skyBox["back"].toString("").isEmpty()
-            ? getAbsolutePath(skyBox["back"].toString())
-            : QString();
-    auto top = !skyBox["top"].toString("").isEmpty()
-            ? getAbsolutePath(skyBox["top"].toString())
-            : QString();
-    auto bottom = !skyBox["bottom"].toString("").isEmpty()
-            ? getAbsolutePath(skyBox["bottom"].toString())
-            : QString();
-    auto left = !skyBox["left"].toString("").isEmpty()
-            ? getAbsolutePath(skyBox["left"].toString())
-            : QString();
-    auto right = !skyBox["right"].toString("").isEmpty()
-            ? getAbsolutePath(skyBox["right"].toString())
-            : QString();
-
-    QString sides[6] = {front, back, top, bottom, left, right};
+    QString sides[6] = {
+        skyBox["front"].toString(""),
+        skyBox["back"].toString(""),
+        skyBox["top"].toString(""),
+        skyBox["bottom"].toString(""),
+        skyBox["left"].toString(""),
+        skyBox["right"].toString("")
+    };
 
-    QImage *info;
-    bool useTex = false;
-    for (int i = 0; i < 6; i++) {
-        if (!sides[i].isEmpty()) {
-            info = new QImage(sides[i]);
-            useTex = true;
-            break;
-        }
-    }
-
-    if (useTex) {
-        scene->skyBoxTextures[0] = front;
-        scene->skyBoxTextures[1] = back;
-        scene->skyBoxTextures[2] = top;
-        scene->skyBoxTextures[3] = bottom;
-        scene->skyBoxTextures[4] = left;
-        scene->skyBoxTextures[5] = right;
-        scene->setSkyTexture(iris::Texture2D::createCubeMap(front, back, top, bottom, left, right, info));
-    }
+    setSkyBox(scene, sides);
 
     scene->setSkyColor(this->readColor(sceneObj["skyColor"].toObject()));
     scene->setAmbientColor(this->readColor(sceneObj["ambientColor"].toObject()));
@@ -218,9 +228,375 @@ iris::ScenePtr SceneReader::readScene(QJsonObject& projectObj)
         scene->getRootNode()->addChild(childNode);
     }
 
+    loadPendingModels();
+
+    return scene;
+}
+
+void SceneReader::setSkyBox(iris::ScenePtr scene, QString sides[6])
+{
+    for (int i = 0; i < 6; i++) {
+        if (!sides[i].isEmpty()) sides[i] = getAbsolutePath(sides[i]);
+    }
+
+    QImage *info;
+    bool useTex = false;
+    for (int i = 0; i < 6; i++) {
+        if (!sides[i].isEmpty()) {
+            info = new QImage(sides[i]);
+            useTex = true;
+            break;
+        }
+    }
+
+    if (useTex) {
+        for (int i = 0; i < 6; i++) scene->skyBoxTextures[i] = sides[i];
+        scene->setSkyTexture(iris::Texture2D::createCubeMap(sides[0], sides[1], sides[2],
+                                                            sides[3], sides[4], sides[5], info));
+    }
+}
+
+iris::ScenePtr SceneReader::readScene(SceneFileReader &file)
+{
+    auto scene = iris::Scene::create();
+    auto& stream = file.data();
+
+    QString sides[6];
+    for (int i = 0; i < 6; i++) sides[i] = file.readString();
+    setSkyBox(scene, sides);
+
+    scene->setSkyColor(file.readColor());
+    scene->setAmbientColor(file.readColor());
+    scene->fogColor = file.readColor();
+    stream >> scene->fogStart >> scene->fogEnd >> scene->fogEnabled >> scene->shadowEnabled;
+
+    quint32 nodeCount = 0;
+    stream >> nodeCount;
+
+    // parents are always stored before their children
+    QVector<iris::SceneNodePtr> nodes;
+    for (quint32 i = 0; i < nodeCount && file.isValid(); i++) {
+        qint32 parent = -1;
+        auto node = readSceneNode(file, parent);
+        if (!file.isValid()) break;
+
+        if (parent >= 0 && parent < nodes.size()) {
+            nodes[parent]->addChild(node, false);
+        } else {
+            scene->getRootNode()->addChild(node);
+        }
+
+        nodes.append(node);
+    }
+
+    loadPendingModels();
+
     return scene;
 }
 
+EditorData* SceneReader::readEditorData(SceneFileReader &file)
+{
+    auto& stream = file.data();
+
+    bool hasEditorData = false;
+    stream >> hasEditorData;
+    if (!hasEditorData) return nullptr;
+
+    auto camera = iris::CameraNode::create();
+    stream >> camera->angle >> camera->nearClip >> camera->farClip;
+    camera->setLocalPos(file.readVector3());
+    camera->setLocalRot(QQuaternion::fromEulerAngles(file.readVector3()));
+
+    auto editorData = new EditorData();
+    editorData->editorCamera = camera;
+    stream >> editorData->distFromPivot >> editorData->showLightWires;
+
+    return editorData;
+}
+
+void SceneReader::readPostProcessData(SceneFileReader &file, iris::PostProcessManagerPtr postMan)
+{
+    auto& stream = file.data();
+
+    quint32 processCount = 0;
+    stream >> processCount;
+
+    for (quint32 i = 0; i < processCount && file.isValid(); i++) {
+        auto process = createPostProcess(file.readString());
+
+        quint32 propCount = 0;
+        stream >> propCount;
+
+        QHash<QString, QVariant> values;
+        for (quint32 p = 0; p < propCount && file.isValid(); p++) {
+            auto name = file.readString();
+            values.insert(name, file.readValue());
+        }
+
+        if (!!process) {
+            for (auto prop : process->getProperties()) {
+                if (values.contains(prop->name)) {
+                    prop->setValue(values[prop->name]);
+                    process->setProperty(prop);
+                }
+            }
+        }
+
+        postMan->addPostProcess(process);
+    }
+}
+
+iris::SceneNodePtr SceneReader::readSceneNode(SceneFileReader &file, qint32 &parent)
+{
+    auto& stream = file.data();
+
+    quint8 nodeType = 0;
+    stream >> parent >> nodeType;
+
+    auto name = file.readString();
+    bool attached = false, visible = true;
+    stream >> attached >> visible;
+
+    auto pos = file.readVector3();
+    auto rot = file.readVector3();
+    auto scale = file.readVector3();
+
+    iris::SceneNodePtr sceneNode;
+    switch ((iris::SceneNodeType)nodeType) {
+        case iris::SceneNodeType::Mesh:
+            sceneNode = createMesh(file).staticCast<iris::SceneNode>();
+        break;
+        case iris::SceneNodeType::Light:
+            sceneNode = createLight(file).staticCast<iris::SceneNode>();
+        break;
+        case iris::SceneNodeType::Viewer:
+            sceneNode = createViewer(file).staticCast<iris::SceneNode>();
+        break;
+        case iris::SceneNodeType::ParticleSystem:
+            sceneNode = createParticleSystem(file).staticCast<iris::SceneNode>();
+        break;
+        default:
+            sceneNode = iris::SceneNode::create();
+        break;
+    }
+
+    sceneNode->setLocalPos(pos);
+    sceneNode->setLocalRot(QQuaternion::fromEulerAngles(rot));
+    sceneNode->setLocalScale(scale);
+
+    readAnimationData(file, sceneNode);
+
+    sceneNode->name = name;
+    sceneNode->setAttached(attached);
+    sceneNode->setVisible(visible);
+
+    return sceneNode;
+}
+
+void SceneReader::readAnimationData(SceneFileReader &file, iris::SceneNodePtr sceneNode)
+{
+    auto& stream = file.data();
+
+    qint32 activeAnimIndex = -1;
+    quint32 animCount = 0;
+    stream >> activeAnimIndex >> animCount;
+
+    for (quint32 a = 0; a < animCount && file.isValid(); a++) {
+        auto animation = iris::Animation::create(file.readString());
+
+        float length = 0;
+        bool loop = false;
+        stream >> length >> loop;
+        animation->setLength(length);
+        animation->setLooping(loop);
+
+        quint32 propCount = 0;
+        stream >> propCount;
+
+        for (quint32 p = 0; p < propCount && file.isValid(); p++) {
+            auto name = file.readString();
+
+            quint8 keyFrameCount = 0;
+            stream >> keyFrameCount;
+
+            iris::PropertyAnim* propAnim;
+            if (keyFrameCount == 1)
+                propAnim = new iris::FloatPropertyAnim();
+            else if (keyFrameCount == 3)
+                propAnim = new iris::Vector3DPropertyAnim();
+            else
+                propAnim = new iris::ColorPropertyAnim();
+
+            propAnim->setName(name);
+            auto keyFrames = propAnim->getKeyFrames();
+
+            for (int k = 0; k < keyFrameCount; k++) {
+                // the keyframe names are set by the property anim
+                file.readString();
+
+                SceneFileKeys keys;
+                file.readKeys(keys);
+                if (k >= keyFrames.size()) continue;
+
+                auto keyFrame = keyFrames[k].keyFrame;
+                keyFrame->reserve(keys.times.size());
+
+                for (int i = 0; i < keys.times.size(); i++) {
+                    auto key = keyFrame->addKey(keys.values[i], keys.times[i]);
+                    key->leftSlope = keys.leftSlopes[i];
+                    key->rightSlope = keys.rightSlopes[i];
+
+                    int leftTangent, rightTangent, handleMode;
+                    SceneFileKeys::unpackFlags(keys.flags[i], leftTangent, rightTangent, handleMode);
+                    key->leftTangent = (iris::TangentType)leftTangent;
+                    key->rightTangent = (iris::TangentType)rightTangent;
+                    key->handleMode = (iris::HandleMode)handleMode;
+                }
+            }
+
+            animation->addPropertyAnim(propAnim);
+        }
+
+        bool hasSkeletalAnimation = false;
+        stream >> hasSkeletalAnimation;
+        if (hasSkeletalAnimation) {
+            auto source = file.readString();
+            auto name = file.readString();
+
+            // set once the model file is loaded
+            auto& model = pendingModels[getAbsolutePath(source)];
+            model.animationSource = source;
+            model.skeletalAnimations.append({sceneNode, animation, name});
+        }
+
+        bool baked = false;
+        stream >> baked;
+        if (baked) {
+            qint32 frameRate;
+            QByteArray data;
+            stream >> frameRate >> data;
+            animation->setFrameRate(frameRate);
+            animation->setBakedAnimation(iris::BakedAnimation::deserialize(data));
+        }
+
+        sceneNode->addAnimation(animation);
+    }
+
+    if (activeAnimIndex >= 0 && activeAnimIndex < sceneNode->getAnimations().size()) {
+        sceneNode->setAnimation(sceneNode->getAnimations()[activeAnimIndex]);
+    }
+}
+
+iris::MeshNodePtr SceneReader::createMesh(SceneFileReader &file)
+{
+    auto& stream = file.data();
+    auto meshNode = iris::MeshNode::create();
+
+    auto mesh = file.readString();
+    auto meshGUID = file.readString();
+
+    qint32 meshIndex = 0;
+    bool pickable = true;
+    quint8 faceCullingMode = 0;
+    stream >> meshIndex >> pickable >> faceCullingMode;
+
+    setMeshSource(meshNode, mesh, meshIndex);
+    meshNode->setGUID(meshGUID);
+    meshNode->setPickable(pickable);
+    meshNode->meshIndex = meshIndex;
+
+    meshNode->setMaterial(readMaterial(file));
+    meshNode->setFaceCullingMode((iris::FaceCullingMode)faceCullingMode);
+
+    meshNode->applyDefaultPose();
+
+    return meshNode;
+}
+
+iris::LightNodePtr SceneReader::createLight(SceneFileReader &file)
+{
+    auto& stream = file.data();
+    auto lightNode = iris::LightNode::create();
+
+    quint8 lightType = 0;
+    stream >> lightType >> lightNode->intensity >> lightNode->distance >> lightNode->spotCutOff;
+    lightNode->setLightType((iris::LightType)lightType);
+    lightNode->color = file.readColor();
+
+    quint8 shadowType = 0;
+    qint32 shadowSize = 1024, shadowCascades = 1;
+    auto shadowMap = lightNode->shadowMap;
+    stream >> shadowType >> shadowSize >> shadowMap->bias >> shadowCascades;
+    shadowMap->setResolution(qBound(512, (int)shadowSize, 4096));
+    shadowMap->shadowType = (iris::ShadowMapType)shadowType;
+    shadowMap->setCascadeCount(shadowCascades);
+
+    setLightIcon(lightNode);
+
+    return lightNode;
+}
+
+iris::ViewerNodePtr SceneReader::createViewer(SceneFileReader &file)
+{
+    auto viewerNode = iris::ViewerNode::create();
+
+    float viewScale = 1.0f;
+    file.data() >> viewScale;
+    viewerNode->setViewScale(viewScale);
+
+    return viewerNode;
+}
+
+iris::ParticleSystemNodePtr SceneReader::createParticleSystem(SceneFileReader &file)
+{
+    auto& stream = file.data();
+    auto particleNode = iris::ParticleSystemNode::create();
+
+    float pps, particleScale, gravity, lifeLength, speed;
+    bool dissipate, dissipateInv, randomRotation, blendMode;
+    stream >> pps >> particleScale >> dissipate >> dissipateInv >> gravity
+           >> randomRotation >> blendMode >> lifeLength >> speed;
+
+    particleNode->setPPS(pps);
+    particleNode->setParticleScale(particleScale);
+    particleNode->setDissipation(dissipate);
+    particleNode->setDissipationInv(dissipateInv);
+    particleNode->setRandomRotation(randomRotation);
+    particleNode->setGravity(gravity);
+    particleNode->setBlendMode(blendMode);
+    particleNode->setLife(lifeLength);
+    particleNode->setSpeed(speed);
+
+    auto texture = file.readString();
+    particleNode->setTexture(!texture.isEmpty()
+                             ? iris::AssetLoader::getSingleton()->loadTexture(getAbsolutePath(texture))
+                             : iris::Texture2D::null());
+
+    return particleNode;
+}
+
+iris::MaterialPtr SceneReader::readMaterial(SceneFileReader &file)
+{
+    auto name = file.readString();
+    auto shaderGuid = file.readString();
+    auto m = createMaterial(name, shaderGuid);
+
+    quint32 valueCount = 0;
+    file.data() >> valueCount;
+
+    QHash<QString, QVariant> values;
+    for (quint32 i = 0; i < valueCount && file.isValid(); i++) {
+        auto propName = file.readString();
+        values.insert(propName, file.readValue());
+    }
+
+    for (auto prop : m->properties) {
+        if (values.contains(prop->name)) setMaterialValue(m, prop, values[prop->name]);
+    }
+
+    return m;
+}
+
 /**
  * Creates scene node from json data
  * @param nodeObj
@@ -326,9 +702,18 @@ void SceneReader::readAnimationData(QJsonObject& nodeObj,iris::SceneNodePtr scen
 
         if (animObj.contains("skeletalAnimation")) {
             auto skelAnim = animObj["skeletalAnimation"].toObject();
+            auto source = skelAnim["source"].toString();
 
-            auto skel = this->getSkeletalAnimation(skelAnim["source"].toString(), skelAnim["name"].toString());
-            animation->setSkeletalAnimation(skel);
+            // set once the model file is loaded
+            auto& model = pendingModels[getAbsolutePath(source)];
+            model.animationSource = source;
+            model.skeletalAnimations.append({sceneNode, animation, skelAnim["name"].toString()});
+        }
+
+        if (animObj.contains("baked")) {
+            animation->setFrameRate(animObj["frameRate"].toInt(animation->getFrameRate()));
+            auto data = QByteArray::fromBase64(animObj["baked"].toString().toLatin1());
+            animation->setBakedAnimation(iris::BakedAnimation::deserialize(data));
         }
 
         sceneNode->addAnimation(animation);
@@ -374,34 +759,16 @@ iris::MeshNodePtr SceneReader::createMesh(QJsonObject& nodeObj)
 {
     auto meshNode = iris::MeshNode::create();
 
-	auto asset = handle->fetchAsset(nodeObj["mesh"].toString(""));
-
-    QString source = nodeObj["mesh"].toString("");
-	// Keep a special reference to embedded asset primitives for now
-	if (!source.startsWith(":")) {
-		source = IrisUtils::join(Globals::project->getProjectFolder(), asset.name);
-	}
-
     int meshIndex = nodeObj["meshIndex"].toInt(0);
     QString meshGUID = nodeObj["guid"].toString();
     bool pickable = nodeObj["pickable"].toBool(true);
 
-    if (!source.isEmpty()) {
-        auto mesh = getMesh(source, meshIndex);
-
-        if (source.startsWith(":")) {
-            meshNode->setMesh(source);
-			meshNode->meshPath = source;
-        } else {
-            meshNode->setMesh(mesh);
-			meshNode->meshPath = nodeObj["mesh"].toString();
-        }
+    setMeshSource(meshNode, nodeObj["mesh"].toString(""), meshIndex);
 
-        meshNode->setGUID(meshGUID);
-        meshNode->setPickable(pickable);
-		meshNode->setVisible(nodeObj["visible"].toBool(true));
-        meshNode->meshIndex = meshIndex;
-    }
+    meshNode->setGUID(meshGUID);
+    meshNode->setPickable(pickable);
+	meshNode->setVisible(nodeObj["visible"].toBool(true));
+    meshNode->meshIndex = meshIndex;
 
     auto material = readMaterial(nodeObj);
     meshNode->setMaterial(material);
@@ -424,6 +791,25 @@ iris::MeshNodePtr SceneReader::createMesh(QJsonObject& nodeObj)
     return meshNode;
 }
 
+void SceneReader::setMeshSource(iris::MeshNodePtr meshNode, const QString &mesh, int meshIndex)
+{
+	// Keep a special reference to embedded asset primitives for now
+    if (mesh.startsWith(":")) {
+        meshNode->setMesh(mesh);
+        meshNode->meshPath = mesh;
+        return;
+    }
+
+    auto asset = handle->fetchAsset(mesh);
+    auto source = IrisUtils::join(Globals::project->getProjectFolder(), asset.name);
+
+    // the mesh is set once the model file is loaded
+    auto& model = pendingModels[source];
+    model.assetGuid = asset.guid;
+    model.meshNodes.append(qMakePair(meshNode.toWeakRef(), meshIndex));
+    meshNode->meshPath = mesh;
+}
+
 iris::ShadowMapType evalShadowMapType(QString shadowType)
 {
     if (shadowType=="hard")
@@ -459,7 +845,15 @@ iris::LightNodePtr SceneReader::createLight(QJsonObject& nodeObj)
     auto res = qBound(512, nodeObj["shadowSize"].toInt(1024), 4096);
     shadowMap->setResolution(res);
     shadowMap->shadowType = evalShadowMapType(nodeObj["shadowType"].toString());
+    shadowMap->setCascadeCount(nodeObj["shadowCascades"].toInt(1));
+
+    setLightIcon(lightNode);
 
+    return lightNode;
+}
+
+void SceneReader::setLightIcon(iris::LightNodePtr lightNode)
+{
     //TODO: move this to the sceneview widget or somewhere more appropriate
     if (lightNode->lightType == iris::LightType::Directional) {
         lightNode->icon = iris::Texture2D::load(":/icons/light.png");
@@ -468,8 +862,6 @@ iris::LightNodePtr SceneReader::createLight(QJsonObject& nodeObj)
     }
 
     lightNode->iconSize = 0.5f;
-
-    return lightNode;
 }
 
 iris::ViewerNodePtr SceneReader::createViewer(QJsonObject& nodeObj)
@@ -495,7 +887,10 @@ iris::ParticleSystemNodePtr SceneReader::createParticleSystem(QJsonObject& nodeO
     particleNode->setLife((float) nodeObj["lifeLength"].toDouble(1.0f));
     particleNode->setName(nodeObj["name"].toString());
     particleNode->setSpeed((float) nodeObj["speed"].toDouble(1.0f));
-    particleNode->setTexture(iris::Texture2D::load(getAbsolutePath(nodeObj["texture"].toString())));
+    auto texture = nodeObj["texture"].toString();
+    particleNode->setTexture(!texture.isEmpty()
+                             ? iris::AssetLoader::getSingleton()->loadTexture(getAbsolutePath(texture))
+                             : iris::Texture2D::null());
 	particleNode->setVisible(nodeObj["visible"].toBool(true));
 
     return particleNode;
@@ -543,10 +938,20 @@ iris::MaterialPtr SceneReader::readMaterial(QJsonObject& nodeObj)
     if (nodeObj["material"].isNull()) return iris::CustomMaterial::create();
 
     auto mat = nodeObj["material"].toObject();
+    auto m = createMaterial(mat["name"].toString(), mat["guid"].toString());
+
+    for (auto prop : m->properties) {
+        if (mat.contains(prop->name)) setMaterialValue(m, prop, mat[prop->name].toVariant());
+    }
+
+    return m;
+}
+
+iris::CustomMaterialPtr SceneReader::createMaterial(const QString &name, const QString &shaderGuid)
+{
     auto m = iris::CustomMaterial::create();
-    auto shaderGuid = mat["guid"].toString();
 
-    m->setName(mat["name"].toString());
+    m->setName(name);
     m->setGuid(shaderGuid);
 
     QFileInfo shaderFile;
@@ -597,48 +1002,123 @@ iris::MaterialPtr SceneReader::readMaterial(QJsonObject& nodeObj)
   //      }
   //  }
 
-    for (auto prop : m->properties) {
-        if (mat.contains(prop->name)) {
-            if (prop->type == iris::PropertyType::Texture) {
-                //auto textureStr = !mat[prop->name].toString().isEmpty()
-                //                  ? getAbsolutePath(mat[prop->name].toString())
-                //                  : QString();
-				auto textureStr = !mat[prop->name].toString().isEmpty()
-					? QDir(Globals::project->getProjectFolder()).filePath(handle->fetchAsset(mat[prop->name].toString()).name)
-					: QString();
-
-                m->setValue(prop->name, textureStr);
-            } else {
-                m->setValue(prop->name, mat[prop->name].toVariant());
-            }
-        }
-    }
-
     return m;
 }
 
-void SceneReader::extractAssetsFromAssimpScene(QString filePath)
+void SceneReader::setMaterialValue(iris::CustomMaterialPtr m, iris::Property *prop, const QVariant &value)
+{
+    if (prop->type == iris::PropertyType::Texture) {
+        //auto textureStr = !value.toString().isEmpty()
+        //                  ? getAbsolutePath(value.toString())
+        //                  : QString();
+		auto textureStr = !value.toString().isEmpty()
+			? QDir(Globals::project->getProjectFolder()).filePath(handle->fetchAsset(value.toString()).name)
+			: QString();
+
+        m->setValue(prop->name, textureStr, true);
+    } else {
+        m->setValue(prop->name, value);
+    }
+}
+
+void SceneReader::extractAssetsFromAssimpScene(QString filePath, QString assetGuid)
 {
-    if (!assimpScenes.contains(filePath)) {
+    auto meshManager = iris::MeshManager::getSingleton();
+    if (!meshManager->contains(filePath)) {
         QList<iris::MeshPtr> meshList;
         QMap<QString, iris::SkeletalAnimationPtr> animationss;
-        iris::GraphicsHelper::loadAllMeshesAndAnimationsFromStore<Asset*>(AssetManager::getAssets(),
+        auto cachePath = !assetGuid.isEmpty() ? AssetHelper::getMeshCachePath(assetGuid) : QString();
+        loadModel(filePath, cachePath, AssetManager::getAssets(), meshList, animationss);
+
+        if (!meshList.isEmpty())
+            meshManager->addMeshes(filePath, meshList, animationss);
+    }
+}
+
+void SceneReader::loadModel(const QString& filePath,
+                            const QString& cachePath,
+                            const QVector<Asset*>& assets,
+                            QList<iris::MeshPtr>& meshes,
+                            QMap<QString, iris::SkeletalAnimationPtr>& animations)
+{
+    QByteArray sourceHash;
+    if (!cachePath.isEmpty()) {
+        sourceHash = IrisUtils::hashFile(filePath);
+        iris::MeshFile::load(cachePath, meshes, animations, sourceHash);
+    }
+
+    if (meshes.isEmpty()) {
+        iris::GraphicsHelper::loadAllMeshesAndAnimationsFromStore<Asset*>(assets,
                                                                           filePath,
-                                                                          meshList,
-                                                                          animationss);
+                                                                          meshes,
+                                                                          animations);
+        if (meshes.isEmpty())
+            iris::MeshManager::load(filePath, meshes, animations);
+
+        // convert it so it loads without an import next time
+        if (!cachePath.isEmpty() && !meshes.isEmpty()) {
+            QDir().mkpath(QFileInfo(cachePath).absolutePath());
+            iris::MeshFile::save(cachePath, meshes, animations, sourceHash);
+        }
+    }
+}
+
+void SceneReader::loadPendingModels()
+{
+    auto meshManager = iris::MeshManager::getSingleton();
+
+    for (auto iter = pendingModels.begin(); iter != pendingModels.end(); ++iter) {
+        auto filePath = iter.key();
+        auto model = iter.value();
+
+        // runs on the gui thread, nodes that were deleted in the meantime are skipped
+        auto onLoaded = [filePath, model]() {
+            auto meshManager = iris::MeshManager::getSingleton();
+
+            // null if the mesh was modified after the file was saved
+            for (auto& meshNode : model.meshNodes) {
+                auto node = meshNode.first.toStrongRef();
+                if (!!node)
+                    node->setMesh(meshManager->getMesh(filePath, meshNode.second));
+            }
+
+            if (model.skeletalAnimations.isEmpty())
+                return;
 
-		//iris::GraphicsHelper::loadAllMeshesAndAnimationsFromFile(filePath, meshList, animationss);
+            //reset relative paths for animations since they have the absolute path
+            auto animMap = meshManager->getSkeletalAnimations(filePath);
+            for (auto anim : animMap)
+                anim->source = model.animationSource;
 
-        meshes.insert(filePath,meshList);
-        assimpScenes.insert(filePath);
-        animations.insert(filePath, animationss);
+            for (auto& pending : model.skeletalAnimations) {
+                auto sceneNode = pending.sceneNode.toStrongRef();
+                auto animation = pending.animation.toStrongRef();
+                if (!sceneNode || !animation)
+                    continue;
 
-//        auto relPath = QDir(Globals::project->folderPath).relativeFilePath(filename);
-//        for(auto anim : node->getAnimations()) {
-//            if (!!anim->skeletalAnimation)
-//                anim->skeletalAnimation->source = relPath;
-//        }
+                animation->setSkeletalAnimation(animMap.value(pending.name));
+                sceneNode->applyDefaultPose();
+            }
+        };
+
+        if (meshManager->contains(filePath)) {
+            onLoaded();
+            continue;
+        }
+
+        // the worker only gets copies of what it needs, it never reads the asset store
+        auto cachePath = !model.assetGuid.isEmpty()
+                         ? AssetHelper::getMeshCachePath(model.assetGuid)
+                         : QString();
+        iris::AssetLoader::getSingleton()->loadMeshes(filePath, onLoaded,
+            [filePath, cachePath](QList<iris::MeshPtr>& meshes,
+                                  QMap<QString, iris::SkeletalAnimationPtr>& animations)
+        {
+            loadModel(filePath, cachePath, QVector<Asset*>(), meshes, animations);
+        });
     }
+
+    pendingModels.clear();
 }
 
 /**
@@ -646,18 +1126,15 @@ void SceneReader::extractAssetsFromAssimpScene(QString filePath)
  * if the mesh doesnt exist, nullptr is returned
  * @param filePath
  * @param index
+ * @param assetGuid
  * @return
  */
-iris::MeshPtr SceneReader::getMesh(QString filePath, int index)
+iris::MeshPtr SceneReader::getMesh(QString filePath, int index, QString assetGuid)
 {
-    extractAssetsFromAssimpScene(filePath);
-
-    // if the mesh is already in the hashmap then it was already loaded, just return the indexed mesh=
-    auto meshList = meshes[filePath];
-    if (index < meshList.size()) return meshList[index];
+    extractAssetsFromAssimpScene(filePath, assetGuid);
 
-    // maybe the mesh was modified after the file was saved
-    return iris::MeshPtr();
+    // null if the mesh was modified after the file was saved
+    return iris::MeshManager::getSingleton()->getMesh(filePath, index);
 }
 
 iris::SkeletalAnimationPtr SceneReader::getSkeletalAnimation(QString filePath, QString animName)
@@ -666,7 +1143,7 @@ iris::SkeletalAnimationPtr SceneReader::getSkeletalAnimation(QString filePath, Q
     filePath = this->getAbsolutePath(filePath);
     extractAssetsFromAssimpScene(filePath);
 
-    auto animMap = animations[filePath];
+    auto animMap = iris::MeshManager::getSingleton()->getSkeletalAnimations(filePath);
 
     //reset relative paths for animations since they have the absolute path
     for(auto anim : animMap)
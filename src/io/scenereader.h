@@ -22,6 +22,7 @@ For more information see the LICENSE file
 #include <QJsonValueRef>
 #include <QJsonDocument>
 #include <QMap>
+#include <QVector>
 
 #include "../irisgl/src/irisglfwd.h"
 #include "../irisgl/src/scenegraph/scenenode.h"
@@ -29,23 +30,46 @@ For more information see the LICENSE file
 #include "../irisgl/src/animation/keyframeanimation.h"
 
 class EditorData;
+class SceneFileReader;
+struct Asset;
 class aiScene;
 
 class Database;	// this is a temp way to get this working, remove later
 
 class SceneReader : public AssetIOBase
 {
-    QHash<QString,QList<iris::MeshPtr>> meshes;
-    QSet<QString> assimpScenes;
-    QHash<QString,QMap<QString, iris::SkeletalAnimationPtr>> animations;
-
 	Database *handle;
+
+    // model files used by the scene, they're loaded in the background once
+    // the scene is read and given to the nodes that use them when ready
+    // nodes are weak so loads finishing after the scene is closed dont keep it alive
+    struct PendingSkeletalAnimation
+    {
+        QWeakPointer<iris::SceneNode> sceneNode;
+        QWeakPointer<iris::Animation> animation;
+        QString name;
+    };
+
+    struct PendingModel
+    {
+        QString assetGuid;
+        QString animationSource;
+        QList<QPair<QWeakPointer<iris::MeshNode>, int>> meshNodes;
+        QList<PendingSkeletalAnimation> skeletalAnimations;
+    };
+
+    QMap<QString, PendingModel> pendingModels;
+
 public:
 	void setDatabaseHandle(Database *db) {
 		this->handle = db;
 	}
 
 public:
+    /**
+     * Reads a scene blob from the projects table
+     * Both SceneFile blobs and the json blobs saved before them are read
+     */
     iris::ScenePtr readScene(const QString &projectPath,
                              const QByteArray &sceneBlob,
                              iris::PostProcessManagerPtr postMan,
@@ -54,6 +78,25 @@ public:
     EditorData* readEditorData(QJsonObject &projectObj);
     void readPostProcessData(QJsonObject &projectObj, iris::PostProcessManagerPtr postMan);
 
+    // the same for SceneFile blobs, each reads its part of the file in order
+    iris::ScenePtr readScene(SceneFileReader &file);
+    EditorData* readEditorData(SceneFileReader &file);
+    void readPostProcessData(SceneFileReader &file, iris::PostProcessManagerPtr postMan);
+
+    /**
+     * Creates scene node from the next node in the file
+     * @param file
+     * @param parent index of the node's parent, -1 if it's a child of the root node
+     * @return
+     */
+    iris::SceneNodePtr readSceneNode(SceneFileReader &file, qint32 &parent);
+    void readAnimationData(SceneFileReader &file, iris::SceneNodePtr sceneNode);
+    iris::MeshNodePtr createMesh(SceneFileReader &file);
+    iris::LightNodePtr createLight(SceneFileReader &file);
+    iris::ViewerNodePtr createViewer(SceneFileReader &file);
+    iris::ParticleSystemNodePtr createParticleSystem(SceneFileReader &file);
+    iris::MaterialPtr readMaterial(SceneFileReader &file);
+
     /**
      * Creates scene node from json data
      * @param nodeObj
@@ -101,19 +144,58 @@ public:
      */
     iris::MaterialPtr readMaterial(QJsonObject &nodeObj);
 
-    // extracts meshes and animations from model file
-    void extractAssetsFromAssimpScene(QString filePath);
+    /**
+     * Extracts meshes and animations from model file
+     * If the model's asset guid is given, they're loaded from the model's
+     * converted mesh file instead, which is created if it's missing or stale
+     */
+    void extractAssetsFromAssimpScene(QString filePath, QString assetGuid = QString());
 
     /**
      * Returns mesh from mesh file at index
      * if the mesh doesnt exist, nullptr is returned
      * @param filePath
      * @param index
+     * @param assetGuid
      * @return
      */
-    iris::MeshPtr getMesh(QString filePath, int index);
+    iris::MeshPtr getMesh(QString filePath, int index, QString assetGuid = QString());
 
     iris::SkeletalAnimationPtr getSkeletalAnimation(QString filePath, QString animName);
+
+private:
+    // sides are relative to the project folder
+    void setSkyBox(iris::ScenePtr scene, QString sides[6]);
+
+    // gives the node its mesh or queues the model file it's in
+    void setMeshSource(iris::MeshNodePtr meshNode, const QString &mesh, int meshIndex);
+
+    // material using the built in or custom shader with the guid
+    iris::CustomMaterialPtr createMaterial(const QString &name, const QString &shaderGuid);
+
+    // textures are stored as asset guids
+    void setMaterialValue(iris::CustomMaterialPtr material, iris::Property *prop, const QVariant &value);
+
+    void setLightIcon(iris::LightNodePtr lightNode);
+    iris::PostProcessPtr createPostProcess(const QString &name);
+
+    /**
+     * Starts loading the model files collected while reading the scene
+     * Files that are already loaded are given to their nodes right away
+     */
+    void loadPendingModels();
+
+    /**
+     * Loads a model file's meshes and animations from its mesh cache at cachePath,
+     * writing the cache if it's missing or stale
+     * Scenes already imported into the asset store are reused, the store belongs
+     * to the gui thread so loader threads pass no assets and import the file instead
+     */
+    static void loadModel(const QString& filePath,
+                          const QString& cachePath,
+                          const QVector<Asset*>& assets,
+                          QList<iris::MeshPtr>& meshes,
+                          QMap<QString, iris::SkeletalAnimationPtr>& animations);
 };
 
 #endif // SCENEREADER_H
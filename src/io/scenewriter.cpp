@@ -30,14 +30,17 @@ For more information see the LICENSE file
 #include "../irisgl/src/materials/custommaterial.h"
 #include "../irisgl/src/core/property.h"
 #include "../irisgl/src/animation/animation.h"
+#include "../irisgl/src/animation/bakedanimation.h"
 #include "../irisgl/src/animation/keyframeanimation.h"
 #include "../irisgl/src/animation/keyframeset.h"
 #include "../irisgl/src/animation/propertyanim.h"
 #include "../irisgl/src/animation/skeletalanimation.h"
 #include "../irisgl/src/graphics/postprocess.h"
 #include "../irisgl/src/graphics/postprocessmanager.h"
+#include "../irisgl/src/core/performancetimer.h"
 
 #include "scenewriter.h"
+#include "scenefile.h"
 #include "assetiobase.h"
 #include "../constants.h"
 #include "../core/database/database.h"
@@ -73,23 +76,249 @@ QByteArray SceneWriter::getSceneObject(QString projectPath,
                                        iris::PostProcessManagerPtr postMan,
                                        EditorData *editorData)
 {
+    return SceneFile::assemble(getSceneParts(projectPath, scene, postMan, editorData));
+}
+
+SceneFileParts SceneWriter::getSceneParts(QString projectPath,
+                                          iris::ScenePtr scene,
+                                          iris::PostProcessManagerPtr postMan,
+                                          EditorData *editorData)
+{
+    IRIS_PROFILE("write scene");
     dir = projectPath;
-    QJsonObject projectObj;
-    projectObj["version"] = Constants::CONTENT_VERSION;
 
-    writeScene(projectObj, scene);
+    // no json is built, the records are assembled into a blob by SceneFile::assemble()
+    SceneFileParts parts;
 
-    if (editorData != nullptr) {
-        writeEditorData(projectObj, editorData);
+    SceneFileWriter settings(true);
+    writeSceneFileSettings(settings, scene);
+    parts.settings = settings.toRecord();
+
+    if (cache != nullptr)
+        cache->beginSave();
+
+    for (auto child : scene->getRootNode()->children)
+        writeSceneFileNode(parts, child, -1);
+
+    if (cache != nullptr)
+        cache->endSave();
+
+    SceneFileWriter trailer(true);
+    writeSceneFileEditorData(trailer, editorData);
+    writeSceneFilePostProcesses(trailer, postMan);
+    parts.trailer = trailer.toRecord();
+
+    return parts;
+}
+
+void SceneWriter::writeSceneFileSettings(SceneFileWriter& file, iris::ScenePtr scene)
+{
+    auto& stream = file.data();
+
+    for (int i = 0; i < 6; i++)
+        file.writeString(getRelativePath(scene->skyBoxTextures[i]));
+
+    file.writeColor(scene->skyColor);
+    file.writeColor(scene->ambientColor);
+    file.writeColor(scene->fogColor);
+    stream << scene->fogStart << scene->fogEnd << scene->fogEnabled << scene->shadowEnabled;
+}
+
+void SceneWriter::writeSceneFileNode(SceneFileParts& parts, iris::SceneNodePtr sceneNode, int parent)
+{
+    int nodeIndex = parts.nodes.size();
+
+    SceneFileRecord record;
+    if (cache == nullptr || !cache->findRecord(sceneNode, record)) {
+        SceneFileWriter recordFile(true);
+        writeSceneFileNodeData(recordFile, sceneNode);
+        record = recordFile.toRecord();
+
+        if (cache != nullptr)
+            cache->insertRecord(sceneNode, record);
     }
 
-    if (!!postMan) {
-        writePostProcessData(projectObj, postMan);
+    // the parent index changes when nodes are added or moved so it's never cached
+    parts.nodes.append(qMakePair((qint32)parent, record));
+
+    for (auto child : sceneNode->children)
+        writeSceneFileNode(parts, child, nodeIndex);
+}
+
+void SceneWriter::writeSceneFileNodeData(SceneFileWriter& file, iris::SceneNodePtr sceneNode)
+{
+    auto& stream = file.data();
+
+    stream << (quint8)sceneNode->sceneNodeType;
+    file.writeString(sceneNode->getName());
+    stream << sceneNode->isAttached() << sceneNode->isVisible();
+    file.writeVector3(sceneNode->getLocalPos());
+    file.writeVector3(sceneNode->getLocalRot().toEulerAngles());
+    file.writeVector3(sceneNode->getLocalScale());
+
+    switch (sceneNode->sceneNodeType) {
+        case iris::SceneNodeType::Mesh: {
+            auto meshNode = sceneNode.staticCast<iris::MeshNode>();
+            file.writeString(meshNode->meshPath);
+            file.writeString(meshNode->getGUID());
+            stream << (qint32)meshNode->meshIndex
+                   << meshNode->pickable
+                   << (quint8)meshNode->getFaceCullingMode();
+
+            auto mat = meshNode->getMaterial().staticCast<iris::CustomMaterial>();
+            file.writeString(mat->getName());
+            file.writeString(mat->getGuid());
+
+            int valueCount = 0;
+            for (auto prop : mat->properties) {
+                if (prop->type == iris::PropertyType::Bool  || prop->type == iris::PropertyType::Float ||
+                    prop->type == iris::PropertyType::Color || prop->type == iris::PropertyType::Texture)
+                    valueCount++;
+            }
+
+            stream << (quint32)valueCount;
+            for (auto prop : mat->properties) {
+                if (prop->type == iris::PropertyType::Bool  || prop->type == iris::PropertyType::Float ||
+                    prop->type == iris::PropertyType::Color) {
+                    file.writeString(prop->name);
+                    file.writeValue(prop->getValue());
+                }
+
+                if (prop->type == iris::PropertyType::Texture) {
+                    file.writeString(prop->name);
+                    file.writeValue(handle->fetchAssetGUIDByName(QFileInfo(prop->getValue().toString()).fileName()));
+                }
+            }
+        }
+        break;
+        case iris::SceneNodeType::Light: {
+            auto lightNode = sceneNode.staticCast<iris::LightNode>();
+            stream << (quint8)lightNode->lightType
+                   << lightNode->intensity
+                   << lightNode->distance
+                   << lightNode->spotCutOff;
+            file.writeColor(lightNode->color);
+
+            auto shadowMap = lightNode->shadowMap;
+            stream << (quint8)shadowMap->shadowType
+                   << (qint32)shadowMap->resolution
+                   << shadowMap->bias
+                   << (qint32)shadowMap->cascadeCount;
+        }
+        break;
+        case iris::SceneNodeType::Viewer:
+            stream << sceneNode.staticCast<iris::ViewerNode>()->getViewScale();
+        break;
+        case iris::SceneNodeType::ParticleSystem: {
+            auto node = sceneNode.staticCast<iris::ParticleSystemNode>();
+            stream << node->particlesPerSecond
+                   << node->particleScale
+                   << node->dissipate
+                   << node->dissipateInv
+                   << node->gravityComplement
+                   << node->randomRotation
+                   << node->useAdditive
+                   << node->lifeLength
+                   << node->speed;
+            file.writeString(getRelativePath(node->texture->getSource()));
+        }
+        break;
+        default: break;
+    }
+
+    writeSceneFileAnimations(file, sceneNode);
+}
+
+void SceneWriter::writeSceneFileAnimations(SceneFileWriter& file, iris::SceneNodePtr sceneNode)
+{
+    auto& stream = file.data();
+    auto animations = sceneNode->getAnimations();
+    auto activeAnim = sceneNode->getAnimation();
+
+    stream << (qint32)(!!activeAnim ? animations.indexOf(activeAnim) : -1) << (quint32)animations.size();
+    for (auto anim : animations) {
+        file.writeString(anim->getName());
+        stream << anim->getLength() << anim->getLooping();
+
+        stream << (quint32)anim->properties.size();
+        for (auto propName : anim->properties.keys()) {
+            auto keyFrames = anim->properties[propName]->getKeyFrames();
+            file.writeString(propName);
+            stream << (quint8)keyFrames.size();
+
+            for (auto animInfo : keyFrames) {
+                file.writeString(animInfo.name);
+
+                SceneFileKeys keys;
+                auto keyCount = animInfo.keyFrame->keys.size();
+                keys.times.reserve(keyCount);
+                keys.values.reserve(keyCount);
+                keys.leftSlopes.reserve(keyCount);
+                keys.rightSlopes.reserve(keyCount);
+                keys.flags.reserve(keyCount);
+
+                for (auto key : animInfo.keyFrame->keys) {
+                    keys.times.append(key->time);
+                    keys.values.append(key->value);
+                    keys.leftSlopes.append(key->leftSlope);
+                    keys.rightSlopes.append(key->rightSlope);
+                    keys.flags.append(SceneFileKeys::packFlags((int)key->leftTangent,
+                                                               (int)key->rightTangent,
+                                                               (int)key->handleMode));
+                }
+                file.writeKeys(keys);
+            }
+        }
+
+        stream << anim->hasSkeletalAnimation();
+        if (anim->hasSkeletalAnimation()) {
+            auto skelAnim = anim->getSkeletalAnimation();
+            file.writeString(skelAnim->source);
+            file.writeString(skelAnim->name);
+        }
+
+        stream << anim->isBaked();
+        if (anim->isBaked())
+            stream << (qint32)anim->getFrameRate() << anim->getBakedAnimation()->serialize();
+    }
+}
+
+void SceneWriter::writeSceneFileEditorData(SceneFileWriter& file, EditorData* editorData)
+{
+    auto& stream = file.data();
+
+    stream << (editorData != nullptr);
+    if (editorData == nullptr)
+        return;
+
+    auto cam = editorData->editorCamera;
+    stream << cam->angle << cam->nearClip << cam->farClip;
+    file.writeVector3(cam->getLocalPos());
+    file.writeVector3(cam->getLocalRot().toEulerAngles());
+    stream << editorData->distFromPivot << editorData->showLightWires;
+}
+
+void SceneWriter::writeSceneFilePostProcesses(SceneFileWriter& file, iris::PostProcessManagerPtr postMan)
+{
+    auto& stream = file.data();
+
+    if (!postMan) {
+        stream << (quint32)0;
+        return;
     }
 
-    //qDebug() << projectObj;
+    auto processes = postMan->getPostProcesses();
+    stream << (quint32)processes.size();
+    for (auto process : processes) {
+        file.writeString(process->getName());
 
-    return QJsonDocument(projectObj).toBinaryData();
+        auto props = process->getProperties();
+        stream << (quint32)props.size();
+        for (auto prop : props) {
+            file.writeString(prop->name);
+            file.writeValue(prop->getValue());
+        }
+    }
 }
 
 void SceneWriter::writeScene(QJsonObject& projectObj, iris::ScenePtr scene)
@@ -289,6 +518,11 @@ void SceneWriter::writeAnimationData(QJsonObject& sceneNodeObj,iris::SceneNodePt
             animObj["skeletalAnimation"] = skelObj;
         }
 
+        if (anim->isBaked()) {
+            animObj["frameRate"] = anim->getFrameRate();
+            animObj["baked"] = QString::fromLatin1(anim->getBakedAnimation()->serialize().toBase64());
+        }
+
         animListObj.append(animObj);
     }
 
@@ -422,6 +656,7 @@ void SceneWriter::writeLightData(QJsonObject& sceneNodeObject,iris::LightNodePtr
     sceneNodeObject["shadowType"] = evalShadowTypeName(shadowMap->shadowType);
     sceneNodeObject["shadowSize"] = shadowMap->resolution;
     sceneNodeObject["shadowBias"] = shadowMap->bias;
+    sceneNodeObject["shadowCascades"] = shadowMap->cascadeCount;
 	sceneNodeObject["visible"] = lightNode->isVisible();
 }
 
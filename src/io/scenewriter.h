@@ -25,21 +25,36 @@ For more information see the LICENSE file
 #include "../irisgl/src/irisglfwd.h"
 
 class EditorData;
+class SceneFileWriter;
+class SceneFileCache;
+struct SceneFileParts;
 class Database;	// this is a temp way to get this working, remove later
 
 class SceneWriter : public AssetIOBase
 {
 	static Database *handle;
+    SceneFileCache *cache = nullptr;
 public:
 	void setDatabaseHandle(Database *db) {
 		this->handle = db;
 	}
+
+    // nodes with records in the cache are copied from it instead of being written again
+    void setCache(SceneFileCache *cache) {
+        this->cache = cache;
+    }
     void writeScene(QString filePath,iris::ScenePtr scene, iris::PostProcessManagerPtr postMan, EditorData* ediorData = nullptr);
     QByteArray getSceneObject(QString projectPath,
                               iris::ScenePtr scene,
                               iris::PostProcessManagerPtr postMan,
                               EditorData *editorData);
 
+    // the scene as records, nodes are taken from the cache when it has them
+    SceneFileParts getSceneParts(QString projectPath,
+                                 iris::ScenePtr scene,
+                                 iris::PostProcessManagerPtr postMan,
+                                 EditorData *editorData);
+
 public:
     void writeScene(QJsonObject& projectObj, iris::ScenePtr scene);
     void writePostProcessData(QJsonObject& projectObj, iris::PostProcessManagerPtr postMan);
@@ -60,6 +75,15 @@ public:
 	static QString getLightNodeTypeName(iris::LightType lightType);
 	static QString getKeyTangentTypeName(iris::TangentType tangentType);
 	static QString getKeyHandleModeName(iris::HandleMode handleMode);
+
+private:
+    // binary scene blob, see SceneFile
+    void writeSceneFileSettings(SceneFileWriter& file, iris::ScenePtr scene);
+    void writeSceneFileNode(SceneFileParts& parts, iris::SceneNodePtr node, int parent);
+    void writeSceneFileNodeData(SceneFileWriter& file, iris::SceneNodePtr node);
+    void writeSceneFileAnimations(SceneFileWriter& file, iris::SceneNodePtr node);
+    void writeSceneFileEditorData(SceneFileWriter& file, EditorData* editorData);
+    void writeSceneFilePostProcesses(SceneFileWriter& file, iris::PostProcessManagerPtr postMan);
 };
 
 #endif // SCENEWRITER_H
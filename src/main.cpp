@@ -24,6 +24,7 @@ For more information see the LICENSE file
 #include "constants.h"
 #include "misc/updatechecker.h"
 #include "misc/upgrader.h"
+#include "irisgl/src/core/shadermanager.h"
 #include "dialogs/softwareupdatedialog.h"
 #ifdef USE_BREAKPAD
 #include "breakpad/breakpad.h"
@@ -63,6 +64,8 @@ int main(int argc, char *argv[])
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
     QApplication::setAttribute(Qt::AA_UseDesktopOpenGL);
+    // meshes are cached and shared by every view, so their buffers must be too
+    QApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
     QApplication::setDesktopSettingsAware(false);
     QApplication app(argc, argv);
 
@@ -90,6 +93,9 @@ int main(int argc, char *argv[])
     QDir assetDir(assetPath);
     if (!assetDir.exists()) assetDir.mkpath(assetPath);
 
+    // compiled shaders are kept per user since they depend on the driver, not the project
+    iris::ShaderManager::getSingleton()->setCacheFolder(dataPath + Constants::SHADER_CACHE_FOLDER);
+
 // use nicer font on platforms with poor defaults, Mac has really nice font rendering (iKlsR)
 #if defined(Q_OS_WIN) || defined(Q_OS_LINUX)
     int id = QFontDatabase::addApplicationFont(":/fonts/DroidSans.ttf");
@@ -40,6 +40,8 @@ For more information see the LICENSE file
 #include "irisgl/src/animation/animation.h"
 #include "irisgl/src/graphics/postprocessmanager.h"
 #include "irisgl/src/core/logger.h"
+#include "irisgl/src/core/texturemanager.h"
+#include "irisgl/src/content/assetloader.h"
 #include "core/guidmanager.h"
 #include "core/thumbnailmanager.h"
 #include "src/dialogs/donatedialog.h"
@@ -99,13 +101,17 @@ For more information see the LICENSE file
 
 #include "io/scenewriter.h"
 #include "io/scenereader.h"
+#include "io/assethelper.h"
+#include "io/scenefile.h"
 
 #include "constants.h"
 #include <src/io/materialreader.hpp>
 #include "uimanager.h"
 #include "core/database/database.h"
+#include "core/scenesaver.h"
 
 #include "commands/addscenenodecommand.h"
+#include "commands/changemeshmaterialcommand.h"
 #include "commands/deletescenenodecommand.h"
 
 #include "widgets/screenshotwidget.h"
@@ -180,6 +186,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
     setupUndoRedo();
 
 	undoStackCount = 0;
+	savedRevision = 0;
 }
 
 void MainWindow::grabOpenGLContextHack()
@@ -452,6 +459,8 @@ void MainWindow::closeEvent(QCloseEvent *event)
 				closing = true;
 			}
 			else if (reply == QMessageBox::No) {
+				// the changes were discarded so they shouldnt be recovered next time
+				sceneSaver->clearSnapshot(Globals::project->getProjectGuid());
 				event->accept();
 				closing = true;
 			}
@@ -466,6 +475,8 @@ void MainWindow::closeEvent(QCloseEvent *event)
 		}
 	}
 
+    if (closing) autosaveTimer->stop();
+
 //#ifndef QT_DEBUG
     if (closing) {
         if (!getSettingsManager()->getValue("ddialog_seen", "false").toBool()) {
@@ -512,6 +523,7 @@ void MainWindow::renameNode()
     dialog.exec();
 
     activeSceneNode->setName(dialog.getName());
+    UiManager::markSceneNodeDirty(activeSceneNode);
     this->sceneHierarchyWidget->repopulateTree();
 }
 
@@ -530,6 +542,23 @@ void MainWindow::setupProjectDB()
 	if (db->initializeDatabase(path)) {
 		db->createAllTables();
 	}
+
+    // scenes are written on the saver's own connections so saving doesnt stall the editor
+    sceneSaver = new SceneSaver(path, IrisUtils::join(
+        QStandardPaths::writableLocation(QStandardPaths::DataLocation), Constants::AUTOSAVE_DATABASE
+    ));
+    connect(sceneSaver, &SceneSaver::projectSaved, this, [this](const QString &guid, const QByteArray &thumb) {
+        pmContainer->updateTile(guid, thumb);
+    });
+    sceneSaver->start();
+
+    sceneFileCache = new SceneFileCache;
+    UiManager::sceneFileCache = sceneFileCache;
+
+    autosaveTimer = new QTimer(this);
+    autosaveTimer->setInterval(Constants::AUTOSAVE_INTERVAL);
+    connect(autosaveTimer, SIGNAL(timeout()), this, SLOT(autosaveScene()));
+    autosaveTimer->start();
 }
 
 void MainWindow::setupUndoRedo()
@@ -694,46 +723,82 @@ void MainWindow::switchSpace(WindowSpaces space)
 void MainWindow::saveScene(const QString &filename, const QString &projectPath)
 {
 	SceneWriter writer;
-	auto sceneObject = writer.getSceneObject(projectPath,
-											 this->scene,
-											 sceneView->getRenderer()->getPostProcessManager(),
-											 sceneView->getEditorData());
+	writer.setCache(sceneFileCache);
+	auto sceneParts = writer.getSceneParts(projectPath,
+										   this->scene,
+										   sceneView->getRenderer()->getPostProcessManager(),
+										   sceneView->getEditorData());
 
+	// written on the saver's thread like every other save
 	auto img = sceneView->takeScreenshot(Constants::TILE_SIZE * 2);
-	QByteArray thumb;
-	QBuffer buffer(&thumb);
-	buffer.open(QIODevice::WriteOnly);
-	img.save(&buffer, "PNG");
-
-	db->updateProject(sceneObject, thumb);
+	sceneSaver->saveProject(Globals::project->getProjectGuid(), sceneParts, img);
+	savedRevision = sceneFileCache->getRevision();
 
 	undoStackCount = UiManager::getUndoStackCount();
 }
 
 void MainWindow::saveScene()
 {
-	SceneWriter writer;
-    auto blob = writer.getSceneObject(Globals::project->getProjectFolder(),
-                                      scene,
-                                      sceneView->getRenderer()->getPostProcessManager(),
-                                      sceneView->getEditorData());
+    // only nodes marked dirty since they were last written are encoded again
+    auto sceneParts = getSceneParts();
 
+    // the screenshot needs the gl context, the blob is assembled and stored on the saver's thread
     auto img = sceneView->takeScreenshot(Constants::TILE_SIZE * 2);
-    QByteArray thumb;
-    QBuffer buffer(&thumb);
-    buffer.open(QIODevice::WriteOnly);
-    img.save(&buffer, "PNG");
-
-    db->updateProject(blob, thumb);
-	pmContainer->updateTile(Globals::project->getProjectGuid(), thumb);
+    sceneSaver->saveProject(Globals::project->getProjectGuid(), sceneParts, img);
+    savedRevision = sceneFileCache->getRevision();
 
 	undoStackCount = UiManager::getUndoStackCount();
 }
 
+SceneFileParts MainWindow::getSceneParts()
+{
+    SceneWriter writer;
+    writer.setCache(sceneFileCache);
+    return writer.getSceneParts(Globals::project->getProjectFolder(),
+                                scene,
+                                sceneView->getRenderer()->getPostProcessManager(),
+                                sceneView->getEditorData());
+}
+
+void MainWindow::autosaveScene()
+{
+    if (!UiManager::isSceneOpen || UiManager::isScenePlaying || UiManager::playMode || !scene) return;
+
+    // nothing was marked dirty since the last save
+    if (sceneFileCache->getRevision() == savedRevision) return;
+
+    savedRevision = sceneFileCache->getRevision();
+    sceneSaver->saveSnapshot(Globals::project->getProjectGuid(), getSceneParts());
+}
+
 void MainWindow::openProject(bool playMode)
 {
+    // the project could still be being saved
+    sceneSaver->waitForSaves();
+
+    auto guid = Globals::project->getProjectGuid();
+    auto sceneBlob = db->getSceneBlobGlobal();
+
+    // a snapshot is only left behind if the editor closed without saving
+    auto snapshot = sceneSaver->fetchSnapshot(guid);
+    if (!snapshot.isEmpty() && snapshot != sceneBlob && !playMode) {
+        auto reply = QMessageBox::question(this,
+                                           "Recover Unsaved Changes",
+                                           "This project has changes that werent saved, recover them?",
+                                           QMessageBox::Yes | QMessageBox::No);
+        if (reply == QMessageBox::Yes) {
+            sceneBlob = snapshot;
+        } else {
+            sceneSaver->clearSnapshot(guid);
+        }
+    }
+
     sceneView->makeCurrent();
     removeScene();
+    sceneFileCache->clear();
+
+    // converted textures are kept with the project
+    iris::TextureManager::getSingleton()->setCacheFolder(AssetHelper::getTextureCacheFolder());
 
     std::unique_ptr<SceneReader> reader(new SceneReader);
 	reader->setDatabaseHandle(db);
@@ -745,7 +810,7 @@ void MainWindow::openProject(bool playMode)
     postMan->clearPostProcesses();
 
     auto scene = reader->readScene(Globals::project->getProjectFolder(),
-                                   db->getSceneBlobGlobal(),
+                                   sceneBlob,
                                    postMan,
                                    &editorData);
 
@@ -776,6 +841,9 @@ void MainWindow::openProject(bool playMode)
     UiManager::playMode ? switchSpace(WindowSpaces::PLAYER) : switchSpace(WindowSpaces::EDITOR);
 
 	undoStackCount = 0;
+
+    // the first autosave only writes the scene if it changed since now
+    savedRevision = sceneFileCache->getRevision();
 }
 
 void MainWindow::closeProject()
@@ -794,9 +862,14 @@ void MainWindow::closeProject()
 
     UiManager::mainWindow->setWindowTitle(originalTitle);
 
+    // models still loading for the closed scene are dropped
+    iris::AssetLoader::getSingleton()->cancelMeshLoads();
+
     scene->cleanup();
     scene.clear();
 
+    sceneFileCache->clear();
+
 	undoStackCount = 0;
 
     if (currentSpace == WindowSpaces::DESKTOP) return;
@@ -829,7 +902,7 @@ void MainWindow::applyMaterialPreset(MaterialPreset *preset)
     m->setValue("reflectionInfluence", preset->reflectionInfluence);
     m->setValue("textureScale", preset->textureScale);
 
-    meshNode->setMaterial(m);
+    UiManager::pushUndoStack(new ChangeMeshMaterialCommand(meshNode, meshNode->getMaterial(), m));
 
     // TODO: update node's material without updating the whole ui
     this->sceneNodePropertiesWidget->refreshMaterial(preset->type);
@@ -1475,10 +1548,7 @@ void MainWindow::duplicateNode()
 
 	sceneView->makeCurrent();
     auto node = activeSceneNode->duplicate();
-    activeSceneNode->parent->addChild(node, false);
-
-    this->sceneHierarchyWidget->repopulateTree();
-    sceneNodeSelected(node);
+    UiManager::pushUndoStack(new AddSceneNodeCommand(activeSceneNode->parent, node));
 	sceneView->doneCurrent();
 }
 
@@ -1831,7 +1901,11 @@ void MainWindow::exportSceneAsZip()
                     );
 
     if (filePath.isEmpty() || filePath.isNull()) return;
-    if (!!scene) saveScene();
+    if (!!scene) {
+        saveScene();
+        // the export copies the project from the database
+        sceneSaver->waitForSaves();
+    }
 
     // Maybe in the future one could add a way to using an in memory database
     // and saving that as a blob which can be put into the zip as bytes (iKlsR)
@@ -2656,6 +2730,8 @@ void MainWindow::showProjectManagerInternal()
 
         if (option == QMessageBox::Yes) {
             saveScene();
+        } else if (option == QMessageBox::No) {
+            sceneSaver->clearSnapshot(Globals::project->getProjectGuid());
         } else if (option == QMessageBox::Cancel) {
             return;
         }
@@ -2699,6 +2775,11 @@ void MainWindow::newProject(const QString &filename, const QString &projectPath)
 
 MainWindow::~MainWindow()
 {
+    // waits for queued saves to be written
+    delete sceneSaver;
+    UiManager::sceneFileCache = Q_NULLPTR;
+    delete sceneFileCache;
+
     this->db->closeDatabase();
     delete ui;
 }
@@ -101,6 +101,9 @@ enum class Widget
 };
 
 class Database;
+class SceneFileCache;
+struct SceneFileParts;
+class SceneSaver;
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -284,7 +287,11 @@ private slots:
     void enterEditMode();
     void enterPlayMode();
 
+    void autosaveScene();
+
 private:
+    SceneFileParts getSceneParts();
+
     Ui::MainWindow *ui;
     SurfaceView* surface;
     SceneViewWidget* sceneView;
@@ -331,6 +338,12 @@ private:
     Database *db;
     ProjectManager *pmContainer;
 
+    SceneFileCache *sceneFileCache;
+    SceneSaver *sceneSaver;
+    QTimer *autosaveTimer;
+    // the cache's revision when the scene was last read or saved, unchanged scenes arent autosaved
+    quint32 savedRevision;
+
     QUndoStack* undoStack;
 
 	QPushButton *worlds_menu;
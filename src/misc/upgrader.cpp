@@ -16,14 +16,31 @@ For more information see the LICENSE file
 #include <QDir>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
 #include <QPushButton>
 #include <QStandardPaths>
+#include <QThread>
 #include <QVBoxLayout>
 
 #include "core/database/database.h"
 #include "core/settingsmanager.h"
+#include "editor/editordata.h"
+#include "io/assethelper.h"
+#include "io/assetmanager.h"
+#include "io/scenefile.h"
+#include "io/scenereader.h"
+#include "io/scenewriter.h"
+#include "irisgl/src/content/assetloader.h"
 #include "irisgl/src/core/irisutils.h"
+#include "irisgl/src/core/logger.h"
+#include "irisgl/src/core/meshmanager.h"
+#include "irisgl/src/core/texturemanager.h"
+#include "irisgl/src/graphics/graphicsdevice.h"
+#include "irisgl/src/graphics/postprocessmanager.h"
+#include "irisgl/src/scenegraph/scene.h"
 #include "constants.h"
+#include "globals.h"
 
 #include <QDebug>
 
@@ -127,6 +144,91 @@ void Upgrader::checkIfDeprecatedVersion()
 			}
 		}
 
+		if (db.checkIfTableExists("projects")) upgradeSceneBlobs(db);
+
 		db.closeDatabase();
 	}
+}
+
+void Upgrader::upgradeSceneBlobs(Database &db)
+{
+	auto blobs = db.fetchSceneBlobs();
+
+	QMutableMapIterator<QString, QByteArray> it(blobs);
+	while (it.hasNext()) {
+		it.next();
+		if (it.value().isEmpty() || SceneFile::isSceneFile(it.value())) it.remove();
+	}
+
+	if (blobs.isEmpty()) return;
+
+	// the scenes are read and written the same way the editor saves them, the
+	// reader creates textures and materials so it needs a context of its own
+	QOffscreenSurface surface;
+	surface.create();
+
+	QOpenGLContext context;
+	context.setShareContext(QOpenGLContext::globalShareContext());
+	if (!context.create() || !context.makeCurrent(&surface)) {
+		irisLog("Couldn't create a context to upgrade the scenes, they're upgraded when they're next saved");
+		return;
+	}
+
+	QMap<QString, QString> names;
+	for (const auto &project : db.fetchProjects()) names.insert(project.guid, project.name);
+
+	auto pFldr = IrisUtils::join(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation),
+		Constants::PROJECT_FOLDER);
+	auto projectFolder = SettingsManager::getDefaultManager()->getValue("default_directory", pFldr).toString();
+
+	// the reader and writer find assets through the open project
+	Project previousProject = *Globals::project;
+
+	auto device = iris::GraphicsDevice::create();
+	auto loader = iris::AssetLoader::getSingleton();
+	QMap<QString, QByteArray> upgraded;
+
+	for (auto blob = blobs.cbegin(); blob != blobs.cend(); ++blob) {
+		Globals::project->setProjectPath(
+			QDir(QDir(projectFolder).filePath("Projects")).filePath(blob.key()),
+			names.value(blob.key())
+		);
+		Globals::project->setProjectGuid(blob.key());
+		AssetHelper::addShaderAssets(&db);
+		iris::TextureManager::getSingleton()->setCacheFolder(AssetHelper::getTextureCacheFolder());
+
+		auto postMan = iris::PostProcessManager::create(device);
+		EditorData *editorData = nullptr;
+
+		SceneReader reader;
+		reader.setDatabaseHandle(&db);
+		auto scene = reader.readScene(Globals::project->getProjectFolder(), blob.value(), postMan, &editorData);
+
+		// skeletal animations are only given to their nodes once the models are loaded
+		while (loader->isLoading()) {
+			loader->processUploads(device);
+			QThread::msleep(1);
+		}
+
+		SceneWriter writer;
+		writer.setDatabaseHandle(&db);
+		auto sceneBlob = writer.getSceneObject(Globals::project->getProjectFolder(), scene, postMan, editorData);
+		if (SceneFile::isSceneFile(sceneBlob)) upgraded.insert(blob.key(), sceneBlob);
+
+		delete editorData;
+		AssetManager::clearAssetList();
+	}
+
+	db.getDb().transaction();
+	for (auto blob = upgraded.cbegin(); blob != upgraded.cend(); ++blob) {
+		db.updateSceneBlob(blob.key(), blob.value());
+	}
+	db.getDb().commit();
+
+	*Globals::project = previousProject;
+
+	// vertex arrays arent shared between contexts so the meshes are loaded again by the editor
+	iris::MeshManager::getSingleton()->clear();
+	device.clear();
+	context.doneCurrent();
 }
\ No newline at end of file
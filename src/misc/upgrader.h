@@ -14,6 +14,8 @@ For more information see the LICENSE file
 
 #include <QObject>
 
+class Database;
+
 class Upgrader : protected QObject
 {
 	Q_OBJECT
@@ -21,6 +23,10 @@ class Upgrader : protected QObject
 public:
 	Upgrader() = default;
 	void checkIfDeprecatedVersion();
+
+private:
+	// converts scenes saved as json blobs to the binary scene format
+	void upgradeSceneBlobs(Database &db);
 };
 
 #endif // UPGRADER_H
\ No newline at end of file
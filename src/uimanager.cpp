@@ -2,6 +2,7 @@
 #include "mainwindow.h"
 #include "globals.h"
 #include "core/project.h"
+#include "io/scenefile.h"
 #include "widgets/sceneviewwidget.h"
 
 #include <QUndoStack>
@@ -15,6 +16,7 @@ SceneNodePropertiesWidget *UiManager::propertyWidget = Q_NULLPTR;
 
 QUndoStack *UiManager::undoStack = Q_NULLPTR;
 SceneMode UiManager::sceneMode = SceneMode::EditMode;
+SceneFileCache *UiManager::sceneFileCache = Q_NULLPTR;
 
 bool UiManager::isSceneOpen = false;
 bool UiManager::isScenePlaying = false;
@@ -108,6 +110,24 @@ void UiManager::clearUndoStack()
     UiManager::undoStack->clear();
 }
 
+void UiManager::markSceneNodeDirty(iris::SceneNodePtr node)
+{
+    if (sceneFileCache != Q_NULLPTR)
+        sceneFileCache->markDirty(node);
+}
+
+void UiManager::markMaterialDirty(iris::MaterialPtr material)
+{
+    if (sceneFileCache != Q_NULLPTR)
+        sceneFileCache->markDirty(material);
+}
+
+void UiManager::markSceneChanged()
+{
+    if (sceneFileCache != Q_NULLPTR)
+        sceneFileCache->markChanged();
+}
+
 void UiManager::setUndoStack(QUndoStack *undoStack)
 {
     UiManager::undoStack = undoStack;
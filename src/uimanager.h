@@ -1,6 +1,8 @@
 #ifndef UIMANAGER_H
 #define UIMANAGER_H
 
+#include "irisglfwd.h"
+
 class AnimationWidget;
 class QUndoStack;
 class QUndoCommand;
@@ -8,6 +10,7 @@ class MainWindow;
 class SceneViewWidget;
 class SceneHierarchyWidget;
 class SceneNodePropertiesWidget;
+class SceneFileCache;
 
 /*
 Tied directly to the WindowSpaces enum
@@ -56,7 +59,14 @@ public:
     static void pushUndoStack(QUndoCommand*);
     static void popUndoStack();
 
+    // drops the node's cached data so the next save writes it again
+    static void markSceneNodeDirty(iris::SceneNodePtr node);
+    static void markMaterialDirty(iris::MaterialPtr material);
+    // for changes that arent kept in a node, like the sky or post processes
+    static void markSceneChanged();
+
     static SceneMode sceneMode;
+    static SceneFileCache* sceneFileCache;
 
 private:
     static QUndoStack* undoStack;
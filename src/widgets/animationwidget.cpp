@@ -34,6 +34,7 @@ For more information see the LICENSE file
 #include "animationwidgetdata.h"
 #include "createanimationwidget.h"
 #include "../dialogs/getnamedialog.h"
+#include "../uimanager.h"
 
 
 AnimationWidget::AnimationWidget(QWidget *parent) :
@@ -46,6 +47,7 @@ AnimationWidget::AnimationWidget(QWidget *parent) :
     connect(ui->deleteAnimBtn,SIGNAL(clicked(bool)), this, SLOT(deleteAnimation()));
     connect(ui->animList,SIGNAL(currentTextChanged(QString)), this, SLOT(animationChanged(QString)));
     connect(ui->loopCheckBox,SIGNAL(clicked(bool)), this, SLOT(setLooping(bool)));
+    connect(ui->bakeCheckBox,SIGNAL(clicked(bool)), this, SLOT(setBaked(bool)));
 
     animWidgetData = new AnimationWidgetData();
 
@@ -59,6 +61,10 @@ AnimationWidget::AnimationWidget(QWidget *parent) :
     curveWidget->setAnimWidgetData(animWidgetData);
     curveWidget->hide();
 
+    // edited keys make the baked samples stale
+    connect(keyFrameWidget,SIGNAL(keysChanged()), this, SLOT(onKeysChanged()));
+    connect(curveWidget,SIGNAL(keyChanged(iris::FloatKey*)), this, SLOT(onKeysChanged()));
+
     createAnimWidget = new CreateAnimationWidget();
     connect(createAnimWidget->getCreateButton(),SIGNAL(clicked(bool)), this, SLOT(addAnimation()));
     createAnimWidget->hide();
@@ -162,8 +168,10 @@ void AnimationWidget::setSceneNode(iris::SceneNodePtr node)
         showKeyFrameWidget();
         hideCreateAnimWidget();
         ui->loopCheckBox->setChecked(animation->getLooping());
+        ui->bakeCheckBox->setChecked(animation->isBaked());
 
         // enable ui
+        ui->bakeCheckBox->setEnabled(true);
         ui->deleteAnimBtn->setEnabled(true);
         ui->insertFrame->setEnabled(true);
         ui->addAnimBtn->setEnabled(true);
@@ -175,6 +183,8 @@ void AnimationWidget::setSceneNode(iris::SceneNodePtr node)
         ui->sceneNodeName->setText("");
 
         // disable ui
+        ui->bakeCheckBox->setChecked(false);
+        ui->bakeCheckBox->setEnabled(false);
         ui->deleteAnimBtn->setEnabled(false);
         ui->insertFrame->setEnabled(false);
         ui->addAnimBtn->setEnabled(false);
@@ -309,6 +319,8 @@ void AnimationWidget::removeProperty(QString propertyName)
     if (!!node) {
         node->getAnimation()->removePropertyAnim(propertyName);
         ui->keylabelView->removeProperty(propertyName);
+        ui->bakeCheckBox->setChecked(false);
+        UiManager::markSceneNodeDirty(node);
 
         this->repaintViews();
     }
@@ -348,9 +360,35 @@ void AnimationWidget::setLooping(bool loop)
 {
     if (!!node) {
         node->getAnimation()->setLooping(loop);
+        ui->bakeCheckBox->setChecked(node->getAnimation()->isBaked());
+        UiManager::markSceneNodeDirty(node);
     }
 }
 
+void AnimationWidget::setBaked(bool baked)
+{
+    if (!node)
+        return;
+
+    auto anim = node->getAnimation();
+    if (baked)
+        anim->bake();
+    else
+        anim->clearBake();
+
+    UiManager::markSceneNodeDirty(node);
+}
+
+void AnimationWidget::onKeysChanged()
+{
+    if (!node)
+        return;
+
+    node->getAnimation()->clearBake();
+    ui->bakeCheckBox->setChecked(false);
+    UiManager::markSceneNodeDirty(node);
+}
+
 void AnimationWidget::addAnimation()
 {
     if(!node)
@@ -368,6 +406,7 @@ void AnimationWidget::addAnimation()
 
     node->addAnimation(animation);
     node->setAnimation(animation);
+    UiManager::markSceneNodeDirty(node);
 
     // todo: create method for updating views
     //this->setSceneNode(node);
@@ -384,6 +423,7 @@ void AnimationWidget::addAnimation()
 void AnimationWidget::deleteAnimation()
 {
     node->deleteAnimation(node->getAnimation());
+    UiManager::markSceneNodeDirty(node);
 
     //refresh ui
     this->setSceneNode(node);
@@ -443,6 +483,7 @@ void AnimationWidget::addPropertyKey(QAction *action)
     }
 
     animation->calculateAnimationLength();
+    onKeysChanged();
 
     // recalc summary keys for this property
     ui->keylabelView->recalcPropertySummaryKeys(animProp->name);
@@ -522,6 +563,8 @@ void AnimationWidget::animationChanged(QString name)
         if (anim->getName() == name) {
             node->setAnimation(anim);
             ui->keylabelView->setActiveAnimation(anim);
+            ui->bakeCheckBox->setChecked(anim->isBaked());
+            UiManager::markSceneNodeDirty(node);
             this->repaintViews();
         }
     }
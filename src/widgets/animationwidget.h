@@ -108,11 +108,13 @@ private:
 
 public slots:
     void setLooping(bool loop);
+    void setBaked(bool baked);
     void addAnimation();
     void deleteAnimation();
 
 private slots:
     void addPropertyKey(QAction* action);
+    void onKeysChanged();
 
     void updateAnim();
     void startTimer();
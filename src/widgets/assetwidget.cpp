@@ -1825,6 +1825,9 @@ void AssetWidget::importRegularAssets(const QList<directory_tuple> &fileNames)
                     assetTexture->fileName = asset->fileName;
                     assetTexture->path = fileToCopyTo;
                     AssetManager::addAsset(assetTexture);
+
+                    // Compress the texture and its mip levels so scenes dont have to decode it
+                    AssetHelper::convertTexture(asset->path);
                 }
 
                 if (asset->type == ModelTypes::Shader) {
@@ -1990,6 +1993,9 @@ void AssetWidget::importRegularAssets(const QList<directory_tuple> &fileNames)
                     );
 					// Remove the thumbnail from the object asset
 					db->updateAssetAsset(assetGuid, QByteArray());
+
+					// Convert the model to the native mesh format so scenes can load it without importing it
+					AssetHelper::convertMesh(asset->path, assetGuid);
 				}
 
 				// Copy only models, textures, whitelisted files and shaders for now
@@ -64,6 +64,7 @@ void KeyFrameWidget::deleteContextKey()
 
     contextKey = DopeKey::Null();
 
+    emit keysChanged();
 }
 
 KeyFrameWidget::KeyFrameWidget(QWidget* parent):
@@ -342,12 +343,22 @@ void KeyFrameWidget::mouseMoveEvent(QMouseEvent* evt)
         //key dragging
         auto timeDiff = posToTime(evt->x())-posToTime(mousePos.x());
         selectedKey.move(timeDiff);
+
+        // keys are moved in place so their keyframes need to be resorted
+        auto propAnim = obj->getAnimation()->getPropertyAnim(selectedKey.propertyName);
+        if (propAnim != nullptr) {
+            for (auto frame : propAnim->getKeyFrames())
+                frame.keyFrame->sortKeys();
+        }
+
         if(selectedKey.keyType == DopeKeyType::FloatKey)
         {
             // recalculate summary keys
             // todo: recalc only summary keys for this key's property
             labelWidget->recalcPropertySummaryKeys(selectedKey.propertyName);
         }
+
+        emit keysChanged();
         this->repaint();
     }
     else if(leftButtonDown)
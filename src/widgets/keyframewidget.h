@@ -164,6 +164,7 @@ public:
 
 signals:
     void timeRangeChanged(float timeStart, float timeEnd);
+    void keysChanged();
 
 protected slots:
     void deleteContextKey();
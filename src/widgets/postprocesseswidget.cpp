@@ -13,6 +13,7 @@
 #include "../irisgl/src/postprocesses/ssaopostprocess.h"
 #include "../irisgl/src/postprocesses/greyscalepostprocess.h"
 #include "../irisgl/src/postprocesses/coloroverlaypostprocess.h"
+#include "../uimanager.h"
 
 #include <QDebug>
 
@@ -111,6 +112,7 @@ void PostProcessesWidget::addPostProcess(QAction* action)
 
         postProcesses.append(process);
         postProcessMgr->addPostProcess(process);
+        UiManager::markSceneChanged();
         widget->setPostProcess(process);
         widget->setPanelTitle(process->getDisplayName());
 
@@ -38,6 +38,7 @@
 #include "core/settingsmanager.h"
 #include "dialogs/newprojectdialog.h"
 #include "dialogs/progressdialog.h"
+#include "io/assethelper.h"
 #include "io/assetmanager.h"
 
 ProjectManager::ProjectManager(Database *handle, QWidget *parent) : QWidget(parent), ui(new Ui::ProjectManager)
@@ -67,29 +68,7 @@ ProjectManager::ProjectManager(Database *handle, QWidget *parent) : QWidget(pare
 			AssetManager::addAsset(model);
 		}
 
-        for (const auto &asset : db->fetchAssetsByType(static_cast<int>(ModelTypes::File))) {
-            auto assetFile = new AssetFile;
-            assetFile->fileName = asset.name;
-            assetFile->assetGuid = asset.guid;
-            assetFile->path = IrisUtils::join(Globals::project->getProjectFolder(), asset.name);
-            AssetManager::addAsset(assetFile);
-        }
-
-        for (const auto &asset : db->fetchAssetsByType(static_cast<int>(ModelTypes::Shader))) {
-            QFile *templateShaderFile = new QFile(IrisUtils::join(Globals::project->getProjectFolder(), asset.name));
-            templateShaderFile->open(QIODevice::ReadOnly | QIODevice::Text);
-            QJsonObject shaderDefinition = QJsonDocument::fromJson(templateShaderFile->readAll()).object();
-            templateShaderFile->close();
-            // shaderDefinition["name"] = QFileInfo(asset.name).baseName();
-            shaderDefinition.insert("guid", asset.guid);
-
-            auto assetShader = new AssetShader;
-            assetShader->assetGuid = asset.guid;
-            assetShader->fileName = QFileInfo(asset.name).baseName();
-            assetShader->path = IrisUtils::join(Globals::project->getProjectFolder(), asset.name);
-            assetShader->setValue(QVariant::fromValue(shaderDefinition));
-            AssetManager::addAsset(assetShader);
-        }
+        AssetHelper::addShaderAssets(db);
 
         for (const auto &asset : db->fetchAssetsByType(static_cast<int>(ModelTypes::Texture))) {
             auto assetTexture = new AssetTexture;
@@ -18,9 +18,11 @@ For more information see the LICENSE file
 #include "../comboboxwidget.h"
 
 #include "../../irisgl/src/graphics/texture2d.h"
+#include "../../irisgl/src/core/texturemanager.h"
 #include "../../irisgl/src/scenegraph/meshnode.h"
 #include "../../irisgl/src/scenegraph/particlesystemnode.h"
 #include "../../irisgl/src/materials/defaultmaterial.h"
+#include "../../uimanager.h"
 
 EmitterPropertyWidget::EmitterPropertyWidget()
 {
@@ -79,7 +81,8 @@ EmitterPropertyWidget::~EmitterPropertyWidget()
 void EmitterPropertyWidget::onBillboardImageChanged(QString image)
 {
     if (!image.isEmpty() || !image.isNull()) {
-        ps->texture = iris::Texture2D::load(image);
+        ps->texture = iris::TextureManager::getSingleton()->getTexture(image);
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -114,6 +117,7 @@ void EmitterPropertyWidget::onEmissionRateChanged(float val)
 {
     if (!!this->ps) {
         ps->particlesPerSecond = val;
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -121,6 +125,7 @@ void EmitterPropertyWidget::onParticleLifeChanged(float val)
 {
     if (!!this->ps) {
         ps->lifeLength = val;
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -128,6 +133,7 @@ void EmitterPropertyWidget::onParticleScaleChanged(float val)
 {
     if (!!this->ps) {
         ps->particleScale = val;
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -135,6 +141,7 @@ void EmitterPropertyWidget::onLifeFactorChanged(float val)
 {
     if (!!this->ps) {
         ps->setLifeError(val);
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -142,6 +149,7 @@ void EmitterPropertyWidget::onSpeedFactorChanged(float val)
 {
     if (!!this->ps) {
         ps->setSpeedError(val);
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -149,6 +157,7 @@ void EmitterPropertyWidget::onScaleFactorChanged(float val)
 {
     if (!!this->ps) {
         ps->setScaleError(val);
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -156,6 +165,7 @@ void EmitterPropertyWidget::onGravityFactorChanged(float val)
 {
     if (!!this->ps) {
         ps->gravityComplement = val;
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -163,6 +173,7 @@ void EmitterPropertyWidget::onVelocityFactorChanged(float val)
 {
     if (!!this->ps) {
         ps->speed = val;
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -170,6 +181,7 @@ void EmitterPropertyWidget::onRandomRotation(bool val)
 {
     if (!!this->ps) {
         ps->randomRotation = val;
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -182,6 +194,7 @@ void EmitterPropertyWidget::onDissipateChanged(bool val)
 {
     if (!!this->ps) {
         ps->dissipate = val;
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -189,6 +202,7 @@ void EmitterPropertyWidget::onDissipateInvChanged(bool val)
 {
     if (!!this->ps) {
         ps->dissipateInv = val;
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -196,6 +210,7 @@ void EmitterPropertyWidget::onAdditiveChanged(bool val)
 {
     if (!!this->ps) {
         ps->setBlendMode(val);
+        UiManager::markSceneNodeDirty(ps);
     }
 }
 
@@ -20,6 +20,9 @@ For more information see the LICENSE file
 
 #include "../checkboxwidget.h"
 
+#include "../../commands/changescenepropertycommand.h"
+#include "../../uimanager.h"
+
 FogPropertyWidget::FogPropertyWidget()
 {
     fogEnabled      = this->addCheckBox("Fog Enabled", false);
@@ -52,35 +55,35 @@ void FogPropertyWidget::setScene(QSharedPointer<iris::Scene> scene)
 
 void FogPropertyWidget::onFogColorChanged(QColor color)
 {
-    if (!!scene) {
-        scene->fogColor = color;
+    if (!!scene && scene->fogColor != color) {
+        UiManager::pushUndoStack(new ChangeScenePropertyCommand(scene, "fogColor", scene->fogColor, color));
     }
 }
 
 void FogPropertyWidget::onFogStartChanged(float val)
 {
-    if (!!scene) {
-        scene->fogStart = val;
+    if (!!scene && scene->fogStart != val) {
+        UiManager::pushUndoStack(new ChangeScenePropertyCommand(scene, "fogStart", scene->fogStart, val));
     }
 }
 
 void FogPropertyWidget::onFogEndChanged(float val)
 {
-    if (!!scene) {
-        scene->fogEnd = val;
+    if (!!scene && scene->fogEnd != val) {
+        UiManager::pushUndoStack(new ChangeScenePropertyCommand(scene, "fogEnd", scene->fogEnd, val));
     }
 }
 
 void FogPropertyWidget::onFogEnabledChanged(bool val)
 {
-    if (!!scene) {
-        scene->fogEnabled = val;
+    if (!!scene && scene->fogEnabled != val) {
+        UiManager::pushUndoStack(new ChangeScenePropertyCommand(scene, "fogEnabled", scene->fogEnabled, val));
     }
 }
 
 void FogPropertyWidget::onShadowEnabledChanged(bool val)
 {
-    if (!!scene) {
-        scene->shadowEnabled = val;
+    if (!!scene && scene->shadowEnabled != val) {
+        UiManager::pushUndoStack(new ChangeScenePropertyCommand(scene, "shadowEnabled", scene->shadowEnabled, val));
     }
 }
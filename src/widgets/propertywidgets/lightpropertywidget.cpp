@@ -21,6 +21,7 @@ For more information see the LICENSE file
 #include "../../irisgl/src/scenegraph/scene.h"
 #include "../../irisgl/src/scenegraph/scenenode.h"
 #include "../../irisgl/src/scenegraph/lightnode.h"
+#include "../../uimanager.h"
 
 
 LightPropertyWidget::LightPropertyWidget(QWidget* parent):
@@ -42,6 +43,11 @@ LightPropertyWidget::LightPropertyWidget(QWidget* parent):
     shadowSize->addItem("1024");
     shadowSize->addItem("2048");
     shadowSize->addItem("4096");
+    shadowCascades = this->addComboBox("Shadow Cascades");
+    shadowCascades->addItem("1");
+    shadowCascades->addItem("2");
+    shadowCascades->addItem("3");
+    shadowCascades->addItem("4");
     //shadowBias = this->addFloatValueSlider("Shadow Bias",0,1);
 
     connect(lightColor->getPicker(),SIGNAL(onColorChanged(QColor)),this,SLOT(lightColorChanged(QColor)));
@@ -54,6 +60,7 @@ LightPropertyWidget::LightPropertyWidget(QWidget* parent):
 
     connect(shadowType, SIGNAL(currentIndexChanged(QString)), this, SLOT(shadowTypeChanged(QString)));
     connect(shadowSize, SIGNAL(currentIndexChanged(QString)), this, SLOT(shadowSizeChanged(QString)));
+    connect(shadowCascades, SIGNAL(currentIndexChanged(QString)), this, SLOT(shadowCascadesChanged(QString)));
     //connect(shadowBias, SIGNAL(valueChanged(float)), this, SLOT(shadowBiasChanged(float)));
 }
 
@@ -81,6 +88,7 @@ void LightPropertyWidget::setSceneNode(QSharedPointer<iris::SceneNode> sceneNode
 
         shadowSize->setCurrentItem(QString("%1").arg(lightNode->shadowMap->resolution));
         shadowType->setCurrentItem(evalShadowTypeName(lightNode->shadowMap->shadowType));
+        shadowCascades->setCurrentItem(QString("%1").arg(lightNode->shadowMap->cascadeCount));
         //shadowBias->setValue(lightNode->shadowMap->bias);
 
         // hide shadow params for point lights
@@ -93,6 +101,12 @@ void LightPropertyWidget::setSceneNode(QSharedPointer<iris::SceneNode> sceneNode
             shadowType->show();
             //shadowBias->show();
         }
+
+        // only directional lights use cascades
+        if (lightNode->getLightType()==iris::LightType::Directional)
+            shadowCascades->show();
+        else
+            shadowCascades->hide();
     }
     else
     {
@@ -102,49 +116,68 @@ void LightPropertyWidget::setSceneNode(QSharedPointer<iris::SceneNode> sceneNode
 
 void LightPropertyWidget::lightColorChanged(QColor color)
 {
-    if(!!lightNode)
+    if(!!lightNode) {
         lightNode->color = color;
+        UiManager::markSceneNodeDirty(lightNode);
+    }
 }
 
 void LightPropertyWidget::lightIntensityChanged(float intensity)
 {
-    if(!!lightNode)
+    if(!!lightNode) {
         lightNode->intensity = intensity;
+        UiManager::markSceneNodeDirty(lightNode);
+    }
 }
 
 void LightPropertyWidget::lightDistanceChanged(float distance)
 {
-    if(!!lightNode)
+    if(!!lightNode) {
         lightNode->distance = distance;
+        UiManager::markSceneNodeDirty(lightNode);
+    }
 }
 
 void LightPropertyWidget::lightSpotCutoffChanged(float spotCutOff)
 {
-    if(!!lightNode)
+    if(!!lightNode) {
         lightNode->spotCutOff = spotCutOff;
+        UiManager::markSceneNodeDirty(lightNode);
+    }
 }
 
 void LightPropertyWidget::lightSpotCutoffSoftnessChanged(float spotCutOffSoftness)
 {
-    if(!!lightNode)
+    if(!!lightNode) {
         lightNode->spotCutOffSoftness = spotCutOffSoftness;
+        UiManager::markSceneNodeDirty(lightNode);
+    }
 }
 
 void LightPropertyWidget::shadowTypeChanged(QString name)
 {
     auto shadowType = evalShadowMapType(name);
     lightNode->shadowMap->shadowType = shadowType;
+    UiManager::markSceneNodeDirty(lightNode);
 }
 
 void LightPropertyWidget::shadowSizeChanged(QString size)
 {
     int res = size.toInt();
     lightNode->shadowMap->setResolution(res);
+    UiManager::markSceneNodeDirty(lightNode);
+}
+
+void LightPropertyWidget::shadowCascadesChanged(QString count)
+{
+    lightNode->shadowMap->setCascadeCount(count.toInt());
+    UiManager::markSceneNodeDirty(lightNode);
 }
 
 void LightPropertyWidget::shadowBiasChanged(float bias)
 {
     lightNode->shadowMap->bias = bias;
+    UiManager::markSceneNodeDirty(lightNode);
 }
 
 QString LightPropertyWidget::evalShadowTypeName(iris::ShadowMapType shadowType)
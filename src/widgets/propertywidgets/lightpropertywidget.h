@@ -73,6 +73,7 @@ protected slots:
 
     void shadowTypeChanged(QString name);
     void shadowSizeChanged(QString size);
+    void shadowCascadesChanged(QString count);
     void shadowBiasChanged(float bias);
 
 private:
@@ -92,6 +93,7 @@ private:
 
     ComboBoxWidget* shadowType;
     ComboBoxWidget* shadowSize;
+    ComboBoxWidget* shadowCascades;
     HFloatSliderWidget* shadowBias;
 };
 
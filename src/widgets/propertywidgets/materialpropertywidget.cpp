@@ -123,6 +123,7 @@ void MaterialPropertyWidget::materialChanged(int index)
     clearPanel(this->layout());
     material->setName(materialSelector->getCurrentItem());
     material->setGuid(materialSelector->getCurrentItemData());
+    UiManager::markMaterialDirty(material);
     setSceneNode(meshNode);
 
     //if (db->checkIfRecordExists("guid", material->getGuid(), "assets")) {
@@ -158,12 +159,16 @@ void MaterialPropertyWidget::setupShaderSelector()
 
 void MaterialPropertyWidget::onPropertyChanged(iris::Property *prop)
 {
-    for (auto property : material->properties) {
-        if (property->name == prop->name) property->setValue(prop->getValue());
-    }
+    UiManager::markMaterialDirty(material);
 
     // special case for textures since we have to generate these
-    if (prop->type == iris::PropertyType::Texture) {
+    if (prop->type != iris::PropertyType::Texture) {
+        material->setValue(prop->name, prop->getValue());
+    } else {
+        for (auto property : material->properties) {
+            if (property->name == prop->name) property->setValue(prop->getValue());
+        }
+
         material->setTextureWithUniform(prop->uniform, prop->getValue().toString());
         
         // HANDLE CASE where the widget isn't deselected
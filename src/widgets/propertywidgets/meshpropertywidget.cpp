@@ -13,6 +13,7 @@ For more information see the LICENSE file
 #include "../filepickerwidget.h"
 #include "../../irisgl/src/scenegraph/meshnode.h"
 #include "../../globals.h"
+#include "../../uimanager.h"
 #include "../sceneviewwidget.h"
 #include "../comboboxwidget.h"
 
@@ -51,6 +52,8 @@ void MeshPropertyWidget::onCullModeChanged(const QString& cullMode)
 		meshNode->setFaceCullingMode(iris::FaceCullingMode::None);
 	else
 		meshNode->setFaceCullingMode(iris::FaceCullingMode::DefinedInMaterial);
+
+    UiManager::markSceneNodeDirty(meshNode);
 }
 
 void MeshPropertyWidget::setSceneNode(iris::SceneNodePtr sceneNode)
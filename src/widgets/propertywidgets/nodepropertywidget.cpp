@@ -17,6 +17,7 @@ For more information see the LICENSE file
 
 #include "../../irisgl/src/scenegraph/meshnode.h"
 #include "../../irisgl/src/scenegraph/particlesystemnode.h"
+#include "../../uimanager.h"
 
 NodePropertyWidget::NodePropertyWidget()
 {
@@ -57,6 +58,7 @@ void NodePropertyWidget::onShadowEnabledChanged(bool val)
 {
     if (!!this->sceneNode) {
         this->sceneNode->setShadowCastingEnabled(val);
+        UiManager::markSceneNodeDirty(this->sceneNode);
     }
 }
 
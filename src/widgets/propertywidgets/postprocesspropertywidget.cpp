@@ -4,6 +4,7 @@
 #include "../propertywidget.h"
 
 #include "../../irisgl/src/core/property.h"
+#include "../../uimanager.h"
 
 #include <QDebug>
 
@@ -22,6 +23,7 @@ void PostProcessPropertyWidget::setPostProcess(iris::PostProcessPtr postProcess)
 void PostProcessPropertyWidget::onPropertyChanged(iris::Property *prop)
 {
     postProcess->setProperty(prop);
+    UiManager::markSceneChanged();
 }
 
 void PostProcessPropertyWidget::onPropertyChangeStart(iris::Property* prop)
@@ -21,6 +21,9 @@ For more information see the LICENSE file
 #include "../checkboxwidget.h"
 #include "../comboboxwidget.h"
 
+#include "../../commands/changescenepropertycommand.h"
+#include "../../uimanager.h"
+
 void WorldPropertyWidget::setupViewSelector()
 {
     viewSelector = this->addComboBox("Skybox View");
@@ -108,44 +111,41 @@ void WorldPropertyWidget::setScene(QSharedPointer<iris::Scene> scene)
 
 void WorldPropertyWidget::onSkyTextureChanged(QString texPath)
 {
+    QStringList textures;
+    for (int i = 0; i < 6; i++) {
+        textures.append(scene->skyBoxTextures[i]);
+    }
+
+    auto newTextures = textures;
     if (viewSelector->getCurrentItem() == "Front") {
-        scene->skyBoxTextures[0] = texPath;
+        newTextures[0] = texPath;
     } else if (viewSelector->getCurrentItem() == "Back") {
-        scene->skyBoxTextures[1] = texPath;
+        newTextures[1] = texPath;
     } else if (viewSelector->getCurrentItem() == "Top") {
-        scene->skyBoxTextures[2] = texPath;
+        newTextures[2] = texPath;
     } else if (viewSelector->getCurrentItem() == "Bottom") {
-        scene->skyBoxTextures[3] = texPath;
+        newTextures[3] = texPath;
     } else if (viewSelector->getCurrentItem() == "Left") {
-        scene->skyBoxTextures[4] = texPath;
+        newTextures[4] = texPath;
     } else if (viewSelector->getCurrentItem() == "Right") {
-        scene->skyBoxTextures[5] = texPath;
+        newTextures[5] = texPath;
     }
 
-    QImage *info;
-    for (int i = 0; i < 6; i++) {
-        if (!scene->skyBoxTextures[i].isEmpty()) {
-            info = new QImage(scene->skyBoxTextures[i]);
-            break;
-        }
+    if (newTextures != textures) {
+        UiManager::pushUndoStack(new ChangeScenePropertyCommand(scene, "skyBoxTextures", textures, newTextures));
     }
-
-    scene->setSkyTexture(iris::Texture2D::createCubeMap(scene->skyBoxTextures[0],
-                                                        scene->skyBoxTextures[1],
-                                                        scene->skyBoxTextures[2],
-                                                        scene->skyBoxTextures[3],
-                                                        scene->skyBoxTextures[4],
-                                                        scene->skyBoxTextures[5],
-                                                        info));
 }
 
 void WorldPropertyWidget::onSkyColorChanged(QColor color)
 {
-    scene->setSkyColor(color);
+    if (scene->skyColor != color) {
+        UiManager::pushUndoStack(new ChangeScenePropertyCommand(scene, "skyColor", scene->skyColor, color));
+    }
 }
 
 void WorldPropertyWidget::onAmbientColorChanged(QColor color)
 {
-    scene->setAmbientColor(color);
+    if (scene->ambientColor != color) {
+        UiManager::pushUndoStack(new ChangeScenePropertyCommand(scene, "ambientColor", scene->ambientColor, color));
+    }
 }
-
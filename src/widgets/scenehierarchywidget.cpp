@@ -197,6 +197,7 @@ bool SceneHierarchyWidget::eventFilter(QObject *watched, QEvent *event)
             long itemId = droppedIndex->data(0, Qt::UserRole).toLongLong();
             auto source = nodeList[itemId];
             source->addChild(this->lastDraggedHiearchyItemSrc);
+            UiManager::markSceneNodeDirty(this->lastDraggedHiearchyItemSrc);
         }
     }
 
@@ -237,6 +238,8 @@ void SceneHierarchyWidget::treeItemSelected(QTreeWidgetItem *item, int column)
 			node->show();
 			item->setData(1, Qt::UserRole, QVariant::fromValue(true));
 		}
+
+		UiManager::markSceneNodeDirty(node);
 	}
 	else {
 		selectedNode = nodeList[nodeId];
@@ -378,6 +381,8 @@ void SceneHierarchyWidget::showHideNode(QTreeWidgetItem* item, bool show)
     } else {
         node->hide();
     }
+
+    UiManager::markSceneNodeDirty(node);
 }
 
 void SceneHierarchyWidget::repopulateTree()
@@ -194,6 +194,17 @@ void SceneNodePropertiesWidget::refreshTransform()
 	}
 }
 
+void SceneNodePropertiesWidget::refreshSceneSettings(QSharedPointer<iris::Scene> scene)
+{
+    if (fogPropView) {
+        fogPropView->setScene(scene);
+    }
+
+    if (worldPropView) {
+        worldPropView->setScene(scene);
+    }
+}
+
 void SceneNodePropertiesWidget::setDatabase(Database *db)
 {
     this->db = db;
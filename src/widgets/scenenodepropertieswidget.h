@@ -17,6 +17,7 @@ For more information see the LICENSE file
 #include <QSharedPointer>
 
 namespace iris {
+    class Scene;
     class SceneNode;
 }
 
@@ -59,6 +60,9 @@ public:
 
 	void refreshTransform();
 
+    // updates the fog and world panels if the scene's root is selected
+    void refreshSceneSettings(QSharedPointer<iris::Scene> scene);
+
     void setDatabase(Database*);
 
 private:
@@ -12,21 +12,32 @@ For more information see the LICENSE file
 #include "assetwidget.h"
 #include "sceneviewwidget.h"
 
+#include <QApplication>
+#include <QCursor>
+#include <QDateTime>
+#include <QCoreApplication>
 #include <QDebug>
+#include <QDir>
 #include <QElapsedTimer>
 #include <QMouseEvent>
 #include <QMimeData>
 #include <QOpenGLDebugLogger>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
+#include <QStandardPaths>
 #include <QtMath>
 #include <QTimer>
 
 #include "irisgl/src/graphics/font.h"
+#include "irisgl/src/content/assetloader.h"
+#include "irisgl/src/core/performancetimer.h"
 #include "irisgl/src/graphics/forwardrenderer.h"
 #include "irisgl/src/graphics/mesh.h"
+#include "irisgl/src/core/meshmanager.h"
+#include "irisgl/src/core/property.h"
 #include "irisgl/src/graphics/texture2d.h"
 #include "irisgl/src/geometry/trimesh.h"
+#include "irisgl/src/geometry/boundingsphere.h"
 #include "irisgl/src/graphics/renderlist.h"
 #include "irisgl/src/graphics/rendertarget.h"
 #include "irisgl/src/graphics/shadowmap.h"
@@ -52,6 +63,8 @@ For more information see the LICENSE file
 #include "mainwindow.h"
 #include "uimanager.h"
 
+#include "commands/changematerialpropertycommand.h"
+#include "commands/changemeshmaterialcommand.h"
 #include "core/keyboardstate.h"
 #include "core/settingsmanager.h"
 #include "editor/animationpath.h"
@@ -62,6 +75,7 @@ For more information see the LICENSE file
 #include "editor/gizmo.h"
 #include "editor/orbitalcameracontroller.h"
 #include "editor/outlinerenderer.h"
+#include "editor/pickingrenderer.h"
 #include "editor/rotationgizmo.h"
 #include "editor/scalegizmo.h"
 #include "editor/thumbnailgenerator.h"
@@ -72,6 +86,9 @@ For more information see the LICENSE file
 void SceneViewWidget::setShowFps(bool value)
 {
 	showFps = value;
+
+	// passes are only timed while their times are shown
+	iris::PerformanceTimer::getSingleton()->setEnabled(value);
 }
 
 void SceneViewWidget::cleanup()
@@ -195,7 +212,12 @@ void SceneViewWidget::dropEvent(QDropEvent *event)
 				++iterator;
 			}
 
-            //if (!!material) savedActiveNode.staticCast<iris::MeshNode>()->setMaterial(material); ???
+            // the node has the asset's material while it's dragged over, it gets its own copy
+            auto meshNode = savedActiveNode.staticCast<iris::MeshNode>();
+            meshNode->setMaterial(originalMaterial);
+            if (!!material) {
+                UiManager::pushUndoStack(new ChangeMeshMaterialCommand(meshNode, originalMaterial, material));
+            }
 		}
 		else {
 			qDebug() << "Empty";
@@ -213,8 +235,17 @@ void SceneViewWidget::dropEvent(QDropEvent *event)
             auto meshNode = node.staticCast<iris::MeshNode>();
             auto mat = meshNode->getMaterial().staticCast<iris::CustomMaterial>();
 
-            if (!mat->firstTextureSlot().isEmpty()) {
-                mat->setValue(mat->firstTextureSlot(), QDir(Globals::project->getProjectFolder()).filePath(roleDataMap.value(1).toString()));
+            auto slot = mat->firstTextureSlot();
+            if (!slot.isEmpty()) {
+                QVariant oldValue;
+                for (auto prop : mat->properties) {
+                    if (prop->name == slot) oldValue = prop->getValue();
+                }
+
+                UiManager::pushUndoStack(new ChangeMaterialPropertyCommand(
+                    mat, slot, oldValue,
+                    QDir(Globals::project->getProjectFolder()).filePath(roleDataMap.value(1).toString())
+                ));
             }
         }
     }
@@ -266,6 +297,7 @@ SceneViewWidget::SceneViewWidget(QWidget *parent) : QOpenGLWidget(parent)
     viewportMode = ViewportMode::Editor;
 
     elapsedTimer = new QElapsedTimer();
+    timer = nullptr;
     playScene = false;
     animTime = 0.0f;
 
@@ -280,7 +312,15 @@ SceneViewWidget::SceneViewWidget(QWidget *parent) : QOpenGLWidget(parent)
     thumbGen = nullptr;
 
     fontSize = 20;
-    showFps = SettingsManager::getDefaultManager()->getValue("show_fps", false).toBool();
+    setShowFps(SettingsManager::getDefaultManager()->getValue("show_fps", false).toBool());
+
+    redrawRequested = true;
+    continuousRendering = SettingsManager::getDefaultManager()->getValue("continuous_rendering", false).toBool();
+    frameCap = qMax(1, SettingsManager::getDefaultManager()->getValue("frame_cap", 60).toInt());
+    gpuPicking = SettingsManager::getDefaultManager()->getValue("gpu_picking", true).toBool();
+
+    // edits made in the rest of the editor can change the scene, see eventFilter()
+    QCoreApplication::instance()->installEventFilter(this);
 }
 
 void SceneViewWidget::resetEditorCam()
@@ -320,6 +360,7 @@ bool SceneViewWidget::getShowLightWires() const
 void SceneViewWidget::setShowLightWires(bool value)
 {
     showLightWires = value;
+    requestRedraw();
 }
 
 void SceneViewWidget::initLightAssets()
@@ -407,6 +448,7 @@ void SceneViewWidget::setScene(iris::ScenePtr scene)
 
     // remove selected scenenode
     selectedNode.reset();
+    requestRedraw();
 }
 
 void SceneViewWidget::setSelectedNode(iris::SceneNodePtr sceneNode)
@@ -431,6 +473,8 @@ void SceneViewWidget::setSelectedNode(iris::SceneNodePtr sceneNode)
 		renderer->setSelectedSceneNode(sceneNode);
 		gizmo->setSelectedNode(sceneNode);
 	}
+
+	requestRedraw();
 }
 
 void SceneViewWidget::clearSelectedNode()
@@ -438,6 +482,7 @@ void SceneViewWidget::clearSelectedNode()
     selectedNode.clear();
     renderer->setSelectedSceneNode(selectedNode);
 	gizmo->clearSelectedNode();
+    requestRedraw();
 }
 
 void SceneViewWidget::enterEditorMode()
@@ -456,7 +501,9 @@ void SceneViewWidget::renderGizmos(bool once)
 {
 	if (viewportMode != ViewportMode::Editor || UiManager::sceneMode != SceneMode::EditMode)
 		return;
-	
+
+	IRIS_PROFILE_GPU("gizmos", renderer->getGraphicsDevice());
+
     auto gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
 	if (!!selectedNode) {
 		gizmo->updateSize(editorCam);
@@ -471,9 +518,37 @@ void SceneViewWidget::renderSelectedNode(iris::SceneNodePtr selectedNode)
 {
 	if (viewportMode != ViewportMode::Editor || UiManager::sceneMode != SceneMode::EditMode)
 		return;
+
+	IRIS_PROFILE_GPU("outline", renderer->getGraphicsDevice());
 	outliner->renderOutline(renderer->getGraphicsDevice(), selectedNode, editorCam, qBound(1.f,(float)scene->outlineWidth,2.f),scene->outlineColor);
 }
 
+void SceneViewWidget::doHoverPicking()
+{
+    if (!gpuPicking || viewportMode != ViewportMode::Editor || UiManager::sceneMode != SceneMode::EditMode)
+        return;
+
+    if (!underMouse())
+        return;
+
+    auto device = renderer->getGraphicsDevice();
+    IRIS_PROFILE_GPU("picking", device);
+
+    // nothing's picked while the camera or gizmo is being dragged
+    if (QApplication::mouseButtons() == Qt::NoButton) {
+        picker->resolve();
+        picker->pick(device, scene, editorCam, size(), mapFromGlobal(QCursor::pos()));
+    }
+
+    // outlines what would be selected if it was clicked
+    auto hoveredNode = picker->getHoveredNode();
+    if (!!hoveredNode) {
+        hoveredNode = getSelectableNode(hoveredNode, selectedNode);
+        if (hoveredNode != selectedNode)
+            outliner->renderOutline(device, hoveredNode, editorCam, 1.f, scene->outlineColor.darker(200));
+    }
+}
+
 void SceneViewWidget::setSceneMode(SceneMode sceneMode)
 {
 	// stop animation
@@ -514,7 +589,7 @@ void SceneViewWidget::initializeGL()
 	auto mat = ViewerMaterial::create();
 	mat->setTexture(iris::Texture2D::load(":/assets/models/head.png"));
 	viewerMat = mat.staticCast<iris::Material>();
-	viewerMesh = iris::Mesh::loadMesh(":/assets/models/head2.obj");
+	viewerMesh = iris::MeshManager::getSingleton()->getMesh(":/assets/models/head2.obj");
 
     screenshotRT = iris::RenderTarget::create(500, 500);
     screenshotTex = iris::Texture2D::create(500, 500);
@@ -523,6 +598,9 @@ void SceneViewWidget::initializeGL()
 	outliner = new OutlinerRenderer();
 	outliner->loadAssets();
 
+    picker = new PickingRenderer();
+    picker->loadAssets();
+
     emit initializeGraphics(this, this);
 
     //thumbGen = new ThumbnialGenerator();
@@ -531,8 +609,9 @@ void SceneViewWidget::initializeGL()
 	animPath = new AnimationPath();
 
     timer = new QTimer(this);
-    connect(timer, SIGNAL(timeout()), this, SLOT(update()));
-    timer->start(Constants::FPS_60);
+    connect(timer, SIGNAL(timeout()), this, SLOT(onFrameTimer()));
+    updateFrameInterval();
+    timer->start();
 
     this->elapsedTimer->start();
 
@@ -556,22 +635,97 @@ void SceneViewWidget::initializeOpenGLDebugger()
 	}
 }
 
-void SceneViewWidget::paintGL()
+void SceneViewWidget::onFrameTimer()
 {
-    makeCurrent();
-
     if (iris::VrManager::getDefaultDevice()->isHeadMounted() && viewportMode != ViewportMode::VR) {
         // set to vr mode automatically if a headset is detected
         this->setViewportMode(ViewportMode::VR);
-        timer->setInterval(Constants::FPS_90); // 90 fps for vr
+        updateFrameInterval();
     }
     else if (!iris::VrManager::getDefaultDevice()->isHeadMounted() &&
             viewportMode == ViewportMode::VR)
     {
         this->setViewportMode(ViewportMode::Editor);
-        timer->setInterval(Constants::FPS_60); // 60 for regular
+        updateFrameInterval();
+    }
+
+    // picks are read back as soon as they're ready rather than on the next redraw
+    if (gpuPicking && picker->isPending()) {
+        makeCurrent();
+        if (picker->resolve())
+            redrawRequested = true;
+        doneCurrent();
+    }
+
+    if (needsRedraw()) {
+        update();
+    } else {
+        // so the time spent idle isnt passed to the next frame's update
+        elapsedTimer->restart();
     }
+}
+
+bool SceneViewWidget::needsRedraw()
+{
+    if (redrawRequested || continuousRendering || playScene)
+        return true;
+
+    if (viewportMode == ViewportMode::VR || UiManager::sceneMode == SceneMode::PlayMode)
+        return true;
+
+    // assets are uploaded a few at a time while frames are drawn
+    if (iris::AssetLoader::getSingleton()->isLoading())
+        return true;
+
+    // keys move the camera for as long as they're held
+    if (hasFocus() && KeyboardState::isAnyKeyDown())
+        return true;
+
+    if (camController != nullptr && camController->isAnimating())
+        return true;
+
+    return !!scene && (scene->hasChanges() || !scene->particleSystems.isEmpty());
+}
 
+void SceneViewWidget::updateFrameInterval()
+{
+    if (timer == nullptr)
+        return;
+
+    if (viewportMode == ViewportMode::VR)
+        timer->setInterval(Constants::FPS_90); // 90 fps for vr
+    else
+        timer->setInterval(1000 / frameCap);
+}
+
+void SceneViewWidget::requestRedraw()
+{
+    redrawRequested = true;
+}
+
+void SceneViewWidget::setContinuousRendering(bool value)
+{
+    continuousRendering = value;
+}
+
+void SceneViewWidget::setFrameCap(int fps)
+{
+    frameCap = qMax(1, fps);
+    updateFrameInterval();
+}
+
+void SceneViewWidget::setGpuPicking(bool value)
+{
+    gpuPicking = value;
+    requestRedraw();
+}
+
+void SceneViewWidget::paintGL()
+{
+    makeCurrent();
+
+    // cleared first so changes made while drawing get another frame
+    redrawRequested = false;
     renderScene();
 
 }
@@ -584,7 +738,16 @@ void SceneViewWidget::renderScene()
     float dt = elapsedTimer->nsecsElapsed() / (1000.0f * 1000.0f * 1000.0f);
     elapsedTimer->restart();
 
+    auto profiler = iris::PerformanceTimer::getSingleton();
+    auto device = renderer->getGraphicsDevice();
+    profiler->beginFrame();
+    device->beginFrame();
+
     if (!!renderer && !!scene) {
+        // assets loading in the background are uploaded a few at a time
+        iris::AssetLoader::getSingleton()->processUploads(renderer->getGraphicsDevice(),
+                                                          Constants::ASSET_UPLOAD_BUDGET);
+
         this->camController->update(dt);
 
         if (playScene) {
@@ -602,6 +765,10 @@ void SceneViewWidget::renderScene()
             viewerVisible = false;    
         }
 		*/
+        // picks made before the scene changed are out of date
+        if (scene->hasChanges())
+            picker->invalidate();
+
         scene->update(dt);
 		//animPath->submit(scene->geometryRenderList);
 
@@ -652,11 +819,17 @@ void SceneViewWidget::renderScene()
         }
 		
 		this->renderSelectedNode(selectedNode);
+		this->doHoverPicking();
 		this->renderGizmos();
         
     }
 
+    // the overlay isnt part of the stats it shows
+    device->endFrame();
+    profiler->endFrame();
+
     // render fps
+    float lineY = 8;
     spriteBatch->begin();
     if (showFps) {
         float fps = 1.0 / dt;
@@ -665,7 +838,44 @@ void SceneViewWidget::renderScene()
                                 QString("%1ms (%2fps)")
                                     .arg(QString::number(ms, 'f', 1))
                                     .arg(QString::number(fps, 'f', 1)),
-                                QVector2D(8, 8),
+                                QVector2D(8, lineY),
+                                QColor(255, 255, 255));
+        lineY += 8 + fontSize;
+
+        auto& stats = device->getFrameStats();
+        spriteBatch->drawString(font,
+                                QString("%1 draws  %2 state changes  %3 uniforms  %4 tris")
+                                    .arg(stats.drawCalls)
+                                    .arg(stats.stateChanges)
+                                    .arg(stats.uniformUploads)
+                                    .arg(stats.triangles),
+                                QVector2D(8, lineY),
+                                QColor(255, 255, 255));
+        lineY += 8 + fontSize;
+
+        // gpu times lag a few frames behind
+        for (auto& zone : profiler->getFrameZones()) {
+            auto cpu = zone.cpuMs < 0 ? QString("-") : QString::number(zone.cpuMs, 'f', 2);
+            auto gpu = zone.gpuMs < 0 ? QString("-") : QString::number(zone.gpuMs, 'f', 2);
+            spriteBatch->drawString(font,
+                                    QString("%1%2  cpu %3ms  gpu %4ms")
+                                        .arg(QString(zone.depth * 2, ' '))
+                                        .arg(zone.name)
+                                        .arg(cpu)
+                                        .arg(gpu),
+                                    QVector2D(8, lineY),
+                                    QColor(200, 200, 200));
+            lineY += 8 + fontSize;
+        }
+    }
+
+    auto assetLoader = iris::AssetLoader::getSingleton();
+    if (assetLoader->isLoading()) {
+        spriteBatch->drawString(font,
+                                QString("Loading assets %1/%2")
+                                    .arg(assetLoader->getLoadedCount())
+                                    .arg(assetLoader->getTotalCount()),
+                                QVector2D(8, lineY),
                                 QColor(255, 255, 255));
     }
 
@@ -695,6 +905,32 @@ void SceneViewWidget::onAnimationKeyChanged(iris::FloatKey* key)
 
 bool SceneViewWidget::eventFilter(QObject *obj, QEvent *event)
 {
+    // input anywhere in the editor can change what's shown, such as a property
+    // being edited, so it redraws the view
+    switch (event->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::Wheel:
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+    case QEvent::Drop:
+        redrawRequested = true;
+        break;
+    case QEvent::MouseMove:
+        // hovering only matters over the view, for highlighting the gizmo
+        if (obj == this || static_cast<QMouseEvent*>(event)->buttons() != Qt::NoButton)
+            redrawRequested = true;
+        break;
+    case QEvent::Leave:
+        // removes the hover outline
+        if (obj == this)
+            redrawRequested = true;
+        break;
+    default:
+        break;
+    }
+
     return QWidget::eventFilter(obj, event);
 }
 
@@ -843,6 +1079,17 @@ void SceneViewWidget::keyPressEvent(QKeyEvent *event)
 {
     KeyboardState::keyStates[event->key()] = true;
 	camController->onKeyPressed((Qt::Key)event->key());
+
+    // saves the recorded frames while they're being profiled
+    if (showFps && event->key() == Qt::Key_F12 && !event->isAutoRepeat()) {
+        auto path = QDir(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation))
+                        .filePath(QString("trace-%1.json")
+                                  .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+        if (iris::PerformanceTimer::getSingleton()->exportChromeTrace(path))
+            qDebug() << "saved trace to" << path;
+        else
+            qDebug() << "couldnt save trace to" << path;
+    }
 }
 
 void SceneViewWidget::keyReleaseEvent(QKeyEvent *event)
@@ -876,7 +1123,16 @@ void SceneViewWidget::doObjectPicking(
     auto segEnd = segStart + rayDir;
 
     QList<PickingResult> hitList;
-    doScenePicking(scene->getRootNode(), segStart, segEnd, hitList);
+    iris::SceneNodePtr gpuPickedNode;
+    if (gpuPicking && picker->getPickedNode(point, editorCam, gpuPickedNode)) {
+        // the id buffer already has the mesh under the cursor, only its hit point is raycast
+        // the ray can still miss it by a fraction of a pixel so the whole scene is raycast then
+        if (!!gpuPickedNode && !doNodePicking(gpuPickedNode, segStart, segEnd, hitList))
+            doScenePicking(scene->getRootNode(), segStart, segEnd, hitList);
+    } else {
+        doScenePicking(scene->getRootNode(), segStart, segEnd, hitList);
+    }
+
     if (!skipLights) {
         doLightPicking(segStart, segEnd, hitList);
     }
@@ -897,26 +1153,32 @@ void SceneViewWidget::doObjectPicking(
     });
 
     auto pickedNode = hitList.last().hitNode;
-    iris::SceneNodePtr lastSelectedRoot;
+    if (selectRootObject)
+        pickedNode = getSelectableNode(pickedNode, lastSelectedNode);
 
-    if (selectRootObject) {
-        if (!!lastSelectedNode) {
-            lastSelectedRoot = lastSelectedNode;
-            while (lastSelectedRoot->isAttached())
-                lastSelectedRoot = lastSelectedRoot->parent;
-        }
-
-        auto pickedRoot = hitList.last().hitNode;
-        while (pickedRoot->isAttached())
-            pickedRoot = pickedRoot->parent;
+    gizmo->setSelectedNode(pickedNode);
+    emit sceneNodeSelected(pickedNode);
+}
 
-        if (!lastSelectedNode ||            // if the user clicked away then the root should be reselected
-            pickedRoot != lastSelectedRoot) // if both are under, or is, the same root then pick the actual object
-            pickedNode = pickedRoot;        // if not then pick the root node
+iris::SceneNodePtr SceneViewWidget::getSelectableNode(const iris::SceneNodePtr& pickedNode,
+                                                      const iris::SceneNodePtr& lastSelectedNode)
+{
+    iris::SceneNodePtr lastSelectedRoot;
+    if (!!lastSelectedNode) {
+        lastSelectedRoot = lastSelectedNode;
+        while (lastSelectedRoot->isAttached())
+            lastSelectedRoot = lastSelectedRoot->parent;
     }
 
-    gizmo->setSelectedNode(pickedNode);
-    emit sceneNodeSelected(pickedNode);
+    auto pickedRoot = pickedNode;
+    while (pickedRoot->isAttached())
+        pickedRoot = pickedRoot->parent;
+
+    if (!lastSelectedNode ||            // if the user clicked away then the root should be reselected
+        pickedRoot != lastSelectedRoot) // if both are under, or is, the same root then pick the actual object
+        return pickedRoot;              // if not then pick the root node
+
+    return pickedNode;
 }
 
 QImage SceneViewWidget::takeScreenshot(QSize dimension)
@@ -1010,31 +1272,7 @@ void SceneViewWidget::doScenePicking(const QSharedPointer<iris::SceneNode>& scen
     if ((sceneNode->getSceneNodeType() == iris::SceneNodeType::Mesh) &&
          sceneNode->isPickable())
     {
-        auto meshNode = sceneNode.staticCast<iris::MeshNode>();
-        auto mesh = meshNode->getMesh();
-        if (mesh != nullptr) {
-            auto triMesh = meshNode->getMesh()->getTriMesh();
-
-            // transform segment to local space
-            auto invTransform = meshNode->globalTransform.inverted();
-            auto a = invTransform * segStart;
-            auto b = invTransform * segEnd;
-
-            QList<iris::TriangleIntersectionResult> results;
-            if (int resultCount = triMesh->getSegmentIntersections(a, b, results)) {
-                for (auto triResult : results) {
-                    // convert hit to world space
-                    auto hitPoint = meshNode->globalTransform * triResult.hitPoint;
-
-                    PickingResult pick;
-                    pick.hitNode = sceneNode;
-                    pick.hitPoint = hitPoint;
-                    pick.distanceFromCameraSqrd = (hitPoint - editorCam->getGlobalPosition()).lengthSquared();
-
-                    hitList.append(pick);
-                }
-            }
-        }
+        doNodePicking(sceneNode, segStart, segEnd, hitList);
     }
 
     for (auto child : sceneNode->children) {
@@ -1042,6 +1280,45 @@ void SceneViewWidget::doScenePicking(const QSharedPointer<iris::SceneNode>& scen
     }
 }
 
+bool SceneViewWidget::doNodePicking(const QSharedPointer<iris::SceneNode>& sceneNode,
+                                    const QVector3D& segStart,
+                                    const QVector3D& segEnd,
+                                    QList<PickingResult>& hitList)
+{
+    auto meshNode = sceneNode.staticCast<iris::MeshNode>();
+    auto mesh = meshNode->getMesh();
+    // skip meshes whose bounds the segment misses
+    if (mesh == nullptr || mesh->getTriMesh() == nullptr ||
+        (mesh->boundingSphere.radius > 0 &&
+         !meshNode->getTransformedBoundingSphere().intersectsSegment(segStart, segEnd)))
+        return false;
+
+    auto triMesh = mesh->getTriMesh();
+
+    // transform segment to local space
+    auto invTransform = meshNode->globalTransform.inverted();
+    auto a = invTransform * segStart;
+    auto b = invTransform * segEnd;
+
+    QList<iris::TriangleIntersectionResult> results;
+    if (!triMesh->getSegmentIntersections(a, b, results))
+        return false;
+
+    for (auto triResult : results) {
+        // convert hit to world space
+        auto hitPoint = meshNode->globalTransform * triResult.hitPoint;
+
+        PickingResult pick;
+        pick.hitNode = sceneNode;
+        pick.hitPoint = hitPoint;
+        pick.distanceFromCameraSqrd = (hitPoint - editorCam->getGlobalPosition()).lengthSquared();
+
+        hitList.append(pick);
+    }
+
+    return true;
+}
+
 void SceneViewWidget::doMeshPicking(const QSharedPointer<iris::SceneNode>& sceneNode,
                                     const QVector3D& segStart,
                                     const QVector3D& segEnd,
@@ -1149,6 +1426,7 @@ void SceneViewWidget::focusOnNode(iris::SceneNodePtr sceneNode)
 {
 	setCameraController(orbitalCam);
 	orbitalCam->focusOnNode(sceneNode);
+	requestRedraw();
 }
 
 bool SceneViewWidget::isVrSupported()
@@ -48,6 +48,7 @@ class EditorVrController;
 class Gizmo;
 class OrbitalCameraController;
 class OutlinerRenderer;
+class PickingRenderer;
 class QElapsedTimer;
 class QOpenGLDebugLogger;
 class QOpenGLShaderProgram;
@@ -92,6 +93,14 @@ class SceneViewWidget : public QOpenGLWidget, protected QOpenGLFunctions_3_2_Cor
     QElapsedTimer* elapsedTimer;
     QTimer* timer;
 
+    // the view is only redrawn when something changed, unless continuousRendering is set
+    bool redrawRequested;
+    bool continuousRendering;
+    int frameCap;
+
+    // picks meshes with an id buffer, raycasting is used when it has no result
+    bool gpuPicking;
+
     // for displaying thumbnail of viewer
     iris::CameraNodePtr viewerCamera;
     iris::RenderTargetPtr viewerRT;
@@ -196,6 +205,17 @@ public:
     void setShowFps(bool value);
 	void renderSelectedNode(iris::SceneNodePtr selectedNode);
 
+    // redraws the view on the next frame, for changes the view cant detect itself
+    void requestRedraw();
+
+    // redraws every frame even if nothing changed, play mode and vr always do
+    void setContinuousRendering(bool value);
+
+    // the most frames drawn per second
+    void setFrameCap(int fps);
+
+    void setGpuPicking(bool value);
+
 	void setSceneMode(SceneMode sceneMode);
 
     void cleanup();
@@ -218,6 +238,7 @@ protected:
     void getMousePosAndRay(const QPointF& point, QVector3D& rayPos, QVector3D& rayDir);
 
 private slots:
+    void onFrameTimer();
     void paintGL();
     void renderGizmos(bool once = false);
     void resizeGL(int width, int height);
@@ -244,9 +265,25 @@ private:
                        const QVector3D& segEnd,
                        QList<PickingResult>& hitList);
 
+    // raycasts a single mesh node, returns false if it wasnt hit
+    bool doNodePicking(const iris::SceneNodePtr& sceneNode,
+                       const QVector3D& segStart,
+                       const QVector3D& segEnd,
+                       QList<PickingResult>& hitList);
+
+    // the root of pickedNode unless it's under the same root as lastSelectedNode
+    iris::SceneNodePtr getSelectableNode(const iris::SceneNodePtr& pickedNode,
+                                         const iris::SceneNodePtr& lastSelectedNode);
+
+    // picks under the cursor on the gpu and outlines the hovered node
+    void doHoverPicking();
+
     void makeObject();
     void renderScene();
 
+    bool needsRedraw();
+    void updateFrameInterval();
+
 
     iris::ScenePtr scene;
     iris::SceneNodePtr selectedNode;
@@ -268,6 +305,7 @@ private:
     iris::Viewport* viewport;
     iris::FullScreenQuad* fsQuad;
 	OutlinerRenderer* outliner;
+    PickingRenderer* picker;
 
     bool playScene;
     iris::Plane sceneFloor;
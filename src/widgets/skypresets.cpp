@@ -13,6 +13,8 @@ For more information see the LICENSE file
 #include "ui_skypresets.h"
 
 #include "../mainwindow.h"
+#include "../uimanager.h"
+#include "../commands/changescenepropertycommand.h"
 #include "../irisgl/src/scenegraph/scene.h"
 #include "../irisgl/src/materials/defaultskymaterial.h"
 #include "../irisgl/src/core/irisutils.h"
@@ -94,18 +96,21 @@ void SkyPresets::applyCubeSky(QListWidgetItem* item)
     auto z1 = path + "/front." + ext;
     auto z2 = path + "/back." + ext;
 
-    mainWindow->getScene()->skyBoxTextures[0] = z1;
-    mainWindow->getScene()->skyBoxTextures[1] = z2;
-    mainWindow->getScene()->skyBoxTextures[2] = y1;
-    mainWindow->getScene()->skyBoxTextures[3] = y2;
-    mainWindow->getScene()->skyBoxTextures[4] = x1;
-    mainWindow->getScene()->skyBoxTextures[5] = x2;
+    auto scene = mainWindow->getScene();
 
-    auto img = new QImage(z1);
+    QStringList textures;
+    for (int i = 0; i < 6; i++) {
+        textures.append(scene->skyBoxTextures[i]);
+    }
 
-    mainWindow->getScene()->setSkyTexture(iris::Texture2D::createCubeMap(z1, z2, y1, y2, x1, x2, img));
-    mainWindow->getScene()->setSkyTextureSource(z1);
-    mainWindow->getScene()->setSkyColor(QColor(255, 255, 255));
+    // the command makes the cube map
+    QStringList newTextures = {z1, z2, y1, y2, x1, x2};
+    UiManager::pushUndoStack(new ChangeScenePropertyCommand(scene, "skyBoxTextures", textures, newTextures));
+    scene->setSkyTextureSource(z1);
+
+    if (scene->skyColor != QColor(255, 255, 255)) {
+        UiManager::pushUndoStack(new ChangeScenePropertyCommand(scene, "skyColor", scene->skyColor, QColor(255, 255, 255)));
+    }
 }
 
 void SkyPresets::applySky(QListWidgetItem* item)
@@ -13,6 +13,7 @@ For more information see the LICENSE file
 #include "ui_transformeditor.h"
 
 #include "../irisgl/src/scenegraph/scenenode.h"
+#include "../uimanager.h"
 
 TransformEditor::TransformEditor(QWidget* parent) :
     QWidget(parent),
@@ -104,6 +105,7 @@ void TransformEditor::xPosChanged(double value)
         auto pos = sceneNode->getLocalPos();
         pos.setX(value);
         sceneNode->setLocalPos(pos);
+        UiManager::markSceneNodeDirty(sceneNode);
     }
 }
 
@@ -113,6 +115,7 @@ void TransformEditor::yPosChanged(double value)
         auto pos = sceneNode->getLocalPos();
         pos.setY(value);
         sceneNode->setLocalPos(pos);
+        UiManager::markSceneNodeDirty(sceneNode);
     }
 }
 
@@ -122,6 +125,7 @@ void TransformEditor::zPosChanged(double value)
         auto pos = sceneNode->getLocalPos();
         pos.setZ(value);
         sceneNode->setLocalPos(pos);
+        UiManager::markSceneNodeDirty(sceneNode);
     }
 }
 
@@ -134,6 +138,7 @@ void TransformEditor::xRotChanged(double value)
         auto rot = sceneNode->getLocalRot().toEulerAngles();
         rot.setX(value);
         sceneNode->setLocalRot(QQuaternion::fromEulerAngles(rot));
+        UiManager::markSceneNodeDirty(sceneNode);
     }
 }
 
@@ -143,6 +148,7 @@ void TransformEditor::yRotChanged(double value)
         auto rot = sceneNode->getLocalRot().toEulerAngles();
         rot.setY(value);
         sceneNode->setLocalRot(QQuaternion::fromEulerAngles(rot));
+        UiManager::markSceneNodeDirty(sceneNode);
     }
 }
 
@@ -152,6 +158,7 @@ void TransformEditor::zRotChanged(double value)
         auto rot = sceneNode->getLocalRot().toEulerAngles();
         rot.setZ(value);
         sceneNode->setLocalRot(QQuaternion::fromEulerAngles(rot));
+        UiManager::markSceneNodeDirty(sceneNode);
     }
 }
 
@@ -164,6 +171,7 @@ void TransformEditor::xScaleChanged(double value)
         auto scale = sceneNode->getLocalScale();
         scale.setX(value);
         sceneNode->setLocalScale(scale);
+        UiManager::markSceneNodeDirty(sceneNode);
     }
 }
 
@@ -173,6 +181,7 @@ void TransformEditor::yScaleChanged(double value)
         auto scale = sceneNode->getLocalScale();
         scale.setY(value);
         sceneNode->setLocalScale(scale);
+        UiManager::markSceneNodeDirty(sceneNode);
     }
 }
 
@@ -182,6 +191,7 @@ void TransformEditor::zScaleChanged(double value)
         auto scale = sceneNode->getLocalScale();
         scale.setZ(value);
         sceneNode->setLocalScale(scale);
+        UiManager::markSceneNodeDirty(sceneNode);
     }
 }
 